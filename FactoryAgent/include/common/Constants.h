@@ -19,6 +19,7 @@ namespace AgentConstants {
     const int DEFAULT_HTTP_PORT = 80;
     const int DEFAULT_HTTPS_PORT = 443;
     const char* const DEFAULT_IP_ADDRESS = "0.0.0.0";
+    const unsigned int HTTP_UPLOAD_CHUNK_SIZE = 256 * 1024;
 
     /* File system constants */
     const char* const TEMP_FOLDER_NAME = "temp";
@@ -34,11 +35,14 @@ namespace AgentConstants {
     const wchar_t* const ENDPOINT_REGISTER = L"/api/agent/register";
     const wchar_t* const ENDPOINT_HEARTBEAT = L"/api/agent/heartbeat";
     const wchar_t* const ENDPOINT_UPDATE_CONFIG = L"/api/agent/updateconfig";
+    const wchar_t* const ENDPOINT_CONFIG_CHANGES = L"/api/agent/configchanges";
     const wchar_t* const ENDPOINT_UPDATE_LOG = L"/api/agent/updatelog";
     const wchar_t* const ENDPOINT_SYNC_LOGS = L"/api/agent/synclogs";
     const wchar_t* const ENDPOINT_SYNC_MODELS = L"/api/agent/syncmodels";
     const wchar_t* const ENDPOINT_COMMAND_RESULT = L"/api/agent/commandresult";
     const wchar_t* const ENDPOINT_UPLOAD_MODEL = L"/api/agent/uploadmodelfile";
+    const wchar_t* const ENDPOINT_ANOMALY_EVENTS = L"/api/agent/anomalies";
+    const wchar_t* const ENDPOINT_BARREL_EVENTS = L"/api/agent/barrelevents";
 
     /* Command types */
     const char* const COMMAND_UPDATE_CONFIG = "UpdateConfig";
@@ -46,6 +50,13 @@ namespace AgentConstants {
     const char* const COMMAND_UPLOAD_MODEL = "UploadModel";
     const char* const COMMAND_DELETE_MODEL = "DeleteModel";
     const char* const COMMAND_DOWNLOAD_MODEL = "DownloadModel";
+    const char* const COMMAND_GET_LOG_FILE_CONTENT = "GetLogFileContent";
+    const char* const COMMAND_QUERY_LOG_INDEX = "QueryLogIndex";
+    const char* const COMMAND_SEARCH_LOGS = "SearchLogs";
+    const char* const COMMAND_CANCEL_SEARCH = "CancelSearch";
+    const char* const COMMAND_ANALYZE_CRITICAL_PATH = "AnalyzeCriticalPath";
+    const char* const COMMAND_ROLLBACK_CONFIG = "RollbackConfig";
+    const char* const COMMAND_REVERT_MODEL = "RevertModel";
 
     /* Status values */
     const char* const STATUS_IN_PROGRESS = "InProgress";
@@ -70,6 +81,163 @@ namespace AgentConstants {
         L"Click 'Retry' to reconnect.\n"
         L"Click 'Cancel' to exit the application.";
 
+    /* Log record layout (tab-separated, JSON payload in the last field) */
+    const int LOG_FIELD_COUNT = 11;
+    const int LOG_FIELD_DATETIME = 0;
+    const int LOG_FIELD_SEQUENCE = 8;
+    const int LOG_FIELD_EVENT = 9;
+    const int LOG_FIELD_PAYLOAD = 10;
+    const char* const LOG_EVENT_START_TEXT = "START";
+    const char* const LOG_EVENT_END_TEXT = "END";
+    const char* const LOG_FILE_EXTENSION = ".log";
+    const char* const LOG_TEXT_EXTENSION = ".txt";
+
+    /* Log sidecar index */
+    const char* const LOG_INDEX_EXTENSION = ".fidx";
+    const unsigned int LOG_INDEX_VERSION = 1;
+    const unsigned int LOG_INDEX_TIME_STRIDE_BYTES = 64 * 1024;
+    const unsigned int LOG_INDEX_HEAD_HASH_BYTES = 4096;
+    const int LOG_INDEX_SCAN_INTERVAL_MS = 10 * 1000;
+    const unsigned int LOG_QUERY_MAX_BYTES = 8 * 1024 * 1024;
+
+    /* Columnar archive of closed logs */
+    const char* const LOG_ARCHIVE_EXTENSION = ".fcol";
+    const unsigned int LOG_ARCHIVE_VERSION = 1;
+    const unsigned int LOG_ARCHIVE_BLOCK_LINES = 8192;
+    const long long LOG_ARCHIVE_MIN_AGE_MS = 30 * 60 * 1000;
+    const int LOG_ARCHIVE_SCAN_INTERVAL_MS = 10 * 60 * 1000;
+
+    /* Log search */
+    const int LOG_SEARCH_DEFAULT_MAX_HITS = 1000;
+    const int LOG_SEARCH_MAX_HITS = 5000;
+    const int LOG_SEARCH_DEFAULT_CPU_BUDGET_MS = 30000;
+    const int LOG_SEARCH_MAX_THREADS = 4;
+    const int LOG_SEARCH_MAX_CONCURRENT = 2;
+    const int LOG_SEARCH_FLUSH_INTERVAL_MS = 1000;
+    const unsigned int LOG_SEARCH_SEGMENT_BYTES = 4 * 1024 * 1024;
+    const unsigned int LOG_SEARCH_MAX_LINE_BYTES = 2048;
+
+    /* Live log tailing and cycle-time statistics */
+    const int LIVE_LOG_POLL_INTERVAL_MS = 500;
+    const int LIVE_LOG_DISCOVERY_INTERVAL_MS = 5000;
+    const unsigned int LIVE_LOG_BOOTSTRAP_BYTES = 4 * 1024 * 1024;
+    const unsigned int LIVE_LOG_MAX_READ_BYTES = 4 * 1024 * 1024;
+    const unsigned int LIVE_LOG_MAX_PENDING_STARTS = 4096;
+    const long long LIVE_LOG_PENDING_TIMEOUT_MS = 10 * 60 * 1000;
+    const long long CYCLE_STATS_WINDOW_MS = 5 * 60 * 1000;
+    const unsigned int CYCLE_STATS_MAX_OPERATIONS = 64;
+
+    /* Cycle-time anomaly detection */
+    const double ANOMALY_EWMA_ALPHA = 0.02;
+    const unsigned int ANOMALY_WARMUP_SAMPLES = 30;
+    const double ANOMALY_Z_THRESHOLD = 4.0;
+    const double ANOMALY_MIN_EXCESS_RATIO = 0.25;
+    const double ANOMALY_IDEAL_FACTOR = 1.5;
+    const long long ANOMALY_COOLDOWN_MS = 30 * 1000;
+    const long long ANOMALY_BARREL_IDLE_MS = 60 * 1000;
+    const long long ANOMALY_SWEEP_INTERVAL_MS = 5 * 1000;
+    const unsigned int ANOMALY_MAX_OPEN_BARRELS = 2048;
+    const unsigned int ANOMALY_MAX_QUEUED = 1000;
+
+    /* Critical-path analysis */
+    const long long CRITICAL_PATH_BARREL_IDLE_MS = 60 * 1000;
+    const unsigned int CRITICAL_PATH_MAX_OPEN_BARRELS = 4096;
+    const unsigned int CRITICAL_PATH_MAX_OPS_PER_BARREL = 64;
+    const unsigned int CRITICAL_PATH_DEFAULT_MAX_BARRELS = 200;
+
+    /* Barrel event stream */
+    const char* const EVENT_STREAM_CHECKPOINT_FILE = "event_stream.checkpoint";
+    const char* const EVENT_STREAM_SPOOL_FOLDER = "event_spool";
+    const char* const EVENT_STREAM_SPOOL_EXTENSION = ".fbev";
+    const unsigned int EVENT_STREAM_VERSION = 1;
+    const unsigned int EVENT_STREAM_BATCH_EVENTS = 500;
+    const int EVENT_STREAM_MAX_LATENCY_MS = 1000;
+    const int EVENT_STREAM_POLL_INTERVAL_MS = 100;
+    const unsigned int EVENT_STREAM_MAX_MEMORY_BYTES = 4 * 1024 * 1024;
+    const unsigned long long EVENT_STREAM_MAX_SPOOL_BYTES = 256ULL * 1024 * 1024;
+    const int EVENT_STREAM_RETRY_MIN_MS = 1000;
+    const int EVENT_STREAM_RETRY_MAX_MS = 30000;
+
+    /* Shared-memory event channel from the LAI application */
+    const unsigned int SHARED_EVENT_RING_VERSION = 1;
+    const unsigned int SHARED_EVENT_RING_CAPACITY = 65536;
+    const unsigned int SHARED_EVENT_BATCH_RECORDS = 256;
+    const int SHARED_EVENT_SPIN_ROUNDS = 64;
+    const int SHARED_EVENT_IDLE_SLEEP_MS = 1;
+    const int SHARED_EVENT_ACTIVE_TIMEOUT_MS = 10000;
+
+    /* File state cache */
+    const int FILE_STATE_RACY_WINDOW_MS = 2000;
+
+    /* Config version history */
+    const unsigned int CONFIG_HISTORY_VERSIONS = 10;
+    const char* const CONFIG_HISTORY_FOLDER_SUFFIX = ".history";
+    const char* const CONFIG_HISTORY_BLOB_EXTENSION = ".ini";
+    const char* const CONFIG_HISTORY_MANIFEST = "history.json";
+
+    /* Zip archives */
+    const int ZIP_COMPRESSION_LEVEL = 6;
+    const int ZIP_LEVEL_ADAPTIVE = -1;
+    const unsigned int ZIP_IO_BUFFER_SIZE = 256 * 1024;
+    const unsigned int ZIP_PARALLEL_CHUNK_SIZE = 1024 * 1024;
+    const unsigned int ZIP_PENDING_CHUNKS_PER_THREAD = 2;
+    const unsigned int ZIP_MAX_THREADS = 8;
+    const unsigned int ZIP_PREALLOCATE_MIN_SIZE = 1024 * 1024;
+    const unsigned int ZIP_STREAM_PIPE_SIZE = 8 * 1024 * 1024;
+    const unsigned int ZIP_ADAPTIVE_SAMPLE_SIZE = 64 * 1024;
+    const unsigned int ZIP_ADAPTIVE_MIN_FILE_SIZE = 16 * 1024;
+    const double ZIP_ADAPTIVE_STORE_RATIO = 0.95;   // Sample barely shrinks: store it
+    const double ZIP_ADAPTIVE_FAST_RATIO = 0.80;    // Little to gain from harder levels
+    const char* const ZIP_STORED_EXTENSIONS[] = {
+        ".zip", ".7z", ".rar", ".gz", ".bz2", ".xz", ".zst", ".cab",
+        ".jpg", ".jpeg", ".png", ".gif", ".webp", ".mp4", ".avi", ".mkv", ".mov", ".mp3"
+    };
+
+    /* Model staging and switchover */
+    const char* const MODEL_PREVIOUS_SUFFIX = ".previous";
+    const char* const MODEL_REVERT_SUFFIX = ".reverting";
+    const int MODEL_PREVIOUS_RETENTION_MS = 30 * 60 * 1000;
+    const int MODEL_SWITCH_RETRIES = 10;            // The line may hold a file open for a moment
+    const int MODEL_SWITCH_RETRY_DELAY_MS = 50;
+    const unsigned int MODEL_UPLOAD_MAX_CONCURRENT = 2;
+
+    /* Model blob store */
+    const char* const MODEL_STORE_FOLDER_NAME = ".store";
+    const char* const MODEL_STORE_PROBE_NAME = "link.probe";
+    const char* const MODEL_STORE_LINK_SUFFIX = ".link";
+    const unsigned int MODEL_STORE_MIN_FILE_SIZE = 64 * 1024;
+
+    /* Model cache quota */
+    const char* const MODEL_USAGE_FILE = "model_usage.json";
+    const long long MODEL_CACHE_MIN_IDLE_MS = 60LL * 60 * 1000;   // Recently deployed models are not evicted
+    const unsigned int MODEL_CACHE_EVICTIONS_PER_SYNC = 1;
+
+    /* Model peer distribution */
+    const char* const MODEL_PEER_BLOB_PATH = "/blobs/";
+    const unsigned int MODEL_PEER_MAX_CONNECTIONS = 4;   // More get 503 and try another peer
+    const unsigned int MODEL_PEER_ATTEMPTS = 2;          // Peers tried per file before the server
+    const unsigned int MODEL_PEER_MAX_FAILURES = 2;      // In a row; the peer is then skipped for this upload
+    const int MODEL_PEER_TIMEOUT_MS = 3000;
+    const int MODEL_PEER_ACCEPT_RETRY_MS = 100;
+    const size_t MODEL_PEER_REQUEST_MAX = 4096;
+    const size_t MODEL_PEER_SEND_BUFFER = 64 * 1024;
+
+    /* Model inventory */
+    const int MODEL_INVENTORY_RESCAN_MS = 10 * 60 * 1000;   // Catches edits a folder without change notifications hides
+    const unsigned int MODEL_SYNC_FORCE_PERIODS = 60;         // Unchanged inventory is posted again after this many syncs
+
+    /* Model manifest */
+    const char* const MODEL_MANIFEST_CACHE_FILE = "model_manifest.cache";
+    const unsigned int MODEL_MANIFEST_CACHE_VERSION = 2;
+    const unsigned int MODEL_MANIFEST_MAX_THREADS = 4;
+
+    /* Folder deletion */
+    const size_t DELETE_BATCH_FILES = 256;
+    const size_t DELETE_MAX_THREADS = 4;
+    const int DELETE_RETRIES = 5;
+    const int DELETE_RETRY_DELAY_MS = 20;
+    const char* const DELETE_TRASH_SUFFIX = ".deleting-";
+
     /* Buffer sizes */
     const int MAX_PATH_LENGTH = 260;
     const int MAX_HOSTNAME_LENGTH = 256;
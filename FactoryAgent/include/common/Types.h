@@ -13,6 +13,10 @@ struct AgentSettings {
     std::string modelFolderPath;
     std::string modelVersion;
     std::string ipAddress;       // <--- THIS WAS MISSING
+    std::string sharedEventChannel;  // Shared-memory ring name; empty disables it
+    unsigned long long modelQuotaMB; // Disk budget for the model folder; 0 disables eviction
+    int modelPeerPort;               // Serves model blobs to other agents on the line; 0 disables it
+    bool eventStreamEnabled;         // Streams barrel events; needs a server with the barrelevents endpoint
     std::wstring serverUrl;
     std::wstring exeName;
 
@@ -21,6 +25,9 @@ struct AgentSettings {
         lineNumber = 0;
         pcNumber = 0;
         modelVersion = "3.5";
+        modelQuotaMB = 0;
+        modelPeerPort = 0;
+        eventStreamEnabled = false;
         ipAddress = "";          // Initialize it
     }
 };
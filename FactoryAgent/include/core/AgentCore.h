@@ -16,6 +16,11 @@ class HeartbeatService;
 class CommandExecutor;
 class ConfigService;
 class LogService;
+class LogSearchService;
+class LiveLogService;
+class EventStreamService;
+class SharedEventService;
+class LogArchiveService;
 class ModelService;
 class ConfigManager;
 class ProcessMonitor;
@@ -40,6 +45,11 @@ private:
     CommandExecutor* commandExecutor_;
     ConfigService* configService_;
     LogService* logService_;
+    LogSearchService* logSearchService_;
+    LiveLogService* liveLogService_;
+    EventStreamService* eventStreamService_;
+    SharedEventService* sharedEventService_;
+    LogArchiveService* logArchiveService_;
     ModelService* modelService_;
     ConfigManager* configManager_;
     ProcessMonitor* processMonitor_;
@@ -0,0 +1,77 @@
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+/*
+ * AnomalyDetector.h
+ * Online cycle-time anomaly detection
+ * Every operation, and the per-barrel total cycle time, has an EWMA
+ * mean/variance series. A sample is flagged when it exceeds idealMs by
+ * ANOMALY_IDEAL_FACTOR, or sits more than ANOMALY_Z_THRESHOLD deviations
+ * and ANOMALY_MIN_EXCESS_RATIO above the recent mean. State is
+ * O(operations) plus a bounded set of barrels still in progress.
+ */
+
+#include "CycleTimeTracker.h"
+#include "../../third_party/json/json.hpp"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+
+struct AnomalyEvent {
+    std::string type;          // "OverIdeal", "Outlier" or "BarrelCycle"
+    std::string operation;
+    long long barrelId;
+    long long timeMs;
+    long long durationMs;
+    double expectedMs;
+    long long idealMs;
+    double zScore;
+
+    AnomalyEvent() {
+        barrelId = 0;
+        timeMs = 0;
+        durationMs = 0;
+        expectedMs = 0.0;
+        idealMs = 0;
+        zScore = 0.0;
+    }
+};
+
+class AnomalyDetector {
+public:
+    AnomalyDetector();
+
+    void Add(const CycleSample& sample, std::vector<AnomalyEvent>& events);
+    void Reset();
+
+    static json ToJson(const AnomalyEvent& event);
+
+private:
+    struct Series {
+        double mean;
+        double variance;
+        unsigned long long count;
+        long long lastEventMs;
+        bool hasEvent;
+    };
+
+    struct BarrelSpan {
+        long long firstStartMs;
+        long long lastEndMs;
+    };
+
+    std::map<std::string, Series> series_;
+    Series barrelSeries_;
+    std::unordered_map<long long, BarrelSpan> barrels_;
+    long long lastSweepMs_;
+
+    static void InitSeries(Series& series);
+    static bool Observe(Series& series, double value, double& zScore);
+    static bool CoolingDown(Series& series, long long timeMs);
+    void SweepBarrels(long long nowMs, std::vector<AnomalyEvent>& events);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef BARREL_EVENT_BATCH_H
+#define BARREL_EVENT_BATCH_H
+
+/*
+ * BarrelEventBatch.h
+ * Binary encoding of START/END barrel events for the live event stream
+ * Layout: fixed header, log name, operation dictionary, then one row per
+ * event of varints (time and barrel id as zigzag deltas from the previous
+ * row, operation index, kind, duration + 1, ideal + 1; 0 means absent).
+ * The header names the log (by head hash) and the byte range of it the
+ * batch covers, so the server can drop a batch it has already applied.
+ */
+
+#include "../utilities/LogRecordScanner.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#pragma pack(push, 1)
+struct BarrelEventBatchHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    int32_t pcId;
+    uint32_t eventCount;
+    uint64_t sequence;
+    uint64_t logHeadHash;
+    uint32_t logHeadBytes;
+    uint32_t logNameBytes;
+    uint64_t startOffset;       // Log bytes [startOffset, endOffset) produced this batch
+    uint64_t endOffset;
+    int64_t baseTimeMs;
+};
+#pragma pack(pop)
+
+struct BarrelEvent {
+    long long timeMs;
+    long long barrelId;
+    LogEvent event;
+    long long durationMs;       // END only, -1 when unknown
+    long long idealMs;          // -1 when absent
+};
+
+class BarrelEventBatch {
+public:
+    BarrelEventBatch();
+
+    void Reset(const std::string& logName, uint64_t logHeadHash, uint32_t logHeadBytes, uint64_t startOffset);
+    void Add(const BarrelEvent& event, std::string_view operation, uint64_t endOffset);
+    void Encode(int pcId, uint64_t sequence, std::string& out) const;
+
+    size_t GetCount() const;
+    const std::string& GetLogName() const;
+    uint64_t GetLogHeadHash() const;
+    uint32_t GetLogHeadBytes() const;
+    uint64_t GetEndOffset() const;
+
+    static bool ReadHeader(const std::string& data, BarrelEventBatchHeader& header, std::string& logName);
+
+private:
+    std::string logName_;
+    uint64_t logHeadHash_;
+    uint32_t logHeadBytes_;
+    uint64_t startOffset_;
+    uint64_t endOffset_;
+    std::vector<std::string> operations_;
+    std::unordered_map<std::string, uint32_t> operationIndex_;
+    std::string rows_;
+    long long baseTimeMs_;
+    long long previousTimeMs_;
+    long long previousBarrelId_;
+    size_t count_;
+    std::string key_;
+};
+
+#endif
\ No newline at end of file
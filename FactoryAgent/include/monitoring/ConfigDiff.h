@@ -0,0 +1,49 @@
+#ifndef CONFIG_DIFF_H
+#define CONFIG_DIFF_H
+
+/*
+ * ConfigDiff.h
+ * Key-level changes between two parsed config versions
+ * Sections whose hashes match are skipped without looking at their keys,
+ * so the cost follows the number of changed sections. Key order,
+ * comments, formatting and repeated keys (only the first counts) do not
+ * produce changes.
+ */
+
+#include "../utilities/IniDocument.h"
+#include "../../third_party/json/json.hpp"
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+enum ConfigChangeType {
+    CONFIG_KEY_ADDED,
+    CONFIG_KEY_REMOVED,
+    CONFIG_KEY_CHANGED
+};
+
+struct ConfigChange {
+    ConfigChangeType type;
+    std::string section;
+    std::string key;
+    std::string oldValue;
+    std::string newValue;
+};
+
+class ConfigDiff {
+public:
+    static void Compare(const IniDocument& before, const IniDocument& after, std::vector<ConfigChange>& changes);
+
+    // [section, key, old, new]; old is null for an added key, new is null for a removed one
+    static json ToJson(const std::vector<ConfigChange>& changes);
+
+private:
+    static size_t MatchSection(const IniDocument& document, size_t position, const std::string& name);
+    static void CompareSection(const IniDocument& before, size_t beforeSection,
+        const IniDocument& after, size_t afterSection, std::vector<ConfigChange>& changes);
+
+    ConfigDiff();
+};
+
+#endif
\ No newline at end of file
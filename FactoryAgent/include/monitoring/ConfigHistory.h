@@ -0,0 +1,46 @@
+#ifndef CONFIG_HISTORY_H
+#define CONFIG_HISTORY_H
+
+/*
+ * ConfigHistory.h
+ * Ring of the last CONFIG_HISTORY_VERSIONS applied config versions
+ * Versions live next to the config in <config>.history\, each stored once
+ * under its XXH64 content hash, so rolling back never needs the server.
+ * history.json lists the ring, newest last; blobs that fall out of the
+ * ring are deleted.
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ConfigVersion {
+    std::string hash;
+    unsigned long long size;
+    long long savedAtMs;
+    std::string source;
+};
+
+class ConfigHistory {
+public:
+    ConfigHistory();
+
+    static std::string GetHistoryFolder(const std::string& configPath);
+
+    // Appends the content unless it already is the newest version
+    bool Record(const std::string& configPath, const std::string& content, const std::string& source);
+    bool Load(const std::string& configPath, std::vector<ConfigVersion>& versions);
+
+    // Fails when the stored blob no longer matches its hash
+    bool ReadVersion(const std::string& configPath, const std::string& hash, std::string& content);
+
+private:
+    static std::string GetBlobPath(const std::string& configPath, const std::string& hash);
+    static std::string GetManifestPath(const std::string& configPath);
+    bool Save(const std::string& configPath, const std::vector<ConfigVersion>& versions);
+
+    ConfigHistory(const ConfigHistory&);
+    ConfigHistory& operator=(const ConfigHistory&);
+};
+
+#endif
\ No newline at end of file
@@ -4,10 +4,42 @@
 /*
  * ConfigManager.h
  * Parses and manipulates config files
+ * The model settings are read and edited through an IniDocument that is
+ * only re-parsed when the config content changes
+ * Services read config.ini through one shared, stat-gated snapshot
+ * Writes go to a temp file that is flushed and renamed over the config,
+ * and every applied version is kept in a ConfigHistory for rollback
+ * Edits, writes and rollbacks hold one lock, so model uploads finishing on
+ * their own threads cannot interleave with commands on the worker thread
  */
 
+#include "ConfigHistory.h"
+#include "FileStateCache.h"
+#include "../utilities/IniDocument.h"
 #include <string>
 #include <map>
+#include <memory>
+#include <mutex>
+
+struct ConfigSnapshot {
+    std::shared_ptr<const FileSnapshot> file;
+    IniDocument document;
+    std::string currentModel;
+};
+
+struct ConfigRollbackResult {
+    std::string fromHash;
+    std::string toHash;
+    int steps;
+    unsigned long long switchUs;   // Temp write, flush and rename
+    unsigned long long totalUs;
+
+    ConfigRollbackResult() {
+        steps = 0;
+        switchUs = 0;
+        totalUs = 0;
+    }
+};
 
 class ConfigManager {
 public:
@@ -20,14 +52,43 @@ public:
     std::string GetValue(const std::string& key) const;
     void SetValue(const std::string& key, const std::string& value);
 
+    // The snapshot is shared and immutable; it is rebuilt only when the file content changes
+    bool GetConfigSnapshot(const std::string& filePath, std::shared_ptr<const ConfigSnapshot>& snapshot);
+
     bool ParseConfigFile(const std::string& filePath, std::string& content);
-    bool WriteConfigFile(const std::string& filePath, const std::string& content);
+    bool WriteConfigFile(const std::string& filePath, const std::string& content, const std::string& source = "agent");
+
+    // Restores the version `steps` back in the history, or the one with the given hash
+    bool RollbackConfig(const std::string& filePath, int steps, const std::string& hash,
+        ConfigRollbackResult& result, std::string& error);
+    bool GetConfigVersions(const std::string& filePath, std::vector<ConfigVersion>& versions);
 
     std::string GetCurrentModel(const std::string& configContent);
     bool UpdateCurrentModel(std::string& configContent, const std::string& modelName, const std::string& modelPath);
 
+    // Reads, edits and writes the config as one step, so no concurrent change is lost
+    bool SetCurrentModel(const std::string& filePath, const std::string& modelName, const std::string& modelPath,
+        const std::string& source);
+
 private:
     std::map<std::string, std::string> settings_;
+    IniDocument document_;
+    bool documentParsed_;
+    FileStateCache fileCache_;
+    ConfigHistory history_;
+    std::mutex snapshotMutex_;
+    std::shared_ptr<const ConfigSnapshot> snapshot_;
+    std::string snapshotPath_;
+    std::mutex configMutex_;   // Guards document_, config writes and the history
+
+    // Callers hold configMutex_
+    IniDocument& GetDocument(const std::string& configContent);
+    bool EditCurrentModel(std::string& configContent, const std::string& modelName, const std::string& modelPath);
+    bool WriteLocked(const std::string& filePath, const std::string& content, const std::string& source);
+    void RecordCurrent(const std::string& filePath);
+
+    ConfigManager(const ConfigManager&);
+    ConfigManager& operator=(const ConfigManager&);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,104 @@
+#ifndef CRITICAL_PATH_ANALYZER_H
+#define CRITICAL_PATH_ANALYZER_H
+
+/*
+ * CriticalPathAnalyzer.h
+ * Where a barrel's cycle time goes
+ * Completed operation samples are grouped per barrel in one streaming
+ * pass. A barrel closes when it has been idle for a while (or at the end
+ * of input), and then gets its busy/idle split, a parallelism factor and
+ * the critical path: the chain of operations, walked back from the last
+ * one to finish, that gated each next start. Bottleneck counts per
+ * operation are aggregated across all barrels.
+ */
+
+#include "CycleTimeTracker.h"
+#include "../../third_party/json/json.hpp"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+
+struct OperationInterval {
+    std::string operation;
+    long long startMs;
+    long long endMs;
+};
+
+struct CriticalPathStep {
+    std::string operation;
+    long long startMs;
+    long long durationMs;
+    long long contributionMs;  // Share of the barrel span this step accounts for
+    long long gapBeforeMs;     // Idle time between the previous step and this one
+};
+
+struct BarrelAnalysis {
+    long long barrelId;
+    long long startMs;
+    long long endMs;
+    long long busyMs;          // Time with at least one operation running
+    long long idleMs;
+    long long workMs;          // Sum of all operation durations
+    double parallelism;        // workMs / busyMs
+    size_t operationCount;
+    bool truncated;
+    std::vector<CriticalPathStep> criticalPath;
+    std::string bottleneck;
+
+    BarrelAnalysis() {
+        barrelId = 0;
+        startMs = 0;
+        endMs = 0;
+        busyMs = 0;
+        idleMs = 0;
+        workMs = 0;
+        parallelism = 0.0;
+        operationCount = 0;
+        truncated = false;
+    }
+};
+
+class CriticalPathAnalyzer {
+public:
+    CriticalPathAnalyzer(size_t maxBarrelDetails);
+
+    void Add(const CycleSample& sample);
+    void Finish();
+    json ToJson() const;
+
+    static BarrelAnalysis Analyze(long long barrelId, std::vector<OperationInterval>& intervals);
+
+private:
+    struct OpenBarrel {
+        std::vector<OperationInterval> intervals;
+        long long lastEndMs;
+        bool truncated;
+    };
+
+    struct OperationTotals {
+        unsigned long long samples;
+        unsigned long long onCriticalPath;
+        unsigned long long bottleneckCount;
+        long long criticalMs;
+        long long gapBeforeMs;
+    };
+
+    std::unordered_map<long long, OpenBarrel> open_;
+    std::map<std::string, OperationTotals> totals_;
+    std::vector<BarrelAnalysis> details_;
+    size_t maxBarrelDetails_;
+    size_t barrelsAnalyzed_;
+    long long lastSweepMs_;
+    long long totalSpanMs_;
+    long long totalBusyMs_;
+    long long totalIdleMs_;
+    long long totalWorkMs_;
+
+    void Close(long long barrelId, OpenBarrel& barrel);
+    void Sweep(long long nowMs);
+};
+
+#endif
\ No newline at end of file
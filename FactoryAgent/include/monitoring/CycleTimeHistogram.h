@@ -0,0 +1,46 @@
+#ifndef CYCLE_TIME_HISTOGRAM_H
+#define CYCLE_TIME_HISTOGRAM_H
+
+/*
+ * CycleTimeHistogram.h
+ * Fixed-size log-linear histogram of durations in milliseconds
+ * Values below 128 ms are exact; above that each power of two is split
+ * into 64 buckets, so any percentile is within 1/128 of the true value.
+ * Memory does not grow with the number of recorded samples.
+ */
+
+#include <cstdint>
+#include <cstddef>
+
+class CycleTimeHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 6;
+    static const int SUB_BUCKET_HALF = 1 << SUB_BUCKET_BITS;
+    static const int SUB_BUCKET_COUNT = SUB_BUCKET_HALF * 2;
+    static const int MAX_VALUE_BITS = 31;
+    static const int BUCKET_COUNT = SUB_BUCKET_COUNT + (MAX_VALUE_BITS - SUB_BUCKET_BITS - 1) * SUB_BUCKET_HALF;
+
+    CycleTimeHistogram();
+
+    void Clear();
+    void Record(long long valueMs);
+    void Merge(const CycleTimeHistogram& other);
+
+    unsigned long long GetCount() const;
+    double GetMean() const;
+    long long GetMin() const;
+    long long GetMax() const;
+    long long GetPercentile(double percentile) const;
+
+    static size_t GetBucketIndex(long long valueMs);
+    static long long GetBucketValue(size_t index);
+
+private:
+    uint32_t counts_[BUCKET_COUNT];
+    unsigned long long count_;
+    double sum_;
+    long long min_;
+    long long max_;
+};
+
+#endif
\ No newline at end of file
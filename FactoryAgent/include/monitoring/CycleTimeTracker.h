@@ -0,0 +1,55 @@
+#ifndef CYCLE_TIME_TRACKER_H
+#define CYCLE_TIME_TRACKER_H
+
+/*
+ * CycleTimeTracker.h
+ * Turns START/END log records into completed operation samples
+ * The duration comes from the END payload's startTs/endTs when present,
+ * otherwise from the matching START line of the same sequence and barrel.
+ */
+
+#include "../utilities/LogRecordScanner.h"
+#include <string>
+#include <unordered_map>
+
+struct CycleSample {
+    std::string operation;
+    long long barrelId;
+    long long timeMs;        // END line time (naive local ms)
+    long long durationMs;
+    long long idealMs;
+    bool hasIdeal;
+
+    CycleSample() {
+        barrelId = 0;
+        timeMs = 0;
+        durationMs = 0;
+        idealMs = 0;
+        hasIdeal = false;
+    }
+};
+
+class CycleTimeTracker {
+public:
+    CycleTimeTracker();
+
+    // Returns true when the record completes an operation
+    bool Process(const LogRecord& record, CycleSample& sample);
+    bool Process(LogEvent event, std::string_view operation, long long timeMs,
+        const LogPayload& payload, CycleSample& sample);
+    void Reset();
+
+private:
+    struct PendingStart {
+        long long timeMs;
+        long long idealMs;
+        bool hasIdeal;
+    };
+
+    std::unordered_map<std::string, PendingStart> pending_;
+    std::string key_;
+
+    void PrunePending(long long nowMs);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef FILE_STATE_CACHE_H
+#define FILE_STATE_CACHE_H
+
+/*
+ * FileStateCache.h
+ * Stat-gated snapshots of small files (config.ini)
+ * Each refresh compares the file's size, full last-write time and file ID
+ * with the cached stamp; only when they moved is the file read and
+ * hashed. A new snapshot is published only when the hash changed, so an
+ * unchanged file costs one metadata query and no reads. A file written
+ * within FILE_STATE_RACY_WINDOW_MS of the stamp is re-read once more,
+ * since a same-size edit inside one timestamp tick would not show.
+ */
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <windows.h>
+
+struct FileStamp {
+    uint64_t size;
+    uint64_t writeTime;        // FILETIME, 100 ns ticks
+    uint64_t volume;
+    uint64_t fileIndex;
+
+    FileStamp() {
+        size = 0;
+        writeTime = 0;
+        volume = 0;
+        fileIndex = 0;
+    }
+};
+
+struct FileSnapshot {
+    std::string content;
+    uint64_t hash;
+    unsigned long long generation;  // Bumped whenever the content changes
+};
+
+class FileStateCache {
+public:
+    FileStateCache();
+    ~FileStateCache();
+
+    bool Refresh(const std::string& filePath, std::shared_ptr<const FileSnapshot>& snapshot);
+
+    // Records content the agent itself just wrote, so it is not read back
+    void Store(const std::string& filePath, const std::string& content);
+    void Invalidate(const std::string& filePath);
+
+private:
+    struct Entry {
+        FileStamp stamp;
+        bool racy;
+        std::shared_ptr<const FileSnapshot> snapshot;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, Entry> entries_;
+    unsigned long long generation_;
+
+    static HANDLE OpenForStamp(const std::string& filePath);
+    static bool ReadStamp(HANDLE file, FileStamp& stamp);
+    static bool SameStamp(const FileStamp& a, const FileStamp& b);
+    static bool IsRacy(const FileStamp& stamp);
+    void Publish(Entry& entry, const FileStamp& stamp, std::string& content);
+
+    FileStateCache(const FileStateCache&);
+    FileStateCache& operator=(const FileStateCache&);
+};
+
+#endif
\ No newline at end of file
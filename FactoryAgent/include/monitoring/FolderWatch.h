@@ -0,0 +1,46 @@
+#ifndef FOLDER_WATCH_H
+#define FOLDER_WATCH_H
+
+/*
+ * FolderWatch.h
+ * Tells whether anything under a folder changed since the last check
+ * A change notification over the whole subtree makes a check one
+ * non-blocking wait. Where notifications are not available (some network
+ * shares) the folder's own last-write time is compared instead; it moves
+ * when entries directly inside are added, removed or renamed, so deeper
+ * edits are left to the caller's periodic rescan.
+ */
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <windows.h>
+
+class FolderWatch {
+public:
+    FolderWatch();
+    ~FolderWatch();
+
+    // False when only the last-write time check is available
+    bool Open(const std::string& folderPath);
+    void Close();
+
+    // True once per batch of changes; the first check after Open is always true
+    bool HasChanged();
+    bool IsNotifying();
+
+private:
+    std::mutex mutex_;
+    std::string folderPath_;
+    HANDLE notification_;
+    uint64_t writeTime_;
+    bool changed_;
+
+    bool StartNotification();
+    static uint64_t GetWriteTime(const std::string& folderPath);
+
+    FolderWatch(const FolderWatch&);
+    FolderWatch& operator=(const FolderWatch&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,129 @@
+#ifndef LOG_ARCHIVE_H
+#define LOG_ARCHIVE_H
+
+/*
+ * LogArchive.h
+ * Columnar archive of a closed log (<log>.fcol)
+ * Lines are grouped into blocks. Within a block, timestamps are stored as
+ * deltas, the tab-separated fields and payload templates are dictionary
+ * encoded, and every number in the payload (barrel ids, timestamps,
+ * durations) goes to a per-slot column. All integer columns are
+ * frame-of-reference bit-packed. Lines that cannot round-trip exactly are
+ * kept verbatim, so the original text is always reconstructible.
+ * A trailing block index holds each block's time range for skipping.
+ */
+
+#include "../utilities/LogRecordScanner.h"
+#include "../utilities/MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#pragma pack(push, 1)
+struct LogArchiveHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize;
+    uint64_t headHash;
+    uint64_t lineCount;
+    uint32_t blockCount;
+    uint32_t reserved;
+    uint64_t indexOffset;
+};
+
+struct LogArchiveBlockEntry {
+    uint64_t blockOffset;
+    uint32_t blockSize;
+    uint32_t lineCount;
+    uint64_t textOffset;
+    uint64_t textSize;
+    int64_t minTimeMs;
+    int64_t maxTimeMs;
+};
+#pragma pack(pop)
+
+struct LogArchiveStats {
+    uint64_t sourceBytes;
+    uint64_t archiveBytes;
+    uint64_t lines;
+    uint64_t rawLines;
+    unsigned long long elapsedMs;
+
+    LogArchiveStats() {
+        sourceBytes = 0;
+        archiveBytes = 0;
+        lines = 0;
+        rawLines = 0;
+        elapsedMs = 0;
+    }
+};
+
+// A decoded START/END record; string views stay valid until the next read
+struct ArchivedEvent {
+    long long timeMs;
+    LogEvent event;
+    std::string_view operation;
+    LogPayload payload;
+};
+
+class LogArchive {
+public:
+    LogArchive();
+    ~LogArchive();
+
+    static bool IsArchiveFile(const std::string& filePath);
+    static std::string GetArchivePath(const std::string& logPath);
+    static bool Build(const std::string& logPath, LogArchiveStats& stats);
+
+    // Fails when the log still exists and no longer matches the archive
+    bool Open(const std::string& logPath);
+    void Close();
+
+    uint64_t GetSourceSize() const;
+    uint32_t GetBlockCount() const;
+    const LogArchiveBlockEntry& GetBlock(uint32_t block) const;
+
+    bool ReadEvents(uint32_t block, std::vector<ArchivedEvent>& events);
+    bool ReadText(uint32_t block, std::string& text);
+    bool Reconstruct(std::string& text);
+
+private:
+    struct PayloadSlots {
+        int slot[4];           // barrelId, startTs, endTs, idealMs; -1 when constant
+        bool negate[4];
+        long long constant[4];
+        bool present[4];
+        bool valid;
+    };
+
+    struct DecodedBlock {
+        std::vector<long long> flags;
+        std::vector<long long> times;
+        std::vector<std::string> timeStrings;
+        std::vector<std::string> dictionaries[AgentConstants::LOG_FIELD_COUNT];
+        std::vector<long long> ids[AgentConstants::LOG_FIELD_COUNT];
+        std::vector<std::vector<long long> > slots;
+        std::vector<std::string> rawLines;
+    };
+
+    MappedFile file_;
+    const LogArchiveHeader* header_;
+    const LogArchiveBlockEntry* blocks_;
+    DecodedBlock decoded_;
+    std::vector<PayloadSlots> templateSlots_;
+    std::vector<LogEvent> eventKinds_;
+
+    struct BlockBuilder;
+
+    bool OpenArchive(const std::string& archivePath);
+    bool Decode(uint32_t block);
+
+    static bool MapPayloadSlots(const std::string& payloadTemplate, PayloadSlots& slots);
+    static void FillPayload(const PayloadSlots& slots, const long long* values, size_t valueCount, LogPayload& payload);
+
+    LogArchive(const LogArchive&);
+    LogArchive& operator=(const LogArchive&);
+};
+
+#endif
\ No newline at end of file
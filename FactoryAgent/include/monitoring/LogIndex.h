@@ -0,0 +1,76 @@
+#ifndef LOG_INDEX_H
+#define LOG_INDEX_H
+
+/*
+ * LogIndex.h
+ * Sidecar index for a single log file (<log>.fidx)
+ * Maps barrelId -> byte range and keeps a sparse time -> offset table.
+ * The file is a fixed little-endian layout that is used straight from a
+ * memory mapping; it is extended incrementally as the log grows and
+ * rebuilt from scratch whenever it no longer matches its log.
+ */
+
+#include <string>
+#include <cstdint>
+#include "../utilities/MappedFile.h"
+
+#pragma pack(push, 8)
+struct LogIndexHeader {
+    char magic[4];              // "FLIX"
+    uint32_t version;
+    uint64_t indexedSize;       // Log bytes covered, always ends on a line boundary
+    uint64_t headHash;          // Hash of the first bytes, detects a replaced log
+    uint32_t barrelCount;
+    uint32_t timeMarkCount;
+    uint64_t barrelTableOffset;
+    uint64_t timeTableOffset;
+};
+
+struct LogIndexBarrelEntry {
+    int64_t barrelId;
+    uint64_t beginOffset;       // First line mentioning the barrel
+    uint64_t endOffset;         // End of the last line mentioning the barrel
+    uint32_t lineCount;
+    uint32_t reserved;
+};
+
+struct LogIndexTimeMark {
+    int64_t timeMs;             // Naive ms from LogRecordScanner::ParseDateTime
+    uint64_t offset;
+};
+#pragma pack(pop)
+
+class LogIndex {
+public:
+    LogIndex();
+    ~LogIndex();
+
+    static bool IsLogFile(const std::string& filePath);
+    static bool IsIndexFile(const std::string& filePath);
+    static std::string GetIndexPath(const std::string& logPath);
+    static bool Update(const std::string& logPath);
+    static bool Rebuild(const std::string& logPath);
+
+    // FNV-1a over the head of a log; only used to notice replacement
+    static uint64_t HashHead(const char* data, size_t size);
+
+    bool Open(const std::string& logPath);
+    void Close();
+
+    uint64_t GetIndexedSize() const;
+    bool FindBarrel(long long barrelId, LogIndexBarrelEntry& entry) const;
+    bool FindTimeRange(long long fromMs, long long toMs, uint64_t& beginOffset, uint64_t& endOffset) const;
+
+private:
+    MappedFile file_;
+    const LogIndexHeader* header_;
+    const LogIndexBarrelEntry* barrels_;
+    const LogIndexTimeMark* timeMarks_;
+
+    static bool Build(const std::string& logPath, bool incremental);
+
+    LogIndex(const LogIndex&);
+    LogIndex& operator=(const LogIndex&);
+};
+
+#endif
\ No newline at end of file
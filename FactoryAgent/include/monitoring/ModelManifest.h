@@ -0,0 +1,83 @@
+#ifndef MODEL_MANIFEST_H
+#define MODEL_MANIFEST_H
+
+/*
+ * ModelManifest.h
+ * Per-file content manifest of a model folder
+ * Every file is listed with its relative path, size and XXH64; the root
+ * hash covers the sorted list, so two PCs report the same root exactly
+ * when their folders hold the same files. Hashes are cached by model
+ * folder name and relative path, with size and last-write time, and
+ * persisted, so only files that changed are read again, on low-priority
+ * workers. The key survives the rename of a staged folder into place.
+ * Files written within FILE_STATE_RACY_WINDOW_MS are hashed but not cached.
+ */
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ManifestFile {
+    std::string path;              // Relative to the model folder, '/' separated
+    uint64_t size;
+    uint64_t writeTime;            // file_time_type ticks
+    uint64_t hash;
+
+    ManifestFile() {
+        size = 0;
+        writeTime = 0;
+        hash = 0;
+    }
+};
+
+struct ModelManifest {
+    std::vector<ManifestFile> files;   // Sorted by path
+    uint64_t rootHash;
+    unsigned long long totalSize;
+    unsigned long long hashedBytes;    // Read for this build; 0 when everything was cached
+    size_t hashedFiles;
+
+    ModelManifest() {
+        rootHash = 0;
+        totalSize = 0;
+        hashedBytes = 0;
+        hashedFiles = 0;
+    }
+};
+
+class ModelManifestCache {
+public:
+    ModelManifestCache();
+    ~ModelManifestCache();
+
+    // A missing or unreadable cache only means every file is hashed once
+    void Load(const std::string& cachePath);
+
+    // Writes the cache when it changed, dropping files no build has listed since the last save
+    bool Save();
+
+    bool Build(const std::string& modelPath, ModelManifest& manifest, std::string& error);
+
+private:
+    struct CachedHash {
+        uint64_t size;
+        uint64_t writeTime;
+        uint64_t hash;
+        bool listed;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, CachedHash> entries_;   // Keyed by "<model folder>/<relative path>"
+    std::string cachePath_;
+    bool dirty_;
+
+    static bool HashFile(const std::string& filePath, uint64_t& size, uint64_t& hash);
+    static uint64_t ComputeRoot(const std::vector<ManifestFile>& files);
+
+    ModelManifestCache(const ModelManifestCache&);
+    ModelManifestCache& operator=(const ModelManifestCache&);
+};
+
+#endif
\ No newline at end of file
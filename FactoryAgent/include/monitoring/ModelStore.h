@@ -0,0 +1,97 @@
+#ifndef MODEL_STORE_H
+#define MODEL_STORE_H
+
+/*
+ * ModelStore.h
+ * Content-addressed blob store shared by the model folders
+ * Files of MODEL_STORE_MIN_FILE_SIZE and up (weights) are kept once under
+ * <store>\<xx>\<xxh64>-<size> and every model folder holding them gets a
+ * hardlink, or a copy where links are not possible. The NTFS link count is
+ * the reference count: a blob with no link besides its own is garbage.
+ * A blob is only shared after a byte comparison, so a 64-bit hash
+ * collision costs disk space, never a wrong file. Smaller files (params,
+ * templates an operator may edit in place) are never shared. Blobs are
+ * read-only, so an edit through one model folder fails instead of
+ * changing every model that links the blob.
+ */
+
+#include "ModelManifest.h"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+struct ModelStoreStats {
+    unsigned long long linkedFiles;    // Already in the store: linked, nothing new on disk
+    unsigned long long linkedBytes;
+    unsigned long long storedFiles;    // Moved into the store as new blobs
+    unsigned long long storedBytes;
+    unsigned long long copiedFiles;    // Could not be linked and were copied instead
+    unsigned long long freedFiles;     // Blobs collected as garbage
+    unsigned long long freedBytes;
+
+    ModelStoreStats() {
+        linkedFiles = 0;
+        linkedBytes = 0;
+        storedFiles = 0;
+        storedBytes = 0;
+        copiedFiles = 0;
+        freedFiles = 0;
+        freedBytes = 0;
+    }
+};
+
+class ModelStore {
+public:
+    ModelStore();
+    ~ModelStore();
+
+    // Creates the store if needed; false when the volume cannot hold hardlinks
+    bool Open(const std::string& storePath);
+    bool IsOpen();
+
+    static bool IsShared(uint64_t size);
+    static std::string GetBlobName(uint64_t hash, uint64_t size);
+
+    // Path and size of a blob the store holds; any other name is refused
+    bool FindBlob(const std::string& blobName, std::string& blobPath, uint64_t& size);
+
+    // Turns every shared-size file of the folder into a link to its blob,
+    // adding the blobs that are new
+    bool Ingest(const std::string& folderPath, const ModelManifest& manifest, ModelStoreStats& stats, std::string& error);
+
+    // Links (or copies) a blob to targetPath; false when the store does not hold it
+    bool Materialize(uint64_t hash, uint64_t size, const std::string& targetPath, ModelStoreStats& stats);
+
+    // Drops a blob whose content was found not to match its name
+    void Discard(uint64_t hash, uint64_t size);
+
+    // Bytes of the manifest's files that are not held in the store
+    unsigned long long GetPrivateBytes(const ModelManifest& manifest);
+
+    // Deletes blobs no model folder links to any more
+    void Collect(ModelStoreStats& stats);
+
+    unsigned long long GetStoredBytes();
+    size_t GetBlobCount();
+
+private:
+    std::mutex mutex_;
+    std::string storePath_;
+    bool isOpen_;
+    std::map<std::string, uint64_t> blobs_;   // Blob name to size
+    unsigned long long storedBytes_;
+
+    std::string GetBlobPath(const std::string& blobName);
+    bool LinkOrCopy(const std::string& blobPath, const std::string& targetPath, ModelStoreStats& stats);
+
+    static void Protect(const std::string& blobPath);
+    static bool SameFile(const std::string& a, const std::string& b);
+    static bool SameContent(const std::string& a, const std::string& b);
+    static unsigned int GetLinkCount(const std::string& filePath);
+
+    ModelStore(const ModelStore&);
+    ModelStore& operator=(const ModelStore&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef MODEL_USAGE_LOG_H
+#define MODEL_USAGE_LOG_H
+
+/*
+ * ModelUsageLog.h
+ * When each model was last activated, kept across restarts
+ * Orders least-recently-used eviction from the model folder. A model that
+ * was never seen activated counts from the first time it was seen.
+ * Names compare without case, like the folders they stand for.
+ */
+
+#include <map>
+#include <mutex>
+#include <string>
+
+class ModelUsageLog {
+public:
+    ModelUsageLog();
+    ~ModelUsageLog();
+
+    void Load(const std::string& logPath);
+
+    // Writes the log only when it changed
+    bool Save();
+
+    void Touch(const std::string& modelName);
+    void Forget(const std::string& modelName);
+
+    // Milliseconds since the epoch; records the current time for unknown models
+    long long GetLastActivated(const std::string& modelName);
+
+    static long long CurrentTimeMs();
+
+private:
+    struct NoCaseLess {
+        bool operator()(const std::string& a, const std::string& b) const;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, long long, NoCaseLess> lastActivated_;
+    std::string logPath_;
+    bool dirty_;
+
+    ModelUsageLog(const ModelUsageLog&);
+    ModelUsageLog& operator=(const ModelUsageLog&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef OPERATION_STATS_H
+#define OPERATION_STATS_H
+
+/*
+ * OperationStats.h
+ * Rolling per-operation cycle-time statistics
+ * Each operation keeps two fixed-size histograms (current and previous
+ * window, rotated on log time), so a summary covers the last one to two
+ * windows and memory per operation is constant.
+ */
+
+#include "CycleTimeHistogram.h"
+#include "CycleTimeTracker.h"
+#include "../../third_party/json/json.hpp"
+#include <map>
+#include <string>
+
+using json = nlohmann::json;
+
+class OperationStats {
+public:
+    OperationStats();
+
+    void Add(const CycleSample& sample);
+    void Reset();
+
+    // Compact summary for the heartbeat; empty when nothing was recorded
+    json BuildSummary();
+
+private:
+    struct Operation {
+        CycleTimeHistogram current;
+        CycleTimeHistogram previous;
+        long long windowIndex;
+        long long idealMs;
+        bool hasIdeal;
+    };
+
+    std::map<std::string, Operation> operations_;
+    long long latestWindow_;
+    unsigned long long droppedSamples_;
+
+    void Rotate(Operation& operation, long long windowIndex);
+};
+
+#endif
\ No newline at end of file
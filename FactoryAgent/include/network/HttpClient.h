@@ -15,6 +15,12 @@
 
 using json = nlohmann::json;
 
+// Fills buffer with the next part of a streamed body; size 0 ends the body, false aborts the request
+typedef bool (*HttpBodySource)(char* buffer, size_t capacity, size_t& size, void* userData);
+
+// Receives a response body as it arrives; false aborts the transfer
+typedef bool (*HttpBodySink)(const char* data, size_t size, void* userData);
+
 class HttpClient {
 public:
     HttpClient(const std::wstring& serverUrl);
@@ -22,10 +28,22 @@ public:
 
     bool Post(const std::wstring& endpoint, const json& data, json& response);
     bool Get(const std::wstring& endpoint, json& response);
+    bool PostBinary(const std::wstring& endpoint, const std::string& data, json& response);
     bool UploadFile(const std::wstring& endpoint, const std::string& filePath,
         const std::string& modelName, json& response);
     bool DownloadFile(const std::string& url, const std::string& outputPath);
 
+    // For other agents on the LAN: no proxy, and a host that does not answer
+    // within timeoutMs is given up on
+    bool DownloadFileDirect(const std::string& url, const std::string& outputPath, int timeoutMs);
+
+    // Hands the body of a successful GET to sink as it arrives
+    bool DownloadStream(const std::string& url, HttpBodySink sink, void* userData);
+
+    // Multipart upload sent with chunked transfer encoding, so the size need not be known up front
+    bool UploadStream(const std::wstring& endpoint, const std::string& fileName,
+        const std::string& modelName, HttpBodySource source, void* userData, json& response);
+
 private:
     std::wstring serverUrl_;
     std::wstring hostName_;
@@ -33,8 +51,11 @@ private:
     bool useHttps_;
 
     bool ParseUrl();
+    bool DownloadStream(const std::string& url, HttpBodySink sink, void* userData, bool direct, int timeoutMs);
     bool SendRequest(const std::wstring& method, const std::wstring& endpoint,
         const std::string& data, std::string& response);
+    bool SendRequest(const std::wstring& method, const std::wstring& endpoint,
+        const std::wstring& contentType, const std::string& data, std::string& response);
 };
 
 #endif
\ No newline at end of file
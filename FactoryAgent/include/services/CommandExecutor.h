@@ -15,10 +15,11 @@ using json = nlohmann::json;
 class HttpClient;
 class ConfigService;
 class ModelService;
+class LogSearchService;
 
 class CommandExecutor {
 public:
-    CommandExecutor(HttpClient* client, ConfigService* configSvc, ModelService* modelSvc);
+    CommandExecutor(HttpClient* client, ConfigService* configSvc, ModelService* modelSvc, LogSearchService* searchSvc);
     ~CommandExecutor();
 
     void ProcessCommands(const json& commands);
@@ -27,10 +28,12 @@ private:
     HttpClient* httpClient_;
     ConfigService* configService_;
     ModelService* modelService_;
+    LogSearchService* logSearchService_;
 
     bool ExecuteCommand(const json& command);
     void SendCommandResult(int commandId, const CommandResult& result);
     std::string GetLogFolderPath(); // Helper for log analyzer
+    std::string ResolveLogFilePath(const std::string& filePath);
 
 
     CommandExecutor(const CommandExecutor&);
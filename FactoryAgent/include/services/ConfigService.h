@@ -5,6 +5,8 @@
  * ConfigService.h
  * Handles configuration operations
  * Single Responsibility: Config management only
+ * The server gets the whole config once, then only key-level changes
+ * against the last version it acknowledged
  */
 
 #include "../common/Types.h"
@@ -22,12 +24,15 @@ public:
 
     void SyncConfigToServer();
     bool ApplyConfigFromServer(const std::string& content);
+    bool RollbackConfig(const json& data, std::string& resultData, std::string& error);
 
 private:
     AgentSettings* settings_;
     HttpClient* httpClient_;
     ConfigManager* configManager_;
-    std::string lastConfigContent_;
+    std::shared_ptr<const ConfigSnapshot> baseline_;  // Last version the server has
+
+    bool UploadFullConfig(const FileSnapshot& file);
 
     ConfigService(const ConfigService&);
     ConfigService& operator=(const ConfigService&);
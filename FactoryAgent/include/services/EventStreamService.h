@@ -0,0 +1,112 @@
+#ifndef EVENT_STREAM_SERVICE_H
+#define EVENT_STREAM_SERVICE_H
+
+/*
+ * EventStreamService.h
+ * Near real-time barrel event stream to the server
+ * The live log tailer publishes START/END events; they are batched by
+ * count or by a latency deadline and posted in binary form. While the
+ * server is slow, sealed batches queue in memory and then spill to an
+ * on-disk spool; once the spool is full new events are dropped and
+ * counted, and the tailer keeps reading for the statistics. A
+ * checkpoint records the log offset up
+ * to which events are durable (acknowledged or spooled), and the tailer
+ * resumes there after a restart. A spooled batch that cannot be read
+ * back is deleted and counted as dropped.
+ */
+
+#include "../common/Types.h"
+#include "../monitoring/BarrelEventBatch.h"
+#include "../../third_party/json/json.hpp"
+#include <deque>
+#include <mutex>
+#include <string>
+#include <windows.h>
+
+using json = nlohmann::json;
+
+class HttpClient;
+
+class EventStreamService {
+public:
+    EventStreamService(AgentSettings* settings, HttpClient* client);
+    ~EventStreamService();
+
+    bool Start();
+    void Stop();
+
+    // Log position after the last durable event, if any
+    bool GetResumePoint(std::string& logPath, uint64_t& offset, uint64_t& headHash, uint32_t& headBytes);
+
+    void Publish(const std::string& logPath, uint64_t headHash, uint32_t headBytes,
+        const BarrelEvent& event, std::string_view operation, uint64_t recordOffset, uint64_t endOffset);
+
+    // Spool depth, events dropped while the spool was full and the
+    // batches lost to unreadable spool files
+    json GetStats();
+
+private:
+    struct SealedBatch {
+        uint64_t sequence;
+        std::string data;
+        std::string logPath;
+        uint64_t headHash;
+        uint32_t headBytes;
+        uint64_t endOffset;
+    };
+
+    enum SendResult {
+        SEND_IDLE,
+        SEND_OK,
+        SEND_FAILED
+    };
+
+    struct SpoolEntry {
+        uint64_t sequence;
+        std::string path;
+        uint64_t bytes;
+    };
+
+    AgentSettings* settings_;
+    HttpClient* httpClient_;
+    HANDLE senderThread_;
+    bool isRunning_;
+
+    std::mutex mutex_;
+    BarrelEventBatch batch_;
+    ULONGLONG batchStartTick_;
+    std::string lastLogPath_;
+    uint64_t lastEndOffset_;
+    std::deque<SealedBatch> memory_;
+    size_t memoryBytes_;
+    std::deque<SpoolEntry> spool_;
+    uint64_t spoolBytes_;
+    uint64_t nextSequence_;
+    uint64_t droppedEvents_;
+    uint64_t droppedBatches_;
+    uint64_t droppedBytes_;
+
+    // Durable position, persisted in the checkpoint file
+    std::string durableLog_;
+    uint64_t durableOffset_;
+    uint64_t durableHeadHash_;
+    uint32_t durableHeadBytes_;
+    uint64_t durableSequence_;
+
+    static DWORD WINAPI SenderThreadFunc(LPVOID param);
+    void SenderLoop();
+    SendResult SendNext();
+
+    void LoadState();
+    bool IsSaturatedLocked() const;
+    void SealLocked();
+    void SpillLocked();
+    void MarkDurableLocked(const SealedBatch& batch);
+    void SaveCheckpointLocked();
+    std::string GetSpoolPath(uint64_t sequence) const;
+
+    EventStreamService(const EventStreamService&);
+    EventStreamService& operator=(const EventStreamService&);
+};
+
+#endif
\ No newline at end of file
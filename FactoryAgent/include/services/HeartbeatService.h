@@ -12,10 +12,11 @@ public:
     HeartbeatService();
     ~HeartbeatService();
 
-    bool SendHeartbeat(int pcId, bool isAppRunning, HttpClient* client, json* commands);
+    bool SendHeartbeat(int pcId, bool isAppRunning, const json& cycleStats, const json& archiveStats,
+        HttpClient* client, json* commands);
 
 private:
-    json BuildHeartbeatRequest(int pcId, bool isAppRunning);
+    json BuildHeartbeatRequest(int pcId, bool isAppRunning, const json& cycleStats, const json& archiveStats);
     bool ParseHeartbeatResponse(const json& response, json* commands);
 
     HeartbeatService(const HeartbeatService&);
@@ -0,0 +1,94 @@
+#ifndef LIVE_LOG_SERVICE_H
+#define LIVE_LOG_SERVICE_H
+
+/*
+ * LiveLogService.h
+ * Follows the active log as it is written
+ * A background thread picks the most recently written log under the log
+ * folder, reads only the appended complete lines and feeds them to the
+ * cycle-time tracker, per-operation statistics and anomaly detector.
+ * Anomalies are queued for the agent's worker thread to post, and every
+ * START/END event goes to the barrel event stream when it is enabled. Events arriving over
+ * the shared-memory channel take over the statistics while it is active.
+ */
+
+#include "../common/Types.h"
+#include "../monitoring/CycleTimeTracker.h"
+#include "../monitoring/OperationStats.h"
+#include "../monitoring/AnomalyDetector.h"
+#include "../utilities/SharedEventRing.h"
+#include "../../third_party/json/json.hpp"
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <vector>
+#include <windows.h>
+
+using json = nlohmann::json;
+
+class HttpClient;
+class EventStreamService;
+
+class LiveLogService {
+public:
+    LiveLogService(AgentSettings* settings, HttpClient* client, EventStreamService* eventStream);
+    ~LiveLogService();
+
+    bool Start();
+    void Stop();
+
+    // Rolling per-operation summary attached to each heartbeat
+    json GetCycleStats();
+
+    // Posts the queued anomalies; called from the worker thread
+    void FlushAnomalies();
+
+    // Called from the shared-channel consumer thread
+    void ProcessSharedEvents(const SharedBarrelEvent* records, size_t count, uint64_t dropped);
+
+private:
+    AgentSettings* settings_;
+    HttpClient* httpClient_;
+    EventStreamService* eventStream_;
+    HANDLE tailThread_;
+    bool isRunning_;
+
+    std::mutex mutex_;
+    CycleTimeTracker tracker_;
+    OperationStats stats_;
+    AnomalyDetector detector_;
+    std::vector<AnomalyEvent> pendingEvents_;
+
+    std::mutex anomalyMutex_;
+    std::deque<AnomalyEvent> anomalyQueue_;
+    unsigned long long anomaliesDropped_;
+    CycleTimeTracker sharedTracker_;
+    bool logFeedsStats_;
+    ULONGLONG lastSharedTick_;
+    unsigned long long sharedEvents_;
+    uint64_t sharedDropped_;
+
+    std::string activePath_;
+    unsigned long long offset_;
+    bool skipPartialLine_;
+    bool warmingUp_;
+    unsigned long long publishFrom_;     // Events before this offset were already streamed
+    uint64_t headHash_;
+    uint32_t headBytes_;
+    std::vector<char> buffer_;
+
+    static DWORD WINAPI TailThreadFunc(LPVOID param);
+    void TailLoop();
+    void DiscoverActiveLog();
+    bool AttachAtResumePoint(const std::string& newestPath);
+    bool ReadAppended();
+    void ProcessRecord(const LogRecord& record, unsigned long long recordOffset);
+    void UpdateHeadHash(std::ifstream& file, unsigned long long size);
+    void QueueAnomalies(std::vector<AnomalyEvent>& anomalies);
+    bool SharedChannelActive() const;
+
+    LiveLogService(const LiveLogService&);
+    LiveLogService& operator=(const LiveLogService&);
+};
+
+#endif
\ No newline at end of file
@@ -9,6 +9,8 @@ using json = nlohmann::json;
 namespace LogAnalyzer
 {
     std::string HandleGetLogFileContent(const std::string& commandData);
+    std::string HandleQueryLogIndex(const std::string& commandData);
+    std::string HandleAnalyzeCriticalPath(const std::string& commandData);
     json BuildFileTree(const std::wstring& rootPath, const std::wstring& relativePath = L"");
     std::string WStringToString(const std::wstring& wstr);
     std::wstring StringToWString(const std::string& str);
@@ -0,0 +1,52 @@
+#ifndef LOG_ARCHIVE_SERVICE_H
+#define LOG_ARCHIVE_SERVICE_H
+
+/*
+ * LogArchiveService.h
+ * Low-priority background conversion of closed logs to columnar archives
+ * A log counts as closed when a newer one exists in its folder and it has
+ * not been written for LOG_ARCHIVE_MIN_AGE_MS. The original text is left
+ * in place; it belongs to the application, not to the agent. The running
+ * compression totals go out with the heartbeat.
+ */
+
+#include "../common/Types.h"
+#include "../monitoring/LogArchive.h"
+#include "../../third_party/json/json.hpp"
+#include <mutex>
+#include <string>
+#include <windows.h>
+
+using json = nlohmann::json;
+
+class LogArchiveService {
+public:
+    LogArchiveService(AgentSettings* settings);
+    ~LogArchiveService();
+
+    bool Start();
+    void Stop();
+
+    // Totals since start; null until something has been archived
+    json GetStats();
+
+private:
+    AgentSettings* settings_;
+    HANDLE archiveThread_;
+    bool isRunning_;
+
+    std::mutex statsMutex_;
+    LogArchiveStats totals_;
+    unsigned long long archivedFiles_;
+
+    static DWORD WINAPI ArchiveThreadFunc(LPVOID param);
+    void ArchiveLoop();
+    void ArchiveClosedLogs();
+
+    static double Ratio(const LogArchiveStats& stats);
+
+    LogArchiveService(const LogArchiveService&);
+    LogArchiveService& operator=(const LogArchiveService&);
+};
+
+#endif
\ No newline at end of file
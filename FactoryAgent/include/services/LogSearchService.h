@@ -0,0 +1,53 @@
+#ifndef LOG_SEARCH_SERVICE_H
+#define LOG_SEARCH_SERVICE_H
+
+/*
+ * LogSearchService.h
+ * Runs SearchLogs commands in the background
+ * Candidate log files are memory-mapped and scanned in parallel on a
+ * low-priority pool; InProgress command results carry every hit so far,
+ * since the server keeps only the latest result of a command.
+ * Each search has its own cancellation flag and CPU budget.
+ */
+
+#include "../common/Types.h"
+#include "../../third_party/json/json.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+
+using json = nlohmann::json;
+
+class HttpClient;
+
+class LogSearchService {
+public:
+    LogSearchService(AgentSettings* settings, HttpClient* client);
+    ~LogSearchService();
+
+    bool StartSearch(int commandId, const json& request, std::string& error);
+    bool CancelSearch(int commandId);
+
+    // Longest run of plain characters every match must contain; empty when
+    // the pattern has alternation, a group or no usable literal
+    static std::string ExtractLiteral(const std::string& regexPattern);
+
+private:
+    struct SearchJob;
+
+    AgentSettings* settings_;
+    HttpClient* httpClient_;
+    std::mutex mutex_;
+    std::map<int, std::shared_ptr<SearchJob> > jobs_;
+
+    void RunSearch(std::shared_ptr<SearchJob> job);
+    void SearchFile(SearchJob& job, const std::string& filePath, const std::string& relativePath);
+    bool ChargeCpu(SearchJob& job, unsigned long long& lastCpuUs);
+    void FlushHits(SearchJob& job, bool done);
+    void ReapFinishedJobs();
+
+    LogSearchService(const LogSearchService&);
+    LogSearchService& operator=(const LogSearchService&);
+};
+
+#endif
\ No newline at end of file
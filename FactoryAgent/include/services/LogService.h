@@ -5,10 +5,14 @@
  * LogService.h
  * Handles log file operations
  * Single Responsibility: Log management only
+ * Sidecar indexes of logs that grew are updated on a low-priority thread
+ * of their own, so a large backlog never holds up the heartbeat
  */
 
 #include "../common/Types.h"
 #include "../../third_party/json/json.hpp"
+#include <map>
+#include <windows.h>
 
 using json = nlohmann::json;
 
@@ -20,6 +24,10 @@ public:
     ~LogService();
 
     void SyncLogsToServer();
+
+    bool StartIndexing();
+    void StopIndexing();
+
     static std::string FormatTime(std::filesystem::file_time_type ftime);
     static nlohmann::json BuildDirectoryTree(const std::filesystem::path& currentPath, const std::filesystem::path& rootPath);
 
@@ -27,6 +35,13 @@ private:
     AgentSettings* settings_;
     HttpClient* httpClient_;
     std::string lastSyncedStructure_;
+    HANDLE indexThread_;
+    bool isIndexing_;
+    std::map<std::string, uintmax_t> indexedSizes_;   // Used by the index thread only
+
+    static DWORD WINAPI IndexThreadFunc(LPVOID param);
+    void IndexLoop();
+    void UpdateLogIndexes();
 
     LogService(const LogService&);
     LogService& operator=(const LogService&);
@@ -0,0 +1,72 @@
+#ifndef MODEL_PEER_SERVER_H
+#define MODEL_PEER_SERVER_H
+
+/*
+ * ModelPeerServer.h
+ * Serves the blob store to the other agents on the line
+ * GET /blobs/<xxh64>-<size> answers with the blob; any other request, or a
+ * blob the store does not hold, gets 404. The server knows from the synced
+ * manifest hashes which PCs hold a model and passes them to the others as
+ * Peers, so the uplink carries each file about once per line instead of
+ * once per PC. The receiver checks every blob against the hash the server
+ * gave it, so a peer never has to be trusted. At most
+ * MODEL_PEER_MAX_CONNECTIONS blobs are sent at once, on low-priority
+ * workers; further requests get 503 and move on to another peer.
+ */
+
+#include "../monitoring/ModelStore.h"
+#include "../utilities/ThreadPool.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+struct ModelPeerStats {
+    unsigned long long peerFiles;      // Fetched from other agents
+    unsigned long long peerBytes;
+    unsigned long long serverFiles;    // Fetched from the server
+    unsigned long long serverBytes;
+    unsigned long long peerFailures;   // Peer attempts that failed or did not match the hash
+
+    ModelPeerStats() {
+        peerFiles = 0;
+        peerBytes = 0;
+        serverFiles = 0;
+        serverBytes = 0;
+        peerFailures = 0;
+    }
+};
+
+class ModelPeerServer {
+public:
+    ModelPeerServer();
+    ~ModelPeerServer();
+
+    // Listens on every interface; false when the port is taken
+    bool Start(ModelStore* store, int port);
+    void Stop();
+
+    // 0 while not serving
+    int GetPort();
+    unsigned long long GetServedBlobs();
+    unsigned long long GetServedBytes();
+
+private:
+    ModelStore* store_;
+    uintptr_t listenSocket_;   // SOCKET, kept out of the header so winsock2.h need not come before windows.h
+    int port_;
+    std::thread acceptThread_;
+    std::unique_ptr<ThreadPool> workers_;
+    std::atomic<bool> stopping_;
+    std::atomic<unsigned int> active_;
+    std::atomic<unsigned long long> servedBlobs_;
+    std::atomic<unsigned long long> servedBytes_;
+
+    void AcceptLoop();
+    void Serve(uintptr_t client);
+
+    ModelPeerServer(const ModelPeerServer&);
+    ModelPeerServer& operator=(const ModelPeerServer&);
+};
+
+#endif
\ No newline at end of file
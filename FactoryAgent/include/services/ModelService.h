@@ -5,11 +5,24 @@
  * ModelService.h
  * Handles model operations
  * Single Responsibility: Model management only
+ * Uploads are staged in the hidden temp folder and switched in by rename
  */
 
 #include "../common/Types.h"
 #include "../monitoring/ConfigManager.h"
+#include "../monitoring/FolderWatch.h"
+#include "../monitoring/ModelManifest.h"
+#include "../monitoring/ModelStore.h"
+#include "../monitoring/ModelUsageLog.h"
+#include "ModelPeerServer.h"
+#include "../utilities/ZipUtils.h"
 #include "../../third_party/json/json.hpp"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 using json = nlohmann::json;
@@ -22,16 +35,104 @@ public:
     ~ModelService();
 
     std::vector<ModelInfo> GetModelFolders();
+
+    // Reports each model with its manifest root hash, size and last activation,
+    // plus the quota headroom; evicts the least recently used model over quota.
+    // Unchanged ticks touch neither the disk nor the network; a changed folder
+    // is rebuilt behind the sync, which reports the previous inventory meanwhile
     void SyncModelsToServer();
+
+    // The next sync posts the inventory even if unchanged; for a (re-)registration
+    void ResendInventory();
     bool ChangeModel(const std::string& modelName);
-    bool UploadModelToServer(const json& data);
+
+    // Renames the folder into the temp folder and deletes it behind the rename;
+    // refuses the model in config
     bool DeleteModel(const std::string& modelName);
-    bool UploadModelToLibrary(const std::string& modelName, const std::string& uploadUrl);
+
+    // Runs UploadModelToServer on its own thread and posts the result under commandId
+    bool StartUpload(int commandId, const json& data, std::string& error);
+
+    // Unpacks while downloading unless StreamExtract is false (then MaxThreads
+    // applies); with Files and BlobUrl only the files the store lacks are
+    // fetched, from Peers first. Staged files are checked against Files and
+    // ModelHash before the switch. resultData gets the unzip statistics, time
+    // to ready and the switchover time. Nothing is downloaded when ModelHash
+    // matches the local model's root hash
+    bool UploadModelToServer(const json& data, std::string& resultData, std::string& error);
+
+    // Swaps the model with its previous version, kept for MODEL_PREVIOUS_RETENTION_MS;
+    // reverting again swaps them back
+    bool RevertModel(const std::string& modelName, std::string& resultData, std::string& error);
+
+    // Optional CompressionLevel (0 stores, -1 adaptive) and MaxThreads; resultData gets the zip statistics
+    bool UploadModelToLibrary(const json& data, std::string& resultData, std::string& error);
 
 private:
+    struct UploadJob;
+
     AgentSettings* settings_;
     HttpClient* httpClient_;
     ConfigManager* configManager_;
+    ModelManifestCache manifestCache_;
+    ModelStore modelStore_;
+    ModelUsageLog usage_;
+    ModelPeerServer peerServer_;
+
+    // Guards the jobs and previous-version times; switchMutex_ serializes renames
+    std::mutex jobsMutex_;
+    std::map<int, std::shared_ptr<UploadJob> > uploads_;
+    std::map<std::string, std::chrono::steady_clock::time_point> previousSince_;
+    std::mutex switchMutex_;
+    std::atomic<bool> stopping_;
+    std::atomic<bool> collectPending_;
+
+    // The watch, start time and current model are used by the sync thread only;
+    // the inventory of the last finished rebuild is swapped in under inventoryMutex_
+    FolderWatch folderWatch_;
+    std::atomic<bool> inventoryDirty_;
+    std::atomic<bool> inventoryBuilding_;
+    std::atomic<bool> inventoryFresh_;
+    std::thread inventoryThread_;
+    std::chrono::steady_clock::time_point inventoryBuilt_;
+    std::string inventoryCurrent_;
+    std::mutex inventoryMutex_;
+    bool inventoryReady_;
+    std::vector<ModelInfo> inventory_;
+    std::vector<json> inventoryEntries_;
+    std::vector<unsigned long long> inventoryBytes_;
+    uint64_t sentDigest_;
+    bool inventorySent_;
+    unsigned int syncsSinceSent_;
+
+    std::string GetStagingFolder();
+    void RunUpload(std::shared_ptr<UploadJob> job);
+    void ReapFinishedUploads();
+    bool ActivateStaged(const json& data, const std::string& modelName, const std::string& stagingPath,
+        double& switchMs, std::string& error);
+    void PurgePreviousVersions();
+    void RebuildInventory(std::string currentModel);
+    bool CanDelete(const std::string& modelName);
+    bool DeleteModelLocked(const std::string& modelName);
+
+    // The least recently activated model that is not in config, while over modelQuotaMB
+    void EvictForQuota(const std::vector<ModelInfo>& models, const std::vector<unsigned long long>& privateBytes,
+        const std::string& currentModel, std::vector<bool>& removed, json& evicted);
+    bool IsStaging(const std::string& modelName);
+    void ApplyUploadedModel(const json& data, const std::string& modelName, const std::string& modelPath);
+    bool DownloadAndExtract(const std::string& url, const std::string& stagingPath,
+        const ZipOptions& options, ZipStats& stats, std::string& error);
+    bool StageFromStore(const json& data, const std::string& stagingPath, ZipStats& stats,
+        ModelStoreStats& storeStats, ModelPeerStats& peerStats, std::string& error);
+    bool FetchFromPeers(const std::vector<std::string>& peers, std::vector<unsigned int>& failures,
+        uint64_t hash, uint64_t size, const std::string& targetPath, ModelPeerStats& peerStats);
+    bool FetchFile(const std::string& blobUrl, const std::vector<std::string>& peers,
+        std::vector<unsigned int>& peerFailures, const std::string& relativePath, uint64_t hash, uint64_t size,
+        const std::string& targetPath, ModelPeerStats& peerStats, std::string& error);
+    bool VerifyStaged(const json& data, const std::string& stagingPath, ModelManifest& manifest,
+        ZipStats& stats, ModelPeerStats& peerStats, std::string& error);
+    bool DownloadThenExtract(const std::string& url, const std::string& zipPath,
+        const std::string& stagingPath, const ZipOptions& options, ZipStats& stats, std::string& error);
 
     ModelService(const ModelService&);
     ModelService& operator=(const ModelService&);
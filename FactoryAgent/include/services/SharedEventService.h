@@ -0,0 +1,40 @@
+#ifndef SHARED_EVENT_SERVICE_H
+#define SHARED_EVENT_SERVICE_H
+
+/*
+ * SharedEventService.h
+ * Consumer of the optional shared-memory event channel
+ * When settings name a channel, the agent creates the ring and a thread
+ * drains it in place, handing batches to the live log service. The thread
+ * spins briefly after traffic and then falls back to short sleeps.
+ */
+
+#include "../common/Types.h"
+#include "../utilities/SharedEventRing.h"
+#include <windows.h>
+
+class LiveLogService;
+
+class SharedEventService {
+public:
+    SharedEventService(AgentSettings* settings, LiveLogService* liveLogService);
+    ~SharedEventService();
+
+    bool Start();
+    void Stop();
+
+private:
+    AgentSettings* settings_;
+    LiveLogService* liveLogService_;
+    SharedEventRing ring_;
+    HANDLE consumerThread_;
+    bool isRunning_;
+
+    static DWORD WINAPI ConsumerThreadFunc(LPVOID param);
+    void ConsumerLoop();
+
+    SharedEventService(const SharedEventService&);
+    SharedEventService& operator=(const SharedEventService&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,163 @@
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+/*
+ * Deflate.h
+ * Streaming raw DEFLATE (RFC 1951) compressor and decompressor
+ * Deflater takes input in any chunk size and pushes compressed bytes to
+ * a sink. Matches come from hash chains over a 32 KB window, with lazy
+ * matching from level 4 up. Each block is emitted as dynamic Huffman,
+ * fixed Huffman or stored, whichever is smallest.
+ * Inflater pulls compressed bytes from a source and pushes output to a
+ * sink through a 32 KB history window, so memory stays constant however
+ * large the stream is.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Return false to abort the stream
+typedef bool (*DeflateSink)(const unsigned char* data, size_t size, void* userData);
+
+// Returns the number of bytes placed in buffer; 0 means end of input
+typedef size_t (*DeflateSource)(unsigned char* buffer, size_t capacity, void* userData);
+
+class Deflater {
+public:
+    Deflater();
+    ~Deflater();
+
+    // Level 1 (fastest) to 9 (smallest)
+    void Reset(int level, DeflateSink sink, void* userData);
+
+    // Preloads the window with the data preceding this stream (call before Write)
+    void SetDictionary(const void* data, size_t size);
+
+    bool Write(const void* data, size_t size);
+
+    // Ends the current block on a byte boundary without ending the stream,
+    // so independently compressed pieces can be concatenated
+    bool Flush();
+    bool Finish();
+
+    unsigned long long GetTotalIn() const;
+    unsigned long long GetTotalOut() const;
+
+private:
+    struct LevelConfig {
+        int goodLength;
+        int maxLazy;
+        int niceLength;
+        int maxChain;
+    };
+
+    DeflateSink sink_;
+    void* sinkData_;
+    LevelConfig config_;
+    bool lazy_;
+    bool failed_;
+
+    std::vector<unsigned char> window_;   // Two 32 KB halves, slid when the upper one fills
+    std::vector<int> head_;
+    std::vector<int> prev_;
+    size_t windowEnd_;
+    size_t position_;
+    long blockStart_;                     // Negative once the block's start was slid out
+    int matchLength_;
+    long matchStart_;
+    int prevLength_;
+    long prevMatch_;
+    bool matchAvailable_;
+
+    std::vector<uint16_t> symbolLitLen_;
+    std::vector<uint16_t> symbolDist_;    // 0 for a literal
+
+    std::vector<unsigned char> output_;
+    uint64_t bitBuffer_;
+    int bitCount_;
+
+    unsigned long long totalIn_;
+    unsigned long long totalOut_;
+
+    int InsertString(size_t position);
+    int LongestMatch(size_t position, long chainHead, int prevLength, long& matchStart);
+    bool CompressGreedy(bool flush);
+    bool CompressLazy(bool flush);
+    bool CompressPending();
+    void SlideWindow();
+    bool FlushBlock(size_t blockEnd, bool final);
+    void WriteBits(uint32_t value, int count);
+    void WriteStored(const unsigned char* data, size_t size, bool final);
+    bool FlushOutput(bool all);
+
+    Deflater(const Deflater&);
+    Deflater& operator=(const Deflater&);
+};
+
+class Inflater {
+public:
+    Inflater();
+    ~Inflater();
+
+    void Reset(DeflateSource source, void* sourceData, DeflateSink sink, void* sinkData);
+
+    // Decodes up to and including the final block
+    bool Run();
+
+    const std::string& GetError() const;
+    unsigned long long GetTotalIn() const;
+    unsigned long long GetTotalOut() const;
+
+    // Input pulled from the source but not part of the deflate stream
+    void GetUnconsumed(const unsigned char*& data, size_t& size) const;
+
+private:
+    struct HuffmanTable {
+        uint16_t fast[1 << 10];   // (symbol << 4) | length for codes up to 10 bits, 0 otherwise
+        uint16_t count[16];
+        uint16_t symbol[288];
+    };
+
+    DeflateSource source_;
+    void* sourceData_;
+    DeflateSink sink_;
+    void* sinkData_;
+
+    std::vector<unsigned char> input_;
+    size_t inputPos_;
+    size_t inputSize_;
+    bool inputEnded_;
+    uint64_t bitBuffer_;
+    int bitCount_;
+
+    std::vector<unsigned char> output_;
+    size_t outputPos_;
+    size_t outputFlushed_;
+
+    HuffmanTable litLen_;
+    HuffmanTable dist_;
+
+    std::string error_;
+    unsigned long long totalIn_;
+    unsigned long long totalOut_;
+    unsigned long long totalRead_;            // Bytes pulled from the source
+
+    bool Refill();
+    bool Fill(int bits);
+    uint32_t TakeBits(int count);
+    bool Decode(const HuffmanTable& table, int& symbol);
+    bool BuildTable(HuffmanTable& table, const uint8_t* lengths, int count);
+    bool ReadDynamicTables();
+    void BuildFixedTables();
+    bool InflateStored();
+    bool InflateBlock();
+    bool FlushOutput(bool all);
+    bool Fail(const char* message);
+
+    Inflater(const Inflater&);
+    Inflater& operator=(const Inflater&);
+};
+
+#endif
\ No newline at end of file
@@ -4,6 +4,10 @@
 /*
  * FileUtils.h
  * File system utility functions
+ * DeleteFolder enumerates the tree once, unlinks the files in parallel
+ * batches on low-priority workers (clearing read-only attributes), then
+ * removes directories bottom-up. Junctions and symlinks are removed as
+ * links; their targets are never entered.
  */
 
 #include <string>
@@ -15,9 +19,15 @@ public:
     static bool FolderExists(const std::string& folderPath);
     static bool CreateFolder(const std::string& folderPath);
     static bool DeleteFolder(const std::string& folderPath);
+
+    // Renames the folder into trashFolder (same volume) and deletes it on a
+    // background thread; returns once the rename is done
+    static bool DeleteFolderInBackground(const std::string& folderPath, const std::string& trashFolder);
+
     static bool DeleteFile(const std::string& filePath);
     static bool ReadFileContent(const std::string& filePath, std::string& content);
     static bool WriteFileContent(const std::string& filePath, const std::string& content);
+    static bool WriteFileAtomic(const std::string& filePath, const std::string& content);
     static std::string GetFileName(const std::string& filePath);
     static std::string GetFileExtension(const std::string& filePath);
 
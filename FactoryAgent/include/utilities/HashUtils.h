@@ -0,0 +1,28 @@
+#ifndef HASH_UTILS_H
+#define HASH_UTILS_H
+
+/*
+ * HashUtils.h
+ * Content hashing helpers
+ * Xxh64 is the XXH64 algorithm (four parallel 64-bit lanes over 32-byte
+ * stripes), fast enough to hash config and model files on every change.
+ * Crc32 is the zip/PNG CRC-32, table driven eight bytes at a time.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class HashUtils {
+public:
+    static uint64_t Xxh64(const void* data, size_t size, uint64_t seed = 0);
+
+    // Pass the previous result to continue a running CRC; start from 0
+    static uint32_t Crc32(uint32_t crc, const void* data, size_t size);
+    static std::string ToHex(uint64_t value);
+
+private:
+    HashUtils();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef INI_DOCUMENT_H
+#define INI_DOCUMENT_H
+
+/*
+ * IniDocument.h
+ * Formatting-preserving INI document
+ * The text is scanned once and every key is indexed by section and name
+ * (case-insensitive) as an offset/length span into the original text, so
+ * lookups are O(1) and hand out string_views without copying. Edits
+ * replace only the value span of the target key; comments, blank lines,
+ * ordering and line endings are left exactly as they were.
+ * A key repeated within a section keeps its first value. Each section
+ * carries an order-independent hash of its keys and values, so two
+ * documents can be compared section by section without walking the keys.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class IniDocument {
+public:
+    IniDocument();
+
+    void Parse(const std::string& text);
+    const std::string& GetText() const;
+
+    bool HasSection(const std::string& section) const;
+
+    // Sections in order of first appearance; names are lower case
+    size_t GetSectionCount() const;
+    const std::string& GetSectionName(size_t section) const;
+    uint64_t GetSectionHash(size_t section) const;
+    bool FindSection(const std::string& section, size_t& index) const;
+    size_t GetKeyCount(size_t section) const;
+    std::string_view GetKey(size_t section, size_t key) const;
+    std::string_view GetValue(size_t section, size_t key) const;
+
+    // Views stay valid until the next Parse or SetValue
+    bool Find(const std::string& section, const std::string& key, std::string_view& value) const;
+    bool FindFirst(const std::string& key, std::string_view& value) const;
+
+    // Only existing keys are updated; values may not contain line breaks
+    bool SetValue(const std::string& section, const std::string& key, const std::string& value);
+    bool SetFirstValue(const std::string& key, const std::string& value);
+
+private:
+    struct Entry {
+        size_t keyOffset;
+        size_t keyLength;
+        size_t valueOffset;
+        size_t valueLength;
+        size_t section;
+    };
+
+    struct Section {
+        std::string name;
+        std::vector<size_t> entries;  // First occurrence of each key
+        uint64_t hash;
+    };
+
+    std::string text_;
+    std::vector<Entry> entries_;
+    std::vector<Section> sections_;
+    std::unordered_map<std::string, size_t> index_;         // "section\nkey" -> first entry in that section
+    std::unordered_map<std::string, size_t> firstIndex_;    // key -> first entry in any section
+    std::unordered_map<std::string, size_t> sectionIndex_;  // name -> section
+
+    static std::string MakeKey(std::string_view section, std::string_view key);
+    static std::string Lower(std::string_view text);
+    size_t AddSection(const std::string& name);
+    uint64_t HashSection(const Section& section) const;
+    bool Replace(size_t entry, const std::string& value);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef LOG_RECORD_SCANNER_H
+#define LOG_RECORD_SCANNER_H
+
+/*
+ * LogRecordScanner.h
+ * Zero-copy scanner for tab-separated LAI log records
+ * Delimiters are located with AVX2/SSE2 (scalar fallback) and fields are
+ * handed out as string_views into the caller's buffer. The JSON payload is
+ * decoded by a specialized parser that only knows the four keys we use.
+ */
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include "../common/Constants.h"
+
+enum LogEvent {
+    LOG_EVENT_NONE,
+    LOG_EVENT_START,
+    LOG_EVENT_END
+};
+
+struct LogPayload {
+    long long barrelId;
+    long long startTs;
+    long long endTs;
+    long long idealMs;
+    bool hasBarrelId;
+    bool hasStartTs;
+    bool hasEndTs;
+    bool hasIdealMs;
+
+    LogPayload() {
+        barrelId = 0;
+        startTs = 0;
+        endTs = 0;
+        idealMs = 0;
+        hasBarrelId = false;
+        hasStartTs = false;
+        hasEndTs = false;
+        hasIdealMs = false;
+    }
+};
+
+struct LogRecord {
+    std::string_view line;       // Without the line terminator
+    std::string_view fields[AgentConstants::LOG_FIELD_COUNT];
+    size_t fieldCount;
+    size_t offset;               // Byte offset of the line in the scanned buffer
+    size_t length;               // Bytes consumed including the terminator
+
+    LogRecord() {
+        fieldCount = 0;
+        offset = 0;
+        length = 0;
+    }
+
+    bool IsEvent() const {
+        return fieldCount == (size_t)AgentConstants::LOG_FIELD_COUNT;
+    }
+};
+
+class LogRecordScanner {
+public:
+    // When acceptUnterminated is false a trailing line without '\n' is left
+    // unread, so a file that is still being written can be resumed later.
+    LogRecordScanner(const char* data, size_t size, bool acceptUnterminated = true);
+
+    bool Next(LogRecord& record);
+    size_t Position() const;
+
+    static bool ParsePayload(std::string_view text, LogPayload& payload);
+    static LogEvent ParseEvent(std::string_view field);
+    static bool ParseDateTime(std::string_view text, long long& epochMs);
+    static std::string FormatDateTime(long long epochMs);
+
+    static const char* FindDelimiter(const char* begin, const char* end);
+    static const char* FindByte(const char* begin, const char* end, char value);
+    static const char* FindSubstring(const char* begin, const char* end, std::string_view needle);
+    static const char* GetSimdLevel();
+
+private:
+    const char* data_;
+    const char* cursor_;
+    const char* end_;
+    bool acceptUnterminated_;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+/*
+ * MappedFile.h
+ * Read-only memory mapping of a file
+ * Opened with full sharing so files still being written by the LAI
+ * application can be mapped; the view covers the size at open time.
+ */
+
+#include <string>
+#include <windows.h>
+
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool Open(const std::string& filePath);
+    void Close();
+
+    bool IsOpen() const;
+    const char* GetData() const;
+    size_t GetSize() const;
+
+private:
+    HANDLE file_;
+    HANDLE mapping_;
+    const char* data_;
+    size_t size_;
+    bool isOpen_;
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef PIPE_BUFFER_H
+#define PIPE_BUFFER_H
+
+/*
+ * PipeBuffer.h
+ * Bounded byte pipe between one producer thread and one consumer thread
+ * The producer blocks while the pipe is full and the consumer while it is
+ * empty, so memory never exceeds the capacity whichever side is slower.
+ * Either side can abort, which wakes and fails the other.
+ */
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+class PipeBuffer {
+public:
+    PipeBuffer(size_t capacity);
+    ~PipeBuffer();
+
+    // Blocks until everything is queued; false once the pipe was aborted
+    bool Write(const void* data, size_t size);
+
+    // Blocks until data arrives; 0 at the end of the stream or after an abort
+    size_t Read(void* buffer, size_t capacity);
+
+    // Producer is done; the consumer drains what is left
+    void Close();
+    void Abort();
+    bool IsAborted();
+
+    // Time each side spent blocked on the other
+    unsigned long long GetWriterWaitMs();
+    unsigned long long GetReaderWaitMs();
+
+private:
+    std::vector<unsigned char> buffer_;
+    size_t head_;
+    size_t size_;
+    bool closed_;
+    bool aborted_;
+    unsigned long long writerWaitMs_;
+    unsigned long long readerWaitMs_;
+
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+
+    PipeBuffer(const PipeBuffer&);
+    PipeBuffer& operator=(const PipeBuffer&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef SHARED_EVENT_RING_H
+#define SHARED_EVENT_RING_H
+
+/*
+ * SharedEventRing.h
+ * Single-producer/single-consumer ring of fixed-size barrel events in
+ * shared memory, for the LAI application to hand events to the agent
+ * without going through its text logs.
+ * The agent creates the ring; the application opens it and pushes. The
+ * two indexes are free-running counters on separate cache lines, each
+ * written by one side only (release) and read by the other (acquire), so
+ * no locks are involved. When the ring is full the producer drops the
+ * event and counts it rather than block the application.
+ * Backends: named file mapping on Windows, shm_open/mmap elsewhere.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#pragma pack(push, 1)
+struct SharedBarrelEvent {
+    int64_t timeMs;             // Local time as milliseconds since 1970-01-01
+    int64_t barrelId;
+    int32_t durationMs;         // END only, -1 when unknown
+    int32_t idealMs;            // -1 when absent
+    uint16_t event;             // LogEvent: 1 START, 2 END
+    uint16_t operationLength;
+    char operation[36];         // Not terminated when all 36 bytes are used
+};
+#pragma pack(pop)
+
+struct SharedRingHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t capacity;          // Records; a power of two
+    alignas(64) std::atomic<uint64_t> writeIndex;
+    alignas(64) std::atomic<uint64_t> readIndex;
+    alignas(64) std::atomic<uint64_t> dropped;
+    std::atomic<uint32_t> producerAttached;
+};
+
+class SharedEventRing {
+public:
+    SharedEventRing();
+    ~SharedEventRing();
+
+    // Consumer side: creates (or re-creates) the named ring
+    bool Create(const std::string& name, uint32_t capacity);
+    // Producer side: attaches to a ring the consumer created
+    bool Open(const std::string& name);
+    void Close();
+    bool IsOpen() const;
+
+    // Producer; false when the ring is full (the event is counted as dropped)
+    bool TryPush(const SharedBarrelEvent& event);
+
+    // Consumer; points at up to maxCount contiguous unread records in place.
+    // They stay valid until Release.
+    size_t Peek(const SharedBarrelEvent*& records, size_t maxCount);
+    void Release(size_t count);
+
+    uint64_t GetDropped() const;
+    bool IsProducerAttached() const;
+
+    static size_t GetMappingSize(uint32_t capacity);
+
+private:
+    SharedRingHeader* header_;
+    SharedBarrelEvent* records_;
+    size_t mappingSize_;
+    uint64_t mask_;
+    uint64_t cachedOtherIndex_;     // Last seen index of the other side
+    bool isOwner_;
+    std::string name_;
+#ifdef _WIN32
+    HANDLE mapping_;
+#else
+    int fd_;
+#endif
+
+    bool Map(const std::string& name, size_t size, bool create);
+
+    SharedEventRing(const SharedEventRing&);
+    SharedEventRing& operator=(const SharedEventRing&);
+};
+
+#endif
\ No newline at end of file
@@ -20,6 +20,7 @@ public:
     static bool EndsWith(const std::string& str, const std::string& suffix);
     static std::vector<std::string> Split(const std::string& str, char delimiter);
     static std::string Replace(const std::string& str, const std::string& from, const std::string& to);
+    static bool WildcardMatch(const std::string& str, const std::string& pattern);
 
 private:
     StringUtils();
@@ -0,0 +1,46 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/*
+ * ThreadPool.h
+ * Fixed-size worker pool for background jobs
+ * Workers can run at lowered priority so agent work never competes with
+ * the production application for CPU.
+ */
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    ThreadPool(size_t threadCount, bool lowPriority);
+    ~ThreadPool();
+
+    void Submit(const std::function<void()>& task);
+    void Wait();
+    size_t GetThreadCount() const;
+
+    // Half the cores (at least one), never more than maxThreads when non-zero
+    static size_t GetBackgroundThreadCount(size_t maxThreads);
+
+private:
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()> > tasks_;
+    std::mutex mutex_;
+    std::condition_variable taskAvailable_;
+    std::condition_variable idle_;
+    size_t activeCount_;
+    bool stopping_;
+    bool lowPriority_;
+
+    void WorkerLoop();
+
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,295 @@
+#ifndef ZIP_ARCHIVE_H
+#define ZIP_ARCHIVE_H
+
+/*
+ * ZipArchive.h
+ * Native zip reader and writer (stored and deflated entries, ZIP64)
+ * ZipWriter streams each file through the deflater, so memory use does
+ * not depend on file size. It never seeks, so the archive can go to a
+ * sink (an upload stream) instead of a file. Entries carry a data descriptor and the
+ * central directory holds the final sizes; ZIP64 records are written
+ * only when a size, offset or entry count needs them.
+ * With worker threads, files are cut into chunks that are deflated
+ * independently (each primed with the 32 KB before it) and written back
+ * in order, with a bounded number of chunks in flight.
+ * ZipReader locates the central directory from the end of the file and
+ * extracts entries with CRC and size verification. Entry names that are
+ * absolute or climb out of the destination are rejected.
+ * Parallel extraction creates every directory up front, then workers with
+ * their own file handle and inflater take entries largest first.
+ * ZipStreamReader extracts from a forward-only stream such as a download in
+ * progress: entries are unpacked from their local headers as the bytes
+ * arrive, and the central directory is checked against them at the end.
+ */
+
+#include "Deflate.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+struct ZipEntry {
+    std::string name;              // As stored, '/' separated
+    uint16_t flags;
+    uint16_t method;               // 0 stored, 8 deflated
+    uint32_t dosDateTime;          // Date in the high word
+    uint32_t crc32;
+    uint64_t compressedSize;
+    uint64_t uncompressedSize;
+    uint64_t localHeaderOffset;
+    bool isDirectory;
+
+    ZipEntry() {
+        flags = 0;
+        method = 0;
+        dosDateTime = 0;
+        crc32 = 0;
+        compressedSize = 0;
+        uncompressedSize = 0;
+        localHeaderOffset = 0;
+        isDirectory = false;
+    }
+};
+
+// Called as data moves; return false to cancel the operation.
+// During parallel extraction it runs on the workers, one call at a time
+typedef bool (*ZipProgressCallback)(const std::string& entryName, unsigned long long bytesDone,
+    unsigned long long bytesTotal, void* userData);
+
+class ZipWriter {
+public:
+    ZipWriter();
+    ~ZipWriter();
+
+    bool Open(const std::string& zipPath);
+
+    // Hands the archive bytes to sink in order as they are produced
+    bool Open(DeflateSink sink, void* userData);
+
+    void SetProgress(ZipProgressCallback callback, void* userData, unsigned long long bytesTotal);
+
+    // Compresses on up to threads low-priority workers; 1 keeps the work on the caller
+    void SetThreads(size_t threads);
+
+    // Level 0 stores the file as is; ZIP_LEVEL_ADAPTIVE picks per file
+    bool AddFile(const std::string& filePath, const std::string& entryName, int level);
+    bool AddDirectory(const std::string& entryName);
+
+    // Writes the central directory; the archive is unusable until this succeeds
+    bool Close();
+
+    // Closes and deletes a partially written archive
+    void Abort();
+
+    const std::string& GetError() const;
+    unsigned long long GetBytesWritten() const;
+
+    // Stores known compressed formats; an adaptive level is resolved from a sample of the data
+    static int ChooseLevel(const std::string& entryName, const unsigned char* sample, size_t sampleSize, int level);
+
+private:
+    struct PendingFile {
+        ZipEntry entry;
+        bool zip64;
+        uint64_t dataStart;
+    };
+
+    struct PendingChunk {
+        std::shared_ptr<PendingFile> file;
+        bool first;
+        bool last;
+        int level;
+        std::vector<unsigned char> dictionary;
+        std::vector<unsigned char> input;
+        std::vector<unsigned char> output;
+        bool done;
+        bool failed;
+    };
+
+    bool isOpen_;
+    std::ofstream file_;
+    std::string path_;
+    DeflateSink sink_;
+    void* sinkData_;
+    std::vector<ZipEntry> entries_;
+    uint64_t offset_;
+    std::string error_;
+
+    ThreadPool* pool_;
+    size_t maxPending_;
+    std::deque<std::shared_ptr<PendingChunk> > pending_;
+    std::mutex pendingMutex_;
+    std::condition_variable chunkDone_;
+
+    ZipProgressCallback progress_;
+    void* progressData_;
+    unsigned long long bytesDone_;
+    unsigned long long bytesTotal_;
+
+    Deflater deflater_;
+    std::vector<unsigned char> buffer_;
+
+    void Reset();
+    bool AddFileParallel(std::ifstream& input, const std::shared_ptr<PendingFile>& file, int level);
+    bool QueueChunk(const std::shared_ptr<PendingChunk>& chunk);
+    bool DrainPending(size_t keep);
+    bool WriteChunk(PendingChunk& chunk);
+    void DiscardPending();
+
+    bool Emit(const void* data, size_t size);
+    bool WriteLocalHeader(const ZipEntry& entry, bool zip64);
+    bool WriteDataDescriptor(const ZipEntry& entry, bool zip64);
+    bool WriteCentralDirectory();
+    bool Fail(const std::string& message);
+
+    static void CompressChunk(PendingChunk& chunk);
+    static bool DeflateToOutput(const unsigned char* data, size_t size, void* userData);
+
+    ZipWriter(const ZipWriter&);
+    ZipWriter& operator=(const ZipWriter&);
+};
+
+class ZipReader {
+public:
+    ZipReader();
+    ~ZipReader();
+
+    bool Open(const std::string& zipPath);
+    void Close();
+    void SetProgress(ZipProgressCallback callback, void* userData);
+
+    // ExtractAll uses up to threads low-priority workers; 1 keeps the work on the caller
+    void SetThreads(size_t threads);
+
+    size_t GetEntryCount() const;
+    const ZipEntry& GetEntry(size_t index) const;
+    unsigned long long GetTotalUncompressed() const;
+
+    // Streams the verified contents of an entry to sink
+    bool ReadEntry(size_t index, DeflateSink sink, void* userData);
+    bool ExtractEntry(size_t index, const std::string& destinationFolder);
+    bool ExtractAll(const std::string& destinationFolder);
+
+    const std::string& GetError() const;
+
+    // Converts an entry name to a relative path; false if it would escape the destination
+    static bool GetSafeRelativePath(const std::string& entryName, std::string& relativePath);
+
+private:
+    // State of the entry being read; each extraction worker has its own
+    struct EntryStream {
+        ZipReader* reader;
+        std::ifstream* file;
+        const ZipEntry* entry;
+        uint64_t remaining;
+        uint64_t produced;
+        uint32_t crc;
+        DeflateSink sink;
+        void* sinkData;
+        Inflater inflater;
+        std::vector<unsigned char> buffer;
+        std::string error;
+    };
+
+    std::ifstream file_;
+    std::string path_;
+    uint64_t fileSize_;
+    std::vector<ZipEntry> entries_;
+    std::string error_;
+    size_t threads_;
+    EntryStream stream_;
+
+    // Guards the progress state and error_ while workers run
+    std::mutex progressMutex_;
+    ZipProgressCallback progress_;
+    void* progressData_;
+    unsigned long long bytesDone_;
+    unsigned long long bytesTotal_;
+    bool cancelled_;
+
+    bool ReadCentralDirectory();
+    bool ReadStream(EntryStream& stream, size_t index);
+    bool ExtractToFile(EntryStream& stream, size_t index, const std::string& target);
+    bool ExtractParallel(const std::vector<size_t>& files, const std::vector<std::string>& targets);
+    bool ReportProgress(const ZipEntry& entry, size_t size);
+    void Cancel(const std::string& message);
+    bool IsCancelled();
+    bool Fail(const std::string& message);
+
+    static bool FailStream(EntryStream& stream, const std::string& message);
+    static size_t ReadCompressed(unsigned char* buffer, size_t capacity, void* userData);
+    static bool Verify(const unsigned char* data, size_t size, void* userData);
+
+    ZipReader(const ZipReader&);
+    ZipReader& operator=(const ZipReader&);
+};
+
+class ZipStreamReader {
+public:
+    ZipStreamReader();
+    ~ZipStreamReader();
+
+    // bytesTotal is 0 in the callback; the stream length is not known
+    void SetProgress(ZipProgressCallback callback, void* userData);
+
+    // Reads source to its end. Files already written stay behind on failure,
+    // so destinationFolder should be a staging folder
+    bool ExtractAll(DeflateSource source, void* sourceData, const std::string& destinationFolder);
+
+    size_t GetEntryCount() const;
+    const ZipEntry& GetEntry(size_t index) const;
+    unsigned long long GetTotalUncompressed() const;
+    unsigned long long GetBytesRead() const;
+    const std::string& GetError() const;
+
+private:
+    DeflateSource source_;
+    void* sourceData_;
+    std::vector<unsigned char> buffer_;
+    size_t pos_;
+    size_t end_;
+    uint64_t offset_;              // Stream position of buffer_[pos_]
+
+    std::vector<ZipEntry> entries_;
+    std::string error_;
+
+    ZipProgressCallback progress_;
+    void* progressData_;
+    unsigned long long bytesDone_;
+
+    // State of the entry being extracted
+    ZipEntry current_;
+    bool sizeKnown_;
+    uint64_t remaining_;
+    uint64_t produced_;
+    uint32_t crc_;
+    std::ofstream* out_;
+
+    Inflater inflater_;
+
+    bool Ensure(size_t size);
+    bool Read(void* data, size_t size);
+    void Consume(size_t size);
+    bool Skip(uint64_t size);
+    void Unread(const unsigned char* data, size_t size);
+    bool ReadLocalEntry(const std::string& destinationFolder, std::string& lastFolder);
+    bool ReadEntryData(bool zip64);
+    bool CopyUntilDescriptor(bool zip64);
+    bool ReadDataDescriptor(bool zip64, uint64_t compressedSize);
+    bool VerifyCentralDirectory(uint64_t directoryOffset);
+    bool Fail(const std::string& message);
+
+    static size_t ReadInput(unsigned char* buffer, size_t capacity, void* userData);
+    static bool Verify(const unsigned char* data, size_t size, void* userData);
+
+    ZipStreamReader(const ZipStreamReader&);
+    ZipStreamReader& operator=(const ZipStreamReader&);
+};
+
+#endif
\ No newline at end of file
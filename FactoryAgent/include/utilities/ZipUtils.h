@@ -3,18 +3,68 @@
 
 /*
  * ZipUtils.h
- * ZIP file operations using PowerShell
+ * ZIP file operations on whole folders
+ * Backed by the native ZipReader/ZipWriter; no external tools are run.
  */
 
+#include "ZipArchive.h"
+#include "../common/Constants.h"
 #include <string>
 
+struct ZipOptions {
+    int level;                     // Compression only: 0 stores everything; ZIP_LEVEL_ADAPTIVE decides per file
+    size_t maxThreads;             // Further capped to the background share of the cores
+    ZipProgressCallback progress;
+    void* userData;
+
+    ZipOptions() {
+        level = AgentConstants::ZIP_LEVEL_ADAPTIVE;
+        maxThreads = AgentConstants::ZIP_MAX_THREADS;
+        progress = NULL;
+        userData = NULL;
+    }
+};
+
+struct ZipStats {
+    unsigned long long files;
+    unsigned long long bytesIn;    // Files read when zipping, archive size when extracting
+    unsigned long long bytesOut;
+    size_t threads;
+    unsigned long long elapsedMs;
+
+    ZipStats() {
+        files = 0;
+        bytesIn = 0;
+        bytesOut = 0;
+        threads = 0;
+        elapsedMs = 0;
+    }
+};
+
 class ZipUtils {
 public:
     static bool ExtractZip(const std::string& zipPath, const std::string& destinationPath);
+    static bool ExtractZip(const std::string& zipPath, const std::string& destinationPath,
+        const ZipOptions& options, ZipStats& stats, std::string& error);
+
+    // Extracts while source is still arriving; on failure the destination holds a partial tree
+    static bool ExtractZip(DeflateSource source, void* userData, const std::string& destinationPath,
+        const ZipOptions& options, ZipStats& stats, std::string& error);
+
+    // Zips the contents of folderPath, not the folder itself
     static bool CreateZip(const std::string& folderPath, const std::string& zipPath);
+    static bool CreateZip(const std::string& folderPath, const std::string& zipPath,
+        const ZipOptions& options, ZipStats& stats, std::string& error);
+
+    // Streams the archive to sink as it is built; nothing touches the disk
+    static bool CreateZip(const std::string& folderPath, DeflateSink sink, void* userData,
+        const ZipOptions& options, ZipStats& stats, std::string& error);
 
 private:
     ZipUtils();
+
+    static bool WriteFolder(ZipWriter& writer, const std::string& folderPath,
+        const ZipOptions& options, ZipStats& stats, std::string& error);
 };
 
 #endif
\ No newline at end of file
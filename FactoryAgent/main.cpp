@@ -66,6 +66,14 @@ bool LoadSettings(AgentSettings& settings) {
             settings.modelVersion = config["modelVersion"];
         }
 
+        if (config.contains("sharedEventChannel")) {
+            settings.sharedEventChannel = config["sharedEventChannel"];
+        }
+
+        settings.modelQuotaMB = config.value("modelQuotaMB", 0ULL);
+        settings.modelPeerPort = config.value("modelPeerPort", 0);
+        settings.eventStreamEnabled = config.value("eventStreamEnabled", false);
+
         std::string serverUrlStr = config["serverUrl"];
         std::string exeNameStr = config["exeName"];
         settings.serverUrl = std::wstring(serverUrlStr.begin(), serverUrlStr.end());
@@ -95,6 +103,22 @@ void SaveSettings(const AgentSettings& settings) {
         config["modelVersion"] = settings.modelVersion;
     }
 
+    if (!settings.sharedEventChannel.empty()) {
+        config["sharedEventChannel"] = settings.sharedEventChannel;
+    }
+
+    if (settings.modelQuotaMB > 0) {
+        config["modelQuotaMB"] = settings.modelQuotaMB;
+    }
+
+    if (settings.modelPeerPort > 0) {
+        config["modelPeerPort"] = settings.modelPeerPort;
+    }
+
+    if (settings.eventStreamEnabled) {
+        config["eventStreamEnabled"] = true;
+    }
+
     std::string serverUrlStr(settings.serverUrl.begin(), settings.serverUrl.end());
     std::string exeNameStr(settings.exeName.begin(), settings.exeName.end());
     config["serverUrl"] = serverUrlStr;
@@ -4,6 +4,11 @@
 #include "../include/services/CommandExecutor.h"
 #include "../include/services/ConfigService.h"
 #include "../include/services/LogService.h"
+#include "../include/services/LogSearchService.h"
+#include "../include/services/LiveLogService.h"
+#include "../include/services/EventStreamService.h"
+#include "../include/services/SharedEventService.h"
+#include "../include/services/LogArchiveService.h"
 #include "../include/services/ModelService.h"
 #include "../include/network/HttpClient.h"
 #include "../include/monitoring/ConfigManager.h"
@@ -20,6 +25,11 @@ AgentCore::AgentCore() {
     commandExecutor_ = NULL;
     configService_ = NULL;
     logService_ = NULL;
+    logSearchService_ = NULL;
+    liveLogService_ = NULL;
+    eventStreamService_ = NULL;
+    sharedEventService_ = NULL;
+    logArchiveService_ = NULL;
     modelService_ = NULL;
     configManager_ = NULL;
     processMonitor_ = NULL;
@@ -34,6 +44,11 @@ AgentCore::~AgentCore() {
 
     if (commandExecutor_) delete commandExecutor_;
     if (modelService_) delete modelService_;
+    if (logSearchService_) delete logSearchService_;
+    if (sharedEventService_) delete sharedEventService_;
+    if (liveLogService_) delete liveLogService_;
+    if (eventStreamService_) delete eventStreamService_;
+    if (logArchiveService_) delete logArchiveService_;
     if (logService_) delete logService_;
     if (configService_) delete configService_;
     if (heartbeatService_) delete heartbeatService_;
@@ -53,8 +68,15 @@ bool AgentCore::Initialize(const AgentSettings& settings) {
     processMonitor_ = new ProcessMonitor();
     configService_ = new ConfigService(&settings_, httpClient_, configManager_);
     logService_ = new LogService(&settings_, httpClient_);
+    logSearchService_ = new LogSearchService(&settings_, httpClient_);
+    if (settings_.eventStreamEnabled) {
+        eventStreamService_ = new EventStreamService(&settings_, httpClient_);
+    }
+    liveLogService_ = new LiveLogService(&settings_, httpClient_, eventStreamService_);
+    sharedEventService_ = new SharedEventService(&settings_, liveLogService_);
+    logArchiveService_ = new LogArchiveService(&settings_);
     modelService_ = new ModelService(&settings_, httpClient_, configManager_);
-    commandExecutor_ = new CommandExecutor(httpClient_, configService_, modelService_);
+    commandExecutor_ = new CommandExecutor(httpClient_, configService_, modelService_, logSearchService_);
 
     return true;
 }
@@ -67,6 +89,13 @@ void AgentCore::Start() {
     isRunning_ = true;
     stopRequested_ = false;
     workerThread_ = CreateThread(NULL, 0, WorkerThreadProc, this, 0, NULL);
+    if (eventStreamService_) {
+        eventStreamService_->Start();
+    }
+    liveLogService_->Start();
+    sharedEventService_->Start();
+    logArchiveService_->Start();
+    logService_->StartIndexing();
 }
 
 void AgentCore::Stop() {
@@ -75,6 +104,13 @@ void AgentCore::Stop() {
     }
 
     stopRequested_ = true;
+    sharedEventService_->Stop();
+    liveLogService_->Stop();
+    if (eventStreamService_) {
+        eventStreamService_->Stop();
+    }
+    logArchiveService_->Stop();
+    logService_->StopIndexing();
 
     if (workerThread_) {
         WaitForSingleObject(workerThread_, 5000);
@@ -138,6 +174,9 @@ void AgentCore::WorkerLoop() {
                 }
                 else {
                     connectionFailureCount_ = 0;
+
+                    // The server may have lost what it had for this PC
+                    modelService_->ResendInventory();
                 }
             }
             else {
@@ -153,6 +192,8 @@ void AgentCore::WorkerLoop() {
             bool heartbeatSuccess = heartbeatService_->SendHeartbeat(
                 settings_.pcId, 
                 processMonitor_->IsProcessRunning(settings_.exeName),
+                liveLogService_->GetCycleStats(),
+                logArchiveService_->GetStats(),
                 httpClient_, 
                 &commands
             );
@@ -184,6 +225,7 @@ void AgentCore::WorkerLoop() {
             }
             else {
                 connectionFailureCount_ = 0;
+                liveLogService_->FlushAnomalies();
 
                 if (!commands.empty()) {
                     commandExecutor_->ProcessCommands(commands);
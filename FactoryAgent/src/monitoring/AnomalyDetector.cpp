@@ -0,0 +1,179 @@
+#include "../include/monitoring/AnomalyDetector.h"
+#include "../include/utilities/LogRecordScanner.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+#include <cmath>
+
+AnomalyDetector::AnomalyDetector() {
+    InitSeries(barrelSeries_);
+    lastSweepMs_ = 0;
+}
+
+void AnomalyDetector::Reset() {
+    series_.clear();
+    barrels_.clear();
+    InitSeries(barrelSeries_);
+    lastSweepMs_ = 0;
+}
+
+void AnomalyDetector::InitSeries(Series& series) {
+    series.mean = 0.0;
+    series.variance = 0.0;
+    series.count = 0;
+    series.lastEventMs = 0;
+    series.hasEvent = false;
+}
+
+bool AnomalyDetector::Observe(Series& series, double value, double& zScore) {
+    bool outlier = false;
+    zScore = 0.0;
+
+    if (series.count >= AgentConstants::ANOMALY_WARMUP_SAMPLES) {
+        // Floor the deviation so a perfectly steady operation does not
+        // flag a 1 ms wobble
+        double deviation = std::sqrt(series.variance);
+        double floor = (std::max)(1.0, series.mean * 0.01);
+        if (deviation < floor) {
+            deviation = floor;
+        }
+
+        // Statistically unusual but only a few percent slow is not worth
+        // paging anyone about
+        zScore = (value - series.mean) / deviation;
+        if (zScore > AgentConstants::ANOMALY_Z_THRESHOLD &&
+            value > series.mean * (1.0 + AgentConstants::ANOMALY_MIN_EXCESS_RATIO)) {
+            outlier = true;
+            // Winsorize so one stuck barrel does not drag the baseline
+            value = series.mean + AgentConstants::ANOMALY_Z_THRESHOLD * deviation;
+        }
+    }
+
+    if (series.count == 0) {
+        series.mean = value;
+        series.variance = 0.0;
+    }
+    else {
+        // Plain running mean until the EWMA weight takes over
+        double alpha = (std::max)(AgentConstants::ANOMALY_EWMA_ALPHA, 1.0 / (double)(series.count + 1));
+        double diff = value - series.mean;
+        double increment = alpha * diff;
+        series.mean += increment;
+        series.variance = (1.0 - alpha) * (series.variance + diff * increment);
+    }
+    series.count++;
+
+    return outlier;
+}
+
+bool AnomalyDetector::CoolingDown(Series& series, long long timeMs) {
+    if (series.hasEvent && timeMs - series.lastEventMs < AgentConstants::ANOMALY_COOLDOWN_MS) {
+        return true;
+    }
+
+    series.lastEventMs = timeMs;
+    series.hasEvent = true;
+    return false;
+}
+
+void AnomalyDetector::Add(const CycleSample& sample, std::vector<AnomalyEvent>& events) {
+    std::map<std::string, Series>::iterator it = series_.find(sample.operation);
+    if (it == series_.end()) {
+        if (series_.size() >= AgentConstants::CYCLE_STATS_MAX_OPERATIONS) {
+            return;
+        }
+        InitSeries(series_[sample.operation]);
+        it = series_.find(sample.operation);
+    }
+
+    Series& series = it->second;
+    double expectedMs = series.mean;
+    double zScore = 0.0;
+    bool outlier = Observe(series, (double)sample.durationMs, zScore);
+    bool overIdeal = sample.hasIdeal && sample.idealMs > 0 &&
+        (double)sample.durationMs > (double)sample.idealMs * AgentConstants::ANOMALY_IDEAL_FACTOR;
+
+    if ((outlier || overIdeal) && !CoolingDown(series, sample.timeMs)) {
+        AnomalyEvent event;
+        event.type = outlier ? "Outlier" : "OverIdeal";
+        event.operation = sample.operation;
+        event.barrelId = sample.barrelId;
+        event.timeMs = sample.timeMs;
+        event.durationMs = sample.durationMs;
+        event.expectedMs = expectedMs;
+        event.idealMs = sample.hasIdeal ? sample.idealMs : 0;
+        event.zScore = zScore;
+        events.push_back(event);
+    }
+
+    // Track the barrel's overall span across all of its operations
+    long long startMs = sample.timeMs - sample.durationMs;
+    std::unordered_map<long long, BarrelSpan>::iterator barrel = barrels_.find(sample.barrelId);
+    if (barrel == barrels_.end()) {
+        if (barrels_.size() >= AgentConstants::ANOMALY_MAX_OPEN_BARRELS) {
+            SweepBarrels(sample.timeMs, events);
+            if (barrels_.size() >= AgentConstants::ANOMALY_MAX_OPEN_BARRELS) {
+                barrels_.clear();
+            }
+        }
+        BarrelSpan& span = barrels_[sample.barrelId];
+        span.firstStartMs = startMs;
+        span.lastEndMs = sample.timeMs;
+    }
+    else {
+        if (startMs < barrel->second.firstStartMs) {
+            barrel->second.firstStartMs = startMs;
+        }
+        if (sample.timeMs > barrel->second.lastEndMs) {
+            barrel->second.lastEndMs = sample.timeMs;
+        }
+    }
+
+    if (sample.timeMs - lastSweepMs_ >= AgentConstants::ANOMALY_SWEEP_INTERVAL_MS) {
+        SweepBarrels(sample.timeMs, events);
+        lastSweepMs_ = sample.timeMs;
+    }
+}
+
+void AnomalyDetector::SweepBarrels(long long nowMs, std::vector<AnomalyEvent>& events) {
+    // A barrel with no activity for ANOMALY_BARREL_IDLE_MS has left the line
+    std::unordered_map<long long, BarrelSpan>::iterator it = barrels_.begin();
+    while (it != barrels_.end()) {
+        if (nowMs - it->second.lastEndMs < AgentConstants::ANOMALY_BARREL_IDLE_MS) {
+            ++it;
+            continue;
+        }
+
+        long long totalMs = it->second.lastEndMs - it->second.firstStartMs;
+        double expectedMs = barrelSeries_.mean;
+        double zScore = 0.0;
+        if (Observe(barrelSeries_, (double)totalMs, zScore) && !CoolingDown(barrelSeries_, it->second.lastEndMs)) {
+            AnomalyEvent event;
+            event.type = "BarrelCycle";
+            event.barrelId = it->first;
+            event.timeMs = it->second.lastEndMs;
+            event.durationMs = totalMs;
+            event.expectedMs = expectedMs;
+            event.zScore = zScore;
+            events.push_back(event);
+        }
+
+        it = barrels_.erase(it);
+    }
+}
+
+json AnomalyDetector::ToJson(const AnomalyEvent& event) {
+    json result;
+    result["type"] = event.type;
+    if (!event.operation.empty()) {
+        result["operation"] = event.operation;
+    }
+    result["barrelId"] = event.barrelId;
+    result["time"] = LogRecordScanner::FormatDateTime(event.timeMs);
+    result["durationMs"] = event.durationMs;
+    result["expectedMs"] = std::round(event.expectedMs);
+    if (event.idealMs > 0) {
+        result["idealMs"] = event.idealMs;
+    }
+    result["zScore"] = std::round(event.zScore * 100.0) / 100.0;
+    return result;
+}
\ No newline at end of file
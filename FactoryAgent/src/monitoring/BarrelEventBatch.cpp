@@ -0,0 +1,128 @@
+#include "../include/monitoring/BarrelEventBatch.h"
+#include "../include/common/Constants.h"
+#include <cstring>
+
+namespace {
+
+    const char BATCH_MAGIC[4] = { 'F', 'B', 'E', 'V' };
+
+    void PutVarint(std::string& out, unsigned long long value) {
+        while (value >= 0x80) {
+            out.push_back((char)((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+
+    void PutSigned(std::string& out, long long value) {
+        PutVarint(out, ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+    }
+}
+
+BarrelEventBatch::BarrelEventBatch() {
+    Reset("", 0, 0, 0);
+}
+
+void BarrelEventBatch::Reset(const std::string& logName, uint64_t logHeadHash, uint32_t logHeadBytes, uint64_t startOffset) {
+    logName_ = logName;
+    logHeadHash_ = logHeadHash;
+    logHeadBytes_ = logHeadBytes;
+    startOffset_ = startOffset;
+    endOffset_ = startOffset;
+    operations_.clear();
+    operationIndex_.clear();
+    rows_.clear();
+    baseTimeMs_ = 0;
+    previousTimeMs_ = 0;
+    previousBarrelId_ = 0;
+    count_ = 0;
+}
+
+void BarrelEventBatch::Add(const BarrelEvent& event, std::string_view operation, uint64_t endOffset) {
+    key_.assign(operation.data(), operation.size());
+    std::unordered_map<std::string, uint32_t>::iterator it = operationIndex_.find(key_);
+    if (it == operationIndex_.end()) {
+        it = operationIndex_.insert(std::make_pair(key_, (uint32_t)operations_.size())).first;
+        operations_.push_back(key_);
+    }
+
+    if (count_ == 0) {
+        baseTimeMs_ = event.timeMs;
+        previousTimeMs_ = event.timeMs;
+    }
+
+    PutSigned(rows_, event.timeMs - previousTimeMs_);
+    PutSigned(rows_, event.barrelId - previousBarrelId_);
+    PutVarint(rows_, it->second);
+    rows_.push_back((char)event.event);
+    PutVarint(rows_, event.durationMs >= 0 ? (unsigned long long)event.durationMs + 1 : 0);
+    PutVarint(rows_, event.idealMs >= 0 ? (unsigned long long)event.idealMs + 1 : 0);
+
+    previousTimeMs_ = event.timeMs;
+    previousBarrelId_ = event.barrelId;
+    endOffset_ = endOffset;
+    count_++;
+}
+
+void BarrelEventBatch::Encode(int pcId, uint64_t sequence, std::string& out) const {
+    BarrelEventBatchHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BATCH_MAGIC, sizeof(BATCH_MAGIC));
+    header.version = (uint16_t)AgentConstants::EVENT_STREAM_VERSION;
+    header.pcId = pcId;
+    header.eventCount = (uint32_t)count_;
+    header.sequence = sequence;
+    header.logHeadHash = logHeadHash_;
+    header.logHeadBytes = logHeadBytes_;
+    header.logNameBytes = (uint32_t)logName_.size();
+    header.startOffset = startOffset_;
+    header.endOffset = endOffset_;
+    header.baseTimeMs = baseTimeMs_;
+
+    out.clear();
+    out.append((const char*)&header, sizeof(header));
+    out.append(logName_);
+
+    PutVarint(out, operations_.size());
+    for (size_t i = 0; i < operations_.size(); i++) {
+        PutVarint(out, operations_[i].size());
+        out.append(operations_[i]);
+    }
+    out.append(rows_);
+}
+
+size_t BarrelEventBatch::GetCount() const {
+    return count_;
+}
+
+const std::string& BarrelEventBatch::GetLogName() const {
+    return logName_;
+}
+
+uint64_t BarrelEventBatch::GetLogHeadHash() const {
+    return logHeadHash_;
+}
+
+uint32_t BarrelEventBatch::GetLogHeadBytes() const {
+    return logHeadBytes_;
+}
+
+uint64_t BarrelEventBatch::GetEndOffset() const {
+    return endOffset_;
+}
+
+bool BarrelEventBatch::ReadHeader(const std::string& data, BarrelEventBatchHeader& header, std::string& logName) {
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, BATCH_MAGIC, sizeof(BATCH_MAGIC)) != 0 ||
+        header.version != AgentConstants::EVENT_STREAM_VERSION ||
+        data.size() < sizeof(header) + header.logNameBytes) {
+        return false;
+    }
+
+    logName.assign(data.data() + sizeof(header), header.logNameBytes);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "../include/monitoring/ConfigDiff.h"
+
+static const size_t NO_SECTION = (size_t)-1;
+
+void ConfigDiff::Compare(const IniDocument& before, const IniDocument& after, std::vector<ConfigChange>& changes) {
+    changes.clear();
+
+    for (size_t i = 0; i < after.GetSectionCount(); i++) {
+        size_t previous = MatchSection(before, i, after.GetSectionName(i));
+        if (previous != NO_SECTION && before.GetSectionHash(previous) == after.GetSectionHash(i)) {
+            continue;
+        }
+        CompareSection(before, previous, after, i, changes);
+    }
+
+    for (size_t i = 0; i < before.GetSectionCount(); i++) {
+        if (MatchSection(after, i, before.GetSectionName(i)) == NO_SECTION) {
+            CompareSection(before, i, after, NO_SECTION, changes);
+        }
+    }
+}
+
+size_t ConfigDiff::MatchSection(const IniDocument& document, size_t position, const std::string& name) {
+    // Sections rarely move, so try the same position before the hash lookup
+    if (position < document.GetSectionCount() && document.GetSectionName(position) == name) {
+        return position;
+    }
+
+    size_t index = NO_SECTION;
+    if (!document.FindSection(name, index)) {
+        return NO_SECTION;
+    }
+    return index;
+}
+
+void ConfigDiff::CompareSection(const IniDocument& before, size_t beforeSection,
+    const IniDocument& after, size_t afterSection, std::vector<ConfigChange>& changes) {
+    const std::string& name = afterSection != NO_SECTION ?
+        after.GetSectionName(afterSection) : before.GetSectionName(beforeSection);
+
+    if (afterSection != NO_SECTION) {
+        for (size_t k = 0; k < after.GetKeyCount(afterSection); k++) {
+            std::string key(after.GetKey(afterSection, k));
+            std::string_view newValue = after.GetValue(afterSection, k);
+            std::string_view oldValue;
+
+            if (beforeSection == NO_SECTION || !before.Find(name, key, oldValue)) {
+                ConfigChange change;
+                change.type = CONFIG_KEY_ADDED;
+                change.section = name;
+                change.key = key;
+                change.newValue = std::string(newValue);
+                changes.push_back(change);
+            }
+            else if (oldValue != newValue) {
+                ConfigChange change;
+                change.type = CONFIG_KEY_CHANGED;
+                change.section = name;
+                change.key = key;
+                change.oldValue = std::string(oldValue);
+                change.newValue = std::string(newValue);
+                changes.push_back(change);
+            }
+        }
+    }
+
+    if (beforeSection != NO_SECTION) {
+        for (size_t k = 0; k < before.GetKeyCount(beforeSection); k++) {
+            std::string key(before.GetKey(beforeSection, k));
+            std::string_view newValue;
+            if (afterSection == NO_SECTION || !after.Find(name, key, newValue)) {
+                ConfigChange change;
+                change.type = CONFIG_KEY_REMOVED;
+                change.section = name;
+                change.key = key;
+                change.oldValue = std::string(before.GetValue(beforeSection, k));
+                changes.push_back(change);
+            }
+        }
+    }
+}
+
+json ConfigDiff::ToJson(const std::vector<ConfigChange>& changes) {
+    json result = json::array();
+    for (size_t i = 0; i < changes.size(); i++) {
+        const ConfigChange& change = changes[i];
+        json entry = json::array();
+        entry.push_back(change.section);
+        entry.push_back(change.key);
+        if (change.type == CONFIG_KEY_ADDED) {
+            entry.push_back(nullptr);
+        }
+        else {
+            entry.push_back(change.oldValue);
+        }
+        if (change.type == CONFIG_KEY_REMOVED) {
+            entry.push_back(nullptr);
+        }
+        else {
+            entry.push_back(change.newValue);
+        }
+        result.push_back(entry);
+    }
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "../include/monitoring/ConfigHistory.h"
+#include "../include/utilities/FileUtils.h"
+#include "../include/utilities/HashUtils.h"
+#include "../include/common/Constants.h"
+#include "../../third_party/json/json.hpp"
+#include <set>
+
+using json = nlohmann::json;
+
+static long long CurrentTimeMs() {
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    unsigned long long ticks = ((unsigned long long)now.dwHighDateTime << 32) | now.dwLowDateTime;
+    return (long long)(ticks / 10000ULL) - 11644473600000LL;
+}
+
+ConfigHistory::ConfigHistory() {
+}
+
+std::string ConfigHistory::GetHistoryFolder(const std::string& configPath) {
+    return configPath + AgentConstants::CONFIG_HISTORY_FOLDER_SUFFIX;
+}
+
+std::string ConfigHistory::GetBlobPath(const std::string& configPath, const std::string& hash) {
+    return GetHistoryFolder(configPath) + "\\" + hash + AgentConstants::CONFIG_HISTORY_BLOB_EXTENSION;
+}
+
+std::string ConfigHistory::GetManifestPath(const std::string& configPath) {
+    return GetHistoryFolder(configPath) + "\\" + AgentConstants::CONFIG_HISTORY_MANIFEST;
+}
+
+bool ConfigHistory::Record(const std::string& configPath, const std::string& content, const std::string& source) {
+    std::vector<ConfigVersion> versions;
+    Load(configPath, versions);
+
+    std::string hash = HashUtils::ToHex(HashUtils::Xxh64(content.data(), content.size()));
+    if (!versions.empty() && versions.back().hash == hash) {
+        return true;
+    }
+
+    std::string folder = GetHistoryFolder(configPath);
+    if (!FileUtils::FolderExists(folder)) {
+        FileUtils::CreateFolder(folder);
+    }
+
+    // Content-addressed: a version seen before is already on disk
+    std::string blobPath = GetBlobPath(configPath, hash);
+    if (!FileUtils::FileExists(blobPath) && !FileUtils::WriteFileAtomic(blobPath, content)) {
+        return false;
+    }
+
+    ConfigVersion version;
+    version.hash = hash;
+    version.size = content.size();
+    version.savedAtMs = CurrentTimeMs();
+    version.source = source;
+    versions.push_back(version);
+
+    std::vector<ConfigVersion> dropped;
+    if (versions.size() > AgentConstants::CONFIG_HISTORY_VERSIONS) {
+        size_t excess = versions.size() - AgentConstants::CONFIG_HISTORY_VERSIONS;
+        dropped.assign(versions.begin(), versions.begin() + excess);
+        versions.erase(versions.begin(), versions.begin() + excess);
+    }
+
+    if (!Save(configPath, versions)) {
+        return false;
+    }
+
+    std::set<std::string> kept;
+    for (size_t i = 0; i < versions.size(); i++) {
+        kept.insert(versions[i].hash);
+    }
+    for (size_t i = 0; i < dropped.size(); i++) {
+        if (kept.find(dropped[i].hash) == kept.end()) {
+            FileUtils::DeleteFile(GetBlobPath(configPath, dropped[i].hash));
+        }
+    }
+    return true;
+}
+
+bool ConfigHistory::Load(const std::string& configPath, std::vector<ConfigVersion>& versions) {
+    versions.clear();
+
+    std::string content;
+    if (!FileUtils::ReadFileContent(GetManifestPath(configPath), content)) {
+        return false;
+    }
+
+    try {
+        json manifest = json::parse(content);
+        if (!manifest.contains("versions") || !manifest["versions"].is_array()) {
+            return false;
+        }
+
+        const json& entries = manifest["versions"];
+        for (size_t i = 0; i < entries.size(); i++) {
+            ConfigVersion version;
+            version.hash = entries[i].value("hash", "");
+            version.size = entries[i].value("size", 0ULL);
+            version.savedAtMs = entries[i].value("savedAtMs", 0LL);
+            version.source = entries[i].value("source", "");
+            if (!version.hash.empty()) {
+                versions.push_back(version);
+            }
+        }
+    }
+    catch (const std::exception&) {
+        versions.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ConfigHistory::ReadVersion(const std::string& configPath, const std::string& hash, std::string& content) {
+    if (!FileUtils::ReadFileContent(GetBlobPath(configPath, hash), content)) {
+        return false;
+    }
+    return HashUtils::ToHex(HashUtils::Xxh64(content.data(), content.size())) == hash;
+}
+
+bool ConfigHistory::Save(const std::string& configPath, const std::vector<ConfigVersion>& versions) {
+    json entries = json::array();
+    for (size_t i = 0; i < versions.size(); i++) {
+        json entry;
+        entry["hash"] = versions[i].hash;
+        entry["size"] = versions[i].size;
+        entry["savedAtMs"] = versions[i].savedAtMs;
+        entry["source"] = versions[i].source;
+        entries.push_back(entry);
+    }
+
+    json manifest;
+    manifest["versions"] = entries;
+    return FileUtils::WriteFileAtomic(GetManifestPath(configPath), manifest.dump(2));
+}
\ No newline at end of file
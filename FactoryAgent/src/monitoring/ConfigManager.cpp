@@ -2,9 +2,9 @@
 #include "../include/utilities/FileUtils.h"
 #include "../include/utilities/StringUtils.h"
 #include <sstream>
-#include <regex>
 
 ConfigManager::ConfigManager() {
+    documentParsed_ = false;
 }
 
 ConfigManager::~ConfigManager() {
@@ -58,33 +58,191 @@ void ConfigManager::SetValue(const std::string& key, const std::string& value) {
     settings_[key] = value;
 }
 
+bool ConfigManager::GetConfigSnapshot(const std::string& filePath, std::shared_ptr<const ConfigSnapshot>& snapshot) {
+    std::shared_ptr<const FileSnapshot> file;
+    if (!fileCache_.Refresh(filePath, file)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(snapshotMutex_);
+    if (snapshot_ && snapshot_->file == file && snapshotPath_ == filePath) {
+        snapshot = snapshot_;
+        return true;
+    }
+
+    std::shared_ptr<ConfigSnapshot> created = std::make_shared<ConfigSnapshot>();
+    created->file = file;
+    created->document.Parse(file->content);
+
+    std::string_view model;
+    if (created->document.Find("current_model", "model", model)) {
+        created->currentModel = std::string(model);
+    }
+
+    snapshot_ = created;
+    snapshotPath_ = filePath;
+    snapshot = snapshot_;
+    return true;
+}
+
 bool ConfigManager::ParseConfigFile(const std::string& filePath, std::string& content) {
-    return FileUtils::ReadFileContent(filePath, content);
+    std::shared_ptr<const ConfigSnapshot> snapshot;
+    if (!GetConfigSnapshot(filePath, snapshot)) {
+        return false;
+    }
+    content = snapshot->file->content;
+    return true;
 }
 
-bool ConfigManager::WriteConfigFile(const std::string& filePath, const std::string& content) {
-    return FileUtils::WriteFileContent(filePath, content);
+bool ConfigManager::WriteConfigFile(const std::string& filePath, const std::string& content, const std::string& source) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return WriteLocked(filePath, content, source);
 }
 
-std::string ConfigManager::GetCurrentModel(const std::string& configContent) {
-    // Capture everything after = until newline, then we trim it.
-    std::regex modelRegex(R"(\[current_model\]\s*model\s*=\s*([^\r\n]+))");
-    std::smatch match;
+bool ConfigManager::WriteLocked(const std::string& filePath, const std::string& content, const std::string& source) {
+    RecordCurrent(filePath);
+
+    if (!FileUtils::WriteFileAtomic(filePath, content)) {
+        fileCache_.Invalidate(filePath);
+        return false;
+    }
+    fileCache_.Store(filePath, content);
+    history_.Record(filePath, content, source);
+    return true;
+}
 
-    if (std::regex_search(configContent, match, modelRegex)) {
-        return StringUtils::Trim(match[1].str());
+bool ConfigManager::RollbackConfig(const std::string& filePath, int steps, const std::string& hash,
+    ConfigRollbackResult& result, std::string& error) {
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER start;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+
+    std::lock_guard<std::mutex> lock(configMutex_);
+
+    // Whatever is live now becomes the newest version, so the rollback can itself be undone
+    RecordCurrent(filePath);
+
+    std::vector<ConfigVersion> versions;
+    if (!history_.Load(filePath, versions) || versions.empty()) {
+        error = "No config history available";
+        return false;
+    }
+    result.fromHash = versions.back().hash;
+
+    int index = -1;
+    if (!hash.empty()) {
+        for (int i = (int)versions.size() - 1; i >= 0; i--) {
+            if (versions[i].hash == hash) {
+                index = i;
+                break;
+            }
+        }
+        if (index < 0) {
+            error = "Config version " + hash + " is not in the history";
+            return false;
+        }
+    }
+    else {
+        index = (int)versions.size() - 1 - steps;
+        if (steps < 1 || index < 0) {
+            error = "Only " + std::to_string(versions.size() - 1) + " earlier config versions are available";
+            return false;
+        }
+    }
+    result.toHash = versions[index].hash;
+    result.steps = (int)versions.size() - 1 - index;
+
+    std::string content;
+    if (!history_.ReadVersion(filePath, result.toHash, content)) {
+        error = "Stored config version " + result.toHash + " is missing or corrupt";
+        return false;
+    }
+
+    LARGE_INTEGER switchStart;
+    LARGE_INTEGER end;
+    QueryPerformanceCounter(&switchStart);
+    bool switched = FileUtils::WriteFileAtomic(filePath, content);
+    QueryPerformanceCounter(&end);
+
+    if (!switched) {
+        fileCache_.Invalidate(filePath);
+        error = "Failed to replace the config file";
+        return false;
+    }
+    fileCache_.Store(filePath, content);
+    history_.Record(filePath, content, "rollback");
+
+    result.switchUs = (unsigned long long)((end.QuadPart - switchStart.QuadPart) * 1000000 / frequency.QuadPart);
+    QueryPerformanceCounter(&end);
+    result.totalUs = (unsigned long long)((end.QuadPart - start.QuadPart) * 1000000 / frequency.QuadPart);
+    return true;
+}
+
+bool ConfigManager::GetConfigVersions(const std::string& filePath, std::vector<ConfigVersion>& versions) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return history_.Load(filePath, versions);
+}
+
+void ConfigManager::RecordCurrent(const std::string& filePath) {
+    std::shared_ptr<const FileSnapshot> file;
+    if (fileCache_.Refresh(filePath, file) && !file->content.empty()) {
+        history_.Record(filePath, file->content, "live");
+    }
+}
+
+std::string ConfigManager::GetCurrentModel(const std::string& configContent) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    std::string_view model;
+    if (GetDocument(configContent).Find("current_model", "model", model)) {
+        return std::string(model);
     }
 
     return "";
 }
 
 bool ConfigManager::UpdateCurrentModel(std::string& configContent, const std::string& modelName, const std::string& modelPath) {
-    // Replace the entire value line
-    std::regex modelRegex(R"((\[current_model\]\s*model\s*=\s*)([^\r\n]+))");
-    configContent = std::regex_replace(configContent, modelRegex, "$1" + modelName);
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return EditCurrentModel(configContent, modelName, modelPath);
+}
+
+bool ConfigManager::SetCurrentModel(const std::string& filePath, const std::string& modelName,
+    const std::string& modelPath, const std::string& source) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+
+    // Read under the lock, so the edit starts from the latest written version
+    std::shared_ptr<const ConfigSnapshot> snapshot;
+    if (!GetConfigSnapshot(filePath, snapshot)) {
+        return false;
+    }
+    std::string content = snapshot->file->content;
+    return EditCurrentModel(content, modelName, modelPath) && WriteLocked(filePath, content, source);
+}
 
-    std::regex pathRegex(R"((model_path\s*=\s*)([^\r\n]+))");
-    configContent = std::regex_replace(configContent, pathRegex, "$1" + modelPath);
+bool ConfigManager::EditCurrentModel(std::string& configContent, const std::string& modelName, const std::string& modelPath) {
+    IniDocument& document = GetDocument(configContent);
 
+    if (!document.SetValue("current_model", "model", modelName)) {
+        return false;
+    }
+
+    // model_path belongs in [current_model]; older configs keep it elsewhere
+    std::string_view existingPath;
+    if (document.Find("current_model", "model_path", existingPath)) {
+        document.SetValue("current_model", "model_path", modelPath);
+    }
+    else {
+        document.SetFirstValue("model_path", modelPath);
+    }
+
+    configContent = document.GetText();
     return true;
+}
+
+IniDocument& ConfigManager::GetDocument(const std::string& configContent) {
+    if (!documentParsed_ || configContent != document_.GetText()) {
+        document_.Parse(configContent);
+        documentParsed_ = true;
+    }
+    return document_;
 }
\ No newline at end of file
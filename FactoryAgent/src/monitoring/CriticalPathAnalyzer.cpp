@@ -0,0 +1,294 @@
+#include "../include/monitoring/CriticalPathAnalyzer.h"
+#include "../include/utilities/LogRecordScanner.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+#include <cmath>
+
+CriticalPathAnalyzer::CriticalPathAnalyzer(size_t maxBarrelDetails) {
+    maxBarrelDetails_ = maxBarrelDetails;
+    barrelsAnalyzed_ = 0;
+    lastSweepMs_ = 0;
+    totalSpanMs_ = 0;
+    totalBusyMs_ = 0;
+    totalIdleMs_ = 0;
+    totalWorkMs_ = 0;
+}
+
+void CriticalPathAnalyzer::Add(const CycleSample& sample) {
+    std::unordered_map<long long, OpenBarrel>::iterator it = open_.find(sample.barrelId);
+    if (it == open_.end()) {
+        if (open_.size() >= AgentConstants::CRITICAL_PATH_MAX_OPEN_BARRELS) {
+            Sweep(sample.timeMs);
+        }
+
+        // Still full: close whichever barrel has been quiet the longest
+        if (open_.size() >= AgentConstants::CRITICAL_PATH_MAX_OPEN_BARRELS) {
+            std::unordered_map<long long, OpenBarrel>::iterator oldest = open_.begin();
+            for (std::unordered_map<long long, OpenBarrel>::iterator scan = open_.begin(); scan != open_.end(); ++scan) {
+                if (scan->second.lastEndMs < oldest->second.lastEndMs) {
+                    oldest = scan;
+                }
+            }
+            Close(oldest->first, oldest->second);
+            open_.erase(oldest);
+        }
+
+        OpenBarrel& created = open_[sample.barrelId];
+        created.lastEndMs = sample.timeMs;
+        created.truncated = false;
+        it = open_.find(sample.barrelId);
+    }
+
+    OpenBarrel& barrel = it->second;
+    if (barrel.intervals.size() < AgentConstants::CRITICAL_PATH_MAX_OPS_PER_BARREL) {
+        OperationInterval interval;
+        interval.operation = sample.operation;
+        interval.startMs = sample.timeMs - sample.durationMs;
+        interval.endMs = sample.timeMs;
+        barrel.intervals.push_back(interval);
+    }
+    else {
+        barrel.truncated = true;
+    }
+    if (sample.timeMs > barrel.lastEndMs) {
+        barrel.lastEndMs = sample.timeMs;
+    }
+
+    if (sample.timeMs - lastSweepMs_ >= AgentConstants::CRITICAL_PATH_BARREL_IDLE_MS / 4) {
+        Sweep(sample.timeMs);
+        lastSweepMs_ = sample.timeMs;
+    }
+}
+
+void CriticalPathAnalyzer::Finish() {
+    for (std::unordered_map<long long, OpenBarrel>::iterator it = open_.begin(); it != open_.end(); ++it) {
+        Close(it->first, it->second);
+    }
+    open_.clear();
+}
+
+void CriticalPathAnalyzer::Sweep(long long nowMs) {
+    std::unordered_map<long long, OpenBarrel>::iterator it = open_.begin();
+    while (it != open_.end()) {
+        if (nowMs - it->second.lastEndMs >= AgentConstants::CRITICAL_PATH_BARREL_IDLE_MS) {
+            Close(it->first, it->second);
+            it = open_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void CriticalPathAnalyzer::Close(long long barrelId, OpenBarrel& barrel) {
+    if (barrel.intervals.empty()) {
+        return;
+    }
+
+    BarrelAnalysis analysis = Analyze(barrelId, barrel.intervals);
+    analysis.truncated = barrel.truncated;
+
+    barrelsAnalyzed_++;
+    totalSpanMs_ += analysis.endMs - analysis.startMs;
+    totalBusyMs_ += analysis.busyMs;
+    totalIdleMs_ += analysis.idleMs;
+    totalWorkMs_ += analysis.workMs;
+
+    for (size_t i = 0; i < barrel.intervals.size(); i++) {
+        std::map<std::string, OperationTotals>::iterator totals = totals_.find(barrel.intervals[i].operation);
+        if (totals == totals_.end()) {
+            if (totals_.size() >= AgentConstants::CYCLE_STATS_MAX_OPERATIONS) {
+                continue;
+            }
+            OperationTotals& created = totals_[barrel.intervals[i].operation];
+            created.samples = 0;
+            created.onCriticalPath = 0;
+            created.bottleneckCount = 0;
+            created.criticalMs = 0;
+            created.gapBeforeMs = 0;
+            totals = totals_.find(barrel.intervals[i].operation);
+        }
+        totals->second.samples++;
+    }
+
+    for (size_t i = 0; i < analysis.criticalPath.size(); i++) {
+        std::map<std::string, OperationTotals>::iterator totals = totals_.find(analysis.criticalPath[i].operation);
+        if (totals != totals_.end()) {
+            totals->second.onCriticalPath++;
+            totals->second.criticalMs += analysis.criticalPath[i].contributionMs;
+            totals->second.gapBeforeMs += analysis.criticalPath[i].gapBeforeMs;
+            if (analysis.criticalPath[i].operation == analysis.bottleneck) {
+                totals->second.bottleneckCount++;
+            }
+        }
+    }
+
+    if (details_.size() < maxBarrelDetails_) {
+        details_.push_back(analysis);
+    }
+}
+
+BarrelAnalysis CriticalPathAnalyzer::Analyze(long long barrelId, std::vector<OperationInterval>& intervals) {
+    BarrelAnalysis analysis;
+    analysis.barrelId = barrelId;
+    analysis.operationCount = intervals.size();
+    if (intervals.empty()) {
+        return analysis;
+    }
+
+    std::sort(intervals.begin(), intervals.end(),
+        [](const OperationInterval& a, const OperationInterval& b) {
+            return a.startMs < b.startMs || (a.startMs == b.startMs && a.endMs < b.endMs);
+        });
+
+    // Busy time is the union of the intervals; the rest of the span is idle
+    analysis.startMs = intervals[0].startMs;
+    analysis.endMs = intervals[0].endMs;
+    long long blockStart = intervals[0].startMs;
+    long long blockEnd = intervals[0].endMs;
+
+    for (size_t i = 0; i < intervals.size(); i++) {
+        const OperationInterval& interval = intervals[i];
+        analysis.workMs += interval.endMs - interval.startMs;
+        if (interval.endMs > analysis.endMs) {
+            analysis.endMs = interval.endMs;
+        }
+
+        if (interval.startMs > blockEnd) {
+            analysis.busyMs += blockEnd - blockStart;
+            blockStart = interval.startMs;
+            blockEnd = interval.endMs;
+        }
+        else if (interval.endMs > blockEnd) {
+            blockEnd = interval.endMs;
+        }
+    }
+    analysis.busyMs += blockEnd - blockStart;
+    analysis.idleMs = (analysis.endMs - analysis.startMs) - analysis.busyMs;
+    analysis.parallelism = analysis.busyMs > 0 ? (double)analysis.workMs / (double)analysis.busyMs : 1.0;
+
+    // Walk back from the operation that finished last. The predecessor of
+    // a step is whatever started before it and ended latest, i.e. the
+    // work the step was waiting on (or overlapping with).
+    size_t current = 0;
+    for (size_t i = 1; i < intervals.size(); i++) {
+        if (intervals[i].endMs > intervals[current].endMs ||
+            (intervals[i].endMs == intervals[current].endMs &&
+             intervals[i].startMs < intervals[current].startMs)) {
+            current = i;
+        }
+    }
+
+    std::vector<CriticalPathStep> reversed;
+    long long nextStart = intervals[current].endMs;
+
+    while (true) {
+        const OperationInterval& interval = intervals[current];
+
+        CriticalPathStep step;
+        step.operation = interval.operation;
+        step.startMs = interval.startMs;
+        step.durationMs = interval.endMs - interval.startMs;
+        step.contributionMs = (std::min)(interval.endMs, nextStart) - interval.startMs;
+        step.gapBeforeMs = 0;
+
+        bool found = false;
+        size_t predecessor = 0;
+        for (size_t i = 0; i < intervals.size(); i++) {
+            if (intervals[i].startMs >= interval.startMs) {
+                break;
+            }
+            if (!found || intervals[i].endMs > intervals[predecessor].endMs) {
+                predecessor = i;
+                found = true;
+            }
+        }
+
+        if (found && intervals[predecessor].endMs < interval.startMs) {
+            step.gapBeforeMs = interval.startMs - intervals[predecessor].endMs;
+        }
+        reversed.push_back(step);
+
+        if (!found) {
+            break;
+        }
+        nextStart = interval.startMs;
+        current = predecessor;
+    }
+
+    analysis.criticalPath.assign(reversed.rbegin(), reversed.rend());
+
+    long long longest = -1;
+    for (size_t i = 0; i < analysis.criticalPath.size(); i++) {
+        if (analysis.criticalPath[i].contributionMs > longest) {
+            longest = analysis.criticalPath[i].contributionMs;
+            analysis.bottleneck = analysis.criticalPath[i].operation;
+        }
+    }
+
+    return analysis;
+}
+
+json CriticalPathAnalyzer::ToJson() const {
+    json barrels = json::array();
+    for (size_t i = 0; i < details_.size(); i++) {
+        const BarrelAnalysis& analysis = details_[i];
+
+        json path = json::array();
+        for (size_t j = 0; j < analysis.criticalPath.size(); j++) {
+            const CriticalPathStep& step = analysis.criticalPath[j];
+            json entry;
+            entry["op"] = step.operation;
+            entry["offsetMs"] = step.startMs - analysis.startMs;
+            entry["durationMs"] = step.durationMs;
+            entry["contributionMs"] = step.contributionMs;
+            entry["gapBeforeMs"] = step.gapBeforeMs;
+            path.push_back(entry);
+        }
+
+        json barrel;
+        barrel["barrelId"] = analysis.barrelId;
+        barrel["start"] = LogRecordScanner::FormatDateTime(analysis.startMs);
+        barrel["spanMs"] = analysis.endMs - analysis.startMs;
+        barrel["busyMs"] = analysis.busyMs;
+        barrel["idleMs"] = analysis.idleMs;
+        barrel["workMs"] = analysis.workMs;
+        barrel["parallelism"] = std::round(analysis.parallelism * 100.0) / 100.0;
+        barrel["operations"] = analysis.operationCount;
+        barrel["criticalPath"] = path;
+        barrel["bottleneck"] = analysis.bottleneck;
+        if (analysis.truncated) {
+            barrel["truncated"] = true;
+        }
+        barrels.push_back(barrel);
+    }
+
+    json operations = json::array();
+    for (std::map<std::string, OperationTotals>::const_iterator it = totals_.begin(); it != totals_.end(); ++it) {
+        json entry;
+        entry["op"] = it->first;
+        entry["samples"] = it->second.samples;
+        entry["onCriticalPath"] = it->second.onCriticalPath;
+        entry["bottleneckCount"] = it->second.bottleneckCount;
+        entry["bottleneckShare"] = barrelsAnalyzed_ > 0 ?
+            std::round((double)it->second.bottleneckCount * 1000.0 / (double)barrelsAnalyzed_) / 1000.0 : 0.0;
+        entry["criticalMs"] = it->second.criticalMs;
+        entry["gapBeforeMs"] = it->second.gapBeforeMs;
+        operations.push_back(entry);
+    }
+
+    json summary;
+    summary["barrelsAnalyzed"] = barrelsAnalyzed_;
+    summary["totalSpanMs"] = totalSpanMs_;
+    summary["totalBusyMs"] = totalBusyMs_;
+    summary["totalIdleMs"] = totalIdleMs_;
+    summary["parallelism"] = totalBusyMs_ > 0 ?
+        std::round((double)totalWorkMs_ * 100.0 / (double)totalBusyMs_) / 100.0 : 0.0;
+
+    json result;
+    result["summary"] = summary;
+    result["operations"] = operations;
+    result["barrels"] = barrels;
+    result["barrelsTruncated"] = barrelsAnalyzed_ > details_.size();
+    return result;
+}
\ No newline at end of file
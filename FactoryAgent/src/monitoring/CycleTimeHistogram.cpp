@@ -0,0 +1,134 @@
+#include "../include/monitoring/CycleTimeHistogram.h"
+#include <cmath>
+#include <cstring>
+
+CycleTimeHistogram::CycleTimeHistogram() {
+    Clear();
+}
+
+void CycleTimeHistogram::Clear() {
+    memset(counts_, 0, sizeof(counts_));
+    count_ = 0;
+    sum_ = 0.0;
+    min_ = 0;
+    max_ = 0;
+}
+
+void CycleTimeHistogram::Record(long long valueMs) {
+    if (valueMs < 0) {
+        valueMs = 0;
+    }
+
+    counts_[GetBucketIndex(valueMs)]++;
+    sum_ += (double)valueMs;
+
+    if (count_ == 0 || valueMs < min_) {
+        min_ = valueMs;
+    }
+    if (count_ == 0 || valueMs > max_) {
+        max_ = valueMs;
+    }
+    count_++;
+}
+
+void CycleTimeHistogram::Merge(const CycleTimeHistogram& other) {
+    if (other.count_ == 0) {
+        return;
+    }
+
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        counts_[i] += other.counts_[i];
+    }
+
+    if (count_ == 0 || other.min_ < min_) {
+        min_ = other.min_;
+    }
+    if (count_ == 0 || other.max_ > max_) {
+        max_ = other.max_;
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+}
+
+unsigned long long CycleTimeHistogram::GetCount() const {
+    return count_;
+}
+
+double CycleTimeHistogram::GetMean() const {
+    return count_ > 0 ? sum_ / (double)count_ : 0.0;
+}
+
+long long CycleTimeHistogram::GetMin() const {
+    return min_;
+}
+
+long long CycleTimeHistogram::GetMax() const {
+    return max_;
+}
+
+long long CycleTimeHistogram::GetPercentile(double percentile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+
+    // Nearest-rank definition, the same one an exact sort would use
+    unsigned long long rank = (unsigned long long)std::ceil(percentile / 100.0 * (double)count_);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > count_) {
+        rank = count_;
+    }
+
+    unsigned long long seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            long long value = GetBucketValue(i);
+            if (value < min_) {
+                value = min_;
+            }
+            if (value > max_) {
+                value = max_;
+            }
+            return value;
+        }
+    }
+
+    return max_;
+}
+
+size_t CycleTimeHistogram::GetBucketIndex(long long valueMs) {
+    unsigned long long value = (unsigned long long)valueMs;
+    unsigned long long limit = (1ULL << MAX_VALUE_BITS) - 1;
+    if (value > limit) {
+        value = limit;
+    }
+
+    if (value < (unsigned long long)SUB_BUCKET_COUNT) {
+        return (size_t)value;
+    }
+
+    int highestBit = 63;
+    while ((value & (1ULL << highestBit)) == 0) {
+        highestBit--;
+    }
+
+    // Keep the top SUB_BUCKET_BITS + 1 bits; shift selects the octave
+    int shift = highestBit - SUB_BUCKET_BITS;
+    size_t subIndex = (size_t)(value >> shift) - SUB_BUCKET_HALF;
+    return SUB_BUCKET_COUNT + (size_t)(shift - 1) * SUB_BUCKET_HALF + subIndex;
+}
+
+long long CycleTimeHistogram::GetBucketValue(size_t index) {
+    if (index < (size_t)SUB_BUCKET_COUNT) {
+        return (long long)index;
+    }
+
+    // Midpoint of the bucket's value range
+    int shift = (int)((index - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF) + 1;
+    long long subValue = (long long)((index - SUB_BUCKET_COUNT) % SUB_BUCKET_HALF) + SUB_BUCKET_HALF;
+    long long low = subValue << shift;
+    long long width = 1LL << shift;
+    return low + width / 2;
+}
\ No newline at end of file
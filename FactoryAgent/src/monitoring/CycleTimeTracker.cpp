@@ -0,0 +1,100 @@
+#include "../include/monitoring/CycleTimeTracker.h"
+#include "../include/common/Constants.h"
+
+CycleTimeTracker::CycleTimeTracker() {
+}
+
+void CycleTimeTracker::Reset() {
+    pending_.clear();
+}
+
+bool CycleTimeTracker::Process(const LogRecord& record, CycleSample& sample) {
+    if (!record.IsEvent()) {
+        return false;
+    }
+
+    LogEvent event = LogRecordScanner::ParseEvent(record.fields[AgentConstants::LOG_FIELD_EVENT]);
+    if (event == LOG_EVENT_NONE) {
+        return false;
+    }
+
+    long long timeMs = 0;
+    LogPayload payload;
+    if (!LogRecordScanner::ParseDateTime(record.fields[AgentConstants::LOG_FIELD_DATETIME], timeMs) ||
+        !LogRecordScanner::ParsePayload(record.fields[AgentConstants::LOG_FIELD_PAYLOAD], payload)) {
+        return false;
+    }
+
+    return Process(event, record.fields[AgentConstants::LOG_FIELD_SEQUENCE], timeMs, payload, sample);
+}
+
+bool CycleTimeTracker::Process(LogEvent event, std::string_view operation, long long timeMs,
+    const LogPayload& payload, CycleSample& sample) {
+    if (event == LOG_EVENT_NONE) {
+        return false;
+    }
+
+    key_.assign(operation.data(), operation.size());
+    key_.push_back('\t');
+    key_.append(std::to_string(payload.barrelId));
+
+    if (event == LOG_EVENT_START) {
+        if (pending_.size() >= AgentConstants::LIVE_LOG_MAX_PENDING_STARTS) {
+            PrunePending(timeMs);
+        }
+
+        PendingStart& start = pending_[key_];
+        start.timeMs = timeMs;
+        start.idealMs = payload.idealMs;
+        start.hasIdeal = payload.hasIdealMs;
+        return false;
+    }
+
+    std::unordered_map<std::string, PendingStart>::iterator it = pending_.find(key_);
+    long long durationMs = -1;
+
+    if (payload.hasStartTs && payload.hasEndTs && payload.endTs >= payload.startTs) {
+        durationMs = payload.endTs - payload.startTs;
+    }
+    else if (it != pending_.end()) {
+        durationMs = timeMs - it->second.timeMs;
+    }
+
+    sample.hasIdeal = payload.hasIdealMs;
+    sample.idealMs = payload.idealMs;
+    if (!sample.hasIdeal && it != pending_.end()) {
+        sample.hasIdeal = it->second.hasIdeal;
+        sample.idealMs = it->second.idealMs;
+    }
+
+    if (it != pending_.end()) {
+        pending_.erase(it);
+    }
+
+    if (durationMs < 0) {
+        return false;
+    }
+
+    sample.operation.assign(operation.data(), operation.size());
+    sample.barrelId = payload.barrelId;
+    sample.timeMs = timeMs;
+    sample.durationMs = durationMs;
+    return true;
+}
+
+void CycleTimeTracker::PrunePending(long long nowMs) {
+    // STARTs without an END (aborted barrels) would otherwise accumulate
+    std::unordered_map<std::string, PendingStart>::iterator it = pending_.begin();
+    while (it != pending_.end()) {
+        if (nowMs - it->second.timeMs > AgentConstants::LIVE_LOG_PENDING_TIMEOUT_MS) {
+            it = pending_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    if (pending_.size() >= AgentConstants::LIVE_LOG_MAX_PENDING_STARTS) {
+        pending_.clear();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "../include/monitoring/FileStateCache.h"
+#include "../include/utilities/HashUtils.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+
+FileStateCache::FileStateCache() {
+    generation_ = 0;
+}
+
+FileStateCache::~FileStateCache() {
+}
+
+bool FileStateCache::Refresh(const std::string& filePath, std::shared_ptr<const FileSnapshot>& snapshot) {
+    HANDLE file = OpenForStamp(filePath);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    FileStamp stamp;
+    if (!ReadStamp(file, stamp)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, Entry>::iterator it = entries_.find(filePath);
+    if (it != entries_.end() && !it->second.racy && SameStamp(it->second.stamp, stamp)) {
+        CloseHandle(file);
+        snapshot = it->second.snapshot;
+        return true;
+    }
+
+    std::string content;
+    content.resize((size_t)stamp.size);
+    size_t total = 0;
+    while (total < content.size()) {
+        DWORD chunk = (DWORD)(std::min)(content.size() - total, (size_t)(1 << 30));
+        DWORD bytesRead = 0;
+        if (!ReadFile(file, &content[total], chunk, &bytesRead, NULL)) {
+            CloseHandle(file);
+            return false;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+        total += bytesRead;
+    }
+    content.resize(total);
+    CloseHandle(file);
+
+    Entry& entry = entries_[filePath];
+    Publish(entry, stamp, content);
+    snapshot = entry.snapshot;
+    return true;
+}
+
+void FileStateCache::Store(const std::string& filePath, const std::string& content) {
+    HANDLE file = OpenForStamp(filePath);
+    if (file == INVALID_HANDLE_VALUE) {
+        Invalidate(filePath);
+        return;
+    }
+
+    FileStamp stamp;
+    bool stamped = ReadStamp(file, stamp);
+    CloseHandle(file);
+    if (!stamped || stamp.size != content.size()) {
+        Invalidate(filePath);
+        return;
+    }
+
+    std::string copy = content;
+    std::lock_guard<std::mutex> lock(mutex_);
+    Publish(entries_[filePath], stamp, copy);
+}
+
+void FileStateCache::Invalidate(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(filePath);
+}
+
+void FileStateCache::Publish(Entry& entry, const FileStamp& stamp, std::string& content) {
+    uint64_t hash = HashUtils::Xxh64(content.data(), content.size());
+
+    entry.stamp = stamp;
+    entry.racy = IsRacy(stamp);
+
+    if (entry.snapshot && entry.snapshot->hash == hash && entry.snapshot->content.size() == content.size()) {
+        return;
+    }
+
+    std::shared_ptr<FileSnapshot> created = std::make_shared<FileSnapshot>();
+    created->content.swap(content);
+    created->hash = hash;
+    created->generation = ++generation_;
+    entry.snapshot = created;
+}
+
+HANDLE FileStateCache::OpenForStamp(const std::string& filePath) {
+    return CreateFileA(filePath.c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+}
+
+bool FileStateCache::ReadStamp(HANDLE file, FileStamp& stamp) {
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(file, &info)) {
+        return false;
+    }
+
+    stamp.size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+    stamp.writeTime = ((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+    stamp.volume = info.dwVolumeSerialNumber;
+    stamp.fileIndex = ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+    return true;
+}
+
+bool FileStateCache::SameStamp(const FileStamp& a, const FileStamp& b) {
+    return a.size == b.size && a.writeTime == b.writeTime &&
+        a.volume == b.volume && a.fileIndex == b.fileIndex;
+}
+
+bool FileStateCache::IsRacy(const FileStamp& stamp) {
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    uint64_t nowTicks = ((uint64_t)now.dwHighDateTime << 32) | now.dwLowDateTime;
+    uint64_t window = (uint64_t)AgentConstants::FILE_STATE_RACY_WINDOW_MS * 10000ULL;
+    return nowTicks < stamp.writeTime + window;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "../include/monitoring/FolderWatch.h"
+
+FolderWatch::FolderWatch() {
+    notification_ = INVALID_HANDLE_VALUE;
+    writeTime_ = 0;
+    changed_ = true;
+}
+
+FolderWatch::~FolderWatch() {
+    Close();
+}
+
+bool FolderWatch::Open(const std::string& folderPath) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (notification_ != INVALID_HANDLE_VALUE) {
+        FindCloseChangeNotification(notification_);
+        notification_ = INVALID_HANDLE_VALUE;
+    }
+    folderPath_ = folderPath;
+    writeTime_ = GetWriteTime(folderPath);
+    changed_ = true;
+    return StartNotification();
+}
+
+void FolderWatch::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (notification_ != INVALID_HANDLE_VALUE) {
+        FindCloseChangeNotification(notification_);
+        notification_ = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool FolderWatch::HasChanged() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (folderPath_.empty()) {
+        return false;
+    }
+
+    if (notification_ != INVALID_HANDLE_VALUE) {
+        // Re-armed before the caller rescans, so a change during the rescan is seen next time
+        if (WaitForSingleObject(notification_, 0) == WAIT_OBJECT_0) {
+            changed_ = true;
+            if (!FindNextChangeNotification(notification_)) {
+                FindCloseChangeNotification(notification_);
+                notification_ = INVALID_HANDLE_VALUE;
+            }
+        }
+    }
+    else {
+        // The folder may not have existed, or the share was reconnected
+        if (StartNotification()) {
+            changed_ = true;
+        }
+        uint64_t writeTime = GetWriteTime(folderPath_);
+        if (writeTime != writeTime_) {
+            writeTime_ = writeTime;
+            changed_ = true;
+        }
+    }
+
+    bool changed = changed_;
+    changed_ = false;
+    return changed;
+}
+
+bool FolderWatch::IsNotifying() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return notification_ != INVALID_HANDLE_VALUE;
+}
+
+bool FolderWatch::StartNotification() {
+    notification_ = FindFirstChangeNotificationA(folderPath_.c_str(), TRUE,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+        FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    return notification_ != INVALID_HANDLE_VALUE;
+}
+
+uint64_t FolderWatch::GetWriteTime(const std::string& folderPath) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(folderPath.c_str(), GetFileExInfoStandard, &data)) {
+        return 0;
+    }
+    return ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+}
\ No newline at end of file
@@ -0,0 +1,925 @@
+#include "../include/monitoring/LogArchive.h"
+#include "../include/monitoring/LogIndex.h"
+#include "../include/utilities/FileUtils.h"
+#include "../include/utilities/StringUtils.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+    const char ARCHIVE_MAGIC[4] = { 'F', 'C', 'O', 'L' };
+    const char PLACEHOLDER = '\x01';
+    const long long PROBE_BASE = 700000000000LL;
+    const int MAX_NUMBER_DIGITS = 18;
+
+    // Per-line flag bits
+    const long long FLAG_STRUCTURED = 1;
+    const int FLAG_TERMINATOR_SHIFT = 1;      // 0 none, 1 LF, 2 CRLF
+    const long long FLAG_CANONICAL_TIME = 8;
+
+    void PutVarint(std::string& out, unsigned long long value) {
+        while (value >= 0x80) {
+            out.push_back((char)((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+
+    void PutSigned(std::string& out, long long value) {
+        PutVarint(out, ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+    }
+
+    void PutStrings(std::string& out, const std::vector<std::string>& values) {
+        PutVarint(out, values.size());
+        for (size_t i = 0; i < values.size(); i++) {
+            PutVarint(out, values[i].size());
+            out.append(values[i]);
+        }
+    }
+
+    // Frame of reference: minimum, bit width, then (value - minimum) packed
+    void PutPacked(std::string& out, const std::vector<long long>& values) {
+        PutVarint(out, values.size());
+        if (values.empty()) {
+            return;
+        }
+
+        long long minimum = values[0];
+        long long maximum = values[0];
+        for (size_t i = 1; i < values.size(); i++) {
+            if (values[i] < minimum) minimum = values[i];
+            if (values[i] > maximum) maximum = values[i];
+        }
+
+        unsigned long long range = (unsigned long long)maximum - (unsigned long long)minimum;
+        int width = 0;
+        while (width < 64 && (range >> width) != 0) {
+            width++;
+        }
+
+        PutSigned(out, minimum);
+        out.push_back((char)width);
+        if (width == 0) {
+            return;
+        }
+
+        size_t start = out.size();
+        out.resize(start + (values.size() * width + 7) / 8, 0);
+        unsigned char* bytes = (unsigned char*)&out[start];
+        size_t position = 0;
+        unsigned long long buffer = 0;
+        int bufferedBits = 0;
+        for (size_t i = 0; i < values.size(); i++) {
+            unsigned long long delta = (unsigned long long)values[i] - (unsigned long long)minimum;
+            int remaining = width;
+            while (remaining > 0) {
+                int take = (std::min)(remaining, 64 - bufferedBits);
+                unsigned long long part = (take == 64) ? delta : (delta & ((1ULL << take) - 1));
+                buffer |= part << bufferedBits;
+                bufferedBits += take;
+                delta = (take == 64) ? 0 : (delta >> take);
+                remaining -= take;
+                while (bufferedBits >= 8) {
+                    bytes[position++] = (unsigned char)buffer;
+                    buffer >>= 8;
+                    bufferedBits -= 8;
+                }
+            }
+        }
+        if (bufferedBits > 0) {
+            bytes[position] = (unsigned char)buffer;
+        }
+    }
+
+    struct ByteReader {
+        const unsigned char* p;
+        const unsigned char* end;
+        bool ok;
+
+        ByteReader(const char* data, size_t size) {
+            p = (const unsigned char*)data;
+            end = p + size;
+            ok = true;
+        }
+
+        unsigned long long Varint() {
+            unsigned long long value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (p >= end) {
+                    ok = false;
+                    return 0;
+                }
+                unsigned char byte = *p++;
+                value |= (unsigned long long)(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+            ok = false;
+            return 0;
+        }
+
+        long long Signed() {
+            unsigned long long value = Varint();
+            return (long long)(value >> 1) ^ -(long long)(value & 1);
+        }
+
+        void Strings(std::vector<std::string>& values) {
+            unsigned long long count = Varint();
+            if (!ok || count > (unsigned long long)(end - p)) {
+                ok = false;
+                return;
+            }
+            values.resize((size_t)count);
+            for (size_t i = 0; i < values.size() && ok; i++) {
+                unsigned long long length = Varint();
+                if (!ok || length > (unsigned long long)(end - p)) {
+                    ok = false;
+                    return;
+                }
+                values[i].assign((const char*)p, (size_t)length);
+                p += length;
+            }
+        }
+
+        void Packed(std::vector<long long>& values) {
+            unsigned long long count = Varint();
+            if (!ok || count > (unsigned long long)AgentConstants::LOG_ARCHIVE_BLOCK_LINES * 64) {
+                ok = false;
+                return;
+            }
+            values.assign((size_t)count, 0);
+            if (count == 0) {
+                return;
+            }
+
+            long long minimum = Signed();
+            if (!ok || p >= end) {
+                ok = false;
+                return;
+            }
+            int width = *p++;
+            if (width > 64) {
+                ok = false;
+                return;
+            }
+
+            size_t byteCount = ((size_t)count * width + 7) / 8;
+            if (byteCount > (size_t)(end - p)) {
+                ok = false;
+                return;
+            }
+
+            // Values up to 56 bits always fit a byte-refilled 64-bit window;
+            // wider ones (rare, e.g. raw epoch deltas) go bit by bit
+            unsigned long long mask = (width == 64) ? ~0ULL : ((1ULL << width) - 1);
+            const unsigned char* in = p;
+            const unsigned char* inEnd = p + byteCount;
+            unsigned long long buffer = 0;
+            int bufferedBits = 0;
+            for (size_t i = 0; i < values.size(); i++) {
+                unsigned long long delta;
+                if (width <= 56) {
+                    while (bufferedBits < width) {
+                        buffer |= (unsigned long long)(in < inEnd ? *in++ : 0) << bufferedBits;
+                        bufferedBits += 8;
+                    }
+                    delta = buffer & mask;
+                    buffer >>= width;
+                    bufferedBits -= width;
+                }
+                else {
+                    delta = 0;
+                    for (int b = 0; b < width; b++) {
+                        if (bufferedBits == 0) {
+                            buffer = in < inEnd ? *in++ : 0;
+                            bufferedBits = 8;
+                        }
+                        delta |= (buffer & 1) << b;
+                        buffer >>= 1;
+                        bufferedBits--;
+                    }
+                }
+                values[i] = (long long)((unsigned long long)minimum + delta);
+            }
+            p += byteCount;
+        }
+    };
+
+    // Replaces each digit run (no leading zero, up to 18 digits) with a
+    // placeholder; everything else stays literal in the template
+    bool SplitPayload(std::string_view payload, std::string& payloadTemplate, std::vector<long long>& numbers) {
+        payloadTemplate.clear();
+        numbers.clear();
+
+        size_t i = 0;
+        while (i < payload.size()) {
+            char c = payload[i];
+            if (c == PLACEHOLDER) {
+                return false;
+            }
+            if (c < '0' || c > '9') {
+                payloadTemplate.push_back(c);
+                i++;
+                continue;
+            }
+
+            size_t start = i;
+            while (i < payload.size() && payload[i] >= '0' && payload[i] <= '9') {
+                i++;
+            }
+            size_t length = i - start;
+
+            if ((length > 1 && payload[start] == '0') || length > (size_t)MAX_NUMBER_DIGITS) {
+                payloadTemplate.append(payload.data() + start, length);
+                continue;
+            }
+
+            long long value = 0;
+            for (size_t j = start; j < i; j++) {
+                value = value * 10 + (payload[j] - '0');
+            }
+            payloadTemplate.push_back(PLACEHOLDER);
+            numbers.push_back(value);
+        }
+        return true;
+    }
+
+    void AppendPayload(std::string& out, const std::string& payloadTemplate, const long long* values, size_t valueCount) {
+        size_t next = 0;
+        for (size_t i = 0; i < payloadTemplate.size(); i++) {
+            if (payloadTemplate[i] == PLACEHOLDER && next < valueCount) {
+                out.append(std::to_string(values[next++]));
+            }
+            else {
+                out.push_back(payloadTemplate[i]);
+            }
+        }
+    }
+
+    size_t CountPlaceholders(const std::string& payloadTemplate) {
+        size_t count = 0;
+        for (size_t i = 0; i < payloadTemplate.size(); i++) {
+            if (payloadTemplate[i] == PLACEHOLDER) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    bool SamePayload(const LogPayload& a, const LogPayload& b) {
+        return a.hasBarrelId == b.hasBarrelId && (!a.hasBarrelId || a.barrelId == b.barrelId) &&
+            a.hasStartTs == b.hasStartTs && (!a.hasStartTs || a.startTs == b.startTs) &&
+            a.hasEndTs == b.hasEndTs && (!a.hasEndTs || a.endTs == b.endTs) &&
+            a.hasIdealMs == b.hasIdealMs && (!a.hasIdealMs || a.idealMs == b.idealMs);
+    }
+
+    const char* TERMINATORS[3] = { "", "\n", "\r\n" };
+}
+
+struct LogArchive::BlockBuilder {
+    std::vector<long long> flags;
+    long long baseTime;
+    long long previousTime;
+    bool haveTime;
+    std::vector<long long> timeDeltas;
+    std::vector<std::string> timeStrings;
+    std::vector<std::string> dictionaries[AgentConstants::LOG_FIELD_COUNT];
+    std::unordered_map<std::string, long long> lookup[AgentConstants::LOG_FIELD_COUNT];
+    std::vector<long long> ids[AgentConstants::LOG_FIELD_COUNT];
+    std::vector<std::vector<long long> > slots;
+    std::vector<std::string> rawLines;
+
+    LogArchiveBlockEntry entry;
+    bool haveRange;
+
+    std::unordered_map<std::string, PayloadSlots> slotCache;
+    std::string payloadTemplate;
+    std::vector<long long> numbers;
+
+    BlockBuilder() {
+        Reset(0);
+    }
+
+    void Reset(uint64_t textOffset) {
+        flags.clear();
+        baseTime = 0;
+        previousTime = 0;
+        haveTime = false;
+        timeDeltas.clear();
+        timeStrings.clear();
+        for (int f = 0; f < AgentConstants::LOG_FIELD_COUNT; f++) {
+            dictionaries[f].clear();
+            lookup[f].clear();
+            ids[f].clear();
+        }
+        slots.clear();
+        rawLines.clear();
+
+        memset(&entry, 0, sizeof(entry));
+        entry.textOffset = textOffset;
+        haveRange = false;
+    }
+
+    long long Intern(int field, std::string_view value) {
+        std::string key(value.data(), value.size());
+        std::unordered_map<std::string, long long>::iterator it = lookup[field].find(key);
+        if (it != lookup[field].end()) {
+            return it->second;
+        }
+        long long id = (long long)dictionaries[field].size();
+        dictionaries[field].push_back(key);
+        lookup[field][key] = id;
+        return id;
+    }
+
+    void NoteTime(long long timeMs) {
+        if (!haveRange || timeMs < entry.minTimeMs) entry.minTimeMs = timeMs;
+        if (!haveRange || timeMs > entry.maxTimeMs) entry.maxTimeMs = timeMs;
+        haveRange = true;
+    }
+
+    const PayloadSlots& SlotsFor(const std::string& templateText) {
+        std::unordered_map<std::string, PayloadSlots>::iterator it = slotCache.find(templateText);
+        if (it == slotCache.end()) {
+            PayloadSlots mapped;
+            MapPayloadSlots(templateText, mapped);
+            it = slotCache.insert(std::make_pair(templateText, mapped)).first;
+        }
+        return it->second;
+    }
+
+    void AddLine(const LogRecord& record, const char* text) {
+        entry.lineCount++;
+        entry.textSize += record.length;
+
+        long long timeMs = 0;
+        bool hasTime = record.fieldCount > 0 &&
+            LogRecordScanner::ParseDateTime(record.fields[AgentConstants::LOG_FIELD_DATETIME], timeMs);
+        if (hasTime) {
+            NoteTime(timeMs);
+        }
+
+        if (!AddStructured(record, text, hasTime, timeMs)) {
+            flags.push_back(0);
+            rawLines.push_back(std::string(text, record.length));
+        }
+    }
+
+    bool AddStructured(const LogRecord& record, const char* text, bool hasTime, long long timeMs) {
+        if (!record.IsEvent()) {
+            return false;
+        }
+
+        std::string_view terminator(text + record.line.size(), record.length - record.line.size());
+        int terminatorCode = -1;
+        for (int i = 0; i < 3; i++) {
+            if (terminator == TERMINATORS[i]) {
+                terminatorCode = i;
+            }
+        }
+        if (terminatorCode < 0) {
+            return false;
+        }
+
+        // Numbers must decode to exactly what the text parser reads, so
+        // analysis over the archive matches analysis over the log
+        std::string_view payloadText = record.fields[AgentConstants::LOG_FIELD_PAYLOAD];
+        if (!SplitPayload(payloadText, payloadTemplate, numbers)) {
+            return false;
+        }
+
+        LogPayload expected;
+        LogRecordScanner::ParsePayload(payloadText, expected);
+        LogPayload decoded;
+        FillPayload(SlotsFor(payloadTemplate), numbers.data(), numbers.size(), decoded);
+        if (!SamePayload(expected, decoded)) {
+            return false;
+        }
+
+        std::string_view timeText = record.fields[AgentConstants::LOG_FIELD_DATETIME];
+        bool canonical = hasTime && LogRecordScanner::FormatDateTime(timeMs) == timeText;
+
+        long long flag = FLAG_STRUCTURED | ((long long)terminatorCode << FLAG_TERMINATOR_SHIFT);
+        if (canonical) {
+            flag |= FLAG_CANONICAL_TIME;
+            if (!haveTime) {
+                baseTime = timeMs;
+                previousTime = timeMs;
+                haveTime = true;
+            }
+            timeDeltas.push_back(timeMs - previousTime);
+            previousTime = timeMs;
+        }
+        else {
+            timeStrings.push_back(std::string(timeText.data(), timeText.size()));
+        }
+        flags.push_back(flag);
+
+        for (int f = 1; f < AgentConstants::LOG_FIELD_PAYLOAD; f++) {
+            ids[f].push_back(Intern(f, record.fields[f]));
+        }
+        ids[AgentConstants::LOG_FIELD_PAYLOAD].push_back(Intern(AgentConstants::LOG_FIELD_PAYLOAD, payloadTemplate));
+
+        if (slots.size() < numbers.size()) {
+            slots.resize(numbers.size());
+        }
+        for (size_t i = 0; i < numbers.size(); i++) {
+            slots[i].push_back(numbers[i]);
+        }
+        return true;
+    }
+
+    void Serialize(std::string& out) const {
+        PutVarint(out, entry.lineCount);
+        PutPacked(out, flags);
+        PutSigned(out, baseTime);
+        PutPacked(out, timeDeltas);
+        PutStrings(out, timeStrings);
+        for (int f = 1; f < AgentConstants::LOG_FIELD_COUNT; f++) {
+            PutStrings(out, dictionaries[f]);
+            PutPacked(out, ids[f]);
+        }
+        PutVarint(out, slots.size());
+        for (size_t i = 0; i < slots.size(); i++) {
+            PutPacked(out, slots[i]);
+        }
+        PutStrings(out, rawLines);
+    }
+};
+
+LogArchive::LogArchive() {
+    header_ = NULL;
+    blocks_ = NULL;
+}
+
+LogArchive::~LogArchive() {
+    Close();
+}
+
+bool LogArchive::IsArchiveFile(const std::string& filePath) {
+    std::string lowerPath = StringUtils::ToLower(filePath);
+    return StringUtils::EndsWith(lowerPath, AgentConstants::LOG_ARCHIVE_EXTENSION) ||
+        StringUtils::EndsWith(lowerPath, std::string(AgentConstants::LOG_ARCHIVE_EXTENSION) + ".tmp");
+}
+
+std::string LogArchive::GetArchivePath(const std::string& logPath) {
+    return logPath + AgentConstants::LOG_ARCHIVE_EXTENSION;
+}
+
+bool LogArchive::Build(const std::string& logPath, LogArchiveStats& stats) {
+    ULONGLONG startTick = GetTickCount64();
+
+    MappedFile log;
+    if (!log.Open(logPath) || log.GetSize() == 0) {
+        return false;
+    }
+
+    const char* data = log.GetData();
+    size_t size = log.GetSize();
+    std::string archivePath = GetArchivePath(logPath);
+    std::string tempPath = archivePath + ".tmp";
+
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    LogArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    header.version = AgentConstants::LOG_ARCHIVE_VERSION;
+    header.sourceSize = size;
+    header.headHash = LogIndex::HashHead(data, size);
+    out.write((const char*)&header, sizeof(header));
+
+    std::vector<LogArchiveBlockEntry> index;
+    BlockBuilder builder;
+    std::string encoded;
+    uint64_t writeOffset = sizeof(header);
+
+    LogRecordScanner scanner(data, size);
+    LogRecord record;
+    bool more = true;
+
+    while (more) {
+        more = scanner.Next(record);
+        if (more) {
+            builder.AddLine(record, data + record.offset);
+            header.lineCount++;
+        }
+
+        if (builder.entry.lineCount > 0 &&
+            (!more || builder.entry.lineCount >= AgentConstants::LOG_ARCHIVE_BLOCK_LINES)) {
+            encoded.clear();
+            builder.Serialize(encoded);
+            out.write(encoded.data(), encoded.size());
+
+            builder.entry.blockOffset = writeOffset;
+            builder.entry.blockSize = (uint32_t)encoded.size();
+            index.push_back(builder.entry);
+            writeOffset += encoded.size();
+            stats.rawLines += builder.rawLines.size();
+
+            builder.Reset(builder.entry.textOffset + builder.entry.textSize);
+        }
+    }
+
+    header.blockCount = (uint32_t)index.size();
+    header.indexOffset = writeOffset;
+    if (!index.empty()) {
+        out.write((const char*)index.data(), index.size() * sizeof(LogArchiveBlockEntry));
+    }
+    out.seekp(0);
+    out.write((const char*)&header, sizeof(header));
+    bool written = out.good();
+    out.close();
+
+    // Never publish an archive that does not reproduce the log byte for byte
+    if (written) {
+        LogArchive verify;
+        written = verify.OpenArchive(tempPath);
+        std::string text;
+        for (uint32_t i = 0; written && i < verify.GetBlockCount(); i++) {
+            const LogArchiveBlockEntry& entry = verify.GetBlock(i);
+            written = verify.ReadText(i, text) && text.size() == entry.textSize &&
+                memcmp(text.data(), data + entry.textOffset, text.size()) == 0;
+        }
+    }
+
+    log.Close();
+
+    if (!written || !MoveFileExA(tempPath.c_str(), archivePath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        FileUtils::DeleteFile(tempPath);
+        return false;
+    }
+
+    stats.sourceBytes += size;
+    stats.archiveBytes += writeOffset + index.size() * sizeof(LogArchiveBlockEntry);
+    stats.lines += header.lineCount;
+    stats.elapsedMs += GetTickCount64() - startTick;
+    return true;
+}
+
+bool LogArchive::Open(const std::string& logPath) {
+    if (!OpenArchive(GetArchivePath(logPath))) {
+        return false;
+    }
+
+    // A log that is still present must be the one that was archived
+    if (FileUtils::FileExists(logPath)) {
+        MappedFile log;
+        if (!log.Open(logPath) || log.GetSize() != header_->sourceSize ||
+            LogIndex::HashHead(log.GetData(), log.GetSize()) != header_->headHash) {
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LogArchive::OpenArchive(const std::string& archivePath) {
+    Close();
+
+    if (!file_.Open(archivePath) || file_.GetSize() < sizeof(LogArchiveHeader)) {
+        file_.Close();
+        return false;
+    }
+
+    const LogArchiveHeader* header = (const LogArchiveHeader*)file_.GetData();
+    uint64_t indexBytes = (uint64_t)header->blockCount * sizeof(LogArchiveBlockEntry);
+    if (memcmp(header->magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 ||
+        header->version != AgentConstants::LOG_ARCHIVE_VERSION ||
+        header->indexOffset + indexBytes > file_.GetSize()) {
+        file_.Close();
+        return false;
+    }
+
+    header_ = header;
+    blocks_ = (const LogArchiveBlockEntry*)(file_.GetData() + header->indexOffset);
+    return true;
+}
+
+void LogArchive::Close() {
+    file_.Close();
+    header_ = NULL;
+    blocks_ = NULL;
+}
+
+uint64_t LogArchive::GetSourceSize() const {
+    return header_ ? header_->sourceSize : 0;
+}
+
+uint32_t LogArchive::GetBlockCount() const {
+    return header_ ? header_->blockCount : 0;
+}
+
+const LogArchiveBlockEntry& LogArchive::GetBlock(uint32_t block) const {
+    return blocks_[block];
+}
+
+bool LogArchive::Decode(uint32_t block) {
+    if (header_ == NULL || block >= header_->blockCount) {
+        return false;
+    }
+
+    const LogArchiveBlockEntry& entry = blocks_[block];
+    if (entry.blockOffset + entry.blockSize > header_->indexOffset) {
+        return false;
+    }
+
+    ByteReader reader(file_.GetData() + entry.blockOffset, entry.blockSize);
+    unsigned long long lineCount = reader.Varint();
+    reader.Packed(decoded_.flags);
+    long long baseTime = reader.Signed();
+    reader.Packed(decoded_.times);
+    reader.Strings(decoded_.timeStrings);
+    for (int f = 1; f < AgentConstants::LOG_FIELD_COUNT && reader.ok; f++) {
+        reader.Strings(decoded_.dictionaries[f]);
+        reader.Packed(decoded_.ids[f]);
+    }
+
+    unsigned long long slotCount = reader.ok ? reader.Varint() : 0;
+    if (!reader.ok || slotCount > entry.blockSize) {
+        return false;
+    }
+    decoded_.slots.resize((size_t)slotCount);
+    for (size_t i = 0; i < decoded_.slots.size() && reader.ok; i++) {
+        reader.Packed(decoded_.slots[i]);
+    }
+    reader.Strings(decoded_.rawLines);
+
+    if (!reader.ok || lineCount != entry.lineCount || decoded_.flags.size() != lineCount) {
+        return false;
+    }
+
+    // Turn the deltas back into absolute times
+    long long running = baseTime;
+    for (size_t i = 0; i < decoded_.times.size(); i++) {
+        running += decoded_.times[i];
+        decoded_.times[i] = running;
+    }
+
+    // Every id must point into its dictionary
+    for (int f = 1; f < AgentConstants::LOG_FIELD_COUNT; f++) {
+        for (size_t i = 0; i < decoded_.ids[f].size(); i++) {
+            if (decoded_.ids[f][i] < 0 || (size_t)decoded_.ids[f][i] >= decoded_.dictionaries[f].size()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool LogArchive::ReadText(uint32_t block, std::string& text) {
+    text.clear();
+    if (!Decode(block)) {
+        return false;
+    }
+
+    const DecodedBlock& d = decoded_;
+    size_t structured = 0;
+    size_t raw = 0;
+    size_t canonical = 0;
+    size_t timeString = 0;
+    std::vector<size_t> slotPositions(d.slots.size(), 0);
+    std::vector<long long> values;
+
+    text.reserve((size_t)blocks_[block].textSize);
+
+    for (size_t line = 0; line < d.flags.size(); line++) {
+        long long flag = d.flags[line];
+        if ((flag & FLAG_STRUCTURED) == 0) {
+            if (raw >= d.rawLines.size()) {
+                return false;
+            }
+            text.append(d.rawLines[raw++]);
+            continue;
+        }
+
+        if (structured >= d.ids[1].size()) {
+            return false;
+        }
+
+        if (flag & FLAG_CANONICAL_TIME) {
+            if (canonical >= d.times.size()) {
+                return false;
+            }
+            text.append(LogRecordScanner::FormatDateTime(d.times[canonical++]));
+        }
+        else {
+            if (timeString >= d.timeStrings.size()) {
+                return false;
+            }
+            text.append(d.timeStrings[timeString++]);
+        }
+
+        for (int f = 1; f < AgentConstants::LOG_FIELD_PAYLOAD; f++) {
+            text.push_back('\t');
+            text.append(d.dictionaries[f][(size_t)d.ids[f][structured]]);
+        }
+        text.push_back('\t');
+
+        const std::string& payloadTemplate =
+            d.dictionaries[AgentConstants::LOG_FIELD_PAYLOAD][(size_t)d.ids[AgentConstants::LOG_FIELD_PAYLOAD][structured]];
+        size_t valueCount = CountPlaceholders(payloadTemplate);
+        if (valueCount > d.slots.size()) {
+            return false;
+        }
+        values.resize(valueCount);
+        for (size_t i = 0; i < valueCount; i++) {
+            if (slotPositions[i] >= d.slots[i].size()) {
+                return false;
+            }
+            values[i] = d.slots[i][slotPositions[i]++];
+        }
+        AppendPayload(text, payloadTemplate, values.data(), valueCount);
+
+        int terminatorCode = (int)((flag >> FLAG_TERMINATOR_SHIFT) & 3);
+        if (terminatorCode > 2) {
+            return false;
+        }
+        text.append(TERMINATORS[terminatorCode]);
+        structured++;
+    }
+
+    return true;
+}
+
+bool LogArchive::ReadEvents(uint32_t block, std::vector<ArchivedEvent>& events) {
+    events.clear();
+    if (!Decode(block)) {
+        return false;
+    }
+
+    const DecodedBlock& d = decoded_;
+
+    // Per-dictionary-entry work is done once per block, not once per line
+    const std::vector<std::string>& eventNames = d.dictionaries[AgentConstants::LOG_FIELD_EVENT];
+    eventKinds_.resize(eventNames.size());
+    for (size_t i = 0; i < eventNames.size(); i++) {
+        eventKinds_[i] = LogRecordScanner::ParseEvent(eventNames[i]);
+    }
+
+    const std::vector<std::string>& templates = d.dictionaries[AgentConstants::LOG_FIELD_PAYLOAD];
+    templateSlots_.resize(templates.size());
+    std::vector<size_t> templateCounts(templates.size());
+    for (size_t i = 0; i < templates.size(); i++) {
+        MapPayloadSlots(templates[i], templateSlots_[i]);
+        templateCounts[i] = CountPlaceholders(templates[i]);
+        if (templateCounts[i] > d.slots.size()) {
+            return false;
+        }
+    }
+
+    size_t structured = 0;
+    size_t raw = 0;
+    size_t canonical = 0;
+    size_t timeString = 0;
+    std::vector<size_t> slotPositions(d.slots.size(), 0);
+    long long values[64];
+
+    for (size_t line = 0; line < d.flags.size(); line++) {
+        long long flag = d.flags[line];
+
+        if ((flag & FLAG_STRUCTURED) == 0) {
+            // Verbatim lines go through the regular text path
+            if (raw >= d.rawLines.size()) {
+                return false;
+            }
+            const std::string& rawLine = d.rawLines[raw++];
+            LogRecordScanner scanner(rawLine.data(), rawLine.size());
+            LogRecord record;
+            ArchivedEvent event;
+            if (scanner.Next(record) && record.IsEvent() &&
+                LogRecordScanner::ParseDateTime(record.fields[AgentConstants::LOG_FIELD_DATETIME], event.timeMs) &&
+                LogRecordScanner::ParsePayload(record.fields[AgentConstants::LOG_FIELD_PAYLOAD], event.payload)) {
+                event.event = LogRecordScanner::ParseEvent(record.fields[AgentConstants::LOG_FIELD_EVENT]);
+                event.operation = record.fields[AgentConstants::LOG_FIELD_SEQUENCE];
+                events.push_back(event);
+            }
+            continue;
+        }
+
+        if (structured >= d.ids[1].size()) {
+            return false;
+        }
+
+        ArchivedEvent event;
+        bool hasTime = true;
+        if (flag & FLAG_CANONICAL_TIME) {
+            if (canonical >= d.times.size()) {
+                return false;
+            }
+            event.timeMs = d.times[canonical++];
+        }
+        else {
+            if (timeString >= d.timeStrings.size()) {
+                return false;
+            }
+            hasTime = LogRecordScanner::ParseDateTime(d.timeStrings[timeString++], event.timeMs);
+        }
+
+        size_t templateId = (size_t)d.ids[AgentConstants::LOG_FIELD_PAYLOAD][structured];
+        size_t valueCount = templateCounts[templateId];
+        for (size_t i = 0; i < valueCount; i++) {
+            if (slotPositions[i] >= d.slots[i].size()) {
+                return false;
+            }
+            long long value = d.slots[i][slotPositions[i]++];
+            if (i < 64) {
+                values[i] = value;
+            }
+        }
+
+        event.event = eventKinds_[(size_t)d.ids[AgentConstants::LOG_FIELD_EVENT][structured]];
+        event.operation = d.dictionaries[AgentConstants::LOG_FIELD_SEQUENCE][(size_t)d.ids[AgentConstants::LOG_FIELD_SEQUENCE][structured]];
+        FillPayload(templateSlots_[templateId], values, (std::min)(valueCount, (size_t)64), event.payload);
+        structured++;
+
+        if (hasTime && event.payload.hasBarrelId) {
+            events.push_back(event);
+        }
+    }
+
+    return true;
+}
+
+bool LogArchive::Reconstruct(std::string& text) {
+    text.clear();
+    if (header_ == NULL) {
+        return false;
+    }
+
+    text.reserve((size_t)header_->sourceSize);
+    std::string blockText;
+    for (uint32_t i = 0; i < header_->blockCount; i++) {
+        if (!ReadText(i, blockText)) {
+            return false;
+        }
+        text.append(blockText);
+    }
+    return text.size() == header_->sourceSize;
+}
+
+bool LogArchive::MapPayloadSlots(const std::string& payloadTemplate, PayloadSlots& slots) {
+    // Parse the template with a distinct probe number in every slot and see
+    // which slot each known key picked up
+    std::string probe;
+    long long next = 0;
+    for (size_t i = 0; i < payloadTemplate.size(); i++) {
+        if (payloadTemplate[i] == PLACEHOLDER) {
+            probe.append(std::to_string(PROBE_BASE + next++));
+        }
+        else {
+            probe.push_back(payloadTemplate[i]);
+        }
+    }
+
+    LogPayload parsed;
+    slots.valid = LogRecordScanner::ParsePayload(probe, parsed);
+
+    const long long values[4] = { parsed.barrelId, parsed.startTs, parsed.endTs, parsed.idealMs };
+    const bool present[4] = { parsed.hasBarrelId, parsed.hasStartTs, parsed.hasEndTs, parsed.hasIdealMs };
+
+    for (int k = 0; k < 4; k++) {
+        slots.present[k] = present[k];
+        slots.slot[k] = -1;
+        slots.negate[k] = false;
+        slots.constant[k] = values[k];
+
+        if (values[k] >= PROBE_BASE && values[k] < PROBE_BASE + next) {
+            slots.slot[k] = (int)(values[k] - PROBE_BASE);
+        }
+        else if (-values[k] >= PROBE_BASE && -values[k] < PROBE_BASE + next) {
+            slots.slot[k] = (int)(-values[k] - PROBE_BASE);
+            slots.negate[k] = true;
+        }
+    }
+    return slots.valid;
+}
+
+void LogArchive::FillPayload(const PayloadSlots& slots, const long long* values, size_t valueCount, LogPayload& payload) {
+    long long* targets[4] = { &payload.barrelId, &payload.startTs, &payload.endTs, &payload.idealMs };
+    bool* flags[4] = { &payload.hasBarrelId, &payload.hasStartTs, &payload.hasEndTs, &payload.hasIdealMs };
+
+    for (int k = 0; k < 4; k++) {
+        *flags[k] = slots.present[k];
+        if (!slots.present[k]) {
+            continue;
+        }
+
+        if (slots.slot[k] < 0) {
+            *targets[k] = slots.constant[k];
+        }
+        else if ((size_t)slots.slot[k] < valueCount) {
+            long long value = values[slots.slot[k]];
+            *targets[k] = slots.negate[k] ? -value : value;
+        }
+        else {
+            *flags[k] = false;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,297 @@
+#include "../include/monitoring/LogIndex.h"
+#include "../include/utilities/LogRecordScanner.h"
+#include "../include/utilities/FileUtils.h"
+#include "../include/utilities/StringUtils.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    const char INDEX_MAGIC[4] = { 'F', 'L', 'I', 'X' };
+
+    // The background indexer and query commands may write the same index
+    std::mutex writeMutex;
+
+    bool ValidateLayout(const char* data, size_t size) {
+        if (size < sizeof(LogIndexHeader)) {
+            return false;
+        }
+
+        const LogIndexHeader* header = (const LogIndexHeader*)data;
+        if (memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+            header->version != AgentConstants::LOG_INDEX_VERSION) {
+            return false;
+        }
+
+        uint64_t barrelBytes = (uint64_t)header->barrelCount * sizeof(LogIndexBarrelEntry);
+        uint64_t timeBytes = (uint64_t)header->timeMarkCount * sizeof(LogIndexTimeMark);
+        return header->barrelTableOffset + barrelBytes <= size &&
+            header->timeTableOffset + timeBytes <= size;
+    }
+}
+
+LogIndex::LogIndex() {
+    header_ = NULL;
+    barrels_ = NULL;
+    timeMarks_ = NULL;
+}
+
+LogIndex::~LogIndex() {
+    Close();
+}
+
+bool LogIndex::IsLogFile(const std::string& filePath) {
+    std::string extension = StringUtils::ToLower(FileUtils::GetFileExtension(filePath));
+    return extension == AgentConstants::LOG_FILE_EXTENSION ||
+        extension == AgentConstants::LOG_TEXT_EXTENSION;
+}
+
+bool LogIndex::IsIndexFile(const std::string& filePath) {
+    std::string lowerPath = StringUtils::ToLower(filePath);
+    return StringUtils::EndsWith(lowerPath, AgentConstants::LOG_INDEX_EXTENSION) ||
+        StringUtils::EndsWith(lowerPath, std::string(AgentConstants::LOG_INDEX_EXTENSION) + ".tmp");
+}
+
+uint64_t LogIndex::HashHead(const char* data, size_t size) {
+    size_t length = (std::min)(size, (size_t)AgentConstants::LOG_INDEX_HEAD_HASH_BYTES);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string LogIndex::GetIndexPath(const std::string& logPath) {
+    return logPath + AgentConstants::LOG_INDEX_EXTENSION;
+}
+
+bool LogIndex::Update(const std::string& logPath) {
+    return Build(logPath, true);
+}
+
+bool LogIndex::Rebuild(const std::string& logPath) {
+    return Build(logPath, false);
+}
+
+bool LogIndex::Build(const std::string& logPath, bool incremental) {
+    MappedFile log;
+    if (!log.Open(logPath)) {
+        return false;
+    }
+
+    const char* data = log.GetData();
+    size_t size = log.GetSize();
+    std::string indexPath = GetIndexPath(logPath);
+
+    std::unordered_map<long long, LogIndexBarrelEntry> barrels;
+    std::vector<LogIndexTimeMark> timeMarks;
+    uint64_t startOffset = 0;
+
+    // Resume from the existing sidecar when it still describes this log
+    if (incremental) {
+        MappedFile existing;
+        if (existing.Open(indexPath) && ValidateLayout(existing.GetData(), existing.GetSize())) {
+            const LogIndexHeader* header = (const LogIndexHeader*)existing.GetData();
+
+            if (header->indexedSize <= size &&
+                header->headHash == HashHead(data, (size_t)header->indexedSize)) {
+                if (header->indexedSize == size) {
+                    return true;
+                }
+
+                const LogIndexBarrelEntry* entries =
+                    (const LogIndexBarrelEntry*)(existing.GetData() + header->barrelTableOffset);
+                const LogIndexTimeMark* marks =
+                    (const LogIndexTimeMark*)(existing.GetData() + header->timeTableOffset);
+
+                barrels.reserve(header->barrelCount);
+                for (uint32_t i = 0; i < header->barrelCount; i++) {
+                    barrels[entries[i].barrelId] = entries[i];
+                }
+                timeMarks.assign(marks, marks + header->timeMarkCount);
+                startOffset = header->indexedSize;
+            }
+        }
+    }
+
+    // Only complete lines are indexed so the tail is picked up next pass
+    uint64_t lastMarkOffset = timeMarks.empty() ? 0 : timeMarks.back().offset;
+    bool needMark = timeMarks.empty();
+    LogRecordScanner scanner(data + startOffset, size - (size_t)startOffset, false);
+    LogRecord record;
+
+    while (scanner.Next(record)) {
+        if (!record.IsEvent()) {
+            continue;
+        }
+
+        uint64_t offset = startOffset + record.offset;
+        uint64_t endOffset = offset + record.length;
+
+        if (needMark || offset - lastMarkOffset >= AgentConstants::LOG_INDEX_TIME_STRIDE_BYTES) {
+            long long timeMs = 0;
+            if (LogRecordScanner::ParseDateTime(record.fields[AgentConstants::LOG_FIELD_DATETIME], timeMs)) {
+                LogIndexTimeMark mark;
+                mark.timeMs = timeMs;
+                mark.offset = offset;
+                timeMarks.push_back(mark);
+                lastMarkOffset = offset;
+                needMark = false;
+            }
+        }
+
+        LogPayload payload;
+        if (!LogRecordScanner::ParsePayload(record.fields[AgentConstants::LOG_FIELD_PAYLOAD], payload)) {
+            continue;
+        }
+
+        std::unordered_map<long long, LogIndexBarrelEntry>::iterator it = barrels.find(payload.barrelId);
+        if (it == barrels.end()) {
+            LogIndexBarrelEntry entry;
+            entry.barrelId = payload.barrelId;
+            entry.beginOffset = offset;
+            entry.endOffset = endOffset;
+            entry.lineCount = 1;
+            entry.reserved = 0;
+            barrels[payload.barrelId] = entry;
+        }
+        else {
+            it->second.endOffset = endOffset;
+            it->second.lineCount++;
+        }
+    }
+
+    if (startOffset > 0 && scanner.Position() == 0) {
+        return true;
+    }
+
+    std::vector<LogIndexBarrelEntry> sortedBarrels;
+    sortedBarrels.reserve(barrels.size());
+    for (std::unordered_map<long long, LogIndexBarrelEntry>::const_iterator it = barrels.begin(); it != barrels.end(); ++it) {
+        sortedBarrels.push_back(it->second);
+    }
+    std::sort(sortedBarrels.begin(), sortedBarrels.end(),
+        [](const LogIndexBarrelEntry& a, const LogIndexBarrelEntry& b) { return a.barrelId < b.barrelId; });
+
+    LogIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = AgentConstants::LOG_INDEX_VERSION;
+    header.indexedSize = startOffset + scanner.Position();
+    header.headHash = HashHead(data, (size_t)header.indexedSize);
+    header.barrelCount = (uint32_t)sortedBarrels.size();
+    header.timeMarkCount = (uint32_t)timeMarks.size();
+    header.barrelTableOffset = sizeof(LogIndexHeader);
+    header.timeTableOffset = header.barrelTableOffset + sortedBarrels.size() * sizeof(LogIndexBarrelEntry);
+
+    log.Close();
+
+    // Write beside the log and swap in atomically so readers never see a torn index
+    std::lock_guard<std::mutex> lock(writeMutex);
+    std::string tempPath = indexPath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write((const char*)&header, sizeof(header));
+        if (!sortedBarrels.empty()) {
+            out.write((const char*)sortedBarrels.data(), sortedBarrels.size() * sizeof(LogIndexBarrelEntry));
+        }
+        if (!timeMarks.empty()) {
+            out.write((const char*)timeMarks.data(), timeMarks.size() * sizeof(LogIndexTimeMark));
+        }
+        if (!out.good()) {
+            out.close();
+            FileUtils::DeleteFile(tempPath);
+            return false;
+        }
+    }
+
+    if (!MoveFileExA(tempPath.c_str(), indexPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        FileUtils::DeleteFile(tempPath);
+        return false;
+    }
+
+    return true;
+}
+
+bool LogIndex::Open(const std::string& logPath) {
+    Close();
+
+    if (!file_.Open(GetIndexPath(logPath)) || !ValidateLayout(file_.GetData(), file_.GetSize())) {
+        file_.Close();
+        return false;
+    }
+
+    header_ = (const LogIndexHeader*)file_.GetData();
+    barrels_ = (const LogIndexBarrelEntry*)(file_.GetData() + header_->barrelTableOffset);
+    timeMarks_ = (const LogIndexTimeMark*)(file_.GetData() + header_->timeTableOffset);
+    return true;
+}
+
+void LogIndex::Close() {
+    file_.Close();
+    header_ = NULL;
+    barrels_ = NULL;
+    timeMarks_ = NULL;
+}
+
+uint64_t LogIndex::GetIndexedSize() const {
+    return header_ ? header_->indexedSize : 0;
+}
+
+bool LogIndex::FindBarrel(long long barrelId, LogIndexBarrelEntry& entry) const {
+    if (header_ == NULL) {
+        return false;
+    }
+
+    const LogIndexBarrelEntry* begin = barrels_;
+    const LogIndexBarrelEntry* end = barrels_ + header_->barrelCount;
+    const LogIndexBarrelEntry* it = std::lower_bound(begin, end, barrelId,
+        [](const LogIndexBarrelEntry& e, long long id) { return e.barrelId < id; });
+
+    if (it == end || it->barrelId != barrelId) {
+        return false;
+    }
+
+    entry = *it;
+    return true;
+}
+
+bool LogIndex::FindTimeRange(long long fromMs, long long toMs, uint64_t& beginOffset, uint64_t& endOffset) const {
+    if (header_ == NULL || fromMs > toMs) {
+        return false;
+    }
+
+    // Marks are sparse, so widen to the surrounding marks; callers filter
+    // the lines inside. Clock steps backwards are absorbed by a running max.
+    beginOffset = 0;
+    endOffset = header_->indexedSize;
+    long long runningMax = 0;
+    bool haveMax = false;
+
+    for (uint32_t i = 0; i < header_->timeMarkCount; i++) {
+        const LogIndexTimeMark& mark = timeMarks_[i];
+        if (!haveMax || mark.timeMs > runningMax) {
+            runningMax = mark.timeMs;
+            haveMax = true;
+        }
+
+        if (runningMax <= fromMs) {
+            beginOffset = mark.offset;
+        }
+        if (mark.timeMs > toMs) {
+            endOffset = mark.offset;
+            break;
+        }
+    }
+
+    return beginOffset < endOffset;
+}
\ No newline at end of file
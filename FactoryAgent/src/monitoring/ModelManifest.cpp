@@ -0,0 +1,242 @@
+#include "../include/monitoring/ModelManifest.h"
+#include "../include/utilities/FileUtils.h"
+#include "../include/utilities/HashUtils.h"
+#include "../include/utilities/MappedFile.h"
+#include "../include/utilities/ThreadPool.h"
+#include "../include/common/Constants.h"
+#include "../../third_party/json/json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+struct ListedFile {
+    ManifestFile file;
+    std::string fullPath;
+    std::string cacheKey;
+};
+
+static bool ByPath(const ListedFile& a, const ListedFile& b) {
+    return a.file.path < b.file.path;
+}
+
+ModelManifestCache::ModelManifestCache() {
+    dirty_ = false;
+}
+
+ModelManifestCache::~ModelManifestCache() {
+}
+
+void ModelManifestCache::Load(const std::string& cachePath) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cachePath_ = cachePath;
+    entries_.clear();
+    dirty_ = false;
+
+    std::string content;
+    if (!FileUtils::ReadFileContent(cachePath, content)) {
+        return;
+    }
+
+    try {
+        json cache = json::parse(content);
+        if (cache.value("version", 0) != (int)AgentConstants::MODEL_MANIFEST_CACHE_VERSION ||
+            !cache.contains("files") || !cache["files"].is_object()) {
+            return;
+        }
+
+        // Each file is stored as [size, writeTime, hash]
+        const json& files = cache["files"];
+        for (json::const_iterator it = files.begin(); it != files.end(); ++it) {
+            if (!it.value().is_array() || it.value().size() != 3) {
+                continue;
+            }
+            CachedHash entry;
+            entry.size = it.value()[0].get<uint64_t>();
+            entry.writeTime = it.value()[1].get<uint64_t>();
+            entry.hash = it.value()[2].get<uint64_t>();
+            entry.listed = true;
+            entries_[it.key()] = entry;
+        }
+    }
+    catch (...) {
+        entries_.clear();
+    }
+}
+
+bool ModelManifestCache::Save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Files that were deleted, or whose model was, are not listed any more
+    std::map<std::string, CachedHash>::iterator it = entries_.begin();
+    while (it != entries_.end()) {
+        if (!it->second.listed) {
+            it = entries_.erase(it);
+            dirty_ = true;
+        }
+        else {
+            it->second.listed = false;
+            ++it;
+        }
+    }
+
+    if (!dirty_ || cachePath_.empty()) {
+        return true;
+    }
+
+    json files = json::object();
+    for (it = entries_.begin(); it != entries_.end(); ++it) {
+        files[it->first] = json::array({ it->second.size, it->second.writeTime, it->second.hash });
+    }
+
+    json cache;
+    cache["version"] = AgentConstants::MODEL_MANIFEST_CACHE_VERSION;
+    cache["files"] = files;
+    if (!FileUtils::WriteFileAtomic(cachePath_, cache.dump())) {
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+bool ModelManifestCache::Build(const std::string& modelPath, ModelManifest& manifest, std::string& error) {
+    manifest = ModelManifest();
+
+    fs::path root(modelPath);
+    std::string modelKey = FileUtils::GetFileName(modelPath) + "/";
+    std::vector<ListedFile> listed;
+    std::error_code ec;
+    fs::recursive_directory_iterator it(root, ec);
+    fs::recursive_directory_iterator end;
+    for (; !ec && it != end; it.increment(ec)) {
+        std::error_code entryError;
+        if (!it->is_regular_file(entryError)) {
+            continue;
+        }
+
+        ListedFile item;
+        item.fullPath = it->path().string();
+        item.file.path = it->path().lexically_relative(root).generic_string();
+        item.cacheKey = modelKey + item.file.path;
+        item.file.size = it->file_size(entryError);
+        item.file.writeTime = (uint64_t)it->last_write_time(entryError).time_since_epoch().count();
+        if (entryError) {
+            error = "Cannot read " + item.fullPath + ": " + entryError.message();
+            return false;
+        }
+        listed.push_back(item);
+    }
+    if (ec) {
+        error = "Cannot list " + modelPath + ": " + ec.message();
+        return false;
+    }
+
+    std::sort(listed.begin(), listed.end(), ByPath);
+
+    // Only files whose size or write time moved since they were cached are read
+    std::vector<size_t> changed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < listed.size(); i++) {
+            std::map<std::string, CachedHash>::iterator cached = entries_.find(listed[i].cacheKey);
+            if (cached != entries_.end() &&
+                cached->second.size == listed[i].file.size &&
+                cached->second.writeTime == listed[i].file.writeTime) {
+                listed[i].file.hash = cached->second.hash;
+                cached->second.listed = true;
+            }
+            else {
+                changed.push_back(i);
+            }
+        }
+    }
+
+    std::vector<char> hashed(changed.size(), 0);
+    if (changed.size() > 1) {
+        size_t threads = (std::min)(ThreadPool::GetBackgroundThreadCount(AgentConstants::MODEL_MANIFEST_MAX_THREADS),
+            changed.size());
+        ThreadPool pool(threads, true);
+        for (size_t i = 0; i < changed.size(); i++) {
+            ListedFile* item = &listed[changed[i]];
+            char* ok = &hashed[i];
+            pool.Submit([item, ok]() {
+                *ok = HashFile(item->fullPath, item->file.size, item->file.hash) ? 1 : 0;
+            });
+        }
+        pool.Wait();
+    }
+    else if (changed.size() == 1) {
+        ListedFile& item = listed[changed[0]];
+        hashed[0] = HashFile(item.fullPath, item.file.size, item.file.hash) ? 1 : 0;
+    }
+
+    for (size_t i = 0; i < changed.size(); i++) {
+        if (!hashed[i]) {
+            error = "Cannot hash " + listed[changed[i]].fullPath;
+            return false;
+        }
+    }
+
+    // A file written just now could change again within the same timestamp
+    // tick without its stamp moving; it is hashed again next time
+    uint64_t racyWindow = (uint64_t)std::chrono::duration_cast<fs::file_time_type::duration>(
+        std::chrono::milliseconds(AgentConstants::FILE_STATE_RACY_WINDOW_MS)).count();
+    uint64_t now = (uint64_t)fs::file_time_type::clock::now().time_since_epoch().count();
+    if (!changed.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < changed.size(); i++) {
+            const ListedFile& item = listed[changed[i]];
+            if (item.file.writeTime + racyWindow > now) {
+                entries_.erase(item.cacheKey);
+                continue;
+            }
+            CachedHash& entry = entries_[item.cacheKey];
+            entry.size = item.file.size;
+            entry.writeTime = item.file.writeTime;
+            entry.hash = item.file.hash;
+            entry.listed = true;
+        }
+        dirty_ = true;
+    }
+
+    manifest.files.reserve(listed.size());
+    for (size_t i = 0; i < listed.size(); i++) {
+        manifest.totalSize += listed[i].file.size;
+        manifest.files.push_back(listed[i].file);
+    }
+    for (size_t i = 0; i < changed.size(); i++) {
+        manifest.hashedBytes += listed[changed[i]].file.size;
+    }
+    manifest.hashedFiles = changed.size();
+    manifest.rootHash = ComputeRoot(manifest.files);
+    return true;
+}
+
+bool ModelManifestCache::HashFile(const std::string& filePath, uint64_t& size, uint64_t& hash) {
+    MappedFile file;
+    if (!file.Open(filePath)) {
+        return false;
+    }
+
+    // The size is taken from what was hashed, in case the file moved since it was listed
+    size = file.GetSize();
+    hash = HashUtils::Xxh64(file.GetData() != NULL ? file.GetData() : "", (size_t)size);
+    file.Close();
+    return true;
+}
+
+uint64_t ModelManifestCache::ComputeRoot(const std::vector<ManifestFile>& files) {
+    // One "path\nsize\nhash\n" line group per file, in path order
+    std::string canonical;
+    for (size_t i = 0; i < files.size(); i++) {
+        canonical += files[i].path;
+        canonical += '\n';
+        canonical += std::to_string(files[i].size);
+        canonical += '\n';
+        canonical += HashUtils::ToHex(files[i].hash);
+        canonical += '\n';
+    }
+    return HashUtils::Xxh64(canonical.data(), canonical.size());
+}
\ No newline at end of file
@@ -0,0 +1,295 @@
+#include "../include/monitoring/ModelStore.h"
+#include "../include/utilities/FileUtils.h"
+#include "../include/utilities/HashUtils.h"
+#include "../include/utilities/MappedFile.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <windows.h>
+
+namespace fs = std::filesystem;
+
+ModelStore::ModelStore() {
+    isOpen_ = false;
+    storedBytes_ = 0;
+}
+
+ModelStore::~ModelStore() {
+}
+
+bool ModelStore::Open(const std::string& storePath) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    isOpen_ = false;
+    storePath_ = storePath;
+    blobs_.clear();
+    storedBytes_ = 0;
+
+    if (!FileUtils::FolderExists(storePath) && !FileUtils::CreateFolder(storePath)) {
+        return false;
+    }
+    SetFileAttributesA(storePath.c_str(), FILE_ATTRIBUTE_HIDDEN);
+
+    // FAT and some network shares have no hardlinks; then every model keeps its own files
+    std::string probePath = storePath + "\\" + AgentConstants::MODEL_STORE_PROBE_NAME;
+    std::string probeLink = probePath + AgentConstants::MODEL_STORE_LINK_SUFFIX;
+    DeleteFileA(probeLink.c_str());
+    bool linked = FileUtils::WriteFileContent(probePath, "") &&
+        CreateHardLinkA(probeLink.c_str(), probePath.c_str(), NULL) != 0;
+    DeleteFileA(probeLink.c_str());
+    DeleteFileA(probePath.c_str());
+    if (!linked) {
+        return false;
+    }
+
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(storePath, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code entryError;
+        if (!it->is_regular_file(entryError)) {
+            continue;
+        }
+
+        std::string name = it->path().filename().string();
+        size_t dash = name.find('-');
+        if (dash != 16 || name.find_first_not_of("0123456789", dash + 1) != std::string::npos) {
+            continue;
+        }
+        uint64_t size = it->file_size(entryError);
+        if (!entryError) {
+            blobs_[name] = size;
+            storedBytes_ += size;
+        }
+    }
+
+    isOpen_ = true;
+    return true;
+}
+
+bool ModelStore::IsOpen() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return isOpen_;
+}
+
+bool ModelStore::IsShared(uint64_t size) {
+    return size >= AgentConstants::MODEL_STORE_MIN_FILE_SIZE;
+}
+
+bool ModelStore::Ingest(const std::string& folderPath, const ModelManifest& manifest, ModelStoreStats& stats,
+    std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!isOpen_) {
+        return true;
+    }
+
+    for (size_t i = 0; i < manifest.files.size(); i++) {
+        const ManifestFile& file = manifest.files[i];
+        if (!IsShared(file.size)) {
+            continue;
+        }
+
+        std::string filePath = folderPath + "\\" + file.path;
+        std::replace(filePath.begin(), filePath.end(), '/', '\\');
+        std::string blobName = GetBlobName(file.hash, file.size);
+        std::string blobPath = GetBlobPath(blobName);
+
+        if (blobs_.find(blobName) == blobs_.end()) {
+            // The file itself becomes the blob: one more name, no data copied
+            std::string blobFolder = blobPath.substr(0, blobPath.find_last_of('\\'));
+            if (!FileUtils::FolderExists(blobFolder)) {
+                FileUtils::CreateFolder(blobFolder);
+            }
+            if (CreateHardLinkA(blobPath.c_str(), filePath.c_str(), NULL)) {
+                Protect(blobPath);
+                blobs_[blobName] = file.size;
+                storedBytes_ += file.size;
+                stats.storedFiles++;
+                stats.storedBytes += file.size;
+            }
+            continue;
+        }
+
+        // Already a link, made by Materialize
+        if (SameFile(filePath, blobPath) || !SameContent(filePath, blobPath)) {
+            continue;
+        }
+
+        // The link is made beside the file and renamed over it, so the path never goes missing
+        std::string linkPath = filePath + AgentConstants::MODEL_STORE_LINK_SUFFIX;
+        DeleteFileA(linkPath.c_str());
+        if (!CreateHardLinkA(linkPath.c_str(), blobPath.c_str(), NULL)) {
+            stats.copiedFiles++;
+            continue;
+        }
+        if (!MoveFileExA(linkPath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            DeleteFileA(linkPath.c_str());
+            error = "Cannot replace " + filePath + " with a link";
+            return false;
+        }
+        stats.linkedFiles++;
+        stats.linkedBytes += file.size;
+    }
+    return true;
+}
+
+bool ModelStore::Materialize(uint64_t hash, uint64_t size, const std::string& targetPath, ModelStoreStats& stats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string blobName = GetBlobName(hash, size);
+    if (!isOpen_ || blobs_.find(blobName) == blobs_.end()) {
+        return false;
+    }
+
+    // Blobs stored before they were made read-only are protected on first use
+    std::string blobPath = GetBlobPath(blobName);
+    Protect(blobPath);
+    if (!LinkOrCopy(blobPath, targetPath, stats)) {
+        return false;
+    }
+    stats.linkedFiles++;
+    stats.linkedBytes += size;
+    return true;
+}
+
+void ModelStore::Discard(uint64_t hash, uint64_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, uint64_t>::iterator it = blobs_.find(GetBlobName(hash, size));
+    if (it == blobs_.end()) {
+        return;
+    }
+
+    // Model folders that link it keep their copy of the bytes
+    std::string blobPath = GetBlobPath(it->first);
+    SetFileAttributesA(blobPath.c_str(), FILE_ATTRIBUTE_NORMAL);
+    DeleteFileA(blobPath.c_str());
+    storedBytes_ -= it->second;
+    blobs_.erase(it);
+}
+
+bool ModelStore::FindBlob(const std::string& blobName, std::string& blobPath, uint64_t& size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, uint64_t>::iterator it = blobs_.find(blobName);
+    if (!isOpen_ || it == blobs_.end()) {
+        return false;
+    }
+    blobPath = GetBlobPath(blobName);
+    size = it->second;
+    return true;
+}
+
+unsigned long long ModelStore::GetPrivateBytes(const ModelManifest& manifest) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned long long privateBytes = 0;
+    for (size_t i = 0; i < manifest.files.size(); i++) {
+        const ManifestFile& file = manifest.files[i];
+        if (!IsShared(file.size) || blobs_.find(GetBlobName(file.hash, file.size)) == blobs_.end()) {
+            privateBytes += file.size;
+        }
+    }
+    return privateBytes;
+}
+
+void ModelStore::Collect(ModelStoreStats& stats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Deleting a model folder clears the read-only flag its links share with
+    // the blob, so the blobs that stay are protected again
+    std::map<std::string, uint64_t>::iterator it = blobs_.begin();
+    while (it != blobs_.end()) {
+        std::string blobPath = GetBlobPath(it->first);
+        if (GetLinkCount(blobPath) == 1 && SetFileAttributesA(blobPath.c_str(), FILE_ATTRIBUTE_NORMAL) &&
+            DeleteFileA(blobPath.c_str())) {
+            stats.freedFiles++;
+            stats.freedBytes += it->second;
+            storedBytes_ -= it->second;
+            it = blobs_.erase(it);
+        }
+        else {
+            Protect(blobPath);
+            ++it;
+        }
+    }
+}
+
+unsigned long long ModelStore::GetStoredBytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return storedBytes_;
+}
+
+size_t ModelStore::GetBlobCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blobs_.size();
+}
+
+std::string ModelStore::GetBlobName(uint64_t hash, uint64_t size) {
+    return HashUtils::ToHex(hash) + "-" + std::to_string(size);
+}
+
+std::string ModelStore::GetBlobPath(const std::string& blobName) {
+    return storePath_ + "\\" + blobName.substr(0, 2) + "\\" + blobName;
+}
+
+bool ModelStore::LinkOrCopy(const std::string& blobPath, const std::string& targetPath, ModelStoreStats& stats) {
+    if (CreateHardLinkA(targetPath.c_str(), blobPath.c_str(), NULL)) {
+        return true;
+    }
+
+    // NTFS allows 1023 links per file; a copy is private, so it is not kept read-only
+    if (CopyFileA(blobPath.c_str(), targetPath.c_str(), FALSE)) {
+        SetFileAttributesA(targetPath.c_str(), FILE_ATTRIBUTE_NORMAL);
+        stats.copiedFiles++;
+        return true;
+    }
+    return false;
+}
+
+void ModelStore::Protect(const std::string& blobPath) {
+    DWORD attributes = GetFileAttributesA(blobPath.c_str());
+    if (attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_READONLY)) {
+        SetFileAttributesA(blobPath.c_str(), attributes | FILE_ATTRIBUTE_READONLY);
+    }
+}
+
+bool ModelStore::SameFile(const std::string& a, const std::string& b) {
+    BY_HANDLE_FILE_INFORMATION infoA;
+    BY_HANDLE_FILE_INFORMATION infoB;
+    HANDLE fileA = CreateFileA(a.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, 0, NULL);
+    if (fileA == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    HANDLE fileB = CreateFileA(b.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, 0, NULL);
+    if (fileB == INVALID_HANDLE_VALUE) {
+        CloseHandle(fileA);
+        return false;
+    }
+
+    bool same = GetFileInformationByHandle(fileA, &infoA) && GetFileInformationByHandle(fileB, &infoB) &&
+        infoA.dwVolumeSerialNumber == infoB.dwVolumeSerialNumber &&
+        infoA.nFileIndexHigh == infoB.nFileIndexHigh &&
+        infoA.nFileIndexLow == infoB.nFileIndexLow;
+    CloseHandle(fileA);
+    CloseHandle(fileB);
+    return same;
+}
+
+bool ModelStore::SameContent(const std::string& a, const std::string& b) {
+    MappedFile fileA;
+    MappedFile fileB;
+    if (!fileA.Open(a) || !fileB.Open(b) || fileA.GetSize() != fileB.GetSize()) {
+        return false;
+    }
+    return fileA.GetSize() == 0 || memcmp(fileA.GetData(), fileB.GetData(), fileA.GetSize()) == 0;
+}
+
+unsigned int ModelStore::GetLinkCount(const std::string& filePath) {
+    HANDLE file = CreateFileA(filePath.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, 0, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+
+    BY_HANDLE_FILE_INFORMATION info;
+    unsigned int links = GetFileInformationByHandle(file, &info) ? (unsigned int)info.nNumberOfLinks : 0;
+    CloseHandle(file);
+    return links;
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "../include/monitoring/ModelUsageLog.h"
+#include "../include/utilities/FileUtils.h"
+#include "../../third_party/json/json.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+
+using json = nlohmann::json;
+
+ModelUsageLog::ModelUsageLog() {
+    dirty_ = false;
+}
+
+ModelUsageLog::~ModelUsageLog() {
+}
+
+void ModelUsageLog::Load(const std::string& logPath) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    logPath_ = logPath;
+    lastActivated_.clear();
+    dirty_ = false;
+
+    std::string content;
+    if (!FileUtils::ReadFileContent(logPath, content)) {
+        return;
+    }
+
+    try {
+        json log = json::parse(content);
+        if (!log.contains("models") || !log["models"].is_object()) {
+            return;
+        }
+
+        const json& models = log["models"];
+        for (json::const_iterator it = models.begin(); it != models.end(); ++it) {
+            if (it.value().is_number()) {
+                lastActivated_[it.key()] = it.value().get<long long>();
+            }
+        }
+    }
+    catch (...) {
+        lastActivated_.clear();
+    }
+}
+
+bool ModelUsageLog::Save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dirty_ || logPath_.empty()) {
+        return true;
+    }
+
+    json models = json::object();
+    for (std::map<std::string, long long, NoCaseLess>::iterator it = lastActivated_.begin(); it != lastActivated_.end(); ++it) {
+        models[it->first] = it->second;
+    }
+
+    json log;
+    log["models"] = models;
+    if (!FileUtils::WriteFileAtomic(logPath_, log.dump())) {
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+void ModelUsageLog::Touch(const std::string& modelName) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lastActivated_[modelName] = CurrentTimeMs();
+    dirty_ = true;
+}
+
+void ModelUsageLog::Forget(const std::string& modelName) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (lastActivated_.erase(modelName) > 0) {
+        dirty_ = true;
+    }
+}
+
+long long ModelUsageLog::GetLastActivated(const std::string& modelName) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, long long, NoCaseLess>::iterator it = lastActivated_.find(modelName);
+    if (it != lastActivated_.end()) {
+        return it->second;
+    }
+
+    long long now = CurrentTimeMs();
+    lastActivated_[modelName] = now;
+    dirty_ = true;
+    return now;
+}
+
+long long ModelUsageLog::CurrentTimeMs() {
+    return (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool ModelUsageLog::NoCaseLess::operator()(const std::string& a, const std::string& b) const {
+    size_t length = (std::min)(a.size(), b.size());
+    for (size_t i = 0; i < length; i++) {
+        int ca = tolower((unsigned char)a[i]);
+        int cb = tolower((unsigned char)b[i]);
+        if (ca != cb) {
+            return ca < cb;
+        }
+    }
+    return a.size() < b.size();
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "../include/monitoring/OperationStats.h"
+#include "../include/common/Constants.h"
+#include <cmath>
+
+namespace {
+
+    double Round(double value, int decimals) {
+        double scale = std::pow(10.0, decimals);
+        return std::round(value * scale) / scale;
+    }
+}
+
+OperationStats::OperationStats() {
+    latestWindow_ = 0;
+    droppedSamples_ = 0;
+}
+
+void OperationStats::Reset() {
+    operations_.clear();
+    latestWindow_ = 0;
+    droppedSamples_ = 0;
+}
+
+void OperationStats::Add(const CycleSample& sample) {
+    long long windowIndex = sample.timeMs / AgentConstants::CYCLE_STATS_WINDOW_MS;
+    if (windowIndex > latestWindow_) {
+        latestWindow_ = windowIndex;
+    }
+
+    std::map<std::string, Operation>::iterator it = operations_.find(sample.operation);
+    if (it == operations_.end()) {
+        if (operations_.size() >= AgentConstants::CYCLE_STATS_MAX_OPERATIONS) {
+            droppedSamples_++;
+            return;
+        }
+
+        Operation& created = operations_[sample.operation];
+        created.windowIndex = windowIndex;
+        created.idealMs = 0;
+        created.hasIdeal = false;
+        it = operations_.find(sample.operation);
+    }
+
+    Operation& operation = it->second;
+    Rotate(operation, windowIndex);
+    operation.current.Record(sample.durationMs);
+
+    if (sample.hasIdeal && sample.idealMs > 0) {
+        operation.idealMs = sample.idealMs;
+        operation.hasIdeal = true;
+    }
+}
+
+void OperationStats::Rotate(Operation& operation, long long windowIndex) {
+    // Late lines from an older window are folded into the current one
+    if (windowIndex <= operation.windowIndex) {
+        return;
+    }
+
+    if (windowIndex == operation.windowIndex + 1) {
+        operation.previous = operation.current;
+    }
+    else {
+        operation.previous.Clear();
+    }
+    operation.current.Clear();
+    operation.windowIndex = windowIndex;
+}
+
+json OperationStats::BuildSummary() {
+    json operations = json::array();
+
+    for (std::map<std::string, Operation>::iterator it = operations_.begin(); it != operations_.end(); ++it) {
+        Operation& operation = it->second;
+
+        // Age out operations that have gone quiet relative to the log
+        Rotate(operation, latestWindow_);
+
+        CycleTimeHistogram window = operation.previous;
+        window.Merge(operation.current);
+        if (window.GetCount() == 0) {
+            continue;
+        }
+
+        json entry;
+        entry["op"] = it->first;
+        entry["n"] = window.GetCount();
+        entry["mean"] = Round(window.GetMean(), 1);
+        entry["p50"] = window.GetPercentile(50.0);
+        entry["p95"] = window.GetPercentile(95.0);
+        entry["p99"] = window.GetPercentile(99.0);
+        entry["max"] = window.GetMax();
+
+        if (operation.hasIdeal) {
+            entry["idealMs"] = operation.idealMs;
+            entry["p50Ratio"] = Round((double)window.GetPercentile(50.0) / (double)operation.idealMs, 2);
+            entry["meanRatio"] = Round(window.GetMean() / (double)operation.idealMs, 2);
+        }
+
+        operations.push_back(entry);
+    }
+
+    if (operations.empty()) {
+        return json();
+    }
+
+    json summary;
+    summary["windowSec"] = AgentConstants::CYCLE_STATS_WINDOW_MS * 2 / 1000;
+    summary["operations"] = operations;
+    if (droppedSamples_ > 0) {
+        summary["droppedSamples"] = droppedSamples_;
+    }
+    return summary;
+}
\ No newline at end of file
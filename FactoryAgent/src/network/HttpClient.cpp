@@ -1,5 +1,7 @@
 #include "../include/network/HttpClient.h"
 #include "../include/common/Constants.h"
+#include <algorithm>
+#include <cstdio>
 #include <sstream>
 #include <vector>
 #include <fstream>
@@ -44,6 +46,11 @@ bool HttpClient::ParseUrl() {
 
 bool HttpClient::SendRequest(const std::wstring& method, const std::wstring& endpoint,
     const std::string& data, std::string& response) {
+    return SendRequest(method, endpoint, L"application/json", data, response);
+}
+
+bool HttpClient::SendRequest(const std::wstring& method, const std::wstring& endpoint,
+    const std::wstring& contentType, const std::string& data, std::string& response) {
     HINTERNET hSession = WinHttpOpen(L"Factory Agent/1.0",
         WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
         WINHTTP_NO_PROXY_NAME,
@@ -68,7 +75,7 @@ bool HttpClient::SendRequest(const std::wstring& method, const std::wstring& end
         return false;
     }
 
-    std::wstring headers = L"Content-Type: application/json\r\n";
+    std::wstring headers = L"Content-Type: " + contentType + L"\r\n";
     bool result = false;
 
     if (WinHttpSendRequest(hRequest, headers.c_str(), -1,
@@ -133,6 +140,22 @@ bool HttpClient::Get(const std::wstring& endpoint, json& response) {
     return false;
 }
 
+bool HttpClient::PostBinary(const std::wstring& endpoint, const std::string& data, json& response) {
+    std::string responseStr;
+
+    if (SendRequest(L"POST", endpoint, L"application/octet-stream", data, responseStr)) {
+        try {
+            response = json::parse(responseStr);
+            return true;
+        }
+        catch (...) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
 bool HttpClient::UploadFile(const std::wstring& endpoint, const std::string& filePath,
     const std::string& modelName, json& response) {
     std::ifstream file(filePath, std::ios::binary | std::ios::ate);
@@ -238,7 +261,147 @@ bool HttpClient::UploadFile(const std::wstring& endpoint, const std::string& fil
     return result;
 }
 
+// WinHTTP passes a chunked body through untouched, so every write carries its own framing
+static bool WriteChunk(HINTERNET request, const char* data, size_t size, std::string& frame) {
+    char header[24];
+    snprintf(header, sizeof(header), "%zx\r\n", size);
+    frame.assign(header);
+    frame.append(data, size);
+    frame.append("\r\n");
+
+    DWORD written = 0;
+    return WinHttpWriteData(request, frame.data(), (DWORD)frame.size(), &written) && written == frame.size();
+}
+
+bool HttpClient::UploadStream(const std::wstring& endpoint, const std::string& fileName,
+    const std::string& modelName, HttpBodySource source, void* userData, json& response) {
+    std::string boundary = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
+
+    std::ostringstream bodyStream;
+    bodyStream << "--" << boundary << "\r\n";
+    bodyStream << "Content-Disposition: form-data; name=\"modelName\"\r\n\r\n";
+    bodyStream << modelName << "\r\n";
+    bodyStream << "--" << boundary << "\r\n";
+    bodyStream << "Content-Disposition: form-data; name=\"file\"; filename=\"" << fileName << "\"\r\n";
+    bodyStream << "Content-Type: application/octet-stream\r\n\r\n";
+
+    std::string bodyPrefix = bodyStream.str();
+    std::string bodySuffix = "\r\n--" + boundary + "--\r\n";
+
+    HINTERNET hSession = WinHttpOpen(L"Factory Agent/1.0",
+        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+        WINHTTP_NO_PROXY_NAME,
+        WINHTTP_NO_PROXY_BYPASS, 0);
+    if (!hSession) return false;
+
+    HINTERNET hConnect = WinHttpConnect(hSession, hostName_.c_str(), port_, 0);
+    if (!hConnect) {
+        WinHttpCloseHandle(hSession);
+        return false;
+    }
+
+    DWORD flags = (useHttps_ ? WINHTTP_FLAG_SECURE : 0);
+    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"POST", endpoint.c_str(),
+        NULL, WINHTTP_NO_REFERER,
+        WINHTTP_DEFAULT_ACCEPT_TYPES, flags);
+    if (!hRequest) {
+        WinHttpCloseHandle(hConnect);
+        WinHttpCloseHandle(hSession);
+        return false;
+    }
+
+    std::wstring headers = L"Content-Type: multipart/form-data; boundary=" +
+        std::wstring(boundary.begin(), boundary.end()) + L"\r\n" +
+        L"Transfer-Encoding: chunked\r\n";
+
+    bool result = false;
+
+    if (WinHttpSendRequest(hRequest, headers.c_str(), -1,
+        WINHTTP_NO_REQUEST_DATA, 0, WINHTTP_IGNORE_REQUEST_TOTAL_LENGTH, 0)) {
+        std::vector<char> buffer(AgentConstants::HTTP_UPLOAD_CHUNK_SIZE);
+        std::string frame;
+        bool sent = WriteChunk(hRequest, bodyPrefix.data(), bodyPrefix.size(), frame);
+
+        while (sent) {
+            size_t size = 0;
+            if (!source(buffer.data(), buffer.size(), size, userData)) {
+                sent = false;
+            }
+            else if (size == 0) {
+                break;
+            }
+            else {
+                sent = WriteChunk(hRequest, buffer.data(), size, frame);
+            }
+        }
+
+        // Without the final empty chunk the server sees an incomplete body and drops it
+        if (sent && WriteChunk(hRequest, bodySuffix.data(), bodySuffix.size(), frame) &&
+            WriteChunk(hRequest, "", 0, frame) && WinHttpReceiveResponse(hRequest, NULL)) {
+            std::string responseStr;
+            DWORD size = 0;
+
+            do {
+                size = 0;
+                if (WinHttpQueryDataAvailable(hRequest, &size) && size > 0) {
+                    buffer.resize((std::max)(buffer.size(), (size_t)size));
+                    DWORD downloaded = 0;
+                    if (WinHttpReadData(hRequest, buffer.data(), size, &downloaded)) {
+                        responseStr.append(buffer.data(), downloaded);
+                    }
+                }
+            } while (size > 0);
+
+            try {
+                response = json::parse(responseStr);
+                result = true;
+            }
+            catch (...) {
+                result = false;
+            }
+        }
+    }
+
+    WinHttpCloseHandle(hRequest);
+    WinHttpCloseHandle(hConnect);
+    WinHttpCloseHandle(hSession);
+
+    return result;
+}
+
+static bool WriteToFile(const char* data, size_t size, void* userData) {
+    std::ofstream* out = (std::ofstream*)userData;
+    out->write(data, size);
+    return out->good();
+}
+
 bool HttpClient::DownloadFile(const std::string& url, const std::string& outputPath) {
+    std::ofstream outFile(outputPath, std::ios::binary);
+    if (!outFile.is_open()) {
+        return false;
+    }
+
+    bool result = DownloadStream(url, WriteToFile, &outFile);
+    outFile.close();
+    return result && !outFile.fail();
+}
+
+bool HttpClient::DownloadFileDirect(const std::string& url, const std::string& outputPath, int timeoutMs) {
+    std::ofstream outFile(outputPath, std::ios::binary);
+    if (!outFile.is_open()) {
+        return false;
+    }
+
+    bool result = DownloadStream(url, WriteToFile, &outFile, true, timeoutMs);
+    outFile.close();
+    return result && !outFile.fail();
+}
+
+bool HttpClient::DownloadStream(const std::string& url, HttpBodySink sink, void* userData) {
+    return DownloadStream(url, sink, userData, false, 0);
+}
+
+bool HttpClient::DownloadStream(const std::string& url, HttpBodySink sink, void* userData, bool direct, int timeoutMs) {
     std::wstring wUrl(url.begin(), url.end());
 
     size_t schemeEnd = wUrl.find(AgentConstants::PROTOCOL_SEPARATOR);
@@ -275,10 +438,13 @@ bool HttpClient::DownloadFile(const std::string& url, const std::string& outputP
     }
 
     HINTERNET hSession = WinHttpOpen(L"Factory Agent/1.0",
-        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+        direct ? WINHTTP_ACCESS_TYPE_NO_PROXY : WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
         WINHTTP_NO_PROXY_NAME,
         WINHTTP_NO_PROXY_BYPASS, 0);
     if (!hSession) return false;
+    if (timeoutMs > 0) {
+        WinHttpSetTimeouts(hSession, timeoutMs, timeoutMs, timeoutMs, timeoutMs);
+    }
 
     HINTERNET hConnect = WinHttpConnect(hSession, host.c_str(), port, 0);
     if (!hConnect) {
@@ -299,27 +465,32 @@ bool HttpClient::DownloadFile(const std::string& url, const std::string& outputP
     bool result = false;
 
     if (WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-        WINHTTP_NO_REQUEST_DATA, 0, 0, 0)) {
-        if (WinHttpReceiveResponse(hRequest, NULL)) {
-            std::ofstream outFile(outputPath, std::ios::binary);
-            if (outFile.is_open()) {
-                DWORD size = 0;
-                std::vector<char> buffer;
-
-                do {
-                    size = 0;
-                    if (WinHttpQueryDataAvailable(hRequest, &size) && size > 0) {
-                        buffer.resize(size);
-                        DWORD downloaded = 0;
-                        if (WinHttpReadData(hRequest, buffer.data(), size, &downloaded)) {
-                            outFile.write(buffer.data(), downloaded);
-                        }
-                    }
-                } while (size > 0);
+        WINHTTP_NO_REQUEST_DATA, 0, 0, 0) && WinHttpReceiveResponse(hRequest, NULL)) {
+        // An error page is not a body worth handing on
+        DWORD statusCode = 0;
+        DWORD statusSize = sizeof(statusCode);
+        WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+            WINHTTP_HEADER_NAME_BY_INDEX, &statusCode, &statusSize, WINHTTP_NO_HEADER_INDEX);
+
+        if (statusCode == 200) {
+            DWORD size = 0;
+            std::vector<char> buffer;
+            result = true;
 
-                outFile.close();
-                result = true;
-            }
+            do {
+                size = 0;
+                if (!WinHttpQueryDataAvailable(hRequest, &size)) {
+                    result = false;
+                }
+                else if (size > 0) {
+                    buffer.resize(size);
+                    DWORD downloaded = 0;
+                    if (!WinHttpReadData(hRequest, buffer.data(), size, &downloaded) ||
+                        !sink(buffer.data(), downloaded, userData)) {
+                        result = false;
+                    }
+                }
+            } while (result && size > 0);
         }
     }
 
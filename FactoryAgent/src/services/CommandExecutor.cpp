@@ -2,13 +2,15 @@
 #include "../include/services/LogAnalyzerCommands.h"
 #include "../include/services/ConfigService.h"
 #include "../include/services/ModelService.h"
+#include "../include/services/LogSearchService.h"
 #include "../include/network/HttpClient.h"
 #include "../include/common/Constants.h"
 
-CommandExecutor::CommandExecutor(HttpClient* client, ConfigService* configSvc, ModelService* modelSvc) {
+CommandExecutor::CommandExecutor(HttpClient* client, ConfigService* configSvc, ModelService* modelSvc, LogSearchService* searchSvc) {
     httpClient_ = client;
     configService_ = configSvc;
     modelService_ = modelSvc;
+    logSearchService_ = searchSvc;
 }
 
 CommandExecutor::~CommandExecutor() {
@@ -38,6 +40,9 @@ bool CommandExecutor::ExecuteCommand(const json& command) {
     result.success = false;
     result.status = AgentConstants::STATUS_FAILED;
 
+    // Set when the command reports its own result asynchronously
+    bool deferResult = false;
+
     if (commandType == AgentConstants::COMMAND_UPDATE_CONFIG) {
         if (command.contains("commandData")) {
             std::string configContent = command["commandData"].get<std::string>();
@@ -47,6 +52,32 @@ bool CommandExecutor::ExecuteCommand(const json& command) {
             }
         }
     }
+    else if (commandType == AgentConstants::COMMAND_ROLLBACK_CONFIG) {
+        try {
+            // commandData is optional: defaults to one version back
+            json data = json::object();
+            if (command.contains("commandData")) {
+                std::string commandData = command["commandData"].get<std::string>();
+                if (!commandData.empty()) {
+                    data = json::parse(commandData);
+                }
+            }
+
+            std::string error;
+            if (configService_->RollbackConfig(data, result.resultData, error)) {
+                result.success = true;
+                result.status = AgentConstants::STATUS_COMPLETED;
+            }
+            else {
+                result.errorMessage = error;
+            }
+        }
+        catch (const std::exception& ex) {
+            result.success = false;
+            result.status = AgentConstants::STATUS_FAILED;
+            result.errorMessage = ex.what();
+        }
+    }
     else if (commandType == AgentConstants::COMMAND_CHANGE_MODEL) {
         if (command.contains("commandData")) {
             json data = json::parse(command["commandData"].get<std::string>());
@@ -62,10 +93,28 @@ bool CommandExecutor::ExecuteCommand(const json& command) {
     else if (commandType == AgentConstants::COMMAND_UPLOAD_MODEL) {
         if (command.contains("commandData")) {
             json data = json::parse(command["commandData"].get<std::string>());
-            if (modelService_->UploadModelToServer(data)) {
+            std::string error;
+            if (modelService_->StartUpload(commandId, data, error)) {
+                // Staged in the background; the result follows once the model is switched in
+                result.success = true;
+                deferResult = true;
+            }
+            else {
+                result.errorMessage = error;
+            }
+        }
+    }
+    else if (commandType == AgentConstants::COMMAND_REVERT_MODEL) {
+        if (command.contains("commandData")) {
+            json data = json::parse(command["commandData"].get<std::string>());
+            std::string error;
+            if (modelService_->RevertModel(data.value("ModelName", ""), result.resultData, error)) {
                 result.success = true;
                 result.status = AgentConstants::STATUS_COMPLETED;
             }
+            else {
+                result.errorMessage = error;
+            }
         }
     }
     else if (commandType == AgentConstants::COMMAND_DELETE_MODEL) {
@@ -83,28 +132,21 @@ bool CommandExecutor::ExecuteCommand(const json& command) {
     else if (commandType == "UploadModelToLib") { // Using string literal as constant might not be defined yet
         if (command.contains("commandData")) {
             json data = json::parse(command["commandData"].get<std::string>());
-            if (data.contains("ModelName") && data.contains("UploadUrl")) {
-                std::string modelName = data["ModelName"].get<std::string>();
-                std::string uploadUrl = data["UploadUrl"].get<std::string>();
-                if (modelService_->UploadModelToLibrary(modelName, uploadUrl)) {
-                    result.success = true;
-                    result.status = AgentConstants::STATUS_COMPLETED;
-                }
+            std::string error;
+            if (modelService_->UploadModelToLibrary(data, result.resultData, error)) {
+                result.success = true;
+                result.status = AgentConstants::STATUS_COMPLETED;
+            }
+            else {
+                result.errorMessage = error;
             }
         }
     }
-    else if (commandType == "GetLogFileContent") {
+    else if (commandType == AgentConstants::COMMAND_GET_LOG_FILE_CONTENT) {
         if (command.contains("commandData")) {
             try {
                 json data = json::parse(command["commandData"].get<std::string>());
-                std::string filePath = data.value("FilePath", "");
-
-                // If path is relative (no drive letter), prepend the log folder path
-                if (filePath.find(':') == std::string::npos) {
-                    std::string logFolder = GetLogFolderPath();
-                    filePath = logFolder + "\\" + filePath;
-                    data["FilePath"] = filePath;
-                }
+                data["FilePath"] = ResolveLogFilePath(data.value("FilePath", ""));
 
                 // Call LogAnalyzer to read the file
                 std::string contentResult = LogAnalyzer::HandleGetLogFileContent(data.dump());
@@ -129,8 +171,101 @@ bool CommandExecutor::ExecuteCommand(const json& command) {
             }
         }
     }
+    else if (commandType == AgentConstants::COMMAND_QUERY_LOG_INDEX) {
+        if (command.contains("commandData")) {
+            try {
+                json data = json::parse(command["commandData"].get<std::string>());
+                data["FilePath"] = ResolveLogFilePath(data.value("FilePath", ""));
+
+                std::string queryResult = LogAnalyzer::HandleQueryLogIndex(data.dump());
+
+                json queryJson = json::parse(queryResult);
+                if (queryJson.value("success", false)) {
+                    result.success = true;
+                    result.status = AgentConstants::STATUS_COMPLETED;
+                    result.resultData = queryResult;
+                }
+                else {
+                    result.errorMessage = queryJson.value("error", "Unknown error querying log index");
+                }
+            }
+            catch (const std::exception& ex) {
+                result.success = false;
+                result.status = AgentConstants::STATUS_FAILED;
+                result.errorMessage = ex.what();
+            }
+        }
+    }
+
+    else if (commandType == AgentConstants::COMMAND_ANALYZE_CRITICAL_PATH) {
+        if (command.contains("commandData")) {
+            try {
+                json data = json::parse(command["commandData"].get<std::string>());
+                data["FilePath"] = ResolveLogFilePath(data.value("FilePath", ""));
 
-    SendCommandResult(commandId, result);
+                std::string analysisResult = LogAnalyzer::HandleAnalyzeCriticalPath(data.dump());
+
+                json analysisJson = json::parse(analysisResult);
+                if (analysisJson.value("success", false)) {
+                    result.success = true;
+                    result.status = AgentConstants::STATUS_COMPLETED;
+                    result.resultData = analysisResult;
+                }
+                else {
+                    result.errorMessage = analysisJson.value("error", "Unknown error analyzing log file");
+                }
+            }
+            catch (const std::exception& ex) {
+                result.success = false;
+                result.status = AgentConstants::STATUS_FAILED;
+                result.errorMessage = ex.what();
+            }
+        }
+    }
+    else if (commandType == AgentConstants::COMMAND_SEARCH_LOGS) {
+        if (command.contains("commandData")) {
+            try {
+                json data = json::parse(command["commandData"].get<std::string>());
+                std::string error;
+                if (logSearchService_->StartSearch(commandId, data, error)) {
+                    // Hits stream back as InProgress results under this commandId
+                    result.success = true;
+                    deferResult = true;
+                }
+                else {
+                    result.errorMessage = error;
+                }
+            }
+            catch (const std::exception& ex) {
+                result.success = false;
+                result.status = AgentConstants::STATUS_FAILED;
+                result.errorMessage = ex.what();
+            }
+        }
+    }
+    else if (commandType == AgentConstants::COMMAND_CANCEL_SEARCH) {
+        if (command.contains("commandData")) {
+            try {
+                json data = json::parse(command["commandData"].get<std::string>());
+                if (logSearchService_->CancelSearch(data.value("SearchId", 0))) {
+                    result.success = true;
+                    result.status = AgentConstants::STATUS_COMPLETED;
+                }
+                else {
+                    result.errorMessage = "Search not found or already finished";
+                }
+            }
+            catch (const std::exception& ex) {
+                result.success = false;
+                result.status = AgentConstants::STATUS_FAILED;
+                result.errorMessage = ex.what();
+            }
+        }
+    }
+
+    if (!deferResult) {
+        SendCommandResult(commandId, result);
+    }
     return result.success;
 }
 
@@ -149,3 +284,11 @@ std::string CommandExecutor::GetLogFolderPath() {
     // TODO: Read from config or constants instead of hardcoding
     return "C:\\LAI\\LAI-WorkData\\Log";
 }
+
+std::string CommandExecutor::ResolveLogFilePath(const std::string& filePath) {
+    // If path is relative (no drive letter), prepend the log folder path
+    if (filePath.find(':') == std::string::npos) {
+        return GetLogFolderPath() + "\\" + filePath;
+    }
+    return filePath;
+}
\ No newline at end of file
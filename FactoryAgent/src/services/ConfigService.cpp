@@ -1,6 +1,7 @@
 #include "../include/services/ConfigService.h"
 #include "../include/network/HttpClient.h"
-#include "../include/utilities/FileUtils.h"
+#include "../include/monitoring/ConfigDiff.h"
+#include "../include/utilities/HashUtils.h"
 #include "../include/common/Constants.h"
 
 ConfigService::ConfigService(AgentSettings* settings, HttpClient* client, ConfigManager* configMgr) {
@@ -13,23 +14,64 @@ ConfigService::~ConfigService() {
 }
 
 void ConfigService::SyncConfigToServer() {
-    std::string configContent;
-    if (!FileUtils::ReadFileContent(settings_->configFilePath, configContent)) {
+    std::shared_ptr<const ConfigSnapshot> snapshot;
+    if (!configManager_->GetConfigSnapshot(settings_->configFilePath, snapshot)) {
         return;
     }
 
-    if (configContent.empty() || configContent == lastConfigContent_) {
+    const FileSnapshot& file = *snapshot->file;
+    if (file.content.empty() || (baseline_ && baseline_->file->hash == file.hash)) {
         return;
     }
 
-    lastConfigContent_ = configContent;
+    if (!baseline_) {
+        if (UploadFullConfig(file)) {
+            baseline_ = snapshot;
+        }
+        return;
+    }
+
+    std::vector<ConfigChange> changes;
+    ConfigDiff::Compare(baseline_->document, snapshot->document, changes);
+    if (changes.empty()) {
+        // Comments, formatting or key order only
+        baseline_ = snapshot;
+        return;
+    }
 
     json request;
     request["pcId"] = settings_->pcId;
-    request["configContent"] = configContent;
+    request["baseHash"] = HashUtils::ToHex(baseline_->file->hash);
+    request["hash"] = HashUtils::ToHex(file.hash);
+    request["changes"] = ConfigDiff::ToJson(changes);
 
+    // The server applies the changes to its copy at baseHash. If the post fails
+    // the whole file goes instead; if that fails too the baseline stays, so the
+    // next tick sends the combined changes
     json response;
-    httpClient_->Post(AgentConstants::ENDPOINT_UPDATE_CONFIG, request, response);
+    if (!httpClient_->Post(AgentConstants::ENDPOINT_CONFIG_CHANGES, request, response)) {
+        if (UploadFullConfig(file)) {
+            baseline_ = snapshot;
+        }
+        return;
+    }
+
+    // The server asks for the whole file when its copy is not at baseHash
+    // or the changes do not apply to it
+    if (response.is_object() && response.value("resync", false) && !UploadFullConfig(file)) {
+        return;
+    }
+    baseline_ = snapshot;
+}
+
+bool ConfigService::UploadFullConfig(const FileSnapshot& file) {
+    json request;
+    request["pcId"] = settings_->pcId;
+    request["configContent"] = file.content;
+    request["hash"] = HashUtils::ToHex(file.hash);
+
+    json response;
+    return httpClient_->Post(AgentConstants::ENDPOINT_UPDATE_CONFIG, request, response);
 }
 
 bool ConfigService::ApplyConfigFromServer(const std::string& content) {
@@ -37,10 +79,49 @@ bool ConfigService::ApplyConfigFromServer(const std::string& content) {
         return false;
     }
 
-    if (configManager_->WriteConfigFile(settings_->configFilePath, content)) {
-        lastConfigContent_ = content;
+    if (configManager_->WriteConfigFile(settings_->configFilePath, content, "server")) {
+        // The server already has this version
+        std::shared_ptr<const ConfigSnapshot> snapshot;
+        if (configManager_->GetConfigSnapshot(settings_->configFilePath, snapshot)) {
+            baseline_ = snapshot;
+        }
         return true;
     }
 
     return false;
+}
+
+bool ConfigService::RollbackConfig(const json& data, std::string& resultData, std::string& error) {
+    int steps = data.value("Steps", 1);
+    std::string hash = data.value("Hash", "");
+
+    ConfigRollbackResult rollback;
+    if (!configManager_->RollbackConfig(settings_->configFilePath, steps, hash, rollback, error)) {
+        return false;
+    }
+
+    json versions = json::array();
+    std::vector<ConfigVersion> history;
+    configManager_->GetConfigVersions(settings_->configFilePath, history);
+    for (size_t i = history.size(); i > 0; i--) {
+        json version;
+        version["hash"] = history[i - 1].hash;
+        version["size"] = history[i - 1].size;
+        version["savedAtMs"] = history[i - 1].savedAtMs;
+        version["source"] = history[i - 1].source;
+        versions.push_back(version);
+    }
+
+    json result;
+    result["success"] = true;
+    result["fromHash"] = rollback.fromHash;
+    result["toHash"] = rollback.toHash;
+    result["steps"] = rollback.steps;
+    result["switchUs"] = rollback.switchUs;
+    result["elapsedUs"] = rollback.totalUs;
+    result["versions"] = versions;
+    resultData = result.dump();
+
+    // baseline_ is left alone so the next sync reports the restored keys
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,389 @@
+#include "../include/services/EventStreamService.h"
+#include "../include/network/HttpClient.h"
+#include "../include/utilities/FileUtils.h"
+#include "../include/utilities/StringUtils.h"
+#include "../include/common/Constants.h"
+#include "../../third_party/json/json.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+EventStreamService::EventStreamService(AgentSettings* settings, HttpClient* client) {
+    settings_ = settings;
+    httpClient_ = client;
+    senderThread_ = NULL;
+    isRunning_ = false;
+    batchStartTick_ = 0;
+    lastEndOffset_ = 0;
+    memoryBytes_ = 0;
+    spoolBytes_ = 0;
+    nextSequence_ = 1;
+    droppedEvents_ = 0;
+    droppedBatches_ = 0;
+    droppedBytes_ = 0;
+    durableOffset_ = 0;
+    durableHeadHash_ = 0;
+    durableHeadBytes_ = 0;
+    durableSequence_ = 0;
+
+    LoadState();
+}
+
+EventStreamService::~EventStreamService() {
+    Stop();
+}
+
+bool EventStreamService::Start() {
+    if (isRunning_) {
+        return false;
+    }
+
+    isRunning_ = true;
+    senderThread_ = CreateThread(NULL, 0, SenderThreadFunc, this, 0, NULL);
+    if (senderThread_ == NULL) {
+        isRunning_ = false;
+        return false;
+    }
+    return true;
+}
+
+void EventStreamService::Stop() {
+    if (isRunning_) {
+        isRunning_ = false;
+        if (senderThread_) {
+            WaitForSingleObject(senderThread_, 5000);
+            CloseHandle(senderThread_);
+            senderThread_ = NULL;
+        }
+    }
+
+    // Whatever is still in memory goes to the spool, so a restart neither
+    // loses it nor reads it from the log again
+    std::lock_guard<std::mutex> lock(mutex_);
+    SealLocked();
+    SpillLocked();
+}
+
+bool EventStreamService::GetResumePoint(std::string& logPath, uint64_t& offset, uint64_t& headHash, uint32_t& headBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (durableLog_.empty()) {
+        return false;
+    }
+
+    logPath = durableLog_;
+    offset = durableOffset_;
+    headHash = durableHeadHash_;
+    headBytes = durableHeadBytes_;
+    return true;
+}
+
+void EventStreamService::Publish(const std::string& logPath, uint64_t headHash, uint32_t headBytes,
+    const BarrelEvent& event, std::string_view operation, uint64_t recordOffset, uint64_t endOffset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Backpressure never holds up the tailer; the next batch starts at its
+    // own first event, so the server sees the gap
+    if (IsSaturatedLocked()) {
+        droppedEvents_++;
+        lastLogPath_.clear();
+        return;
+    }
+
+    // A batch never spans two logs
+    if (batch_.GetCount() > 0 && batch_.GetLogName() != logPath) {
+        SealLocked();
+    }
+
+    if (batch_.GetCount() == 0) {
+        // Batches of one log cover contiguous byte ranges
+        bool continues = logPath == lastLogPath_ && lastEndOffset_ <= recordOffset;
+        batch_.Reset(logPath, headHash, headBytes, continues ? lastEndOffset_ : recordOffset);
+        batchStartTick_ = GetTickCount64();
+    }
+
+    batch_.Add(event, operation, endOffset);
+    lastLogPath_ = logPath;
+    lastEndOffset_ = endOffset;
+
+    if (batch_.GetCount() >= AgentConstants::EVENT_STREAM_BATCH_EVENTS) {
+        SealLocked();
+    }
+}
+
+bool EventStreamService::IsSaturatedLocked() const {
+    return spoolBytes_ >= AgentConstants::EVENT_STREAM_MAX_SPOOL_BYTES ||
+        memoryBytes_ > AgentConstants::EVENT_STREAM_MAX_MEMORY_BYTES;
+}
+
+json EventStreamService::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    json stats;
+    stats["spooledBatches"] = spool_.size();
+    stats["spoolBytes"] = spoolBytes_;
+    stats["droppedEvents"] = droppedEvents_;
+    stats["droppedBatches"] = droppedBatches_;
+    stats["droppedBytes"] = droppedBytes_;
+    return stats;
+}
+
+DWORD WINAPI EventStreamService::SenderThreadFunc(LPVOID param) {
+    EventStreamService* service = (EventStreamService*)param;
+    service->SenderLoop();
+    return 0;
+}
+
+void EventStreamService::SenderLoop() {
+    ULONGLONG nextAttempt = 0;
+    int retryDelay = AgentConstants::EVENT_STREAM_RETRY_MIN_MS;
+
+    while (isRunning_) {
+        ULONGLONG now = GetTickCount64();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (batch_.GetCount() > 0 &&
+                now - batchStartTick_ >= (ULONGLONG)AgentConstants::EVENT_STREAM_MAX_LATENCY_MS) {
+                SealLocked();
+            }
+        }
+
+        if (now >= nextAttempt) {
+            SendResult result = SEND_OK;
+            while (isRunning_ && (result = SendNext()) == SEND_OK) {
+            }
+
+            if (result == SEND_FAILED) {
+                // Back off while the server is unreachable or refusing
+                nextAttempt = GetTickCount64() + retryDelay;
+                retryDelay = (std::min)(retryDelay * 2, AgentConstants::EVENT_STREAM_RETRY_MAX_MS);
+            }
+            else {
+                retryDelay = AgentConstants::EVENT_STREAM_RETRY_MIN_MS;
+            }
+        }
+
+        Sleep(AgentConstants::EVENT_STREAM_POLL_INTERVAL_MS);
+    }
+}
+
+EventStreamService::SendResult EventStreamService::SendNext() {
+    uint64_t sequence = 0;
+    std::string spoolPath;
+    std::string data;
+    {
+        // The spool only ever holds batches older than those in memory
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!spool_.empty()) {
+            sequence = spool_.front().sequence;
+            spoolPath = spool_.front().path;
+        }
+        else if (!memory_.empty()) {
+            sequence = memory_.front().sequence;
+            data = memory_.front().data;
+        }
+        else {
+            return SEND_IDLE;
+        }
+    }
+
+    // A spool file that is gone or damaged would block the stream, and be
+    // loaded again after every restart, so it is deleted and counted
+    BarrelEventBatchHeader header;
+    std::string logName;
+    if (!spoolPath.empty() &&
+        (!FileUtils::ReadFileContent(spoolPath, data) || !BarrelEventBatch::ReadHeader(data, header, logName))) {
+        FileUtils::DeleteFile(spoolPath);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!spool_.empty() && spool_.front().sequence == sequence) {
+            droppedBatches_++;
+            droppedBytes_ += spool_.front().bytes;
+            spoolBytes_ -= spool_.front().bytes;
+            spool_.pop_front();
+        }
+        return SEND_OK;
+    }
+
+    json response;
+    if (httpClient_ == NULL || !httpClient_->PostBinary(AgentConstants::ENDPOINT_BARREL_EVENTS, data, response) ||
+        !response.contains("success") || !response["success"].get<bool>()) {
+        return SEND_FAILED;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!memory_.empty() && memory_.front().sequence == sequence) {
+        MarkDurableLocked(memory_.front());
+        memoryBytes_ -= memory_.front().data.size();
+        memory_.pop_front();
+        SaveCheckpointLocked();
+        return SEND_OK;
+    }
+
+    // Spooled before or while it was being sent
+    for (std::deque<SpoolEntry>::iterator it = spool_.begin(); it != spool_.end(); ++it) {
+        if (it->sequence == sequence) {
+            FileUtils::DeleteFile(it->path);
+            spoolBytes_ -= it->bytes;
+            spool_.erase(it);
+            break;
+        }
+    }
+    return SEND_OK;
+}
+
+void EventStreamService::LoadState() {
+    std::string content;
+    if (FileUtils::ReadFileContent(AgentConstants::EVENT_STREAM_CHECKPOINT_FILE, content)) {
+        try {
+            json checkpoint = json::parse(content);
+            durableLog_ = checkpoint.value("logPath", "");
+            durableOffset_ = checkpoint.value("offset", (uint64_t)0);
+            durableHeadHash_ = checkpoint.value("headHash", (uint64_t)0);
+            durableHeadBytes_ = checkpoint.value("headBytes", (uint32_t)0);
+            durableSequence_ = checkpoint.value("sequence", (uint64_t)0);
+            nextSequence_ = durableSequence_ + 1;
+        }
+        catch (...) {
+            durableLog_.clear();
+        }
+    }
+
+    FileUtils::CreateFolder(AgentConstants::EVENT_STREAM_SPOOL_FOLDER);
+
+    std::error_code ec;
+    for (fs::directory_iterator it(AgentConstants::EVENT_STREAM_SPOOL_FOLDER, ec), end; it != end; it.increment(ec)) {
+        if (ec) {
+            break;
+        }
+
+        std::string path = it->path().string();
+        if (StringUtils::EndsWith(path, ".tmp")) {
+            FileUtils::DeleteFile(path);
+            continue;
+        }
+        if (!StringUtils::EndsWith(path, AgentConstants::EVENT_STREAM_SPOOL_EXTENSION)) {
+            continue;
+        }
+
+        std::string data;
+        BarrelEventBatchHeader header;
+        std::string logName;
+        if (!FileUtils::ReadFileContent(path, data) || !BarrelEventBatch::ReadHeader(data, header, logName)) {
+            FileUtils::DeleteFile(path);
+            continue;
+        }
+
+        SpoolEntry entry;
+        entry.sequence = header.sequence;
+        entry.path = path;
+        entry.bytes = data.size();
+        spool_.push_back(entry);
+        spoolBytes_ += entry.bytes;
+
+        // A spooled batch is durable even if the checkpoint write after it
+        // never happened
+        if (header.sequence > durableSequence_) {
+            durableLog_ = logName;
+            durableOffset_ = header.endOffset;
+            durableHeadHash_ = header.logHeadHash;
+            durableHeadBytes_ = header.logHeadBytes;
+            durableSequence_ = header.sequence;
+        }
+        if (header.sequence >= nextSequence_) {
+            nextSequence_ = header.sequence + 1;
+        }
+    }
+
+    std::sort(spool_.begin(), spool_.end(),
+        [](const SpoolEntry& a, const SpoolEntry& b) { return a.sequence < b.sequence; });
+}
+
+void EventStreamService::SealLocked() {
+    if (batch_.GetCount() == 0) {
+        return;
+    }
+
+    SealedBatch sealed;
+    sealed.sequence = nextSequence_++;
+    sealed.logPath = batch_.GetLogName();
+    sealed.headHash = batch_.GetLogHeadHash();
+    sealed.headBytes = batch_.GetLogHeadBytes();
+    sealed.endOffset = batch_.GetEndOffset();
+    batch_.Encode(settings_->pcId, sealed.sequence, sealed.data);
+    batch_.Reset("", 0, 0, 0);
+
+    memoryBytes_ += sealed.data.size();
+    memory_.push_back(sealed);
+
+    if (memoryBytes_ > AgentConstants::EVENT_STREAM_MAX_MEMORY_BYTES) {
+        SpillLocked();
+    }
+}
+
+void EventStreamService::SpillLocked() {
+    // Oldest first and all of memory at once, so the spool stays an older
+    // prefix of the stream and the durable offset only moves forward
+    bool spilled = false;
+    while (!memory_.empty()) {
+        SealedBatch& front = memory_.front();
+        std::string path = GetSpoolPath(front.sequence);
+        std::string tempPath = path + ".tmp";
+
+        if (!FileUtils::WriteFileContent(tempPath, front.data) ||
+            !MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            FileUtils::DeleteFile(tempPath);
+            break;
+        }
+
+        SpoolEntry entry;
+        entry.sequence = front.sequence;
+        entry.path = path;
+        entry.bytes = front.data.size();
+        spool_.push_back(entry);
+        spoolBytes_ += entry.bytes;
+
+        MarkDurableLocked(front);
+        memoryBytes_ -= front.data.size();
+        memory_.pop_front();
+        spilled = true;
+    }
+
+    if (spilled) {
+        SaveCheckpointLocked();
+    }
+}
+
+void EventStreamService::MarkDurableLocked(const SealedBatch& batch) {
+    if (batch.sequence <= durableSequence_) {
+        return;
+    }
+
+    durableLog_ = batch.logPath;
+    durableOffset_ = batch.endOffset;
+    durableHeadHash_ = batch.headHash;
+    durableHeadBytes_ = batch.headBytes;
+    durableSequence_ = batch.sequence;
+}
+
+void EventStreamService::SaveCheckpointLocked() {
+    json checkpoint;
+    checkpoint["logPath"] = durableLog_;
+    checkpoint["offset"] = durableOffset_;
+    checkpoint["headHash"] = durableHeadHash_;
+    checkpoint["headBytes"] = durableHeadBytes_;
+    checkpoint["sequence"] = durableSequence_;
+
+    std::string path = AgentConstants::EVENT_STREAM_CHECKPOINT_FILE;
+    std::string tempPath = path + ".tmp";
+    if (FileUtils::WriteFileContent(tempPath, checkpoint.dump())) {
+        MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+    }
+}
+
+std::string EventStreamService::GetSpoolPath(uint64_t sequence) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)sequence);
+    return std::string(AgentConstants::EVENT_STREAM_SPOOL_FOLDER) + "\\" + name +
+        AgentConstants::EVENT_STREAM_SPOOL_EXTENSION;
+}
\ No newline at end of file
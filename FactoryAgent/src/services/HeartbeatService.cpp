@@ -7,12 +7,13 @@ HeartbeatService::HeartbeatService() {
 HeartbeatService::~HeartbeatService() {
 }
 
-bool HeartbeatService::SendHeartbeat(int pcId, bool isAppRunning, HttpClient* client, json* commands) {
+bool HeartbeatService::SendHeartbeat(int pcId, bool isAppRunning, const json& cycleStats, const json& archiveStats,
+    HttpClient* client, json* commands) {
     if (client == NULL) {
         return false;
     }
 
-    json request = BuildHeartbeatRequest(pcId, isAppRunning);
+    json request = BuildHeartbeatRequest(pcId, isAppRunning, cycleStats, archiveStats);
     json response;
 
     if (client->Post(AgentConstants::ENDPOINT_HEARTBEAT, request, response)) {
@@ -24,10 +25,16 @@ bool HeartbeatService::SendHeartbeat(int pcId, bool isAppRunning, HttpClient* cl
     return false;
 }
 
-json HeartbeatService::BuildHeartbeatRequest(int pcId, bool isAppRunning) {
+json HeartbeatService::BuildHeartbeatRequest(int pcId, bool isAppRunning, const json& cycleStats, const json& archiveStats) {
     json request;
     request["pcId"] = pcId;
     request["isApplicationRunning"] = isAppRunning;
+    if (!cycleStats.is_null()) {
+        request["cycleStats"] = cycleStats;
+    }
+    if (!archiveStats.is_null()) {
+        request["logArchive"] = archiveStats;
+    }
     return request;
 }
 
@@ -0,0 +1,440 @@
+#include "../include/services/LiveLogService.h"
+#include "../include/services/EventStreamService.h"
+#include "../include/monitoring/LogIndex.h"
+#include "../include/network/HttpClient.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+LiveLogService::LiveLogService(AgentSettings* settings, HttpClient* client, EventStreamService* eventStream) {
+    settings_ = settings;
+    httpClient_ = client;
+    eventStream_ = eventStream;
+    tailThread_ = NULL;
+    isRunning_ = false;
+    offset_ = 0;
+    skipPartialLine_ = false;
+    warmingUp_ = false;
+    publishFrom_ = 0;
+    headHash_ = 0;
+    headBytes_ = 0;
+    logFeedsStats_ = true;
+    lastSharedTick_ = 0;
+    sharedEvents_ = 0;
+    sharedDropped_ = 0;
+    anomaliesDropped_ = 0;
+}
+
+LiveLogService::~LiveLogService() {
+    Stop();
+}
+
+bool LiveLogService::Start() {
+    if (isRunning_) {
+        return false;
+    }
+
+    isRunning_ = true;
+    tailThread_ = CreateThread(NULL, 0, TailThreadFunc, this, 0, NULL);
+    if (tailThread_ == NULL) {
+        isRunning_ = false;
+        return false;
+    }
+    return true;
+}
+
+void LiveLogService::Stop() {
+    if (isRunning_) {
+        isRunning_ = false;
+        if (tailThread_) {
+            WaitForSingleObject(tailThread_, 5000);
+            CloseHandle(tailThread_);
+            tailThread_ = NULL;
+        }
+    }
+}
+
+json LiveLogService::GetCycleStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    json summary = stats_.BuildSummary();
+    if (!summary.is_null() && sharedEvents_ > 0) {
+        json channel;
+        channel["active"] = SharedChannelActive();
+        channel["events"] = sharedEvents_;
+        channel["dropped"] = sharedDropped_;
+        summary["sharedChannel"] = channel;
+    }
+
+    // Dropped events and spool batches are reported even before the first cycle completes
+    if (eventStream_ != NULL) {
+        json stream = eventStream_->GetStats();
+        if (!summary.is_null() || stream["droppedEvents"].get<uint64_t>() > 0 ||
+            stream["droppedBatches"].get<uint64_t>() > 0) {
+            summary["eventStream"] = stream;
+        }
+    }
+    return summary;
+}
+
+void LiveLogService::ProcessSharedEvents(const SharedBarrelEvent* records, size_t count, uint64_t dropped) {
+    std::vector<AnomalyEvent> anomalies;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lastSharedTick_ = GetTickCount64();
+        sharedEvents_ += count;
+        sharedDropped_ = dropped;
+
+        for (size_t i = 0; i < count; i++) {
+            const SharedBarrelEvent& record = records[i];
+            if (record.event != LOG_EVENT_START && record.event != LOG_EVENT_END) {
+                continue;
+            }
+
+            LogPayload payload;
+            payload.barrelId = record.barrelId;
+            payload.hasBarrelId = true;
+            payload.idealMs = record.idealMs;
+            payload.hasIdealMs = record.idealMs >= 0;
+            if (record.event == LOG_EVENT_END && record.durationMs >= 0) {
+                payload.startTs = record.timeMs - record.durationMs;
+                payload.endTs = record.timeMs;
+                payload.hasStartTs = true;
+                payload.hasEndTs = true;
+            }
+
+            std::string_view operation(record.operation,
+                (std::min)((size_t)record.operationLength, sizeof(record.operation)));
+            CycleSample sample;
+            if (sharedTracker_.Process((LogEvent)record.event, operation, record.timeMs, payload, sample)) {
+                stats_.Add(sample);
+                detector_.Add(sample, anomalies);
+            }
+        }
+    }
+
+    if (!anomalies.empty()) {
+        QueueAnomalies(anomalies);
+    }
+}
+
+bool LiveLogService::SharedChannelActive() const {
+    return lastSharedTick_ != 0 &&
+        GetTickCount64() - lastSharedTick_ < (ULONGLONG)AgentConstants::SHARED_EVENT_ACTIVE_TIMEOUT_MS;
+}
+
+DWORD WINAPI LiveLogService::TailThreadFunc(LPVOID param) {
+    LiveLogService* service = (LiveLogService*)param;
+    service->TailLoop();
+    return 0;
+}
+
+void LiveLogService::TailLoop() {
+    ULONGLONG lastDiscovery = 0;
+
+    while (isRunning_) {
+        ULONGLONG now = GetTickCount64();
+        if (activePath_.empty() || now - lastDiscovery >= (ULONGLONG)AgentConstants::LIVE_LOG_DISCOVERY_INTERVAL_MS) {
+            DiscoverActiveLog();
+            lastDiscovery = now;
+        }
+
+        if (!activePath_.empty()) {
+            ReadAppended();
+        }
+
+        Sleep(AgentConstants::LIVE_LOG_POLL_INTERVAL_MS);
+    }
+}
+
+void LiveLogService::DiscoverActiveLog() {
+    std::string newestPath;
+    fs::file_time_type newestTime;
+    std::error_code ec;
+
+    for (fs::recursive_directory_iterator it(settings_->logFolderPath, ec), end; it != end; it.increment(ec)) {
+        if (ec) {
+            break;
+        }
+        if (!it->is_regular_file(ec) || !LogIndex::IsLogFile(it->path().string())) {
+            continue;
+        }
+
+        fs::file_time_type modified = it->last_write_time(ec);
+        if (!ec && (newestPath.empty() || modified > newestTime)) {
+            newestPath = it->path().string();
+            newestTime = modified;
+        }
+    }
+
+    if (newestPath.empty() || newestPath == activePath_) {
+        return;
+    }
+
+    if (activePath_.empty()) {
+        warmingUp_ = true;
+        if (AttachAtResumePoint(newestPath)) {
+            return;
+        }
+
+        // First attach: warm up from the recent tail instead of the whole
+        // file; only what is appended from now on is streamed
+        uintmax_t size = fs::file_size(newestPath, ec);
+        offset_ = 0;
+        if (!ec && size > AgentConstants::LIVE_LOG_BOOTSTRAP_BYTES) {
+            offset_ = size - AgentConstants::LIVE_LOG_BOOTSTRAP_BYTES;
+        }
+        skipPartialLine_ = offset_ > 0;
+        publishFrom_ = ec ? 0 : size;
+        headHash_ = 0;
+        headBytes_ = 0;
+        activePath_ = newestPath;
+        return;
+    }
+
+    // The application rolled over to a new log. Finish the old one first so
+    // its last events still reach the stream, then read the new one from
+    // the start.
+    while (isRunning_ && ReadAppended()) {
+    }
+
+    offset_ = 0;
+    skipPartialLine_ = false;
+    publishFrom_ = 0;
+    headHash_ = 0;
+    headBytes_ = 0;
+    activePath_ = newestPath;
+}
+
+bool LiveLogService::AttachAtResumePoint(const std::string& newestPath) {
+    std::string path;
+    uint64_t offset = 0;
+    uint64_t headHash = 0;
+    uint32_t headBytes = 0;
+    if (eventStream_ == NULL || !eventStream_->GetResumePoint(path, offset, headHash, headBytes)) {
+        return false;
+    }
+
+    // The checkpointed log must still be the same file, at least as long
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.seekg(0, std::ios::end);
+    unsigned long long size = (unsigned long long)file.tellg();
+    if (size < offset || size < headBytes) {
+        return false;
+    }
+
+    std::vector<char> head(headBytes);
+    file.seekg(0, std::ios::beg);
+    if (headBytes > 0 && !file.read(head.data(), headBytes)) {
+        return false;
+    }
+    if (LogIndex::HashHead(head.data(), head.size()) != headHash) {
+        return false;
+    }
+
+    activePath_ = path;
+    publishFrom_ = offset;
+    headHash_ = headHash;
+    headBytes_ = headBytes;
+    offset_ = offset;
+    skipPartialLine_ = false;
+
+    // Still the active log: also replay the usual bootstrap window so the
+    // statistics warm up, without streaming anything twice
+    if (path == newestPath && size > AgentConstants::LIVE_LOG_BOOTSTRAP_BYTES &&
+        size - AgentConstants::LIVE_LOG_BOOTSTRAP_BYTES < offset) {
+        offset_ = size - AgentConstants::LIVE_LOG_BOOTSTRAP_BYTES;
+        skipPartialLine_ = true;
+    }
+    else if (path == newestPath && size <= AgentConstants::LIVE_LOG_BOOTSTRAP_BYTES) {
+        offset_ = 0;
+    }
+    return true;
+}
+
+void LiveLogService::UpdateHeadHash(std::ifstream& file, unsigned long long size) {
+    if (headBytes_ >= AgentConstants::LOG_INDEX_HEAD_HASH_BYTES || size <= headBytes_) {
+        return;
+    }
+
+    uint32_t length = (uint32_t)(std::min)(size, (unsigned long long)AgentConstants::LOG_INDEX_HEAD_HASH_BYTES);
+    std::vector<char> head(length);
+    file.seekg(0, std::ios::beg);
+    if (file.read(head.data(), length)) {
+        headHash_ = LogIndex::HashHead(head.data(), length);
+        headBytes_ = length;
+    }
+    file.clear();
+}
+
+bool LiveLogService::ReadAppended() {
+    std::ifstream file(activePath_, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    unsigned long long size = (unsigned long long)file.tellg();
+
+    if (size < offset_) {
+        // Truncated or replaced in place
+        offset_ = 0;
+        skipPartialLine_ = false;
+        publishFrom_ = 0;
+        headBytes_ = 0;
+    }
+    if (size == offset_) {
+        return false;
+    }
+    UpdateHeadHash(file, size);
+
+    size_t toRead = (size_t)(std::min)(size - offset_, (unsigned long long)AgentConstants::LIVE_LOG_MAX_READ_BYTES);
+    buffer_.resize(toRead);
+    file.seekg((std::streamoff)offset_, std::ios::beg);
+    file.read(buffer_.data(), (std::streamsize)toRead);
+    size_t bytesRead = (size_t)file.gcount();
+    if (bytesRead == 0) {
+        return false;
+    }
+    bool reachedEnd = offset_ + bytesRead >= size;
+
+    const char* data = buffer_.data();
+    size_t start = 0;
+    if (skipPartialLine_) {
+        const char* newline = LogRecordScanner::FindByte(data, data + bytesRead, '\n');
+        if (newline == data + bytesRead) {
+            offset_ += bytesRead;
+            return true;
+        }
+        start = (size_t)(newline - data) + 1;
+        skipPartialLine_ = false;
+    }
+
+    // Leave an unterminated last line for the next poll
+    LogRecordScanner scanner(data + start, bytesRead - start, false);
+    LogRecord record;
+    unsigned long long baseOffset = offset_ + start;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // While the application feeds the shared channel, the statistics
+        // come from there; the log still drives the durable event stream
+        logFeedsStats_ = !SharedChannelActive();
+        while (scanner.Next(record)) {
+            ProcessRecord(record, baseOffset + record.offset);
+        }
+    }
+
+    size_t consumed = start + scanner.Position();
+    if (consumed == 0 && bytesRead == AgentConstants::LIVE_LOG_MAX_READ_BYTES) {
+        // A single line longer than the read window; drop it
+        consumed = bytesRead;
+        skipPartialLine_ = true;
+    }
+    offset_ += consumed;
+
+    // History replayed while attaching only trains the detector
+    if (warmingUp_) {
+        pendingEvents_.clear();
+        warmingUp_ = !reachedEnd;
+    }
+    else if (!pendingEvents_.empty()) {
+        QueueAnomalies(pendingEvents_);
+    }
+    return consumed > 0;
+}
+
+void LiveLogService::ProcessRecord(const LogRecord& record, unsigned long long recordOffset) {
+    if (!record.IsEvent()) {
+        return;
+    }
+
+    LogEvent event = LogRecordScanner::ParseEvent(record.fields[AgentConstants::LOG_FIELD_EVENT]);
+    long long timeMs = 0;
+    LogPayload payload;
+    if (event == LOG_EVENT_NONE ||
+        !LogRecordScanner::ParseDateTime(record.fields[AgentConstants::LOG_FIELD_DATETIME], timeMs) ||
+        !LogRecordScanner::ParsePayload(record.fields[AgentConstants::LOG_FIELD_PAYLOAD], payload)) {
+        return;
+    }
+
+    std::string_view operation = record.fields[AgentConstants::LOG_FIELD_SEQUENCE];
+    CycleSample sample;
+    bool completed = tracker_.Process(event, operation, timeMs, payload, sample);
+    if (completed && logFeedsStats_) {
+        stats_.Add(sample);
+        detector_.Add(sample, pendingEvents_);
+    }
+
+    if (eventStream_ != NULL && recordOffset >= publishFrom_) {
+        BarrelEvent barrelEvent;
+        barrelEvent.timeMs = timeMs;
+        barrelEvent.barrelId = payload.barrelId;
+        barrelEvent.event = event;
+        barrelEvent.durationMs = completed ? sample.durationMs : -1;
+        barrelEvent.idealMs = payload.hasIdealMs ? payload.idealMs : -1;
+        if (completed && sample.hasIdeal) {
+            barrelEvent.idealMs = sample.idealMs;
+        }
+        eventStream_->Publish(activePath_, headHash_, headBytes_, barrelEvent, operation,
+            recordOffset, recordOffset + record.length);
+    }
+}
+
+void LiveLogService::QueueAnomalies(std::vector<AnomalyEvent>& anomalies) {
+    std::lock_guard<std::mutex> lock(anomalyMutex_);
+    for (size_t i = 0; i < anomalies.size(); i++) {
+        anomalyQueue_.push_back(anomalies[i]);
+    }
+    anomalies.clear();
+
+    // While the server is unreachable only the newest anomalies are kept
+    while (anomalyQueue_.size() > AgentConstants::ANOMALY_MAX_QUEUED) {
+        anomalyQueue_.pop_front();
+        anomaliesDropped_++;
+    }
+}
+
+void LiveLogService::FlushAnomalies() {
+    std::deque<AnomalyEvent> anomalies;
+    unsigned long long dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(anomalyMutex_);
+        anomalies.swap(anomalyQueue_);
+        dropped = anomaliesDropped_;
+    }
+    if (anomalies.empty() && dropped == 0) {
+        return;
+    }
+
+    json events = json::array();
+    for (size_t i = 0; i < anomalies.size(); i++) {
+        events.push_back(AnomalyDetector::ToJson(anomalies[i]));
+    }
+
+    json request;
+    request["pcId"] = settings_->pcId;
+    request["events"] = events;
+    request["dropped"] = dropped;
+
+    json response;
+    bool posted = httpClient_->Post(AgentConstants::ENDPOINT_ANOMALY_EVENTS, request, response);
+
+    std::lock_guard<std::mutex> lock(anomalyMutex_);
+    if (posted) {
+        anomaliesDropped_ -= dropped;
+        return;
+    }
+
+    // Put the batch back ahead of anything queued meanwhile
+    anomalyQueue_.insert(anomalyQueue_.begin(), anomalies.begin(), anomalies.end());
+    while (anomalyQueue_.size() > AgentConstants::ANOMALY_MAX_QUEUED) {
+        anomalyQueue_.pop_front();
+        anomaliesDropped_++;
+    }
+}
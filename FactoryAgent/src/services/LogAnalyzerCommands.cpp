@@ -1,5 +1,12 @@
 #include "../include/services/LogAnalyzerCommands.h"
 #include "../include/utilities/FileUtils.h"
+#include "../include/utilities/MappedFile.h"
+#include "../include/utilities/LogRecordScanner.h"
+#include "../include/monitoring/LogIndex.h"
+#include "../include/monitoring/LogArchive.h"
+#include "../include/monitoring/CycleTimeTracker.h"
+#include "../include/monitoring/CriticalPathAnalyzer.h"
+#include "../include/common/Constants.h"
 #include "../../third_party/json/json.hpp"
 #include <filesystem>
 #include <fstream>
@@ -121,6 +128,20 @@ namespace LogAnalyzer
             std::ifstream file(wFilePath, std::ios::binary);
             if (!file.is_open())
             {
+                // Closed logs may only survive in their columnar archive
+                LogArchive archive;
+                std::string content;
+                if (archive.Open(filePath) && archive.Reconstruct(content))
+                {
+                    json result;
+                    result["success"] = true;
+                    result["content"] = content;
+                    result["size"] = content.size();
+                    result["encoding"] = "UTF-8";
+                    result["source"] = "archive";
+                    return result.dump();
+                }
+
                 json error;
                 error["success"] = false;
                 error["error"] = "Failed to open file: " + filePath;
@@ -155,4 +176,276 @@ namespace LogAnalyzer
             return error.dump();
         }
     }
+
+    // Handle QueryLogIndex command: read only the byte ranges the sidecar
+    // index points at for a barrel or a time window
+    std::string HandleQueryLogIndex(const std::string& commandData)
+    {
+        try
+        {
+            json cmdJson = json::parse(commandData);
+            std::string filePath = cmdJson["FilePath"];
+            size_t maxBytes = cmdJson.value("MaxBytes", (size_t)AgentConstants::LOG_QUERY_MAX_BYTES);
+
+            bool byBarrel = cmdJson.contains("BarrelId");
+            long long barrelId = byBarrel ? cmdJson["BarrelId"].get<long long>() : 0;
+            long long fromMs = 0;
+            long long toMs = 0;
+
+            if (!byBarrel)
+            {
+                std::string from = cmdJson.value("From", "");
+                std::string to = cmdJson.value("To", "");
+                if (!LogRecordScanner::ParseDateTime(from, fromMs) || !LogRecordScanner::ParseDateTime(to, toMs))
+                {
+                    json error;
+                    error["success"] = false;
+                    error["error"] = "QueryLogIndex needs BarrelId or a From/To date-time window";
+                    return error.dump();
+                }
+            }
+
+            // Bring the sidecar up to date; a damaged one is rebuilt from scratch
+            if (!LogIndex::Update(filePath) && !LogIndex::Rebuild(filePath))
+            {
+                json error;
+                error["success"] = false;
+                error["error"] = "Failed to index file: " + filePath;
+                return error.dump();
+            }
+
+            LogIndex index;
+            MappedFile log;
+            if (!index.Open(filePath) || !log.Open(filePath))
+            {
+                json error;
+                error["success"] = false;
+                error["error"] = "Failed to open file: " + filePath;
+                return error.dump();
+            }
+
+            uint64_t beginOffset = 0;
+            uint64_t endOffset = 0;
+            bool found = false;
+            if (byBarrel)
+            {
+                LogIndexBarrelEntry entry;
+                found = index.FindBarrel(barrelId, entry);
+                beginOffset = entry.beginOffset;
+                endOffset = entry.endOffset;
+            }
+            else
+            {
+                found = index.FindTimeRange(fromMs, toMs, beginOffset, endOffset);
+            }
+
+            std::string content;
+            size_t matchedLines = 0;
+            bool truncated = false;
+
+            if (found && endOffset <= log.GetSize())
+            {
+                LogRecordScanner scanner(log.GetData() + beginOffset, (size_t)(endOffset - beginOffset));
+                LogRecord record;
+
+                while (scanner.Next(record))
+                {
+                    if (!record.IsEvent())
+                    {
+                        continue;
+                    }
+
+                    bool match = false;
+                    if (byBarrel)
+                    {
+                        LogPayload payload;
+                        match = LogRecordScanner::ParsePayload(record.fields[AgentConstants::LOG_FIELD_PAYLOAD], payload) &&
+                            payload.barrelId == barrelId;
+                    }
+                    else
+                    {
+                        long long timeMs = 0;
+                        match = LogRecordScanner::ParseDateTime(record.fields[AgentConstants::LOG_FIELD_DATETIME], timeMs) &&
+                            timeMs >= fromMs && timeMs <= toMs;
+                    }
+
+                    if (!match)
+                    {
+                        continue;
+                    }
+
+                    if (content.size() + record.line.size() + 1 > maxBytes)
+                    {
+                        truncated = true;
+                        break;
+                    }
+
+                    content.append(record.line.data(), record.line.size());
+                    content.push_back('\n');
+                    matchedLines++;
+                }
+            }
+
+            json result;
+            result["success"] = true;
+            result["content"] = content;
+            result["matchedLines"] = matchedLines;
+            result["bytesScanned"] = found ? (endOffset - beginOffset) : 0;
+            result["fileSize"] = log.GetSize();
+            result["truncated"] = truncated;
+            result["encoding"] = "UTF-8";
+
+            return result.dump();
+        }
+        catch (const std::exception& ex)
+        {
+            json error;
+            error["success"] = false;
+            error["error"] = ex.what();
+            return error.dump();
+        }
+    }
+
+    std::string HandleAnalyzeCriticalPath(const std::string& commandData)
+    {
+        try
+        {
+            json cmdJson = json::parse(commandData);
+            std::string filePath = cmdJson["FilePath"];
+            size_t maxBarrels = cmdJson.value("MaxBarrels", (size_t)AgentConstants::CRITICAL_PATH_DEFAULT_MAX_BARRELS);
+
+            bool hasWindow = cmdJson.contains("From") || cmdJson.contains("To");
+            long long fromMs = 0;
+            long long toMs = 0;
+            if (hasWindow &&
+                (!LogRecordScanner::ParseDateTime(cmdJson.value("From", ""), fromMs) ||
+                 !LogRecordScanner::ParseDateTime(cmdJson.value("To", ""), toMs)))
+            {
+                json error;
+                error["success"] = false;
+                error["error"] = "AnalyzeCriticalPath needs both From and To when a window is given";
+                return error.dump();
+            }
+
+            ULONGLONG startTick = GetTickCount64();
+            CycleTimeTracker tracker;
+            CriticalPathAnalyzer analyzer(maxBarrels);
+            CycleSample sample;
+            size_t samples = 0;
+            uint64_t bytesScanned = 0;
+            uint64_t fileSize = 0;
+            const char* source = "text";
+
+            LogArchive archive;
+            if (archive.Open(filePath))
+            {
+                // Columnar archive: skip whole blocks by time range and read
+                // the event columns directly, without rebuilding any text
+                source = "archive";
+                fileSize = archive.GetSourceSize();
+                std::vector<ArchivedEvent> events;
+
+                for (uint32_t block = 0; block < archive.GetBlockCount(); block++)
+                {
+                    const LogArchiveBlockEntry& entry = archive.GetBlock(block);
+                    if (hasWindow && (entry.maxTimeMs < fromMs - AgentConstants::CRITICAL_PATH_BARREL_IDLE_MS ||
+                                      entry.minTimeMs > toMs))
+                    {
+                        continue;
+                    }
+                    if (!archive.ReadEvents(block, events))
+                    {
+                        json error;
+                        error["success"] = false;
+                        error["error"] = "Damaged log archive: " + LogArchive::GetArchivePath(filePath);
+                        return error.dump();
+                    }
+                    bytesScanned += entry.textSize;
+
+                    for (size_t i = 0; i < events.size(); i++)
+                    {
+                        const ArchivedEvent& event = events[i];
+                        if (!tracker.Process(event.event, event.operation, event.timeMs, event.payload, sample))
+                        {
+                            continue;
+                        }
+                        if (hasWindow && (sample.timeMs < fromMs || sample.timeMs > toMs))
+                        {
+                            continue;
+                        }
+
+                        analyzer.Add(sample);
+                        samples++;
+                    }
+                }
+            }
+            else
+            {
+                MappedFile log;
+                if (!log.Open(filePath))
+                {
+                    json error;
+                    error["success"] = false;
+                    error["error"] = "Failed to open file: " + filePath;
+                    return error.dump();
+                }
+
+                // Narrow a windowed run through the sidecar index, starting early
+                // enough to see the START lines of barrels that end in the window
+                uint64_t beginOffset = 0;
+                uint64_t endOffset = log.GetSize();
+                if (hasWindow && (LogIndex::Update(filePath) || LogIndex::Rebuild(filePath)))
+                {
+                    LogIndex index;
+                    uint64_t rangeBegin = 0;
+                    uint64_t rangeEnd = 0;
+                    if (index.Open(filePath) && index.GetIndexedSize() <= log.GetSize() &&
+                        index.FindTimeRange(fromMs - AgentConstants::CRITICAL_PATH_BARREL_IDLE_MS, toMs, rangeBegin, rangeEnd))
+                    {
+                        beginOffset = rangeBegin;
+                        endOffset = (rangeEnd >= index.GetIndexedSize()) ? log.GetSize() : rangeEnd;
+                    }
+                }
+
+                LogRecordScanner scanner(log.GetData() + beginOffset, (size_t)(endOffset - beginOffset));
+                LogRecord record;
+
+                while (scanner.Next(record))
+                {
+                    if (!tracker.Process(record, sample))
+                    {
+                        continue;
+                    }
+                    if (hasWindow && (sample.timeMs < fromMs || sample.timeMs > toMs))
+                    {
+                        continue;
+                    }
+
+                    analyzer.Add(sample);
+                    samples++;
+                }
+
+                bytesScanned = endOffset - beginOffset;
+                fileSize = log.GetSize();
+            }
+            analyzer.Finish();
+
+            json result = analyzer.ToJson();
+            result["success"] = true;
+            result["samples"] = samples;
+            result["bytesScanned"] = bytesScanned;
+            result["fileSize"] = fileSize;
+            result["source"] = source;
+            result["elapsedMs"] = GetTickCount64() - startTick;
+
+            return result.dump();
+        }
+        catch (const std::exception& ex)
+        {
+            json error;
+            error["success"] = false;
+            error["error"] = ex.what();
+            return error.dump();
+        }
+    }
 }
\ No newline at end of file
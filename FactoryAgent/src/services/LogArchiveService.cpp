@@ -0,0 +1,179 @@
+#include "../include/services/LogArchiveService.h"
+#include "../include/monitoring/LogIndex.h"
+#include "../include/common/Constants.h"
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+LogArchiveService::LogArchiveService(AgentSettings* settings) {
+    settings_ = settings;
+    archiveThread_ = NULL;
+    isRunning_ = false;
+    archivedFiles_ = 0;
+}
+
+LogArchiveService::~LogArchiveService() {
+    Stop();
+}
+
+bool LogArchiveService::Start() {
+    if (isRunning_) {
+        return false;
+    }
+
+    isRunning_ = true;
+    archiveThread_ = CreateThread(NULL, 0, ArchiveThreadFunc, this, 0, NULL);
+    if (archiveThread_ == NULL) {
+        isRunning_ = false;
+        return false;
+    }
+    return true;
+}
+
+void LogArchiveService::Stop() {
+    if (isRunning_) {
+        isRunning_ = false;
+        if (archiveThread_) {
+            WaitForSingleObject(archiveThread_, 5000);
+            CloseHandle(archiveThread_);
+            archiveThread_ = NULL;
+        }
+    }
+}
+
+json LogArchiveService::GetStats() {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    if (archivedFiles_ == 0) {
+        return json();
+    }
+
+    json stats;
+    stats["archivedFiles"] = archivedFiles_;
+    stats["sourceBytes"] = totals_.sourceBytes;
+    stats["archiveBytes"] = totals_.archiveBytes;
+    stats["ratio"] = Ratio(totals_);
+    stats["lines"] = totals_.lines;
+    stats["rawLines"] = totals_.rawLines;
+    stats["elapsedMs"] = totals_.elapsedMs;
+    return stats;
+}
+
+DWORD WINAPI LogArchiveService::ArchiveThreadFunc(LPVOID param) {
+    LogArchiveService* service = (LogArchiveService*)param;
+    service->ArchiveLoop();
+    return 0;
+}
+
+void LogArchiveService::ArchiveLoop() {
+    // Archiving must never compete with the application for CPU or disk
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+    ULONGLONG lastPass = 0;
+    bool firstPass = true;
+
+    while (isRunning_) {
+        ULONGLONG now = GetTickCount64();
+        if (firstPass || now - lastPass >= (ULONGLONG)AgentConstants::LOG_ARCHIVE_SCAN_INTERVAL_MS) {
+            ArchiveClosedLogs();
+            lastPass = GetTickCount64();
+            firstPass = false;
+        }
+        Sleep(1000);
+    }
+
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+}
+
+void LogArchiveService::ArchiveClosedLogs() {
+    if (settings_->logFolderPath.empty()) {
+        return;
+    }
+
+    struct Candidate {
+        std::string path;
+        fs::file_time_type modified;
+    };
+
+    // Group logs by folder so the newest (still active) one can be left alone
+    std::map<std::string, std::vector<Candidate> > folders;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(settings_->logFolderPath, ec), end; isRunning_ && it != end; it.increment(ec)) {
+        if (ec) {
+            break;
+        }
+        if (!it->is_regular_file(ec) || !LogIndex::IsLogFile(it->path().string())) {
+            continue;
+        }
+
+        Candidate candidate;
+        candidate.path = it->path().string();
+        candidate.modified = it->last_write_time(ec);
+        if (!ec) {
+            folders[it->path().parent_path().string()].push_back(candidate);
+        }
+    }
+
+    fs::file_time_type cutoff = fs::file_time_type::clock::now() -
+        std::chrono::milliseconds(AgentConstants::LOG_ARCHIVE_MIN_AGE_MS);
+
+    LogArchiveStats pass;
+    unsigned long long archived = 0;
+
+    for (std::map<std::string, std::vector<Candidate> >::iterator folder = folders.begin();
+         isRunning_ && folder != folders.end(); ++folder) {
+        std::vector<Candidate>& logs = folder->second;
+
+        size_t newest = 0;
+        for (size_t i = 1; i < logs.size(); i++) {
+            if (logs[i].modified > logs[newest].modified) {
+                newest = i;
+            }
+        }
+
+        for (size_t i = 0; isRunning_ && i < logs.size(); i++) {
+            if (i == newest || logs[i].modified > cutoff) {
+                continue;
+            }
+
+            // Already archived and still matching
+            LogArchive existing;
+            if (existing.Open(logs[i].path)) {
+                continue;
+            }
+
+            LogArchiveStats stats;
+            if (!LogArchive::Build(logs[i].path, stats)) {
+                continue;
+            }
+
+            pass.sourceBytes += stats.sourceBytes;
+            pass.archiveBytes += stats.archiveBytes;
+            pass.lines += stats.lines;
+            pass.rawLines += stats.rawLines;
+            pass.elapsedMs += stats.elapsedMs;
+            archived++;
+        }
+    }
+
+    if (archived > 0) {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        totals_.sourceBytes += pass.sourceBytes;
+        totals_.archiveBytes += pass.archiveBytes;
+        totals_.lines += pass.lines;
+        totals_.rawLines += pass.rawLines;
+        totals_.elapsedMs += pass.elapsedMs;
+        archivedFiles_ += archived;
+    }
+}
+
+double LogArchiveService::Ratio(const LogArchiveStats& stats) {
+    if (stats.archiveBytes == 0) {
+        return 0.0;
+    }
+    return std::round((double)stats.sourceBytes * 100.0 / (double)stats.archiveBytes) / 100.0;
+}
\ No newline at end of file
@@ -0,0 +1,546 @@
+#include "../include/services/LogSearchService.h"
+#include "../include/services/LogService.h"
+#include "../include/network/HttpClient.h"
+#include "../include/monitoring/LogIndex.h"
+#include "../include/utilities/MappedFile.h"
+#include "../include/utilities/LogRecordScanner.h"
+#include "../include/utilities/StringUtils.h"
+#include "../include/utilities/ThreadPool.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <climits>
+#include <filesystem>
+#include <regex>
+#include <thread>
+#include <vector>
+#include <windows.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    struct SearchHit {
+        std::string file;
+        unsigned long long offset;
+        std::string line;
+    };
+
+    struct CandidateFile {
+        std::string path;
+        std::string relativePath;
+        fs::file_time_type modified;
+    };
+
+    unsigned long long GetThreadCpuMicroseconds() {
+        FILETIME creation, exitTime, kernel, user;
+        if (!GetThreadTimes(GetCurrentThread(), &creation, &exitTime, &kernel, &user)) {
+            return 0;
+        }
+        unsigned long long kernel100ns = ((unsigned long long)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+        unsigned long long user100ns = ((unsigned long long)user.dwHighDateTime << 32) | user.dwLowDateTime;
+        return (kernel100ns + user100ns) / 10;
+    }
+
+    std::string EscapeRegex(const std::string& text) {
+        static const std::string special = "\\^$.|?*+()[]{}";
+        std::string escaped;
+        for (size_t i = 0; i < text.length(); i++) {
+            if (special.find(text[i]) != std::string::npos) {
+                escaped.push_back('\\');
+            }
+            escaped.push_back(text[i]);
+        }
+        return escaped;
+    }
+}
+
+struct LogSearchService::SearchJob {
+    int commandId;
+    std::string literal;
+    bool useRegex;
+    std::regex regex;
+    std::string fileGlob;
+    bool hasWindow;
+    long long fromMs;
+    long long toMs;
+    size_t maxHits;
+    size_t maxThreads;
+    unsigned long long cpuBudgetUs;
+
+    std::atomic<bool> cancelled;
+    std::atomic<bool> budgetExhausted;
+    std::atomic<bool> finished;
+    std::atomic<unsigned long long> cpuUsedUs;
+    std::atomic<unsigned long long> bytesScanned;
+    std::atomic<size_t> filesScanned;
+    std::atomic<size_t> totalHits;
+
+    std::mutex hitsMutex;
+    std::vector<SearchHit> hits;
+    size_t flushedHits;
+    std::thread thread;
+
+    SearchJob() : cancelled(false), budgetExhausted(false), finished(false),
+        cpuUsedUs(0), bytesScanned(0), filesScanned(0), totalHits(0) {
+        commandId = 0;
+        useRegex = false;
+        hasWindow = false;
+        fromMs = 0;
+        toMs = 0;
+        maxHits = 0;
+        flushedHits = 0;
+        maxThreads = 0;
+        cpuBudgetUs = 0;
+    }
+
+    bool ShouldStop() const {
+        return cancelled || budgetExhausted || totalHits >= maxHits;
+    }
+};
+
+LogSearchService::LogSearchService(AgentSettings* settings, HttpClient* client) {
+    settings_ = settings;
+    httpClient_ = client;
+}
+
+LogSearchService::~LogSearchService() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::map<int, std::shared_ptr<SearchJob> >::iterator it = jobs_.begin(); it != jobs_.end(); ++it) {
+        it->second->cancelled = true;
+    }
+    for (std::map<int, std::shared_ptr<SearchJob> >::iterator it = jobs_.begin(); it != jobs_.end(); ++it) {
+        if (it->second->thread.joinable()) {
+            it->second->thread.join();
+        }
+    }
+    jobs_.clear();
+}
+
+bool LogSearchService::StartSearch(int commandId, const json& request, std::string& error) {
+    std::string pattern = request.value("Pattern", "");
+    if (pattern.empty()) {
+        error = "SearchLogs requires a Pattern";
+        return false;
+    }
+
+    std::shared_ptr<SearchJob> job(new SearchJob());
+    job->commandId = commandId;
+    job->fileGlob = request.value("FileGlob", "*");
+    job->maxHits = (std::min)(request.value("MaxHits", (size_t)AgentConstants::LOG_SEARCH_DEFAULT_MAX_HITS),
+        (size_t)AgentConstants::LOG_SEARCH_MAX_HITS);
+    job->cpuBudgetUs = request.value("MaxCpuMs", (unsigned long long)AgentConstants::LOG_SEARCH_DEFAULT_CPU_BUDGET_MS) * 1000ULL;
+    job->maxThreads = (std::min)(request.value("MaxThreads", (size_t)AgentConstants::LOG_SEARCH_MAX_THREADS),
+        (size_t)AgentConstants::LOG_SEARCH_MAX_THREADS);
+
+    bool isRegex = request.value("IsRegex", false);
+    bool ignoreCase = request.value("IgnoreCase", false);
+
+    // Case-insensitive or regex searches go through std::regex; the SIMD
+    // prefilter only runs on an exact-case literal every match contains
+    try {
+        std::regex::flag_type flags = std::regex::ECMAScript | std::regex::optimize;
+        if (ignoreCase) {
+            flags |= std::regex::icase;
+        }
+
+        if (isRegex) {
+            job->regex = std::regex(pattern, flags);
+            job->useRegex = true;
+            job->literal = ignoreCase ? "" : ExtractLiteral(pattern);
+        }
+        else if (ignoreCase) {
+            job->regex = std::regex(EscapeRegex(pattern), flags);
+            job->useRegex = true;
+        }
+        else {
+            job->literal = pattern;
+        }
+    }
+    catch (const std::regex_error& ex) {
+        error = std::string("Invalid pattern: ") + ex.what();
+        return false;
+    }
+
+    std::string from = request.value("From", "");
+    std::string to = request.value("To", "");
+    if (!from.empty() || !to.empty()) {
+        job->fromMs = LLONG_MIN;
+        job->toMs = LLONG_MAX;
+        if ((!from.empty() && !LogRecordScanner::ParseDateTime(from, job->fromMs)) ||
+            (!to.empty() && !LogRecordScanner::ParseDateTime(to, job->toMs))) {
+            error = "Invalid From/To date-time";
+            return false;
+        }
+        job->hasWindow = true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ReapFinishedJobs();
+
+    if (jobs_.size() >= (size_t)AgentConstants::LOG_SEARCH_MAX_CONCURRENT) {
+        error = "Too many searches running";
+        return false;
+    }
+
+    jobs_[commandId] = job;
+    job->thread = std::thread(&LogSearchService::RunSearch, this, job);
+    return true;
+}
+
+bool LogSearchService::CancelSearch(int commandId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<int, std::shared_ptr<SearchJob> >::iterator it = jobs_.find(commandId);
+    if (it == jobs_.end()) {
+        return false;
+    }
+
+    it->second->cancelled = true;
+    return true;
+}
+
+std::string LogSearchService::ExtractLiteral(const std::string& regexPattern) {
+    std::string best;
+    std::string current;
+    size_t i = 0;
+
+    while (i < regexPattern.length()) {
+        char c = regexPattern[i];
+
+        // Alternation, and groups that may be optional, repeated or lookarounds
+        if (c == '|' || c == '(') {
+            return "";
+        }
+
+        if (c == '*' || c == '?' || c == '{') {
+            // The previous character is optional or repeated
+            if (!current.empty()) {
+                current.pop_back();
+            }
+            if (current.length() > best.length()) {
+                best = current;
+            }
+            current.clear();
+            if (c == '{') {
+                while (i < regexPattern.length() && regexPattern[i] != '}') {
+                    i++;
+                }
+            }
+            i++;
+            continue;
+        }
+
+        if (c == '+') {
+            // At least one occurrence stays literal, but the run ends here
+            if (current.length() > best.length()) {
+                best = current;
+            }
+            current.clear();
+            i++;
+            continue;
+        }
+
+        if (c == '\\' && i + 1 < regexPattern.length()) {
+            char next = regexPattern[i + 1];
+            if (std::isalnum(static_cast<unsigned char>(next))) {
+                // Character class (\d, \w ...) or back-reference
+                if (current.length() > best.length()) {
+                    best = current;
+                }
+                current.clear();
+            }
+            else {
+                current.push_back(next);
+            }
+            i += 2;
+            continue;
+        }
+
+        if (c == '[') {
+            if (current.length() > best.length()) {
+                best = current;
+            }
+            current.clear();
+            while (i < regexPattern.length() && regexPattern[i] != ']') {
+                i++;
+            }
+            i++;
+            continue;
+        }
+
+        if (c == '.' || c == '^' || c == '$') {
+            if (current.length() > best.length()) {
+                best = current;
+            }
+            current.clear();
+            i++;
+            continue;
+        }
+
+        current.push_back(c);
+        i++;
+    }
+
+    if (current.length() > best.length()) {
+        best = current;
+    }
+    return best;
+}
+
+void LogSearchService::RunSearch(std::shared_ptr<SearchJob> job) {
+    std::vector<CandidateFile> candidates;
+    bool globHasPath = job->fileGlob.find_first_of("\\/") != std::string::npos;
+
+    try {
+        std::error_code ec;
+        fs::path root(settings_->logFolderPath);
+        for (fs::recursive_directory_iterator it(root, ec), end; it != end; it.increment(ec)) {
+            if (ec) {
+                break;
+            }
+            if (!it->is_regular_file(ec) || !LogIndex::IsLogFile(it->path().string())) {
+                continue;
+            }
+
+            CandidateFile candidate;
+            candidate.path = it->path().string();
+            candidate.relativePath = fs::relative(it->path(), root, ec).string();
+            candidate.modified = it->last_write_time(ec);
+
+            std::string matchTarget = globHasPath ? candidate.relativePath : it->path().filename().string();
+            if (!StringUtils::WildcardMatch(matchTarget, job->fileGlob)) {
+                continue;
+            }
+
+            // A log last written before the window starts cannot contain it
+            if (job->hasWindow) {
+                long long modifiedMs = 0;
+                if (LogRecordScanner::ParseDateTime(LogService::FormatTime(candidate.modified), modifiedMs) &&
+                    modifiedMs + 1000 < job->fromMs) {
+                    continue;
+                }
+            }
+
+            candidates.push_back(candidate);
+        }
+    }
+    catch (const std::exception&) {
+        // Search whatever was enumerated before the failure
+    }
+
+    // Newest logs first so early hits are the most relevant ones
+    std::sort(candidates.begin(), candidates.end(),
+        [](const CandidateFile& a, const CandidateFile& b) { return a.modified > b.modified; });
+
+    if (!candidates.empty()) {
+        std::atomic<size_t> remaining(candidates.size());
+        size_t threadCount = (std::min)(ThreadPool::GetBackgroundThreadCount(job->maxThreads), candidates.size());
+        ThreadPool pool(threadCount, true);
+
+        for (size_t i = 0; i < candidates.size(); i++) {
+            const CandidateFile& candidate = candidates[i];
+            pool.Submit([this, job, &candidate, &remaining]() {
+                if (!job->ShouldStop()) {
+                    SearchFile(*job, candidate.path, candidate.relativePath);
+                }
+                remaining--;
+            });
+        }
+
+        // Stream hits while the workers run
+        while (remaining > 0) {
+            for (int waited = 0; waited < AgentConstants::LOG_SEARCH_FLUSH_INTERVAL_MS && remaining > 0; waited += 50) {
+                Sleep(50);
+            }
+            FlushHits(*job, false);
+        }
+        pool.Wait();
+    }
+
+    FlushHits(*job, true);
+    job->finished = true;
+}
+
+void LogSearchService::SearchFile(SearchJob& job, const std::string& filePath, const std::string& relativePath) {
+    MappedFile log;
+    if (!log.Open(filePath) || log.GetSize() == 0) {
+        return;
+    }
+
+    const char* data = log.GetData();
+    size_t begin = 0;
+    size_t end = log.GetSize();
+
+    // Narrow a time-window search to the byte range the sidecar index
+    // gives; the unindexed tail is always scanned
+    if (job.hasWindow) {
+        LogIndex index;
+        if (index.Open(filePath) && index.GetIndexedSize() <= end) {
+            uint64_t rangeBegin = 0;
+            uint64_t rangeEnd = 0;
+            if (!index.FindTimeRange(job.fromMs, job.toMs, rangeBegin, rangeEnd)) {
+                rangeBegin = index.GetIndexedSize();
+                rangeEnd = rangeBegin;
+            }
+            if (rangeEnd >= index.GetIndexedSize()) {
+                rangeEnd = end;
+            }
+            begin = (size_t)rangeBegin;
+            end = (size_t)rangeEnd;
+        }
+    }
+
+    job.filesScanned++;
+    unsigned long long lastCpuUs = GetThreadCpuMicroseconds();
+    const char* p = data + begin;
+    const char* stop = data + end;
+
+    while (p < stop) {
+        if (!ChargeCpu(job, lastCpuUs)) {
+            return;
+        }
+
+        // Segments end on a line boundary so no line is split between them
+        const char* segmentEnd = stop;
+        if ((size_t)(stop - p) > AgentConstants::LOG_SEARCH_SEGMENT_BYTES) {
+            segmentEnd = LogRecordScanner::FindByte(p + AgentConstants::LOG_SEARCH_SEGMENT_BYTES, stop, '\n');
+            if (segmentEnd < stop) {
+                segmentEnd++;
+            }
+        }
+
+        const char* cursor = p;
+        while (cursor < segmentEnd) {
+            const char* lineStart = cursor;
+            const char* lineEnd = NULL;
+
+            if (!job.literal.empty()) {
+                const char* hit = LogRecordScanner::FindSubstring(cursor, segmentEnd, job.literal);
+                if (hit == segmentEnd) {
+                    break;
+                }
+                lineStart = hit;
+                while (lineStart > cursor && *(lineStart - 1) != '\n') {
+                    lineStart--;
+                }
+                lineEnd = LogRecordScanner::FindByte(hit, segmentEnd, '\n');
+            }
+            else {
+                lineEnd = LogRecordScanner::FindByte(cursor, segmentEnd, '\n');
+            }
+
+            cursor = (lineEnd < segmentEnd) ? lineEnd + 1 : segmentEnd;
+
+            std::string_view line(lineStart, lineEnd - lineStart);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+
+            if (job.hasWindow) {
+                const char* tab = LogRecordScanner::FindByte(line.data(), line.data() + line.size(), '\t');
+                long long timeMs = 0;
+                if (!LogRecordScanner::ParseDateTime(std::string_view(line.data(), tab - line.data()), timeMs) ||
+                    timeMs < job.fromMs || timeMs > job.toMs) {
+                    continue;
+                }
+            }
+
+            if (job.useRegex && !std::regex_search(line.begin(), line.end(), job.regex)) {
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(job.hitsMutex);
+            if (job.totalHits >= job.maxHits) {
+                break;
+            }
+
+            SearchHit hit;
+            hit.file = relativePath;
+            hit.offset = (unsigned long long)(lineStart - data);
+            hit.line.assign(line.data(), (std::min)(line.size(), (size_t)AgentConstants::LOG_SEARCH_MAX_LINE_BYTES));
+            job.hits.push_back(hit);
+            job.totalHits++;
+        }
+
+        job.bytesScanned += segmentEnd - p;
+        p = segmentEnd;
+    }
+
+    ChargeCpu(job, lastCpuUs);
+}
+
+bool LogSearchService::ChargeCpu(SearchJob& job, unsigned long long& lastCpuUs) {
+    unsigned long long nowUs = GetThreadCpuMicroseconds();
+    if (nowUs > lastCpuUs) {
+        job.cpuUsedUs += nowUs - lastCpuUs;
+    }
+    lastCpuUs = nowUs;
+
+    if (job.cpuUsedUs > job.cpuBudgetUs) {
+        job.budgetExhausted = true;
+    }
+    return !job.ShouldStop();
+}
+
+void LogSearchService::FlushHits(SearchJob& job, bool done) {
+    // Each post replaces the stored result, so every one carries all hits so far
+    std::vector<SearchHit> hits;
+    {
+        std::lock_guard<std::mutex> lock(job.hitsMutex);
+        if (!done && job.hits.size() == job.flushedHits) {
+            return;
+        }
+        hits = job.hits;
+        job.flushedHits = hits.size();
+    }
+
+    json hitArray = json::array();
+    for (size_t i = 0; i < hits.size(); i++) {
+        json hit;
+        hit["file"] = hits[i].file;
+        hit["offset"] = hits[i].offset;
+        hit["line"] = hits[i].line;
+        hitArray.push_back(hit);
+    }
+
+    json resultData;
+    resultData["searchId"] = job.commandId;
+    resultData["hits"] = hitArray;
+    resultData["done"] = done;
+
+    if (done) {
+        resultData["totalHits"] = (size_t)job.totalHits;
+        resultData["filesScanned"] = (size_t)job.filesScanned;
+        resultData["bytesScanned"] = (unsigned long long)job.bytesScanned;
+        resultData["cpuMs"] = (unsigned long long)job.cpuUsedUs / 1000;
+        resultData["cancelled"] = (bool)job.cancelled;
+        resultData["budgetExhausted"] = (bool)job.budgetExhausted;
+        resultData["maxHitsReached"] = job.totalHits >= job.maxHits;
+        resultData["simd"] = LogRecordScanner::GetSimdLevel();
+    }
+
+    json request;
+    request["commandId"] = job.commandId;
+    request["status"] = done ? AgentConstants::STATUS_COMPLETED : AgentConstants::STATUS_IN_PROGRESS;
+    request["resultData"] = resultData.dump();
+    request["errorMessage"] = "";
+
+    json response;
+    httpClient_->Post(AgentConstants::ENDPOINT_COMMAND_RESULT, request, response);
+}
+
+void LogSearchService::ReapFinishedJobs() {
+    std::map<int, std::shared_ptr<SearchJob> >::iterator it = jobs_.begin();
+    while (it != jobs_.end()) {
+        if (it->second->finished) {
+            if (it->second->thread.joinable()) {
+                it->second->thread.join();
+            }
+            it = jobs_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "../include/services/LogService.h"
 #include "../include/network/HttpClient.h"
+#include "../include/monitoring/LogIndex.h"
+#include "../include/monitoring/LogArchive.h"
 #include "../include/utilities/FileUtils.h"
 #include "../include/common/Constants.h"
 #include <windows.h>
@@ -14,9 +16,64 @@ LogService::LogService(AgentSettings* settings, HttpClient* client) {
     settings_ = settings;
     httpClient_ = client;
     lastSyncedStructure_ = "";
+    indexThread_ = NULL;
+    isIndexing_ = false;
 }
 
 LogService::~LogService() {
+    StopIndexing();
+}
+
+bool LogService::StartIndexing() {
+    if (isIndexing_) {
+        return false;
+    }
+
+    isIndexing_ = true;
+    indexThread_ = CreateThread(NULL, 0, IndexThreadFunc, this, 0, NULL);
+    if (indexThread_ == NULL) {
+        isIndexing_ = false;
+        return false;
+    }
+    return true;
+}
+
+void LogService::StopIndexing() {
+    if (isIndexing_) {
+        isIndexing_ = false;
+        if (indexThread_) {
+            WaitForSingleObject(indexThread_, 5000);
+            CloseHandle(indexThread_);
+            indexThread_ = NULL;
+        }
+    }
+}
+
+DWORD WINAPI LogService::IndexThreadFunc(LPVOID param) {
+    LogService* service = (LogService*)param;
+    service->IndexLoop();
+    return 0;
+}
+
+void LogService::IndexLoop() {
+    // The first pass over a large log folder reads every log once
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+    ULONGLONG lastPass = 0;
+    bool firstPass = true;
+
+    while (isIndexing_) {
+        ULONGLONG now = GetTickCount64();
+        if (firstPass || now - lastPass >= (ULONGLONG)AgentConstants::LOG_INDEX_SCAN_INTERVAL_MS) {
+            UpdateLogIndexes();
+            lastPass = GetTickCount64();
+            firstPass = false;
+        }
+        Sleep(1000);
+    }
+
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
 }
 
 std::string LogService::FormatTime(fs::file_time_type ftime) {
@@ -47,6 +104,12 @@ json LogService::BuildDirectoryTree(const fs::path& currentPath, const fs::path&
 
     for (const auto& entry : fs::directory_iterator(currentPath)) {
         try {
+            // Sidecar indexes and archives are agent-private and not part of the log tree
+            if (entry.is_regular_file() &&
+                (LogIndex::IsIndexFile(entry.path().string()) || LogArchive::IsArchiveFile(entry.path().string()))) {
+                continue;
+            }
+
             json node;
 
             node["name"] = entry.path().filename().string();
@@ -98,4 +161,41 @@ void LogService::SyncLogsToServer() {
         // Silently fail or log to local debug console if needed
         // std::cerr << "Log Sync Error: " << ex.what() << std::endl;
     }
+}
+
+void LogService::UpdateLogIndexes() {
+    if (!FileUtils::FolderExists(settings_->logFolderPath)) {
+        return;
+    }
+
+    try {
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(settings_->logFolderPath, ec), end; it != end; it.increment(ec)) {
+            if (ec || !isIndexing_) {
+                break;
+            }
+            if (!it->is_regular_file(ec)) {
+                continue;
+            }
+
+            std::string path = it->path().string();
+            if (!LogIndex::IsLogFile(path)) {
+                continue;
+            }
+
+            // Only logs that grew (or are new) since the last pass are touched
+            uintmax_t size = it->file_size(ec);
+            std::map<std::string, uintmax_t>::iterator known = indexedSizes_.find(path);
+            if (ec || (known != indexedSizes_.end() && known->second == size)) {
+                continue;
+            }
+
+            if (LogIndex::Update(path)) {
+                indexedSizes_[path] = size;
+            }
+        }
+    }
+    catch (const std::exception& ex) {
+        // Indexing is best effort; queries fall back to rebuilding
+    }
 }
\ No newline at end of file
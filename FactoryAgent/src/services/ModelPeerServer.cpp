@@ -0,0 +1,208 @@
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include "../include/services/ModelPeerServer.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#pragma comment(lib, "ws2_32.lib")
+
+static bool SendAll(SOCKET socket, const char* data, size_t size) {
+    while (size > 0) {
+        int sent = send(socket, data, (int)(std::min)(size, (size_t)AgentConstants::MODEL_PEER_SEND_BUFFER), 0);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+static void SendStatus(SOCKET socket, const std::string& status) {
+    std::string response = "HTTP/1.1 " + status + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    SendAll(socket, response.data(), response.size());
+}
+
+// Shut down for sending first, so the receiver gets the whole body rather than a reset
+static void CloseConnection(SOCKET socket) {
+    shutdown(socket, SD_SEND);
+    closesocket(socket);
+}
+
+ModelPeerServer::ModelPeerServer() : stopping_(false), active_(0), servedBlobs_(0), servedBytes_(0) {
+    store_ = NULL;
+    listenSocket_ = (uintptr_t)INVALID_SOCKET;
+    port_ = 0;
+}
+
+ModelPeerServer::~ModelPeerServer() {
+    Stop();
+}
+
+bool ModelPeerServer::Start(ModelStore* store, int port) {
+    if (acceptThread_.joinable()) {
+        return port == port_;
+    }
+
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        return false;
+    }
+
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == INVALID_SOCKET) {
+        WSACleanup();
+        return false;
+    }
+
+    // A second agent on the same PC must fail here rather than share the port
+    BOOL exclusive = TRUE;
+    setsockopt(listener, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (const char*)&exclusive, sizeof(exclusive));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((u_short)port);
+    if (bind(listener, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+        listen(listener, SOMAXCONN) == SOCKET_ERROR) {
+        closesocket(listener);
+        WSACleanup();
+        return false;
+    }
+
+    store_ = store;
+    listenSocket_ = (uintptr_t)listener;
+    port_ = port;
+    stopping_ = false;
+    workers_.reset(new ThreadPool(AgentConstants::MODEL_PEER_MAX_CONNECTIONS, true));
+    acceptThread_ = std::thread(&ModelPeerServer::AcceptLoop, this);
+    return true;
+}
+
+void ModelPeerServer::Stop() {
+    if (!acceptThread_.joinable()) {
+        return;
+    }
+
+    // Closing the listener ends the blocked accept; transfers in flight see stopping_
+    stopping_ = true;
+    closesocket((SOCKET)listenSocket_);
+    acceptThread_.join();
+    workers_.reset();
+
+    listenSocket_ = (uintptr_t)INVALID_SOCKET;
+    port_ = 0;
+    WSACleanup();
+}
+
+int ModelPeerServer::GetPort() {
+    return port_;
+}
+
+unsigned long long ModelPeerServer::GetServedBlobs() {
+    return servedBlobs_;
+}
+
+unsigned long long ModelPeerServer::GetServedBytes() {
+    return servedBytes_;
+}
+
+void ModelPeerServer::AcceptLoop() {
+    while (!stopping_) {
+        SOCKET client = accept((SOCKET)listenSocket_, NULL, NULL);
+        if (client == INVALID_SOCKET) {
+            if (!stopping_) {
+                Sleep(AgentConstants::MODEL_PEER_ACCEPT_RETRY_MS);
+            }
+            continue;
+        }
+
+        // A stalled receiver must not hold a worker for good
+        DWORD timeout = AgentConstants::MODEL_PEER_TIMEOUT_MS;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+
+        // The line's own work comes first: a busy PC sends its peers elsewhere
+        if (active_ >= AgentConstants::MODEL_PEER_MAX_CONNECTIONS) {
+            SendStatus(client, "503 Service Unavailable");
+            CloseConnection(client);
+            continue;
+        }
+
+        active_++;
+        uintptr_t connection = (uintptr_t)client;
+        workers_->Submit([this, connection]() {
+            Serve(connection);
+            CloseConnection((SOCKET)connection);
+            active_--;
+        });
+    }
+}
+
+void ModelPeerServer::Serve(uintptr_t connection) {
+    SOCKET client = (SOCKET)connection;
+
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos) {
+        if (request.size() >= AgentConstants::MODEL_PEER_REQUEST_MAX) {
+            return;
+        }
+        int received = recv(client, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            return;
+        }
+        request.append(buffer, (size_t)received);
+    }
+
+    // Only names the store holds are served, so the path cannot leave the store
+    std::string prefix = std::string("GET ") + AgentConstants::MODEL_PEER_BLOB_PATH;
+    size_t nameEnd = request.find(' ', prefix.size());
+    std::string blobPath;
+    uint64_t size = 0;
+    if (request.compare(0, prefix.size(), prefix) != 0 || nameEnd == std::string::npos ||
+        !store_->FindBlob(request.substr(prefix.size(), nameEnd - prefix.size()), blobPath, size)) {
+        SendStatus(client, "404 Not Found");
+        return;
+    }
+
+    // Shared for delete, so collecting the blob meanwhile is not blocked
+    HANDLE file = CreateFileA(blobPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    LARGE_INTEGER fileSize;
+    if (file == INVALID_HANDLE_VALUE) {
+        SendStatus(client, "404 Not Found");
+        return;
+    }
+    if (!GetFileSizeEx(file, &fileSize) || (uint64_t)fileSize.QuadPart != size) {
+        CloseHandle(file);
+        SendStatus(client, "404 Not Found");
+        return;
+    }
+
+    std::string header = "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: " +
+        std::to_string(size) + "\r\nConnection: close\r\n\r\n";
+    bool sent = SendAll(client, header.data(), header.size());
+
+    std::vector<char> data(AgentConstants::MODEL_PEER_SEND_BUFFER);
+    uint64_t remaining = size;
+    while (sent && remaining > 0 && !stopping_) {
+        DWORD read = 0;
+        if (!ReadFile(file, data.data(), (DWORD)data.size(), &read, NULL) || read == 0) {
+            sent = false;
+            break;
+        }
+        sent = SendAll(client, data.data(), read);
+        remaining -= (std::min)((uint64_t)read, remaining);
+    }
+    CloseHandle(file);
+
+    if (sent && remaining == 0) {
+        servedBlobs_++;
+        servedBytes_ += size;
+    }
+}
\ No newline at end of file
@@ -1,17 +1,99 @@
 #include "../include/services/ModelService.h"
 #include "../include/network/HttpClient.h"
 #include "../include/utilities/FileUtils.h"
+#include "../include/utilities/HashUtils.h"
+#include "../include/utilities/MappedFile.h"
+#include "../include/utilities/PipeBuffer.h"
 #include "../include/utilities/ZipUtils.h"
 #include "../include/common/Constants.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <thread>
 #include <windows.h>
 
-ModelService::ModelService(AgentSettings* settings, HttpClient* client, ConfigManager* configMgr) {
+struct ModelService::UploadJob {
+    int commandId;
+    std::string modelName;
+    json data;
+    std::thread thread;
+    std::atomic<bool> finished;
+
+    UploadJob() : finished(false) {
+        commandId = 0;
+    }
+};
+
+static std::vector<std::string> FindTrashedFolders(const std::string& stagingFolder) {
+    std::vector<std::string> folders;
+    WIN32_FIND_DATAA findData;
+    HANDLE hFind = FindFirstFileA((stagingFolder + "\\*" + AgentConstants::DELETE_TRASH_SUFFIX + "*").c_str(), &findData);
+    if (hFind == INVALID_HANDLE_VALUE) {
+        return folders;
+    }
+    do {
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            folders.push_back(stagingFolder + "\\" + findData.cFileName);
+        }
+    } while (FindNextFileA(hFind, &findData));
+    FindClose(hFind);
+    return folders;
+}
+
+// A folder is renamed into the trash, which returns at once, and deleted
+// behind it; a synchronous delete is the fallback when it cannot be renamed
+static bool DeleteFolderQuickly(const std::string& folderPath, const std::string& trashFolder) {
+    if (!FileUtils::FolderExists(folderPath)) {
+        return false;
+    }
+    return FileUtils::DeleteFolderInBackground(folderPath, trashFolder) || FileUtils::DeleteFolder(folderPath);
+}
+
+ModelService::ModelService(AgentSettings* settings, HttpClient* client, ConfigManager* configMgr)
+    : stopping_(false), collectPending_(true), inventoryDirty_(true), inventoryBuilding_(false), inventoryFresh_(false) {
     settings_ = settings;
     httpClient_ = client;
     configManager_ = configMgr;
+    manifestCache_.Load(AgentConstants::MODEL_MANIFEST_CACHE_FILE);
+    usage_.Load(AgentConstants::MODEL_USAGE_FILE);
+    modelStore_.Open(settings_->modelFolderPath + "\\" + AgentConstants::MODEL_STORE_FOLDER_NAME);
+    folderWatch_.Open(settings_->modelFolderPath);
+    if (settings_->modelPeerPort > 0 && modelStore_.IsOpen()) {
+        peerServer_.Start(&modelStore_, settings_->modelPeerPort);
+    }
+    inventoryReady_ = false;
+    sentDigest_ = 0;
+    inventorySent_ = false;
+    syncsSinceSent_ = 0;
+
+    // Deletes the last run did not finish before it exited
+    std::string stagingFolder = settings_->modelFolderPath + "\\" + AgentConstants::TEMP_FOLDER_NAME;
+    std::vector<std::string> trashed = FindTrashedFolders(stagingFolder);
+    for (size_t i = 0; i < trashed.size(); i++) {
+        FileUtils::DeleteFolderInBackground(trashed[i], stagingFolder);
+    }
 }
 
 ModelService::~ModelService() {
+    peerServer_.Stop();
+
+    // Streamed downloads see stopping_ and abort; the rest run to completion
+    stopping_ = true;
+
+    // Joined outside the lock: a finishing job takes it to record its previous version
+    std::map<int, std::shared_ptr<UploadJob> > uploads;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex_);
+        uploads.swap(uploads_);
+    }
+    for (std::map<int, std::shared_ptr<UploadJob> >::iterator it = uploads.begin(); it != uploads.end(); ++it) {
+        if (it->second->thread.joinable()) {
+            it->second->thread.join();
+        }
+    }
+    if (inventoryThread_.joinable()) {
+        inventoryThread_.join();
+    }
 }
 
 std::vector<ModelInfo> ModelService::GetModelFolders() {
@@ -33,7 +115,8 @@ std::vector<ModelInfo> ModelService::GetModelFolders() {
         if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
             strcmp(findData.cFileName, ".") != 0 &&
             strcmp(findData.cFileName, "..") != 0 &&
-            strcmp(findData.cFileName, AgentConstants::TEMP_FOLDER_NAME) != 0) {
+            strcmp(findData.cFileName, AgentConstants::TEMP_FOLDER_NAME) != 0 &&
+            strcmp(findData.cFileName, AgentConstants::MODEL_STORE_FOLDER_NAME) != 0) {
 
             ModelInfo info;
             info.modelName = findData.cFileName;
@@ -48,30 +131,268 @@ std::vector<ModelInfo> ModelService::GetModelFolders() {
     return models;
 }
 
-void ModelService::SyncModelsToServer() {
-    std::vector<ModelInfo> models = GetModelFolders();
+static bool SameModelName(const std::string& a, const std::string& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    std::string configContent;
+void ModelService::SyncModelsToServer() {
     std::string currentModel;
-    if (configManager_->ParseConfigFile(settings_->configFilePath, configContent)) {
-        currentModel = configManager_->GetCurrentModel(configContent);
+    std::shared_ptr<const ConfigSnapshot> snapshot;
+    if (configManager_->GetConfigSnapshot(settings_->configFilePath, snapshot)) {
+        currentModel = snapshot->currentModel;
+
+        // The running model is in use until the line switches away from it,
+        // so both ends of a switch count as activations
+        if (!SameModelName(currentModel, inventoryCurrent_)) {
+            if (!inventoryCurrent_.empty()) {
+                usage_.Touch(inventoryCurrent_);
+            }
+            if (!currentModel.empty()) {
+                usage_.Touch(currentModel);
+            }
+            inventoryCurrent_ = currentModel;
+            inventoryDirty_ = true;
+        }
+    }
+
+    // An idle tick is one wait on the change notification and a config stat
+    bool changed = folderWatch_.HasChanged();
+    bool dirty = inventoryDirty_.exchange(false);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (changed || dirty ||
+        now - inventoryBuilt_ >= std::chrono::milliseconds(AgentConstants::MODEL_INVENTORY_RESCAN_MS)) {
+        if (!inventoryBuilding_) {
+            if (inventoryThread_.joinable()) {
+                inventoryThread_.join();
+            }
+            inventoryBuilding_ = true;
+            inventoryBuilt_ = now;
+            inventoryThread_ = std::thread(&ModelService::RebuildInventory, this, inventoryCurrent_);
+        }
+        else {
+            // The running rebuild may have listed the folder before this change
+            inventoryDirty_ = true;
+        }
+    }
+    bool rebuilt = inventoryFresh_.exchange(false);
+
+    bool previousKept;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex_);
+        previousKept = !previousSince_.empty();
+    }
+    if (rebuilt || previousKept) {
+        PurgePreviousVersions();
+    }
+
+    // Nothing is reported until the first rebuild finished
+    std::vector<ModelInfo> models;
+    std::vector<json> entries;
+    std::vector<unsigned long long> privateBytes;
+    {
+        std::lock_guard<std::mutex> lock(inventoryMutex_);
+        if (!inventoryReady_) {
+            usage_.Save();
+            return;
+        }
+        models = inventory_;
+        entries = inventoryEntries_;
+        privateBytes = inventoryBytes_;
+    }
+
+    // Works from the inventory in memory; the config is only re-read when there is a candidate
+    json evicted = json::array();
+    std::vector<bool> removed(models.size(), false);
+    EvictForQuota(models, privateBytes, currentModel, removed, evicted);
+    usage_.Save();
+
+    // Evicted models leave the inventory now rather than when the next rebuild finishes
+    if (!evicted.empty()) {
+        std::lock_guard<std::mutex> lock(inventoryMutex_);
+        for (size_t i = inventory_.size(); i-- > 0; ) {
+            for (size_t j = 0; j < models.size(); j++) {
+                if (removed[j] && SameModelName(inventory_[i].modelName, models[j].modelName)) {
+                    inventory_.erase(inventory_.begin() + i);
+                    inventoryEntries_.erase(inventoryEntries_.begin() + i);
+                    inventoryBytes_.erase(inventoryBytes_.begin() + i);
+                    break;
+                }
+            }
+        }
     }
 
     json modelArray = json::array();
-    for (size_t i = 0; i < models.size(); i++) {
-        json modelInfo;
-        modelInfo["ModelName"] = models[i].modelName;
-        modelInfo["ModelPath"] = models[i].modelPath;
-        modelInfo["IsCurrent"] = (models[i].modelName == currentModel);
-        modelArray.push_back(modelInfo);
+    unsigned long long usedBytes = modelStore_.GetStoredBytes();
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!removed[i]) {
+            modelArray.push_back(entries[i]);
+            usedBytes += privateBytes[i];
+        }
     }
 
+    json cache;
+    unsigned long long quotaBytes = settings_->modelQuotaMB * 1024ULL * 1024ULL;
+    cache["quotaBytes"] = quotaBytes;
+    cache["usedBytes"] = usedBytes;
+    cache["headroomBytes"] = quotaBytes > 0 ? (long long)quotaBytes - (long long)usedBytes : 0LL;
+    cache["evicted"] = evicted;
+
     json request;
     request["pcId"] = settings_->pcId;
     request["models"] = modelArray;
+    request["storeBlobs"] = modelStore_.GetBlobCount();
+    request["storeBytes"] = modelStore_.GetStoredBytes();
+    request["modelCache"] = cache;
+    request["peerPort"] = peerServer_.GetPort();
+
+    // Sent only when it differs from what the server last accepted, or every
+    // MODEL_SYNC_FORCE_PERIODS syncs in case the server lost it; the peer
+    // counters move with every transfer, so they ride along undigested
+    std::string body = request.dump();
+    uint64_t digest = HashUtils::Xxh64(body.data(), body.size());
+    syncsSinceSent_++;
+    if (inventorySent_ && digest == sentDigest_ && syncsSinceSent_ < AgentConstants::MODEL_SYNC_FORCE_PERIODS) {
+        return;
+    }
+    request["peerServedBlobs"] = peerServer_.GetServedBlobs();
+    request["peerServedBytes"] = peerServer_.GetServedBytes();
 
     json response;
-    httpClient_->Post(AgentConstants::ENDPOINT_SYNC_MODELS, request, response);
+    if (httpClient_->Post(AgentConstants::ENDPOINT_SYNC_MODELS, request, response)) {
+        sentDigest_ = digest;
+        inventorySent_ = true;
+        syncsSinceSent_ = 0;
+    }
+}
+
+void ModelService::ResendInventory() {
+    inventorySent_ = false;
+}
+
+void ModelService::RebuildInventory(std::string currentModel) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+    std::vector<ModelInfo> models = GetModelFolders();
+    std::vector<json> entries;
+    std::vector<unsigned long long> privateBytes;
+
+    for (size_t i = 0; i < models.size(); i++) {
+        if (stopping_) {
+            inventoryBuilding_ = false;
+            return;
+        }
+        models[i].isCurrent = !currentModel.empty() && SameModelName(models[i].modelName, currentModel);
+
+        json modelInfo;
+        modelInfo["ModelName"] = models[i].modelName;
+        modelInfo["ModelPath"] = models[i].modelPath;
+        modelInfo["IsCurrent"] = models[i].isCurrent;
+        modelInfo["LastActivated"] = usage_.GetLastActivated(models[i].modelName);
+
+        // Unchanged files come from the cache, so this is a directory walk per
+        // model; only a new or edited model is read in full
+        ModelManifest manifest;
+        std::string error;
+        unsigned long long diskBytes = 0;
+        if (manifestCache_.Build(models[i].modelPath, manifest, error)) {
+            diskBytes = modelStore_.GetPrivateBytes(manifest);
+            modelInfo["ManifestHash"] = HashUtils::ToHex(manifest.rootHash);
+            modelInfo["FileCount"] = manifest.files.size();
+            modelInfo["TotalSize"] = manifest.totalSize;
+            modelInfo["DiskBytes"] = diskBytes;
+        }
+        entries.push_back(modelInfo);
+        privateBytes.push_back(diskBytes);
+    }
+    manifestCache_.Save();
+
+    {
+        std::lock_guard<std::mutex> lock(inventoryMutex_);
+        inventory_.swap(models);
+        inventoryEntries_.swap(entries);
+        inventoryBytes_.swap(privateBytes);
+        inventoryReady_ = true;
+    }
+    inventoryFresh_ = true;
+
+    // Blobs only become garbage after a model folder was deleted, which for
+    // a background delete may be a few syncs later; the delete finishing
+    // shows up as a change
+    if (collectPending_.exchange(false)) {
+        ModelStoreStats storeStats;
+        modelStore_.Collect(storeStats);
+    }
+    if (!FindTrashedFolders(settings_->modelFolderPath + "\\" + AgentConstants::TEMP_FOLDER_NAME).empty()) {
+        collectPending_ = true;
+    }
+    inventoryBuilding_ = false;
+}
+
+void ModelService::EvictForQuota(const std::vector<ModelInfo>& models, const std::vector<unsigned long long>& privateBytes,
+    const std::string& currentModel, std::vector<bool>& removed, json& evicted) {
+    // Without a readable config the current model is unknown, so nothing is safe to evict
+    unsigned long long quotaBytes = settings_->modelQuotaMB * 1024ULL * 1024ULL;
+    if (quotaBytes == 0 || currentModel.empty()) {
+        return;
+    }
+
+    unsigned long long usedBytes = modelStore_.GetStoredBytes();
+    for (size_t i = 0; i < privateBytes.size(); i++) {
+        usedBytes += privateBytes[i];
+    }
+
+    // One model per sync keeps each cycle short; blobs it shared are freed by the collection after it
+    long long now = ModelUsageLog::CurrentTimeMs();
+    for (unsigned int round = 0; round < AgentConstants::MODEL_CACHE_EVICTIONS_PER_SYNC && usedBytes > quotaBytes; round++) {
+        size_t victim = models.size();
+        long long oldest = 0;
+        for (size_t i = 0; i < models.size(); i++) {
+            long long lastActivated = usage_.GetLastActivated(models[i].modelName);
+            if (removed[i] || SameModelName(models[i].modelName, currentModel) || IsStaging(models[i].modelName) ||
+                now - lastActivated < AgentConstants::MODEL_CACHE_MIN_IDLE_MS) {
+                continue;
+            }
+            if (victim == models.size() || lastActivated < oldest) {
+                victim = i;
+                oldest = lastActivated;
+            }
+        }
+        if (victim == models.size()) {
+            return;
+        }
+
+        // The config may have moved to this model since the sync started
+        std::lock_guard<std::mutex> lock(switchMutex_);
+        if (!CanDelete(models[victim].modelName) || !DeleteModelLocked(models[victim].modelName)) {
+            return;
+        }
+        removed[victim] = true;
+        usedBytes -= (std::min)(usedBytes, privateBytes[victim]);
+
+        json entry;
+        entry["ModelName"] = models[victim].modelName;
+        entry["DiskBytes"] = privateBytes[victim];
+        entry["LastActivated"] = oldest;
+        evicted.push_back(entry);
+    }
+}
+
+bool ModelService::IsStaging(const std::string& modelName) {
+    std::lock_guard<std::mutex> lock(jobsMutex_);
+    for (std::map<int, std::shared_ptr<UploadJob> >::iterator it = uploads_.begin(); it != uploads_.end(); ++it) {
+        if (!it->second->finished && SameModelName(it->second->modelName, modelName)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool ModelService::ChangeModel(const std::string& modelName) {
@@ -81,104 +402,770 @@ bool ModelService::ChangeModel(const std::string& modelName) {
         return false;
     }
 
-    std::string configContent;
-    if (!configManager_->ParseConfigFile(settings_->configFilePath, configContent)) {
+    if (!configManager_->SetCurrentModel(settings_->configFilePath, modelName, modelPath, "model")) {
         return false;
     }
 
-    if (configManager_->UpdateCurrentModel(configContent, modelName, modelPath)) {
-        if (configManager_->WriteConfigFile(settings_->configFilePath, configContent)) {
-            return true;
+    usage_.Touch(modelName);
+    inventoryDirty_ = true;
+    return true;
+}
+
+static bool WriteToPipe(const unsigned char* data, size_t size, void* userData) {
+    return ((PipeBuffer*)userData)->Write(data, size);
+}
+
+static bool ReadFromPipe(char* buffer, size_t capacity, size_t& size, void* userData) {
+    PipeBuffer* pipe = (PipeBuffer*)userData;
+    size = pipe->Read(buffer, capacity);
+    return !pipe->IsAborted();
+}
+
+struct DownloadPipe {
+    PipeBuffer* pipe;
+    const std::atomic<bool>* stopping;
+};
+
+static bool WriteDownloadToPipe(const char* data, size_t size, void* userData) {
+    DownloadPipe* target = (DownloadPipe*)userData;
+    return !*target->stopping && target->pipe->Write(data, size);
+}
+
+static size_t ReadArchiveFromPipe(unsigned char* buffer, size_t capacity, void* userData) {
+    return ((PipeBuffer*)userData)->Read(buffer, capacity);
+}
+
+static bool MatchesHash(const std::string& filePath, uint64_t hash, uint64_t size) {
+    MappedFile file;
+    return file.Open(filePath) && file.GetSize() == size &&
+        HashUtils::Xxh64(size > 0 ? file.GetData() : "", (size_t)size) == hash;
+}
+
+// One entry of an upload's Files list, with its path in the staging folder's form
+static bool ParseStoreFile(const json& file, std::string& relativePath, uint64_t& hash, uint64_t& size,
+    std::string& error) {
+    if (!ZipReader::GetSafeRelativePath(file.value("Path", ""), relativePath)) {
+        error = "Unsafe file path in Files: " + file.value("Path", "");
+        return false;
+    }
+
+    size = file.value("Size", 0ULL);
+    std::string hashHex = file.value("Hash", "");
+    std::transform(hashHex.begin(), hashHex.end(), hashHex.begin(), ::tolower);
+    if (hashHex.size() != 16 || hashHex.find_first_not_of("0123456789abcdef") != std::string::npos) {
+        error = "Invalid hash for " + relativePath;
+        return false;
+    }
+    hash = std::stoull(hashHex, NULL, 16);
+    return true;
+}
+
+// "host:port" of agents the server knows to hold this model
+static std::vector<std::string> GetPeers(const json& data) {
+    std::vector<std::string> peers;
+    if (data.contains("Peers") && data["Peers"].is_array()) {
+        for (size_t i = 0; i < data["Peers"].size(); i++) {
+            if (data["Peers"][i].is_string()) {
+                peers.push_back(data["Peers"][i].get<std::string>());
+            }
         }
     }
+    return peers;
+}
 
-    return false;
+static bool HasUploadSource(const json& data, std::string& error) {
+    if (!data.contains("ModelName") ||
+        (!data.contains("DownloadUrl") && !(data.contains("Files") && data.contains("BlobUrl")))) {
+        error = "UploadModel requires ModelName and either DownloadUrl or Files and BlobUrl";
+        return false;
+    }
+    return true;
+}
+
+static unsigned long long GetFreeSpace(const std::string& folderPath) {
+    ULARGE_INTEGER freeBytes;
+    if (!GetDiskFreeSpaceExA(folderPath.c_str(), &freeBytes, NULL, NULL)) {
+        return 0;
+    }
+    return freeBytes.QuadPart;
+}
+
+bool ModelService::StartUpload(int commandId, const json& data, std::string& error) {
+    if (!HasUploadSource(data, error)) {
+        return false;
+    }
+
+    std::shared_ptr<UploadJob> job(new UploadJob());
+    job->commandId = commandId;
+    job->modelName = data["ModelName"].get<std::string>();
+    job->data = data;
+
+    std::lock_guard<std::mutex> lock(jobsMutex_);
+    ReapFinishedUploads();
+
+    if (uploads_.size() >= (size_t)AgentConstants::MODEL_UPLOAD_MAX_CONCURRENT) {
+        error = "Too many model uploads running";
+        return false;
+    }
+    for (std::map<int, std::shared_ptr<UploadJob> >::iterator it = uploads_.begin(); it != uploads_.end(); ++it) {
+        if (it->second->modelName == job->modelName) {
+            error = "Model " + job->modelName + " is already being staged";
+            return false;
+        }
+    }
+
+    uploads_[commandId] = job;
+    job->thread = std::thread(&ModelService::RunUpload, this, job);
+    return true;
+}
+
+void ModelService::RunUpload(std::shared_ptr<UploadJob> job) {
+    std::string resultData;
+    std::string error;
+    bool uploaded = false;
+    try {
+        uploaded = UploadModelToServer(job->data, resultData, error);
+    }
+    catch (const std::exception& e) {
+        error = std::string("Upload failed: ") + e.what();
+    }
+
+    json request;
+    request["commandId"] = job->commandId;
+    request["status"] = uploaded ? AgentConstants::STATUS_COMPLETED : AgentConstants::STATUS_FAILED;
+    request["resultData"] = resultData;
+    request["errorMessage"] = error;
+
+    json response;
+    httpClient_->Post(AgentConstants::ENDPOINT_COMMAND_RESULT, request, response);
+    job->finished = true;
+}
+
+void ModelService::ReapFinishedUploads() {
+    std::map<int, std::shared_ptr<UploadJob> >::iterator it = uploads_.begin();
+    while (it != uploads_.end()) {
+        if (it->second->finished) {
+            if (it->second->thread.joinable()) {
+                it->second->thread.join();
+            }
+            it = uploads_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+std::string ModelService::GetStagingFolder() {
+    // Hidden so the line's model browser and operators do not pick up half-written models
+    std::string stagingFolder = settings_->modelFolderPath + "\\" + AgentConstants::TEMP_FOLDER_NAME;
+    if (!FileUtils::FolderExists(stagingFolder)) {
+        FileUtils::CreateFolder(stagingFolder);
+    }
+    DWORD attributes = GetFileAttributesA(stagingFolder.c_str());
+    if (attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_HIDDEN)) {
+        SetFileAttributesA(stagingFolder.c_str(), attributes | FILE_ATTRIBUTE_HIDDEN);
+    }
+    return stagingFolder;
 }
 
-bool ModelService::UploadModelToServer(const json& data) {
-    if (!data.contains("DownloadUrl") || !data.contains("ModelName")) {
+bool ModelService::UploadModelToServer(const json& data, std::string& resultData, std::string& error) {
+    if (!HasUploadSource(data, error)) {
         return false;
     }
 
-    std::string downloadUrl = data["DownloadUrl"].get<std::string>();
     std::string modelName = data["ModelName"].get<std::string>();
+    std::string extractPath = settings_->modelFolderPath + "\\" + modelName;
+
+    // The same content is already here: only the apply step is left
+    if (data.contains("ModelHash") && FileUtils::FolderExists(extractPath)) {
+        std::chrono::steady_clock::time_point checkStarted = std::chrono::steady_clock::now();
+        ModelManifest manifest;
+        std::string manifestError;
+        std::string expected = data["ModelHash"].get<std::string>();
+        std::transform(expected.begin(), expected.end(), expected.begin(), ::tolower);
+        if (manifestCache_.Build(extractPath, manifest, manifestError) &&
+            HashUtils::ToHex(manifest.rootHash) == expected) {
+            ApplyUploadedModel(data, modelName, extractPath);
+
+            json result;
+            result["skipped"] = true;
+            result["rootHash"] = expected;
+            result["files"] = manifest.files.size();
+            result["hashedBytes"] = manifest.hashedBytes;
+            result["readyMs"] = (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - checkStarted).count();
+            resultData = result.dump();
+            return true;
+        }
+    }
 
-    std::string tempDir = settings_->modelFolderPath + "\\" + AgentConstants::TEMP_FOLDER_NAME;
-    FileUtils::CreateFolder(tempDir);
+    std::string tempDir = GetStagingFolder();
 
-    std::string tempZipPath = tempDir + "\\" + modelName + AgentConstants::ZIP_EXTENSION;
+    // Everything is unpacked into a staging folder while the line keeps running
+    // the current version; the model folder is only replaced once the whole
+    // archive has been verified
+    std::string stagingPath = tempDir + "\\" + modelName;
+    if (DeleteFolderQuickly(stagingPath, tempDir)) {
+        collectPending_ = true;
+    }
+
+    ZipOptions options;
+    options.maxThreads = (std::min)(data.value("MaxThreads", (size_t)AgentConstants::ZIP_MAX_THREADS),
+        (size_t)AgentConstants::ZIP_MAX_THREADS);
+
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    unsigned long long freeBefore = GetFreeSpace(settings_->modelFolderPath);
 
-    if (httpClient_->DownloadFile(downloadUrl, tempZipPath)) {
-        std::string extractPath = settings_->modelFolderPath + "\\" + modelName;
+    // With a per-file list only the blobs missing from the store are fetched
+    bool fromStore = data.contains("Files") && data.contains("BlobUrl");
+    bool streamed = !fromStore && data.value("StreamExtract", true);
+    ZipStats stats;
+    ModelStoreStats storeStats;
+    ModelPeerStats peerStats;
+    bool extracted = false;
+    if (fromStore) {
+        extracted = StageFromStore(data, stagingPath, stats, storeStats, peerStats, error);
+    }
+    else if (streamed) {
+        extracted = DownloadAndExtract(data["DownloadUrl"].get<std::string>(), stagingPath, options, stats, error);
+    }
+    else {
+        extracted = DownloadThenExtract(data["DownloadUrl"].get<std::string>(),
+            tempDir + "\\" + modelName + AgentConstants::ZIP_EXTENSION, stagingPath, options, stats, error);
+    }
 
-        if (FileUtils::FolderExists(extractPath)) {
-            FileUtils::DeleteFolder(extractPath);
+    // The staged files are checked against Files and the folder against
+    // ModelHash before anything is ingested or activated
+    ModelManifest manifest;
+    extracted = extracted && manifestCache_.Build(stagingPath, manifest, error);
+    if (extracted && fromStore) {
+        extracted = VerifyStaged(data, stagingPath, manifest, stats, peerStats, error);
+    }
+    if (extracted && data.contains("ModelHash")) {
+        std::string expected = data["ModelHash"].get<std::string>();
+        std::transform(expected.begin(), expected.end(), expected.begin(), ::tolower);
+        if (HashUtils::ToHex(manifest.rootHash) != expected) {
+            error = "Staged model " + HashUtils::ToHex(manifest.rootHash) + " does not match ModelHash " + expected;
+            extracted = false;
         }
+    }
+
+    // Files the store already holds become links; new large files become blobs
+    if (extracted) {
+        extracted = modelStore_.Ingest(stagingPath, manifest, storeStats, error);
+    }
+    if (!extracted) {
+        FileUtils::DeleteFolder(stagingPath);
+        collectPending_ = true;
+        return false;
+    }
 
-        // Create the folder where we will extract the zip
-        FileUtils::CreateFolder(extractPath);
+    std::chrono::steady_clock::time_point staged = std::chrono::steady_clock::now();
 
-        if (ZipUtils::ExtractZip(tempZipPath, extractPath)) {
-            FileUtils::DeleteFile(tempZipPath);
+    double switchMs = 0.0;
+    if (!ActivateStaged(data, modelName, stagingPath, switchMs, error)) {
+        FileUtils::DeleteFolder(stagingPath);
+        collectPending_ = true;
+        return false;
+    }
 
-            // REMOVED FLATTENING LOGIC AS REQUESTED
-            // The zip content is extracted exactly as is.
+    json store;
+    store["linkedFiles"] = storeStats.linkedFiles;
+    store["linkedBytes"] = storeStats.linkedBytes;
+    store["storedFiles"] = storeStats.storedFiles;
+    store["storedBytes"] = storeStats.storedBytes;
+    store["copiedFiles"] = storeStats.copiedFiles;
+    store["blobs"] = modelStore_.GetBlobCount();
+    store["bytes"] = modelStore_.GetStoredBytes();
 
-            std::string configContent;
-            if (configManager_->ParseConfigFile(settings_->configFilePath, configContent)) {
+    // What the server would have sent without peers, against what it did send
+    json peers;
+    unsigned long long fetchedBytes = peerStats.peerBytes + peerStats.serverBytes;
+    peers["files"] = peerStats.peerFiles;
+    peers["bytes"] = peerStats.peerBytes;
+    peers["failures"] = peerStats.peerFailures;
+    peers["serverFiles"] = peerStats.serverFiles;
+    peers["serverBytes"] = peerStats.serverBytes;
+    peers["serverSavedPct"] = fetchedBytes > 0 ? (double)peerStats.peerBytes * 100.0 / (double)fetchedBytes : 0.0;
 
-                // Check if ApplyOnUpload is true
-                bool applyOnUpload = false;
-                if (data.contains("ApplyOnUpload")) {
-                    applyOnUpload = data["ApplyOnUpload"].get<bool>();
-                }
+    json result;
+    result["skipped"] = false;
+    result["fromStore"] = fromStore;
+    result["streamed"] = streamed;
+    result["files"] = stats.files;
+    result["bytesIn"] = stats.bytesIn;
+    result["bytesOut"] = stats.bytesOut;
+    result["threads"] = stats.threads;
+    result["unzipMs"] = stats.elapsedMs;
+    result["unzipMBps"] = stats.elapsedMs > 0 ? (double)stats.bytesOut / 1000.0 / (double)stats.elapsedMs : 0.0;
+    result["stageMs"] = (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        staged - started).count();
+    result["switchMs"] = switchMs;
+    result["readyMs"] = (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    result["rootHash"] = HashUtils::ToHex(manifest.rootHash);
+    result["store"] = store;
+    result["peers"] = peers;
+    result["diskFreeBefore"] = freeBefore;
+    result["diskFreeAfter"] = GetFreeSpace(settings_->modelFolderPath);
+    resultData = result.dump();
+    return true;
+}
+
+bool ModelService::StageFromStore(const json& data, const std::string& stagingPath, ZipStats& stats,
+    ModelStoreStats& storeStats, ModelPeerStats& peerStats, std::string& error) {
+    const json& files = data["Files"];
+    std::string blobUrl = data["BlobUrl"].get<std::string>();
+    if (!files.is_array()) {
+        error = "Files must be an array of Path, Size and Hash";
+        return false;
+    }
+
+    std::vector<std::string> peers = GetPeers(data);
+    std::vector<unsigned int> peerFailures(peers.size(), 0);
 
-                if (applyOnUpload) {
-                    if (configManager_->UpdateCurrentModel(configContent, modelName, extractPath)) {
-                        configManager_->WriteConfigFile(settings_->configFilePath, configContent);
-                    }
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    FileUtils::CreateFolder(stagingPath);
+    std::string lastFolder;
+    for (size_t i = 0; i < files.size(); i++) {
+        std::string relativePath;
+        uint64_t hash = 0;
+        uint64_t size = 0;
+        if (!ParseStoreFile(files[i], relativePath, hash, size, error)) {
+            return false;
+        }
+
+        std::replace(relativePath.begin(), relativePath.end(), '/', '\\');
+        std::string targetPath = stagingPath + "\\" + relativePath;
+        size_t folderEnd = relativePath.find_last_of('\\');
+        std::string folder = folderEnd == std::string::npos ? "" : relativePath.substr(0, folderEnd);
+        if (!folder.empty() && folder != lastFolder) {
+            for (size_t pos = folder.find('\\'); ; pos = folder.find('\\', pos + 1)) {
+                FileUtils::CreateFolder(stagingPath + "\\" + folder.substr(0, pos));
+                if (pos == std::string::npos) {
+                    break;
                 }
             }
+            lastFolder = folder;
+        }
 
-            return true;
+        stats.files++;
+        stats.bytesOut += size;
+        if (modelStore_.Materialize(hash, size, targetPath, storeStats)) {
+            continue;
+        }
+        if (!FetchFile(blobUrl, peers, peerFailures, relativePath, hash, size, targetPath, peerStats, error)) {
+            return false;
+        }
+        stats.bytesIn += size;
+    }
+
+    stats.elapsedMs = (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    return true;
+}
+
+bool ModelService::FetchFile(const std::string& blobUrl, const std::vector<std::string>& peers,
+    std::vector<unsigned int>& peerFailures, const std::string& relativePath, uint64_t hash, uint64_t size,
+    const std::string& targetPath, ModelPeerStats& peerStats, std::string& error) {
+    if (FetchFromPeers(peers, peerFailures, hash, size, targetPath, peerStats)) {
+        return true;
+    }
+
+    // Blobs are served by content hash and checked against it before use
+    if (stopping_ || !httpClient_->DownloadFile(blobUrl + "/" + HashUtils::ToHex(hash), targetPath)) {
+        error = "Download of " + relativePath + " failed";
+        return false;
+    }
+    if (!MatchesHash(targetPath, hash, size)) {
+        error = "Downloaded " + relativePath + " does not match its hash";
+        return false;
+    }
+    peerStats.serverFiles++;
+    peerStats.serverBytes += size;
+    return true;
+}
+
+bool ModelService::VerifyStaged(const json& data, const std::string& stagingPath, ModelManifest& manifest,
+    ZipStats& stats, ModelPeerStats& peerStats, std::string& error) {
+    std::map<std::string, const ManifestFile*> staged;
+    for (size_t i = 0; i < manifest.files.size(); i++) {
+        staged[manifest.files[i].path] = &manifest.files[i];
+    }
+
+    const json& files = data["Files"];
+    std::string blobUrl = data["BlobUrl"].get<std::string>();
+    std::vector<std::string> peers = GetPeers(data);
+    std::vector<unsigned int> peerFailures(peers.size(), 0);
+    bool refetched = false;
+    for (size_t i = 0; i < files.size(); i++) {
+        std::string relativePath;
+        uint64_t hash = 0;
+        uint64_t size = 0;
+        if (!ParseStoreFile(files[i], relativePath, hash, size, error)) {
+            return false;
         }
+        std::map<std::string, const ManifestFile*>::iterator it = staged.find(relativePath);
+        if (it != staged.end() && it->second->hash == hash && it->second->size == size) {
+            continue;
+        }
+
+        // A blob changed on disk after it was stored; it would be linked into every later model too
+        modelStore_.Discard(hash, size);
+        std::replace(relativePath.begin(), relativePath.end(), '/', '\\');
+        std::string targetPath = stagingPath + "\\" + relativePath;
+        SetFileAttributesA(targetPath.c_str(), FILE_ATTRIBUTE_NORMAL);
+        DeleteFileA(targetPath.c_str());
+        if (!FetchFile(blobUrl, peers, peerFailures, relativePath, hash, size, targetPath, peerStats, error)) {
+            return false;
+        }
+        stats.bytesIn += size;
+        refetched = true;
+    }
+
+    // The fetched files were checked as they arrived; the manifest is rebuilt for the root hash
+    return !refetched || manifestCache_.Build(stagingPath, manifest, error);
+}
 
-        FileUtils::DeleteFile(tempZipPath);
+bool ModelService::FetchFromPeers(const std::vector<std::string>& peers, std::vector<unsigned int>& failures,
+    uint64_t hash, uint64_t size, const std::string& targetPath, ModelPeerStats& peerStats) {
+    // Peers only hold what their store shares
+    if (peers.empty() || !ModelStore::IsShared(size)) {
+        return false;
     }
 
+    // Starting at a different peer per blob spreads the receivers over the holders
+    std::string blobName = ModelStore::GetBlobName(hash, size);
+    size_t first = (size_t)(hash % peers.size());
+    unsigned int attempts = 0;
+    for (size_t n = 0; n < peers.size() && attempts < AgentConstants::MODEL_PEER_ATTEMPTS && !stopping_; n++) {
+        size_t peer = (first + n) % peers.size();
+        if (failures[peer] >= AgentConstants::MODEL_PEER_MAX_FAILURES) {
+            continue;
+        }
+
+        attempts++;
+        std::string url = "http://" + peers[peer] + AgentConstants::MODEL_PEER_BLOB_PATH + blobName;
+        if (httpClient_->DownloadFileDirect(url, targetPath, AgentConstants::MODEL_PEER_TIMEOUT_MS) &&
+            MatchesHash(targetPath, hash, size)) {
+            failures[peer] = 0;
+            peerStats.peerFiles++;
+            peerStats.peerBytes += size;
+            return true;
+        }
+        failures[peer]++;
+        peerStats.peerFailures++;
+    }
     return false;
 }
 
-bool ModelService::DeleteModel(const std::string& modelName) {
+static bool MoveFolder(const std::string& from, const std::string& to) {
+    for (int attempt = 0; ; attempt++) {
+        if (MoveFileExA(from.c_str(), to.c_str(), 0)) {
+            return true;
+        }
+        if (attempt + 1 >= AgentConstants::MODEL_SWITCH_RETRIES) {
+            return false;
+        }
+        Sleep(AgentConstants::MODEL_SWITCH_RETRY_DELAY_MS);
+    }
+}
+
+bool ModelService::ActivateStaged(const json& data, const std::string& modelName, const std::string& stagingPath,
+    double& switchMs, std::string& error) {
     std::string modelPath = settings_->modelFolderPath + "\\" + modelName;
-    return FileUtils::DeleteFolder(modelPath);
+    std::string previousPath = GetStagingFolder() + "\\" + modelName + AgentConstants::MODEL_PREVIOUS_SUFFIX;
+
+    std::lock_guard<std::mutex> lock(switchMutex_);
+
+    // An older previous version is dropped before the switch, not inside it
+    if (FileUtils::FolderExists(previousPath)) {
+        collectPending_ = true;
+        if (!DeleteFolderQuickly(previousPath, GetStagingFolder())) {
+            error = "Cannot remove " + previousPath;
+            return false;
+        }
+    }
+
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    bool hadPrevious = FileUtils::FolderExists(modelPath);
+    if (hadPrevious && !MoveFolder(modelPath, previousPath)) {
+        error = "Cannot move " + modelPath + " aside; a file in it is in use";
+        return false;
+    }
+    if (!MoveFolder(stagingPath, modelPath)) {
+        if (hadPrevious) {
+            MoveFileExA(previousPath.c_str(), modelPath.c_str(), 0);
+        }
+        error = "Cannot move the model into " + modelPath;
+        return false;
+    }
+
+    ApplyUploadedModel(data, modelName, modelPath);
+    switchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+    usage_.Touch(modelName);
+    inventoryDirty_ = true;
+    if (hadPrevious) {
+        std::lock_guard<std::mutex> jobsLock(jobsMutex_);
+        previousSince_[modelName] = std::chrono::steady_clock::now();
+    }
+    return true;
 }
 
-bool ModelService::UploadModelToLibrary(const std::string& modelName, const std::string& uploadUrl) {
+bool ModelService::RevertModel(const std::string& modelName, std::string& resultData, std::string& error) {
     std::string modelPath = settings_->modelFolderPath + "\\" + modelName;
+    std::string stagingFolder = GetStagingFolder();
+    std::string previousPath = stagingFolder + "\\" + modelName + AgentConstants::MODEL_PREVIOUS_SUFFIX;
+    std::string parkedPath = stagingFolder + "\\" + modelName + AgentConstants::MODEL_REVERT_SUFFIX;
 
-    if (!FileUtils::FolderExists(modelPath)) {
+    std::lock_guard<std::mutex> lock(switchMutex_);
+    if (!FileUtils::FolderExists(previousPath)) {
+        error = "No previous version of " + modelName + " is kept";
+        return false;
+    }
+
+    // The config already names this folder, so the swap is renames only
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    bool hadCurrent = FileUtils::FolderExists(modelPath);
+    if (hadCurrent && !MoveFolder(modelPath, parkedPath)) {
+        error = "Cannot move " + modelPath + " aside; a file in it is in use";
         return false;
     }
+    if (!MoveFolder(previousPath, modelPath)) {
+        if (hadCurrent) {
+            MoveFileExA(parkedPath.c_str(), modelPath.c_str(), 0);
+        }
+        error = "Cannot move the previous version into " + modelPath;
+        return false;
+    }
+    if (hadCurrent) {
+        MoveFileExA(parkedPath.c_str(), previousPath.c_str(), 0);
+    }
+    double switchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+    usage_.Touch(modelName);
+    inventoryDirty_ = true;
+    {
+        std::lock_guard<std::mutex> jobsLock(jobsMutex_);
+        previousSince_[modelName] = std::chrono::steady_clock::now();
+    }
+
+    json result;
+    result["switchMs"] = switchMs;
+    result["previousKept"] = hadCurrent;
+    resultData = result.dump();
+    return true;
+}
+
+void ModelService::PurgePreviousVersions() {
+    std::string stagingFolder = settings_->modelFolderPath + "\\" + AgentConstants::TEMP_FOLDER_NAME;
+    std::string suffix = AgentConstants::MODEL_PREVIOUS_SUFFIX;
+    std::vector<std::string> expired;
+
+    WIN32_FIND_DATAA findData;
+    HANDLE hFind = FindFirstFileA((stagingFolder + "\\*" + suffix).c_str(), &findData);
+    if (hFind == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex_);
+        do {
+            std::string folderName = findData.cFileName;
+            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || folderName.size() <= suffix.size()) {
+                continue;
+            }
 
-    std::string tempDir = settings_->modelFolderPath + "\\" + AgentConstants::TEMP_FOLDER_NAME;
-    FileUtils::CreateFolder(tempDir);
+            // Versions found after a restart get a full retention period from now
+            std::string modelName = folderName.substr(0, folderName.size() - suffix.size());
+            std::map<std::string, std::chrono::steady_clock::time_point>::iterator it = previousSince_.find(modelName);
+            if (it == previousSince_.end()) {
+                previousSince_[modelName] = now;
+            }
+            else if (now - it->second >= std::chrono::milliseconds(AgentConstants::MODEL_PREVIOUS_RETENTION_MS)) {
+                expired.push_back(modelName);
+                previousSince_.erase(it);
+            }
+        } while (FindNextFileA(hFind, &findData));
+    }
+    FindClose(hFind);
 
-    std::string tempZipPath = tempDir + "\\" + modelName + AgentConstants::ZIP_EXTENSION;
+    std::lock_guard<std::mutex> lock(switchMutex_);
+    for (size_t i = 0; i < expired.size(); i++) {
+        DeleteFolderQuickly(stagingFolder + "\\" + expired[i] + suffix, stagingFolder);
+        collectPending_ = true;
+    }
+}
 
-    // Use existing ZipUtils
-    if (ZipUtils::CreateZip(modelPath, tempZipPath)) {
-        if (FileUtils::FileExists(tempZipPath)) {
-            json response;
-            // Use the specific uploadUrl provided by server (converted to wstring)
-            std::wstring wUploadUrl(uploadUrl.begin(), uploadUrl.end());
-            bool success = httpClient_->UploadFile(wUploadUrl, tempZipPath, "file", response);
+void ModelService::ApplyUploadedModel(const json& data, const std::string& modelName, const std::string& modelPath) {
+    // Check if ApplyOnUpload is true
+    bool applyOnUpload = false;
+    if (data.contains("ApplyOnUpload")) {
+        applyOnUpload = data["ApplyOnUpload"].get<bool>();
+    }
 
-            FileUtils::DeleteFile(tempZipPath);
+    // Runs on the upload thread; the config manager serializes it with commands
+    if (applyOnUpload) {
+        configManager_->SetCurrentModel(settings_->configFilePath, modelName, modelPath, "model");
+    }
+}
 
-            return success;
+bool ModelService::DownloadAndExtract(const std::string& url, const std::string& stagingPath,
+    const ZipOptions& options, ZipStats& stats, std::string& error) {
+    // Entries are unpacked on their own thread as the download arrives; the
+    // pipe lets network and disk each run at their own pace in bounded memory
+    PipeBuffer pipe(AgentConstants::ZIP_STREAM_PIPE_SIZE);
+    DownloadPipe target;
+    target.pipe = &pipe;
+    target.stopping = &stopping_;
+    bool extracted = false;
+    std::string zipError;
+    std::thread consumer([&]() {
+        try {
+            extracted = ZipUtils::ExtractZip(ReadArchiveFromPipe, &pipe, stagingPath, options, stats, zipError);
         }
+        catch (const std::exception& e) {
+            zipError = std::string("Extraction failed: ") + e.what();
+        }
+        if (!extracted) {
+            pipe.Abort();
+        }
+    });
+
+    bool downloaded = httpClient_->DownloadStream(url, WriteDownloadToPipe, &target);
+
+    // An abort already in place means the extractor gave up first
+    bool extractFailed = pipe.IsAborted();
+    if (downloaded) {
+        pipe.Close();
+    }
+    else {
+        pipe.Abort();
     }
+    consumer.join();
 
-    return false;
+    if (!downloaded) {
+        error = extractFailed ? zipError : "Download failed";
+        return false;
+    }
+    if (!extracted) {
+        error = zipError;
+        return false;
+    }
+    return true;
+}
+
+bool ModelService::DownloadThenExtract(const std::string& url, const std::string& zipPath,
+    const std::string& stagingPath, const ZipOptions& options, ZipStats& stats, std::string& error) {
+    if (!httpClient_->DownloadFile(url, zipPath)) {
+        FileUtils::DeleteFile(zipPath);
+        error = "Download failed";
+        return false;
+    }
+
+    bool extracted = ZipUtils::ExtractZip(zipPath, stagingPath, options, stats, error);
+    FileUtils::DeleteFile(zipPath);
+    return extracted;
+}
+
+bool ModelService::DeleteModel(const std::string& modelName) {
+    // Activations and reverts rename the same live and previous folders
+    std::lock_guard<std::mutex> lock(switchMutex_);
+    if (!CanDelete(modelName)) {
+        return false;
+    }
+    return DeleteModelLocked(modelName);
+}
+
+// False for the model the line is configured to run, and when the config cannot be read
+bool ModelService::CanDelete(const std::string& modelName) {
+    std::shared_ptr<const ConfigSnapshot> snapshot;
+    return configManager_->GetConfigSnapshot(settings_->configFilePath, snapshot) &&
+        !SameModelName(snapshot->currentModel, modelName);
+}
+
+bool ModelService::DeleteModelLocked(const std::string& modelName) {
+    std::string modelPath = settings_->modelFolderPath + "\\" + modelName;
+    collectPending_ = true;
+    usage_.Forget(modelName);
+    inventoryDirty_ = true;
+    return DeleteFolderQuickly(modelPath, GetStagingFolder());
+}
+
+bool ModelService::UploadModelToLibrary(const json& data, std::string& resultData, std::string& error) {
+    if (!data.contains("ModelName") || !data.contains("UploadUrl")) {
+        error = "UploadModelToLib requires ModelName and UploadUrl";
+        return false;
+    }
+
+    std::string modelName = data["ModelName"].get<std::string>();
+    std::string uploadUrl = data["UploadUrl"].get<std::string>();
+    std::string modelPath = settings_->modelFolderPath + "\\" + modelName;
+
+    if (!FileUtils::FolderExists(modelPath)) {
+        error = "Model folder not found: " + modelName;
+        return false;
+    }
+
+    ZipOptions options;
+    options.level = data.value("CompressionLevel", AgentConstants::ZIP_LEVEL_ADAPTIVE);
+    options.maxThreads = (std::min)(data.value("MaxThreads", (size_t)AgentConstants::ZIP_MAX_THREADS),
+        (size_t)AgentConstants::ZIP_MAX_THREADS);
+
+    // The zip is built on its own thread straight into the request body; the
+    // pipe between them bounds memory and nothing is written to disk
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    PipeBuffer pipe(AgentConstants::ZIP_STREAM_PIPE_SIZE);
+    ZipStats stats;
+    std::string zipError;
+    std::thread producer([&]() {
+        bool zipped = false;
+        try {
+            zipped = ZipUtils::CreateZip(modelPath, WriteToPipe, &pipe, options, stats, zipError);
+        }
+        catch (const std::exception& e) {
+            zipError = std::string("Compression failed: ") + e.what();
+        }
+        if (zipped) {
+            pipe.Close();
+        }
+        else {
+            pipe.Abort();
+        }
+    });
+
+    json response;
+    // Use the specific uploadUrl provided by server (converted to wstring)
+    std::wstring wUploadUrl(uploadUrl.begin(), uploadUrl.end());
+    bool success = httpClient_->UploadStream(wUploadUrl, modelName + AgentConstants::ZIP_EXTENSION,
+        "file", ReadFromPipe, &pipe, response);
+
+    // An abort already in place means the zip failed first; otherwise the
+    // compressor may be blocked on a full pipe and has to be released
+    bool zipFailed = pipe.IsAborted();
+    if (!success) {
+        pipe.Abort();
+    }
+    producer.join();
+
+    json result;
+    result["files"] = stats.files;
+    result["bytesIn"] = stats.bytesIn;
+    result["bytesOut"] = stats.bytesOut;
+    result["threads"] = stats.threads;
+    result["zipMs"] = stats.elapsedMs;
+    result["zipMBps"] = stats.elapsedMs > 0 ? (double)stats.bytesIn / 1000.0 / (double)stats.elapsedMs : 0.0;
+    result["uploadMs"] = (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    result["zipWaitMs"] = pipe.GetWriterWaitMs();
+    result["uploadWaitMs"] = pipe.GetReaderWaitMs();
+    resultData = result.dump();
+
+    if (!success) {
+        error = zipFailed ? zipError : "Upload failed";
+    }
+    return success;
 }
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "../include/services/SharedEventService.h"
+#include "../include/services/LiveLogService.h"
+#include "../include/common/Constants.h"
+
+SharedEventService::SharedEventService(AgentSettings* settings, LiveLogService* liveLogService) {
+    settings_ = settings;
+    liveLogService_ = liveLogService;
+    consumerThread_ = NULL;
+    isRunning_ = false;
+}
+
+SharedEventService::~SharedEventService() {
+    Stop();
+}
+
+bool SharedEventService::Start() {
+    if (isRunning_ || settings_->sharedEventChannel.empty()) {
+        return false;
+    }
+
+    if (!ring_.Create(settings_->sharedEventChannel, AgentConstants::SHARED_EVENT_RING_CAPACITY)) {
+        return false;
+    }
+
+    isRunning_ = true;
+    consumerThread_ = CreateThread(NULL, 0, ConsumerThreadFunc, this, 0, NULL);
+    if (consumerThread_ == NULL) {
+        isRunning_ = false;
+        ring_.Close();
+        return false;
+    }
+    return true;
+}
+
+void SharedEventService::Stop() {
+    if (isRunning_) {
+        isRunning_ = false;
+        if (consumerThread_) {
+            WaitForSingleObject(consumerThread_, 5000);
+            CloseHandle(consumerThread_);
+            consumerThread_ = NULL;
+        }
+        ring_.Close();
+    }
+}
+
+DWORD WINAPI SharedEventService::ConsumerThreadFunc(LPVOID param) {
+    SharedEventService* service = (SharedEventService*)param;
+    service->ConsumerLoop();
+    return 0;
+}
+
+void SharedEventService::ConsumerLoop() {
+    int idleRounds = 0;
+
+    while (isRunning_) {
+        const SharedBarrelEvent* records = NULL;
+        size_t count = ring_.Peek(records, AgentConstants::SHARED_EVENT_BATCH_RECORDS);
+
+        if (count > 0) {
+            // Records are processed where they lie and only then released
+            liveLogService_->ProcessSharedEvents(records, count, ring_.GetDropped());
+            ring_.Release(count);
+            idleRounds = 0;
+            continue;
+        }
+
+        if (idleRounds < AgentConstants::SHARED_EVENT_SPIN_ROUNDS) {
+            idleRounds++;
+            Sleep(0);
+        }
+        else {
+            Sleep(AgentConstants::SHARED_EVENT_IDLE_SLEEP_MS);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,1277 @@
+#include "../include/utilities/Deflate.h"
+#include <algorithm>
+#include <cstring>
+
+static const int WINDOW_SIZE = 32768;
+static const int WINDOW_MASK = WINDOW_SIZE - 1;
+static const int HASH_BITS = 15;
+static const int HASH_SIZE = 1 << HASH_BITS;
+static const int MIN_MATCH = 3;
+static const int MAX_MATCH = 258;
+static const int MIN_LOOKAHEAD = MAX_MATCH + MIN_MATCH + 1;
+static const int MAX_DISTANCE = WINDOW_SIZE - MIN_LOOKAHEAD;
+static const int TOO_FAR = 4096;
+static const size_t BLOCK_SYMBOLS = 16384;
+static const size_t OUTPUT_CHUNK = 65536;
+static const size_t INPUT_CHUNK = 65536;
+static const int INPUT_HISTORY = 8;          // Bytes kept on refill so unread bits can be handed back
+static const int LITLEN_CODES = 286;
+static const int DIST_CODES = 30;
+static const int CODELEN_CODES = 19;
+static const int MAX_BITS = 15;
+static const int FAST_BITS = 10;
+
+static const uint16_t lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const uint8_t codeLengthOrder[CODELEN_CODES] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+static const struct DeflateLevel {
+    int goodLength;
+    int maxLazy;
+    int niceLength;
+    int maxChain;
+} levels[10] = {
+    { 0, 0, 0, 0 },
+    { 4, 4, 8, 4 },
+    { 4, 5, 16, 8 },
+    { 4, 6, 32, 32 },
+    { 4, 4, 16, 16 },
+    { 8, 16, 32, 32 },
+    { 8, 16, 128, 128 },
+    { 8, 32, 128, 256 },
+    { 32, 128, 258, 1024 },
+    { 32, 258, 258, 4096 }
+};
+
+// Symbol lookups for the encoder, built once
+struct DeflateCodeTables {
+    uint8_t lengthCode[MAX_MATCH + 1];
+    uint8_t distCode[WINDOW_SIZE + 1];
+
+    DeflateCodeTables() {
+        for (int code = 0; code < 29; code++) {
+            int end = code < 28 ? lengthBase[code + 1] : MAX_MATCH + 1;
+            for (int length = lengthBase[code]; length < end && length <= MAX_MATCH; length++) {
+                lengthCode[length] = (uint8_t)code;
+            }
+        }
+        lengthCode[MAX_MATCH] = 28;
+        for (int code = 0; code < 30; code++) {
+            int end = code < 29 ? distBase[code + 1] : WINDOW_SIZE + 1;
+            for (int dist = distBase[code]; dist < end; dist++) {
+                distCode[dist] = (uint8_t)code;
+            }
+        }
+    }
+};
+
+static const DeflateCodeTables& CodeTables() {
+    static const DeflateCodeTables tables;
+    return tables;
+}
+
+static uint32_t ReverseBits(uint32_t code, int length) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+// In-place minimum-redundancy code lengths (Moffat and Katajainen) for
+// weights sorted ascending; A[i] becomes the length of the i-th weight
+static void MinimumRedundancy(std::vector<uint32_t>& A) {
+    int n = (int)A.size();
+    if (n == 1) {
+        A[0] = 1;
+        return;
+    }
+
+    A[0] += A[1];
+    int root = 0;
+    int leaf = 2;
+    for (int next = 1; next < n - 1; next++) {
+        if (leaf >= n || A[root] < A[leaf]) {
+            A[next] = A[root];
+            A[root++] = next;
+        }
+        else {
+            A[next] = A[leaf++];
+        }
+        if (leaf >= n || (root < next && A[root] < A[leaf])) {
+            A[next] += A[root];
+            A[root++] = next;
+        }
+        else {
+            A[next] += A[leaf++];
+        }
+    }
+
+    A[n - 2] = 0;
+    for (int next = n - 3; next >= 0; next--) {
+        A[next] = A[A[next]] + 1;
+    }
+
+    int available = 1;
+    int used = 0;
+    uint32_t depth = 0;
+    root = n - 2;
+    int next = n - 1;
+    while (available > 0) {
+        while (root >= 0 && A[root] == depth) {
+            used++;
+            root--;
+        }
+        while (available > used) {
+            A[next--] = depth;
+            available--;
+        }
+        available = 2 * used;
+        depth++;
+        used = 0;
+    }
+}
+
+// Huffman code lengths no longer than limit; unused symbols get 0
+static void BuildCodeLengths(const uint32_t* freq, int count, int limit, uint8_t* lengths) {
+    memset(lengths, 0, count);
+
+    std::vector<std::pair<uint32_t, int> > used;
+    for (int i = 0; i < count; i++) {
+        if (freq[i] > 0) {
+            used.push_back(std::make_pair(freq[i], i));
+        }
+    }
+    if (used.empty()) {
+        return;
+    }
+    std::sort(used.begin(), used.end());
+
+    std::vector<uint32_t> A(used.size());
+    for (size_t i = 0; i < used.size(); i++) {
+        A[i] = used[i].first;
+    }
+    MinimumRedundancy(A);
+
+    std::vector<int> lengthCount(used.size() + 2, 0);
+    int maxLength = 0;
+    for (size_t i = 0; i < A.size(); i++) {
+        lengthCount[A[i]]++;
+        maxLength = (std::max)(maxLength, (int)A[i]);
+    }
+
+    // Fold lengths above the limit back in, keeping the code complete
+    for (int i = maxLength; i > limit; i--) {
+        while (lengthCount[i] > 0) {
+            int j = i - 2;
+            while (lengthCount[j] == 0) {
+                j--;
+            }
+            lengthCount[i] -= 2;
+            lengthCount[i - 1]++;
+            lengthCount[j + 1] += 2;
+            lengthCount[j]--;
+        }
+    }
+
+    // Least frequent symbols take the longest codes
+    size_t next = 0;
+    for (int length = (std::min)(maxLength, limit); length >= 1; length--) {
+        for (int k = 0; k < lengthCount[length]; k++) {
+            lengths[used[next++].second] = (uint8_t)length;
+        }
+    }
+}
+
+static void BuildCodes(const uint8_t* lengths, int count, uint16_t* codes) {
+    int lengthCount[MAX_BITS + 1] = { 0 };
+    for (int i = 0; i < count; i++) {
+        lengthCount[lengths[i]]++;
+    }
+    lengthCount[0] = 0;
+
+    uint32_t nextCode[MAX_BITS + 1] = { 0 };
+    uint32_t code = 0;
+    for (int bits = 1; bits <= MAX_BITS; bits++) {
+        code = (code + lengthCount[bits - 1]) << 1;
+        nextCode[bits] = code;
+    }
+
+    for (int i = 0; i < count; i++) {
+        codes[i] = lengths[i] ? (uint16_t)ReverseBits(nextCode[lengths[i]]++, lengths[i]) : 0;
+    }
+}
+
+// A valid tree needs two codes; pad single-symbol (or empty) alphabets
+static void EnsureTwoCodes(uint8_t* lengths, int count) {
+    int used = 0;
+    for (int i = 0; i < count; i++) {
+        if (lengths[i]) {
+            used++;
+        }
+    }
+    for (int i = 0; i < count && used < 2; i++) {
+        if (!lengths[i]) {
+            lengths[i] = 1;
+            used++;
+        }
+    }
+}
+
+Deflater::Deflater() {
+    sink_ = NULL;
+    sinkData_ = NULL;
+    lazy_ = false;
+    failed_ = false;
+    windowEnd_ = 0;
+    position_ = 0;
+    blockStart_ = 0;
+    matchLength_ = MIN_MATCH - 1;
+    matchStart_ = 0;
+    prevLength_ = MIN_MATCH - 1;
+    prevMatch_ = 0;
+    matchAvailable_ = false;
+    bitBuffer_ = 0;
+    bitCount_ = 0;
+    totalIn_ = 0;
+    totalOut_ = 0;
+    config_.goodLength = 0;
+    config_.maxLazy = 0;
+    config_.niceLength = 0;
+    config_.maxChain = 0;
+}
+
+Deflater::~Deflater() {
+}
+
+void Deflater::Reset(int level, DeflateSink sink, void* userData) {
+    level = (std::max)(1, (std::min)(9, level));
+    config_.goodLength = levels[level].goodLength;
+    config_.maxLazy = levels[level].maxLazy;
+    config_.niceLength = levels[level].niceLength;
+    config_.maxChain = levels[level].maxChain;
+    lazy_ = level >= 4;
+
+    sink_ = sink;
+    sinkData_ = userData;
+    failed_ = false;
+
+    // Chains are only entered through head_, so stale window and prev_ contents are harmless
+    window_.resize(2 * WINDOW_SIZE);
+    head_.assign(HASH_SIZE, -1);
+    prev_.resize(WINDOW_SIZE);
+    windowEnd_ = 0;
+    position_ = 0;
+    blockStart_ = 0;
+    matchLength_ = MIN_MATCH - 1;
+    matchStart_ = 0;
+    prevLength_ = MIN_MATCH - 1;
+    prevMatch_ = 0;
+    matchAvailable_ = false;
+
+    symbolLitLen_.clear();
+    symbolDist_.clear();
+    symbolLitLen_.reserve(BLOCK_SYMBOLS);
+    symbolDist_.reserve(BLOCK_SYMBOLS);
+
+    output_.clear();
+    output_.reserve(OUTPUT_CHUNK + 1024);
+    bitBuffer_ = 0;
+    bitCount_ = 0;
+    totalIn_ = 0;
+    totalOut_ = 0;
+}
+
+void Deflater::SetDictionary(const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    if (size > (size_t)MAX_DISTANCE) {
+        p += size - MAX_DISTANCE;
+        size = MAX_DISTANCE;
+    }
+
+    memcpy(&window_[0], p, size);
+    for (size_t i = 0; i + MIN_MATCH <= size; i++) {
+        InsertString(i);
+    }
+    windowEnd_ = size;
+    position_ = size;
+    blockStart_ = (long)size;
+}
+
+bool Deflater::Write(const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    while (size > 0 && !failed_) {
+        if (windowEnd_ == window_.size()) {
+            SlideWindow();
+        }
+
+        size_t chunk = (std::min)(size, window_.size() - windowEnd_);
+        memcpy(&window_[windowEnd_], p, chunk);
+        windowEnd_ += chunk;
+        totalIn_ += chunk;
+        p += chunk;
+        size -= chunk;
+
+        if (lazy_) {
+            CompressLazy(false);
+        }
+        else {
+            CompressGreedy(false);
+        }
+    }
+    return !failed_;
+}
+
+bool Deflater::Flush() {
+    if (failed_ || !CompressPending()) {
+        return false;
+    }
+
+    if (!symbolLitLen_.empty() && !FlushBlock(position_, false)) {
+        return false;
+    }
+
+    // An empty stored block pads to the next byte boundary
+    WriteStored(NULL, 0, false);
+    return FlushOutput(true);
+}
+
+bool Deflater::Finish() {
+    if (failed_ || !CompressPending()) {
+        return false;
+    }
+
+    FlushBlock(position_, true);
+    if (bitCount_ > 0) {
+        output_.push_back((unsigned char)bitBuffer_);
+        bitBuffer_ = 0;
+        bitCount_ = 0;
+    }
+    return FlushOutput(true);
+}
+
+unsigned long long Deflater::GetTotalIn() const {
+    return totalIn_;
+}
+
+unsigned long long Deflater::GetTotalOut() const {
+    return totalOut_;
+}
+
+bool Deflater::CompressPending() {
+    if (lazy_) {
+        if (!CompressLazy(true)) {
+            return false;
+        }
+        if (matchAvailable_) {
+            symbolLitLen_.push_back(window_[position_ - 1]);
+            symbolDist_.push_back(0);
+            matchAvailable_ = false;
+        }
+        matchLength_ = MIN_MATCH - 1;
+        return true;
+    }
+    return CompressGreedy(true);
+}
+
+int Deflater::InsertString(size_t position) {
+    uint32_t bytes = (uint32_t)window_[position] | ((uint32_t)window_[position + 1] << 8) |
+        ((uint32_t)window_[position + 2] << 16);
+    uint32_t hash = (bytes * 2654435761U) >> (32 - HASH_BITS);
+    int chainHead = head_[hash];
+    prev_[position & WINDOW_MASK] = chainHead;
+    head_[hash] = (int)position;
+    return chainHead;
+}
+
+int Deflater::LongestMatch(size_t position, long chainHead, int prevLength, long& matchStart) {
+    int chain = config_.maxChain;
+    if (prevLength >= config_.goodLength) {
+        chain >>= 2;
+    }
+
+    const unsigned char* scan = &window_[position];
+    int maxLength = (int)(std::min)((size_t)MAX_MATCH, windowEnd_ - position);
+    int nice = (std::min)(config_.niceLength, maxLength);
+    long limit = (long)position > MAX_DISTANCE ? (long)position - MAX_DISTANCE : 0;
+    int best = prevLength;
+    long candidate = chainHead;
+
+    if (best >= maxLength) {
+        return 0;
+    }
+
+    while (candidate >= limit && candidate >= 0 && chain-- > 0) {
+        const unsigned char* match = &window_[candidate];
+        if (match[best] == scan[best] && match[0] == scan[0] && match[1] == scan[1]) {
+            int length = 2;
+            while (length + 8 <= maxLength) {
+                uint64_t a;
+                uint64_t b;
+                memcpy(&a, scan + length, 8);
+                memcpy(&b, match + length, 8);
+                if (a != b) {
+                    uint64_t diff = a ^ b;
+                    int same = 0;
+                    while ((diff & 0xFF) == 0) {
+                        diff >>= 8;
+                        same++;
+                    }
+                    length += same;
+                    goto compared;
+                }
+                length += 8;
+            }
+            while (length < maxLength && scan[length] == match[length]) {
+                length++;
+            }
+        compared:
+            if (length > best) {
+                best = length;
+                matchStart = candidate;
+                if (length >= nice) {
+                    break;
+                }
+            }
+        }
+        candidate = prev_[candidate & WINDOW_MASK];
+    }
+
+    return best > prevLength ? best : 0;
+}
+
+bool Deflater::CompressGreedy(bool flush) {
+    while (true) {
+        size_t lookahead = windowEnd_ - position_;
+        if (lookahead == 0 || (lookahead < (size_t)MIN_LOOKAHEAD && !flush)) {
+            break;
+        }
+
+        long chainHead = -1;
+        if (lookahead >= (size_t)MIN_MATCH) {
+            chainHead = InsertString(position_);
+        }
+
+        int length = 0;
+        long start = 0;
+        if (chainHead >= 0 && (long)position_ - chainHead <= MAX_DISTANCE) {
+            length = LongestMatch(position_, chainHead, MIN_MATCH - 1, start);
+        }
+
+        if (length >= MIN_MATCH) {
+            symbolLitLen_.push_back((uint16_t)length);
+            symbolDist_.push_back((uint16_t)(position_ - start));
+
+            size_t end = position_ + length;
+            if (length <= config_.maxLazy) {
+                for (size_t p = position_ + 1; p < end && p + MIN_MATCH <= windowEnd_; p++) {
+                    InsertString(p);
+                }
+            }
+            position_ = end;
+        }
+        else {
+            symbolLitLen_.push_back(window_[position_]);
+            symbolDist_.push_back(0);
+            position_++;
+        }
+
+        if (symbolLitLen_.size() >= BLOCK_SYMBOLS && !FlushBlock(position_, false)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Deflater::CompressLazy(bool flush) {
+    while (true) {
+        size_t lookahead = windowEnd_ - position_;
+        if (lookahead == 0 || (lookahead < (size_t)MIN_LOOKAHEAD && !flush)) {
+            break;
+        }
+
+        long chainHead = -1;
+        if (lookahead >= (size_t)MIN_MATCH) {
+            chainHead = InsertString(position_);
+        }
+
+        prevLength_ = matchLength_;
+        prevMatch_ = matchStart_;
+        matchLength_ = MIN_MATCH - 1;
+
+        if (chainHead >= 0 && prevLength_ < config_.maxLazy && (long)position_ - chainHead <= MAX_DISTANCE) {
+            long start = 0;
+            int length = LongestMatch(position_, chainHead, prevLength_, start);
+            if (length >= MIN_MATCH) {
+                matchLength_ = length;
+                matchStart_ = start;
+                // A minimum-length match far away costs more than three literals
+                if (matchLength_ == MIN_MATCH && (long)position_ - matchStart_ > TOO_FAR) {
+                    matchLength_ = MIN_MATCH - 1;
+                }
+            }
+        }
+
+        if (prevLength_ >= MIN_MATCH && matchLength_ <= prevLength_) {
+            // The previous position's match wins; emit it and skip over it
+            size_t maxInsert = windowEnd_ - MIN_MATCH;
+            symbolLitLen_.push_back((uint16_t)prevLength_);
+            symbolDist_.push_back((uint16_t)(position_ - 1 - prevMatch_));
+
+            size_t end = position_ - 1 + prevLength_;
+            for (size_t p = position_ + 1; p < end; p++) {
+                if (p <= maxInsert) {
+                    InsertString(p);
+                }
+            }
+            position_ = end;
+            matchAvailable_ = false;
+            matchLength_ = MIN_MATCH - 1;
+
+            if (symbolLitLen_.size() >= BLOCK_SYMBOLS && !FlushBlock(position_, false)) {
+                return false;
+            }
+        }
+        else if (matchAvailable_) {
+            symbolLitLen_.push_back(window_[position_ - 1]);
+            symbolDist_.push_back(0);
+            if (symbolLitLen_.size() >= BLOCK_SYMBOLS && !FlushBlock(position_, false)) {
+                return false;
+            }
+            position_++;
+        }
+        else {
+            matchAvailable_ = true;
+            position_++;
+        }
+    }
+    return true;
+}
+
+void Deflater::SlideWindow() {
+    memmove(&window_[0], &window_[WINDOW_SIZE], WINDOW_SIZE);
+    windowEnd_ -= WINDOW_SIZE;
+    position_ -= WINDOW_SIZE;
+    blockStart_ -= WINDOW_SIZE;
+    matchStart_ -= WINDOW_SIZE;
+    prevMatch_ -= WINDOW_SIZE;
+
+    for (size_t i = 0; i < head_.size(); i++) {
+        head_[i] = head_[i] >= WINDOW_SIZE ? head_[i] - WINDOW_SIZE : -1;
+    }
+    for (size_t i = 0; i < prev_.size(); i++) {
+        prev_[i] = prev_[i] >= WINDOW_SIZE ? prev_[i] - WINDOW_SIZE : -1;
+    }
+}
+
+bool Deflater::FlushBlock(size_t blockEnd, bool final) {
+    const DeflateCodeTables& tables = CodeTables();
+
+    uint32_t litFreq[LITLEN_CODES] = { 0 };
+    uint32_t distFreq[DIST_CODES] = { 0 };
+    unsigned long long extraBits = 0;
+    for (size_t i = 0; i < symbolLitLen_.size(); i++) {
+        if (symbolDist_[i] == 0) {
+            litFreq[symbolLitLen_[i]]++;
+        }
+        else {
+            int lengthCode = tables.lengthCode[symbolLitLen_[i]];
+            int distCode = tables.distCode[symbolDist_[i]];
+            litFreq[257 + lengthCode]++;
+            distFreq[distCode]++;
+            extraBits += lengthExtra[lengthCode] + distExtra[distCode];
+        }
+    }
+    litFreq[256] = 1;
+
+    uint8_t litLengths[LITLEN_CODES];
+    uint8_t distLengths[DIST_CODES];
+    BuildCodeLengths(litFreq, LITLEN_CODES, MAX_BITS, litLengths);
+    BuildCodeLengths(distFreq, DIST_CODES, MAX_BITS, distLengths);
+    EnsureTwoCodes(litLengths, LITLEN_CODES);
+    EnsureTwoCodes(distLengths, DIST_CODES);
+
+    int litCount = LITLEN_CODES;
+    while (litCount > 257 && litLengths[litCount - 1] == 0) {
+        litCount--;
+    }
+    int distCount = DIST_CODES;
+    while (distCount > 1 && distLengths[distCount - 1] == 0) {
+        distCount--;
+    }
+
+    // Run-length encode both length tables as one sequence
+    uint8_t all[LITLEN_CODES + DIST_CODES];
+    memcpy(all, litLengths, litCount);
+    memcpy(all + litCount, distLengths, distCount);
+    int total = litCount + distCount;
+
+    std::vector<uint8_t> runSymbols;
+    std::vector<uint8_t> runExtra;
+    uint32_t codeLengthFreq[CODELEN_CODES] = { 0 };
+    int i = 0;
+    while (i < total) {
+        uint8_t current = all[i];
+        int run = 1;
+        while (i + run < total && all[i + run] == current) {
+            run++;
+        }
+
+        if (current == 0) {
+            int left = run;
+            while (left >= 11) {
+                int take = (std::min)(left, 138);
+                runSymbols.push_back(18);
+                runExtra.push_back((uint8_t)(take - 11));
+                left -= take;
+            }
+            if (left >= 3) {
+                runSymbols.push_back(17);
+                runExtra.push_back((uint8_t)(left - 3));
+                left = 0;
+            }
+            while (left-- > 0) {
+                runSymbols.push_back(0);
+                runExtra.push_back(0);
+            }
+        }
+        else {
+            runSymbols.push_back(current);
+            runExtra.push_back(0);
+            int left = run - 1;
+            while (left >= 3) {
+                int take = (std::min)(left, 6);
+                runSymbols.push_back(16);
+                runExtra.push_back((uint8_t)(take - 3));
+                left -= take;
+            }
+            while (left-- > 0) {
+                runSymbols.push_back(current);
+                runExtra.push_back(0);
+            }
+        }
+        i += run;
+    }
+    for (size_t r = 0; r < runSymbols.size(); r++) {
+        codeLengthFreq[runSymbols[r]]++;
+    }
+
+    uint8_t codeLengthLengths[CODELEN_CODES];
+    BuildCodeLengths(codeLengthFreq, CODELEN_CODES, 7, codeLengthLengths);
+    EnsureTwoCodes(codeLengthLengths, CODELEN_CODES);
+    int codeLengthCount = CODELEN_CODES;
+    while (codeLengthCount > 4 && codeLengthLengths[codeLengthOrder[codeLengthCount - 1]] == 0) {
+        codeLengthCount--;
+    }
+
+    // Sizes of the three encodings, in bits
+    unsigned long long dynamicBits = 3 + 5 + 5 + 4 + 3ULL * codeLengthCount + extraBits;
+    unsigned long long fixedBits = 3 + extraBits;
+    for (size_t r = 0; r < runSymbols.size(); r++) {
+        static const int runExtraBits[3] = { 2, 3, 7 };
+        dynamicBits += codeLengthLengths[runSymbols[r]];
+        if (runSymbols[r] >= 16) {
+            dynamicBits += runExtraBits[runSymbols[r] - 16];
+        }
+    }
+    for (int s = 0; s < LITLEN_CODES; s++) {
+        dynamicBits += (unsigned long long)litFreq[s] * litLengths[s];
+        int fixedLength = s < 144 ? 8 : (s < 256 ? 9 : (s < 280 ? 7 : 8));
+        fixedBits += (unsigned long long)litFreq[s] * fixedLength;
+    }
+    for (int s = 0; s < DIST_CODES; s++) {
+        dynamicBits += (unsigned long long)distFreq[s] * distLengths[s];
+        fixedBits += (unsigned long long)distFreq[s] * 5;
+    }
+
+    size_t storedSize = blockEnd - (size_t)(blockStart_ >= 0 ? blockStart_ : 0);
+    unsigned long long storedBits = ~0ULL;
+    if (blockStart_ >= 0) {
+        storedBits = (storedSize + 5 * (storedSize / 65535 + 1)) * 8ULL + 7;
+    }
+
+    if (storedBits <= dynamicBits && storedBits <= fixedBits) {
+        WriteStored(&window_[blockStart_], storedSize, final);
+    }
+    else if (fixedBits <= dynamicBits) {
+        uint8_t fixedLit[288];
+        uint8_t fixedDist[DIST_CODES];
+        uint16_t litCodes[288];
+        uint16_t distCodes[DIST_CODES];
+        for (int s = 0; s < 288; s++) {
+            fixedLit[s] = (uint8_t)(s < 144 ? 8 : (s < 256 ? 9 : (s < 280 ? 7 : 8)));
+        }
+        memset(fixedDist, 5, sizeof(fixedDist));
+        BuildCodes(fixedLit, 288, litCodes);
+        BuildCodes(fixedDist, DIST_CODES, distCodes);
+
+        WriteBits(final ? 1 : 0, 1);
+        WriteBits(1, 2);
+        for (size_t s = 0; s < symbolLitLen_.size(); s++) {
+            if (symbolDist_[s] == 0) {
+                WriteBits(litCodes[symbolLitLen_[s]], fixedLit[symbolLitLen_[s]]);
+            }
+            else {
+                int length = symbolLitLen_[s];
+                int dist = symbolDist_[s];
+                int lengthCode = tables.lengthCode[length];
+                int distCode = tables.distCode[dist];
+                WriteBits(litCodes[257 + lengthCode], fixedLit[257 + lengthCode]);
+                WriteBits(length - lengthBase[lengthCode], lengthExtra[lengthCode]);
+                WriteBits(distCodes[distCode], 5);
+                WriteBits(dist - distBase[distCode], distExtra[distCode]);
+            }
+        }
+        WriteBits(litCodes[256], fixedLit[256]);
+    }
+    else {
+        uint16_t litCodes[LITLEN_CODES];
+        uint16_t distCodes[DIST_CODES];
+        uint16_t codeLengthCodes[CODELEN_CODES];
+        BuildCodes(litLengths, LITLEN_CODES, litCodes);
+        BuildCodes(distLengths, DIST_CODES, distCodes);
+        BuildCodes(codeLengthLengths, CODELEN_CODES, codeLengthCodes);
+
+        WriteBits(final ? 1 : 0, 1);
+        WriteBits(2, 2);
+        WriteBits(litCount - 257, 5);
+        WriteBits(distCount - 1, 5);
+        WriteBits(codeLengthCount - 4, 4);
+        for (int s = 0; s < codeLengthCount; s++) {
+            WriteBits(codeLengthLengths[codeLengthOrder[s]], 3);
+        }
+        for (size_t r = 0; r < runSymbols.size(); r++) {
+            uint8_t symbol = runSymbols[r];
+            WriteBits(codeLengthCodes[symbol], codeLengthLengths[symbol]);
+            if (symbol == 16) {
+                WriteBits(runExtra[r], 2);
+            }
+            else if (symbol == 17) {
+                WriteBits(runExtra[r], 3);
+            }
+            else if (symbol == 18) {
+                WriteBits(runExtra[r], 7);
+            }
+        }
+
+        for (size_t s = 0; s < symbolLitLen_.size(); s++) {
+            if (symbolDist_[s] == 0) {
+                WriteBits(litCodes[symbolLitLen_[s]], litLengths[symbolLitLen_[s]]);
+            }
+            else {
+                int length = symbolLitLen_[s];
+                int dist = symbolDist_[s];
+                int lengthCode = tables.lengthCode[length];
+                int distCode = tables.distCode[dist];
+                WriteBits(litCodes[257 + lengthCode], litLengths[257 + lengthCode]);
+                WriteBits(length - lengthBase[lengthCode], lengthExtra[lengthCode]);
+                WriteBits(distCodes[distCode], distLengths[distCode]);
+                WriteBits(dist - distBase[distCode], distExtra[distCode]);
+            }
+        }
+        WriteBits(litCodes[256], litLengths[256]);
+    }
+
+    symbolLitLen_.clear();
+    symbolDist_.clear();
+    blockStart_ = (long)blockEnd;
+    return FlushOutput(false);
+}
+
+void Deflater::WriteBits(uint32_t value, int count) {
+    bitBuffer_ |= (uint64_t)value << bitCount_;
+    bitCount_ += count;
+    while (bitCount_ >= 8) {
+        output_.push_back((unsigned char)bitBuffer_);
+        bitBuffer_ >>= 8;
+        bitCount_ -= 8;
+    }
+}
+
+void Deflater::WriteStored(const unsigned char* data, size_t size, bool final) {
+    do {
+        size_t chunk = (std::min)(size, (size_t)65535);
+        bool last = final && chunk == size;
+
+        WriteBits(last ? 1 : 0, 1);
+        WriteBits(0, 2);
+        if (bitCount_ > 0) {
+            WriteBits(0, 8 - bitCount_);
+        }
+        WriteBits((uint32_t)chunk, 16);
+        WriteBits((uint32_t)(~chunk & 0xFFFF), 16);
+        output_.insert(output_.end(), data, data + chunk);
+
+        data += chunk;
+        size -= chunk;
+    } while (size > 0);
+}
+
+bool Deflater::FlushOutput(bool all) {
+    if (output_.empty() || (!all && output_.size() < OUTPUT_CHUNK)) {
+        return true;
+    }
+    if (!sink_(output_.data(), output_.size(), sinkData_)) {
+        failed_ = true;
+        return false;
+    }
+    totalOut_ += output_.size();
+    output_.clear();
+    return true;
+}
+
+Inflater::Inflater() {
+    source_ = NULL;
+    sourceData_ = NULL;
+    sink_ = NULL;
+    sinkData_ = NULL;
+    inputPos_ = 0;
+    inputSize_ = 0;
+    inputEnded_ = false;
+    bitBuffer_ = 0;
+    bitCount_ = 0;
+    outputPos_ = 0;
+    outputFlushed_ = 0;
+    totalIn_ = 0;
+    totalOut_ = 0;
+    totalRead_ = 0;
+}
+
+Inflater::~Inflater() {
+}
+
+void Inflater::Reset(DeflateSource source, void* sourceData, DeflateSink sink, void* sinkData) {
+    source_ = source;
+    sourceData_ = sourceData;
+    sink_ = sink;
+    sinkData_ = sinkData;
+
+    input_.resize(INPUT_HISTORY + INPUT_CHUNK);
+    inputPos_ = INPUT_HISTORY;
+    inputSize_ = INPUT_HISTORY;
+    inputEnded_ = false;
+    bitBuffer_ = 0;
+    bitCount_ = 0;
+
+    output_.resize(2 * WINDOW_SIZE + MAX_MATCH + 1);
+    outputPos_ = 0;
+    outputFlushed_ = 0;
+
+    error_.clear();
+    totalIn_ = 0;
+    totalOut_ = 0;
+    totalRead_ = 0;
+}
+
+bool Inflater::Run() {
+    bool final = false;
+    do {
+        if (!Fill(3)) {
+            return Fail("Deflate stream is truncated");
+        }
+        final = TakeBits(1) != 0;
+        uint32_t type = TakeBits(2);
+
+        bool ok;
+        if (type == 0) {
+            ok = InflateStored();
+        }
+        else if (type == 1) {
+            BuildFixedTables();
+            ok = InflateBlock();
+        }
+        else if (type == 2) {
+            ok = ReadDynamicTables() && InflateBlock();
+        }
+        else {
+            ok = Fail("Invalid deflate block type");
+        }
+        if (!ok) {
+            return false;
+        }
+    } while (!final);
+
+    if (!FlushOutput(true)) {
+        return false;
+    }
+
+    // Whole bytes still in the bit buffer belong to whatever follows the stream
+    inputPos_ -= bitCount_ / 8;
+    bitBuffer_ = 0;
+    bitCount_ = 0;
+    totalIn_ = totalRead_ - (inputSize_ - inputPos_);
+    return true;
+}
+
+const std::string& Inflater::GetError() const {
+    return error_;
+}
+
+unsigned long long Inflater::GetTotalIn() const {
+    return totalIn_;
+}
+
+unsigned long long Inflater::GetTotalOut() const {
+    return totalOut_;
+}
+
+void Inflater::GetUnconsumed(const unsigned char*& data, size_t& size) const {
+    data = input_.data() + inputPos_;
+    size = inputSize_ - inputPos_;
+}
+
+bool Inflater::Refill() {
+    if (inputEnded_) {
+        return false;
+    }
+
+    // Keep the tail so bytes already shifted into the bit buffer can be handed back
+    size_t keep = (std::min)((size_t)INPUT_HISTORY, inputSize_);
+    memmove(&input_[INPUT_HISTORY - keep], &input_[inputSize_ - keep], keep);
+
+    size_t got = source_(&input_[INPUT_HISTORY], INPUT_CHUNK, sourceData_);
+    if (got == 0) {
+        inputEnded_ = true;
+        inputPos_ = INPUT_HISTORY;
+        inputSize_ = INPUT_HISTORY;
+        return false;
+    }
+    totalRead_ += got;
+    inputPos_ = INPUT_HISTORY;
+    inputSize_ = INPUT_HISTORY + got;
+    return true;
+}
+
+bool Inflater::Fill(int bits) {
+    while (bitCount_ < bits) {
+        if (inputPos_ == inputSize_ && !Refill()) {
+            return false;
+        }
+        bitBuffer_ |= (uint64_t)input_[inputPos_++] << bitCount_;
+        bitCount_ += 8;
+    }
+    return true;
+}
+
+uint32_t Inflater::TakeBits(int count) {
+    uint32_t value = (uint32_t)(bitBuffer_ & ((1ULL << count) - 1));
+    bitBuffer_ >>= count;
+    bitCount_ -= count;
+    return value;
+}
+
+bool Inflater::Decode(const HuffmanTable& table, int& symbol) {
+    // Near the end of the stream fewer than 15 bits may remain; that is fine for short codes
+    Fill(MAX_BITS);
+
+    uint16_t entry = table.fast[bitBuffer_ & ((1 << FAST_BITS) - 1)];
+    if (entry != 0) {
+        int length = entry & 15;
+        if (length > bitCount_) {
+            return Fail("Deflate stream is truncated");
+        }
+        symbol = entry >> 4;
+        TakeBits(length);
+        return true;
+    }
+
+    // Canonical decode for codes longer than the fast table
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int length = 1; length <= MAX_BITS; length++) {
+        if (length > bitCount_) {
+            return Fail("Deflate stream is truncated");
+        }
+        code |= (int)((bitBuffer_ >> (length - 1)) & 1);
+        int count = table.count[length];
+        if (code - count < first) {
+            symbol = table.symbol[index + (code - first)];
+            TakeBits(length);
+            return true;
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return Fail("Invalid Huffman code");
+}
+
+bool Inflater::BuildTable(HuffmanTable& table, const uint8_t* lengths, int count) {
+    memset(table.count, 0, sizeof(table.count));
+    for (int i = 0; i < count; i++) {
+        table.count[lengths[i]]++;
+    }
+    table.count[0] = 0;
+
+    int left = 1;
+    for (int length = 1; length <= MAX_BITS; length++) {
+        left <<= 1;
+        left -= table.count[length];
+        if (left < 0) {
+            return Fail("Over-subscribed Huffman table");
+        }
+    }
+
+    uint16_t offsets[MAX_BITS + 2];
+    offsets[1] = 0;
+    for (int length = 1; length <= MAX_BITS; length++) {
+        offsets[length + 1] = offsets[length] + table.count[length];
+    }
+    for (int i = 0; i < count; i++) {
+        if (lengths[i]) {
+            table.symbol[offsets[lengths[i]]++] = (uint16_t)i;
+        }
+    }
+
+    memset(table.fast, 0, sizeof(table.fast));
+    uint32_t nextCode[MAX_BITS + 1] = { 0 };
+    uint32_t code = 0;
+    for (int length = 1; length <= MAX_BITS; length++) {
+        nextCode[length] = code;
+        code = (code + table.count[length]) << 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int length = lengths[i];
+        if (length == 0) {
+            continue;
+        }
+        uint32_t reversed = ReverseBits(nextCode[length]++, length);
+        if (length <= FAST_BITS) {
+            for (uint32_t k = reversed; k < (1U << FAST_BITS); k += 1U << length) {
+                table.fast[k] = (uint16_t)((i << 4) | length);
+            }
+        }
+    }
+    return true;
+}
+
+bool Inflater::ReadDynamicTables() {
+    if (!Fill(14)) {
+        return Fail("Deflate stream is truncated");
+    }
+    int litCount = (int)TakeBits(5) + 257;
+    int distCount = (int)TakeBits(5) + 1;
+    int codeLengthCount = (int)TakeBits(4) + 4;
+    if (litCount > LITLEN_CODES || distCount > DIST_CODES) {
+        return Fail("Invalid dynamic block header");
+    }
+
+    uint8_t codeLengthLengths[CODELEN_CODES] = { 0 };
+    for (int i = 0; i < codeLengthCount; i++) {
+        if (!Fill(3)) {
+            return Fail("Deflate stream is truncated");
+        }
+        codeLengthLengths[codeLengthOrder[i]] = (uint8_t)TakeBits(3);
+    }
+
+    HuffmanTable codeLengths;
+    if (!BuildTable(codeLengths, codeLengthLengths, CODELEN_CODES)) {
+        return false;
+    }
+
+    uint8_t lengths[LITLEN_CODES + DIST_CODES];
+    int index = 0;
+    while (index < litCount + distCount) {
+        int symbol;
+        if (!Decode(codeLengths, symbol)) {
+            return false;
+        }
+
+        if (symbol < 16) {
+            lengths[index++] = (uint8_t)symbol;
+            continue;
+        }
+
+        int repeat;
+        uint8_t value = 0;
+        if (symbol == 16) {
+            if (index == 0) {
+                return Fail("Length repeat with no previous length");
+            }
+            if (!Fill(2)) {
+                return Fail("Deflate stream is truncated");
+            }
+            value = lengths[index - 1];
+            repeat = 3 + (int)TakeBits(2);
+        }
+        else if (symbol == 17) {
+            if (!Fill(3)) {
+                return Fail("Deflate stream is truncated");
+            }
+            repeat = 3 + (int)TakeBits(3);
+        }
+        else {
+            if (!Fill(7)) {
+                return Fail("Deflate stream is truncated");
+            }
+            repeat = 11 + (int)TakeBits(7);
+        }
+
+        if (index + repeat > litCount + distCount) {
+            return Fail("Code lengths overflow the tables");
+        }
+        while (repeat-- > 0) {
+            lengths[index++] = value;
+        }
+    }
+
+    if (lengths[256] == 0) {
+        return Fail("Missing end-of-block code");
+    }
+
+    uint8_t litLengths[288] = { 0 };
+    uint8_t distLengths[DIST_CODES] = { 0 };
+    memcpy(litLengths, lengths, litCount);
+    memcpy(distLengths, lengths + litCount, distCount);
+    return BuildTable(litLen_, litLengths, 288) && BuildTable(dist_, distLengths, DIST_CODES);
+}
+
+void Inflater::BuildFixedTables() {
+    uint8_t litLengths[288];
+    uint8_t distLengths[DIST_CODES];
+    for (int i = 0; i < 288; i++) {
+        litLengths[i] = (uint8_t)(i < 144 ? 8 : (i < 256 ? 9 : (i < 280 ? 7 : 8)));
+    }
+    memset(distLengths, 5, sizeof(distLengths));
+    BuildTable(litLen_, litLengths, 288);
+    BuildTable(dist_, distLengths, DIST_CODES);
+}
+
+bool Inflater::InflateStored() {
+    TakeBits(bitCount_ % 8);
+    if (!Fill(32)) {
+        return Fail("Deflate stream is truncated");
+    }
+    uint32_t length = TakeBits(16);
+    uint32_t check = TakeBits(16);
+    if ((length ^ 0xFFFF) != check) {
+        return Fail("Stored block length check failed");
+    }
+
+    // Bytes already in the bit buffer come first
+    while (length > 0 && bitCount_ >= 8) {
+        output_[outputPos_++] = (unsigned char)TakeBits(8);
+        length--;
+        if (outputPos_ >= 2 * (size_t)WINDOW_SIZE && !FlushOutput(false)) {
+            return false;
+        }
+    }
+
+    while (length > 0) {
+        if (inputPos_ == inputSize_ && !Refill()) {
+            return Fail("Deflate stream is truncated");
+        }
+        size_t chunk = (std::min)((size_t)length, inputSize_ - inputPos_);
+        chunk = (std::min)(chunk, 2 * (size_t)WINDOW_SIZE - outputPos_);
+        memcpy(&output_[outputPos_], &input_[inputPos_], chunk);
+        inputPos_ += chunk;
+        outputPos_ += chunk;
+        length -= (uint32_t)chunk;
+        if (outputPos_ >= 2 * (size_t)WINDOW_SIZE && !FlushOutput(false)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Inflater::InflateBlock() {
+    while (true) {
+        int symbol;
+        if (!Decode(litLen_, symbol)) {
+            return false;
+        }
+
+        if (symbol < 256) {
+            output_[outputPos_++] = (unsigned char)symbol;
+        }
+        else if (symbol == 256) {
+            return true;
+        }
+        else {
+            symbol -= 257;
+            if (symbol >= 29) {
+                return Fail("Invalid length code");
+            }
+            if (!Fill(lengthExtra[symbol])) {
+                return Fail("Deflate stream is truncated");
+            }
+            size_t length = lengthBase[symbol] + TakeBits(lengthExtra[symbol]);
+
+            int distSymbol;
+            if (!Decode(dist_, distSymbol)) {
+                return false;
+            }
+            if (distSymbol >= DIST_CODES) {
+                return Fail("Invalid distance code");
+            }
+            if (!Fill(distExtra[distSymbol])) {
+                return Fail("Deflate stream is truncated");
+            }
+            size_t distance = distBase[distSymbol] + TakeBits(distExtra[distSymbol]);
+            if (distance > outputPos_) {
+                return Fail("Distance reaches before the start of the output");
+            }
+
+            unsigned char* to = &output_[outputPos_];
+            const unsigned char* from = to - distance;
+            if (distance >= length) {
+                memcpy(to, from, length);
+            }
+            else {
+                for (size_t i = 0; i < length; i++) {
+                    to[i] = from[i];
+                }
+            }
+            outputPos_ += length;
+        }
+
+        if (outputPos_ >= 2 * (size_t)WINDOW_SIZE && !FlushOutput(false)) {
+            return false;
+        }
+    }
+}
+
+bool Inflater::FlushOutput(bool all) {
+    if (outputPos_ > outputFlushed_) {
+        if (!sink_(&output_[outputFlushed_], outputPos_ - outputFlushed_, sinkData_)) {
+            return Fail("Output was rejected");
+        }
+        totalOut_ += outputPos_ - outputFlushed_;
+        outputFlushed_ = outputPos_;
+    }
+
+    if (!all) {
+        // Keep one window of history for back references
+        memmove(&output_[0], &output_[outputPos_ - WINDOW_SIZE], WINDOW_SIZE);
+        outputPos_ = WINDOW_SIZE;
+        outputFlushed_ = WINDOW_SIZE;
+    }
+    return true;
+}
+
+bool Inflater::Fail(const char* message) {
+    if (error_.empty()) {
+        error_ = message;
+    }
+    return false;
+}
\ No newline at end of file
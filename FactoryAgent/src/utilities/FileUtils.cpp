@@ -1,6 +1,12 @@
 #include "../include/utilities/FileUtils.h"
+#include "../include/utilities/ThreadPool.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <fstream>
-#include <sstream>
+#include <thread>
+#include <vector>
 #include <sys/stat.h>
 
 bool FileUtils::FileExists(const std::string& filePath) {
@@ -17,14 +23,125 @@ bool FileUtils::CreateFolder(const std::string& folderPath) {
     return CreateDirectoryA(folderPath.c_str(), NULL) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
 }
 
+struct DeleteEntry {
+    std::string path;
+    DWORD attributes;
+};
+
+// Files being deleted by another handle's owner stay "delete pending" briefly
+static bool RemoveEntry(const DeleteEntry& entry, bool isDirectory) {
+    if (entry.attributes & FILE_ATTRIBUTE_READONLY) {
+        SetFileAttributesA(entry.path.c_str(), entry.attributes & ~FILE_ATTRIBUTE_READONLY);
+    }
+
+    for (int attempt = 0; ; attempt++) {
+        if (isDirectory ? RemoveDirectoryA(entry.path.c_str()) : DeleteFileA(entry.path.c_str())) {
+            return true;
+        }
+        DWORD error = GetLastError();
+        if (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND) {
+            return true;
+        }
+        if (attempt + 1 >= AgentConstants::DELETE_RETRIES) {
+            return false;
+        }
+        Sleep(AgentConstants::DELETE_RETRY_DELAY_MS);
+    }
+}
+
 bool FileUtils::DeleteFolder(const std::string& folderPath) {
-    if (!FolderExists(folderPath)) {
+    DWORD rootAttributes = GetFileAttributesA(folderPath.c_str());
+    if (rootAttributes == INVALID_FILE_ATTRIBUTES || !(rootAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        return false;
+    }
+
+    // Directories are listed parents first, so removing them in reverse is bottom-up
+    std::vector<DeleteEntry> files;
+    std::vector<DeleteEntry> folders;
+    DeleteEntry root;
+    root.path = folderPath;
+    root.attributes = rootAttributes;
+    folders.push_back(root);
+
+    for (size_t next = 0; next < folders.size(); next++) {
+        if (folders[next].attributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+            continue;
+        }
+
+        WIN32_FIND_DATAA findData;
+        HANDLE hFind = FindFirstFileA((folders[next].path + "\\*").c_str(), &findData);
+        if (hFind == INVALID_HANDLE_VALUE) {
+            continue;
+        }
+        do {
+            if (strcmp(findData.cFileName, ".") == 0 || strcmp(findData.cFileName, "..") == 0) {
+                continue;
+            }
+
+            DeleteEntry entry;
+            entry.path = folders[next].path + "\\" + findData.cFileName;
+            entry.attributes = findData.dwFileAttributes;
+            if (entry.attributes & FILE_ATTRIBUTE_DIRECTORY) {
+                folders.push_back(entry);
+            }
+            else {
+                files.push_back(entry);
+            }
+        } while (FindNextFileA(hFind, &findData));
+        FindClose(hFind);
+    }
+
+    std::atomic<size_t> failed(0);
+    size_t batchSize = AgentConstants::DELETE_BATCH_FILES;
+    if (files.size() > batchSize) {
+        size_t batches = (files.size() + batchSize - 1) / batchSize;
+        ThreadPool pool((std::min)(ThreadPool::GetBackgroundThreadCount(AgentConstants::DELETE_MAX_THREADS), batches), true);
+        for (size_t start = 0; start < files.size(); start += batchSize) {
+            size_t end = (std::min)(start + batchSize, files.size());
+            const std::vector<DeleteEntry>* list = &files;
+            std::atomic<size_t>* failures = &failed;
+            pool.Submit([list, failures, start, end]() {
+                for (size_t i = start; i < end; i++) {
+                    if (!RemoveEntry((*list)[i], false)) {
+                        (*failures)++;
+                    }
+                }
+            });
+        }
+        pool.Wait();
+    }
+    else {
+        for (size_t i = 0; i < files.size(); i++) {
+            if (!RemoveEntry(files[i], false)) {
+                failed++;
+            }
+        }
+    }
+
+    for (size_t i = folders.size(); i-- > 0; ) {
+        RemoveEntry(folders[i], true);
+    }
+    return failed == 0 && !FolderExists(folderPath);
+}
+
+static void DeleteTrashedFolder(std::string trashedPath) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+    FileUtils::DeleteFolder(trashedPath);
+}
+
+bool FileUtils::DeleteFolderInBackground(const std::string& folderPath, const std::string& trashFolder) {
+    static std::atomic<unsigned long long> sequence(0);
+
+    std::string folderName = GetFileName(folderPath);
+    std::string trashedPath = trashFolder + "\\" + folderName + AgentConstants::DELETE_TRASH_SUFFIX +
+        std::to_string(GetTickCount64()) + "-" + std::to_string(++sequence);
+    if (!MoveFileExA(folderPath.c_str(), trashedPath.c_str(), 0)) {
         return false;
     }
 
-    std::string cmd = "powershell.exe -NoProfile -Command \"Remove-Item -Path '" + folderPath + "' -Recurse -Force\"";
-    int result = system(cmd.c_str());
-    return (result == 0);
+    // Detached: a delete cut short by shutdown is left in the trash for the next sweep
+    std::thread(DeleteTrashedFolder, trashedPath).detach();
+    return true;
 }
 
 bool FileUtils::DeleteFile(const std::string& filePath) {
@@ -37,9 +154,18 @@ bool FileUtils::ReadFileContent(const std::string& filePath, std::string& conten
         return false;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    content = buffer.str();
+    // Read straight into the result instead of through a stringstream
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (size < 0) {
+        return false;
+    }
+
+    content.resize((size_t)size);
+    if (size > 0 && !file.read(&content[0], size)) {
+        content.resize((size_t)file.gcount());
+    }
     file.close();
 
     return true;
@@ -57,6 +183,32 @@ bool FileUtils::WriteFileContent(const std::string& filePath, const std::string&
     return true;
 }
 
+bool FileUtils::WriteFileAtomic(const std::string& filePath, const std::string& content) {
+    // Readers see either the old file or the complete new one, never a partial write
+    std::string tempPath = filePath + ".tmp";
+    HANDLE file = CreateFileA(tempPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    bool written = true;
+    size_t total = 0;
+    while (written && total < content.size()) {
+        DWORD chunk = (DWORD)(std::min)(content.size() - total, (size_t)(1 << 30));
+        DWORD bytesWritten = 0;
+        written = WriteFile(file, content.data() + total, chunk, &bytesWritten, NULL) && bytesWritten == chunk;
+        total += bytesWritten;
+    }
+    written = written && FlushFileBuffers(file);
+    CloseHandle(file);
+
+    if (!written || !MoveFileExA(tempPath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        DeleteFileA(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
 std::string FileUtils::GetFileName(const std::string& filePath) {
     size_t pos = filePath.find_last_of("\\/");
     if (pos != std::string::npos) {
@@ -0,0 +1,261 @@
+#include "../include/utilities/IniDocument.h"
+#include "../include/utilities/HashUtils.h"
+
+static bool IsBlank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+IniDocument::IniDocument() {
+}
+
+void IniDocument::Parse(const std::string& text) {
+    text_ = text;
+    entries_.clear();
+    index_.clear();
+    firstIndex_.clear();
+    sections_.clear();
+    sectionIndex_.clear();
+
+    size_t section = (size_t)-1;
+    const char* data = text_.data();
+    size_t size = text_.size();
+    size_t pos = 0;
+
+    // UTF-8 BOM
+    if (size >= 3 && (unsigned char)data[0] == 0xEF && (unsigned char)data[1] == 0xBB && (unsigned char)data[2] == 0xBF) {
+        pos = 3;
+    }
+
+    while (pos < size) {
+        size_t lineEnd = pos;
+        while (lineEnd < size && data[lineEnd] != '\n') {
+            lineEnd++;
+        }
+        size_t next = lineEnd < size ? lineEnd + 1 : lineEnd;
+
+        size_t end = lineEnd;
+        while (end > pos && (data[end - 1] == '\r' || IsBlank(data[end - 1]))) {
+            end--;
+        }
+        size_t begin = pos;
+        while (begin < end && IsBlank(data[begin])) {
+            begin++;
+        }
+
+        if (begin == end || data[begin] == ';' || data[begin] == '#') {
+            pos = next;
+            continue;
+        }
+
+        if (data[begin] == '[') {
+            size_t close = begin + 1;
+            while (close < end && data[close] != ']') {
+                close++;
+            }
+            size_t nameBegin = begin + 1;
+            size_t nameEnd = close;
+            while (nameBegin < nameEnd && IsBlank(data[nameBegin])) {
+                nameBegin++;
+            }
+            while (nameEnd > nameBegin && IsBlank(data[nameEnd - 1])) {
+                nameEnd--;
+            }
+            section = AddSection(Lower(std::string_view(data + nameBegin, nameEnd - nameBegin)));
+            pos = next;
+            continue;
+        }
+
+        size_t equals = begin;
+        while (equals < end && data[equals] != '=') {
+            equals++;
+        }
+        if (equals == end) {
+            pos = next;
+            continue;
+        }
+
+        size_t keyEnd = equals;
+        while (keyEnd > begin && IsBlank(data[keyEnd - 1])) {
+            keyEnd--;
+        }
+        size_t valueBegin = equals + 1;
+        while (valueBegin < end && IsBlank(data[valueBegin])) {
+            valueBegin++;
+        }
+
+        // Keys ahead of the first header belong to the unnamed section
+        if (section == (size_t)-1) {
+            section = AddSection("");
+        }
+
+        Entry entry;
+        entry.keyOffset = begin;
+        entry.keyLength = keyEnd - begin;
+        entry.valueOffset = valueBegin;
+        entry.valueLength = end - valueBegin;
+        entry.section = section;
+        entries_.push_back(entry);
+
+        std::string key = Lower(std::string_view(data + begin, keyEnd - begin));
+        if (index_.insert(std::make_pair(MakeKey(sections_[section].name, key), entries_.size() - 1)).second) {
+            sections_[section].entries.push_back(entries_.size() - 1);
+        }
+        firstIndex_.insert(std::make_pair(key, entries_.size() - 1));
+
+        pos = next;
+    }
+
+    for (size_t i = 0; i < sections_.size(); i++) {
+        sections_[i].hash = HashSection(sections_[i]);
+    }
+}
+
+const std::string& IniDocument::GetText() const {
+    return text_;
+}
+
+bool IniDocument::HasSection(const std::string& section) const {
+    return sectionIndex_.find(Lower(section)) != sectionIndex_.end();
+}
+
+size_t IniDocument::GetSectionCount() const {
+    return sections_.size();
+}
+
+const std::string& IniDocument::GetSectionName(size_t section) const {
+    return sections_[section].name;
+}
+
+uint64_t IniDocument::GetSectionHash(size_t section) const {
+    return sections_[section].hash;
+}
+
+bool IniDocument::FindSection(const std::string& section, size_t& index) const {
+    std::unordered_map<std::string, size_t>::const_iterator it = sectionIndex_.find(Lower(section));
+    if (it == sectionIndex_.end()) {
+        return false;
+    }
+    index = it->second;
+    return true;
+}
+
+size_t IniDocument::GetKeyCount(size_t section) const {
+    return sections_[section].entries.size();
+}
+
+std::string_view IniDocument::GetKey(size_t section, size_t key) const {
+    const Entry& entry = entries_[sections_[section].entries[key]];
+    return std::string_view(text_.data() + entry.keyOffset, entry.keyLength);
+}
+
+std::string_view IniDocument::GetValue(size_t section, size_t key) const {
+    const Entry& entry = entries_[sections_[section].entries[key]];
+    return std::string_view(text_.data() + entry.valueOffset, entry.valueLength);
+}
+
+bool IniDocument::Find(const std::string& section, const std::string& key, std::string_view& value) const {
+    std::unordered_map<std::string, size_t>::const_iterator it = index_.find(MakeKey(Lower(section), Lower(key)));
+    if (it == index_.end()) {
+        return false;
+    }
+    const Entry& entry = entries_[it->second];
+    value = std::string_view(text_.data() + entry.valueOffset, entry.valueLength);
+    return true;
+}
+
+bool IniDocument::FindFirst(const std::string& key, std::string_view& value) const {
+    std::unordered_map<std::string, size_t>::const_iterator it = firstIndex_.find(Lower(key));
+    if (it == firstIndex_.end()) {
+        return false;
+    }
+    const Entry& entry = entries_[it->second];
+    value = std::string_view(text_.data() + entry.valueOffset, entry.valueLength);
+    return true;
+}
+
+bool IniDocument::SetValue(const std::string& section, const std::string& key, const std::string& value) {
+    std::unordered_map<std::string, size_t>::const_iterator it = index_.find(MakeKey(Lower(section), Lower(key)));
+    if (it == index_.end()) {
+        return false;
+    }
+    return Replace(it->second, value);
+}
+
+bool IniDocument::SetFirstValue(const std::string& key, const std::string& value) {
+    std::unordered_map<std::string, size_t>::const_iterator it = firstIndex_.find(Lower(key));
+    if (it == firstIndex_.end()) {
+        return false;
+    }
+    return Replace(it->second, value);
+}
+
+std::string IniDocument::MakeKey(std::string_view section, std::string_view key) {
+    std::string composite;
+    composite.reserve(section.size() + key.size() + 1);
+    composite.append(section.data(), section.size());
+    composite.push_back('\n');
+    composite.append(key.data(), key.size());
+    return composite;
+}
+
+std::string IniDocument::Lower(std::string_view text) {
+    std::string result(text.data(), text.size());
+    for (size_t i = 0; i < result.size(); i++) {
+        if (result[i] >= 'A' && result[i] <= 'Z') {
+            result[i] = (char)(result[i] - 'A' + 'a');
+        }
+    }
+    return result;
+}
+
+size_t IniDocument::AddSection(const std::string& name) {
+    std::unordered_map<std::string, size_t>::iterator it = sectionIndex_.find(name);
+    if (it != sectionIndex_.end()) {
+        return it->second;
+    }
+
+    Section section;
+    section.name = name;
+    section.hash = 0;
+    sections_.push_back(section);
+    sectionIndex_[name] = sections_.size() - 1;
+    return sections_.size() - 1;
+}
+
+uint64_t IniDocument::HashSection(const Section& section) const {
+    // Summing per-key hashes makes the result independent of key order
+    uint64_t hash = 0;
+    for (size_t i = 0; i < section.entries.size(); i++) {
+        const Entry& entry = entries_[section.entries[i]];
+        std::string key = Lower(std::string_view(text_.data() + entry.keyOffset, entry.keyLength));
+        uint64_t keyHash = HashUtils::Xxh64(key.data(), key.size());
+        hash += HashUtils::Xxh64(text_.data() + entry.valueOffset, entry.valueLength, keyHash);
+    }
+    return hash;
+}
+
+bool IniDocument::Replace(size_t entry, const std::string& value) {
+    if (value.find_first_of("\r\n") != std::string::npos) {
+        return false;
+    }
+
+    Entry& target = entries_[entry];
+    if (value.size() == target.valueLength &&
+        text_.compare(target.valueOffset, target.valueLength, value) == 0) {
+        return true;
+    }
+
+    text_.replace(target.valueOffset, target.valueLength, value);
+
+    // Entries are in text order, so only the ones after the edit move
+    size_t oldLength = target.valueLength;
+    target.valueLength = value.size();
+    for (size_t i = entry + 1; i < entries_.size(); i++) {
+        entries_[i].keyOffset = entries_[i].keyOffset + value.size() - oldLength;
+        entries_[i].valueOffset = entries_[i].valueOffset + value.size() - oldLength;
+    }
+
+    Section& section = sections_[target.section];
+    section.hash = HashSection(section);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,548 @@
+#include "../include/utilities/LogRecordScanner.h"
+#include <cstdio>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define SCANNER_HAS_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SCANNER_HAS_SSE2) && defined(_MSC_VER)
+#define SCANNER_HAS_AVX2 1
+#define SCANNER_TARGET_AVX2
+#elif defined(SCANNER_HAS_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define SCANNER_HAS_AVX2 1
+#define SCANNER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+    typedef const char* (*FindDelimiterFn)(const char* begin, const char* end);
+    typedef const char* (*FindByteFn)(const char* begin, const char* end, char value);
+    typedef const char* (*FindSubstringFn)(const char* begin, const char* end, const char* needle, size_t length);
+
+    const char* FindDelimiterScalar(const char* p, const char* end) {
+        while (p < end) {
+            if (*p == '\t' || *p == '\n') {
+                return p;
+            }
+            p++;
+        }
+        return end;
+    }
+
+    const char* FindByteScalar(const char* p, const char* end, char value) {
+        const void* hit = memchr(p, value, end - p);
+        return hit ? (const char*)hit : end;
+    }
+
+    // Needles are at least two bytes long; single bytes go through FindByte
+    const char* FindSubstringScalar(const char* p, const char* end, const char* needle, size_t length) {
+        while (end - p >= (ptrdiff_t)length) {
+            const char* hit = (const char*)memchr(p, needle[0], (end - p) - length + 1);
+            if (hit == NULL) {
+                return end;
+            }
+            if (memcmp(hit + 1, needle + 1, length - 1) == 0) {
+                return hit;
+            }
+            p = hit + 1;
+        }
+        return end;
+    }
+
+#ifdef SCANNER_HAS_SSE2
+    inline unsigned int CountTrailingZeros(unsigned int mask) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (unsigned int)index;
+#else
+        return (unsigned int)__builtin_ctz(mask);
+#endif
+    }
+
+    const char* FindDelimiterSse2(const char* p, const char* end) {
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i newline = _mm_set1_epi8('\n');
+
+        while (end - p >= 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+            __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, tab), _mm_cmpeq_epi8(chunk, newline));
+            unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+            if (mask != 0) {
+                return p + CountTrailingZeros(mask);
+            }
+            p += 16;
+        }
+        return FindDelimiterScalar(p, end);
+    }
+
+    // Compares the first and last needle byte across a block at once and
+    // only verifies the positions where both match
+    const char* FindSubstringSse2(const char* p, const char* end, const char* needle, size_t length) {
+        const __m128i first = _mm_set1_epi8(needle[0]);
+        const __m128i last = _mm_set1_epi8(needle[length - 1]);
+
+        while (end - p >= (ptrdiff_t)(length + 15)) {
+            __m128i blockFirst = _mm_loadu_si128((const __m128i*)p);
+            __m128i blockLast = _mm_loadu_si128((const __m128i*)(p + length - 1));
+            unsigned int mask = (unsigned int)_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+
+            while (mask != 0) {
+                unsigned int bit = CountTrailingZeros(mask);
+                if (memcmp(p + bit + 1, needle + 1, length - 2) == 0) {
+                    return p + bit;
+                }
+                mask &= mask - 1;
+            }
+            p += 16;
+        }
+        return FindSubstringScalar(p, end, needle, length);
+    }
+
+    const char* FindByteSse2(const char* p, const char* end, char value) {
+        const __m128i needle = _mm_set1_epi8(value);
+
+        while (end - p >= 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+            unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+            if (mask != 0) {
+                return p + CountTrailingZeros(mask);
+            }
+            p += 16;
+        }
+        return FindByteScalar(p, end, value);
+    }
+#endif
+
+#ifdef SCANNER_HAS_AVX2
+    SCANNER_TARGET_AVX2
+    const char* FindDelimiterAvx2(const char* p, const char* end) {
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i newline = _mm256_set1_epi8('\n');
+
+        while (end - p >= 32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i*)p);
+            __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, tab), _mm256_cmpeq_epi8(chunk, newline));
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+            if (mask != 0) {
+                return p + CountTrailingZeros(mask);
+            }
+            p += 32;
+        }
+        return FindDelimiterSse2(p, end);
+    }
+
+    SCANNER_TARGET_AVX2
+    const char* FindSubstringAvx2(const char* p, const char* end, const char* needle, size_t length) {
+        const __m256i first = _mm256_set1_epi8(needle[0]);
+        const __m256i last = _mm256_set1_epi8(needle[length - 1]);
+
+        while (end - p >= (ptrdiff_t)(length + 31)) {
+            __m256i blockFirst = _mm256_loadu_si256((const __m256i*)p);
+            __m256i blockLast = _mm256_loadu_si256((const __m256i*)(p + length - 1));
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast)));
+
+            while (mask != 0) {
+                unsigned int bit = CountTrailingZeros(mask);
+                if (memcmp(p + bit + 1, needle + 1, length - 2) == 0) {
+                    return p + bit;
+                }
+                mask &= mask - 1;
+            }
+            p += 32;
+        }
+        return FindSubstringSse2(p, end, needle, length);
+    }
+
+    SCANNER_TARGET_AVX2
+    const char* FindByteAvx2(const char* p, const char* end, char value) {
+        const __m256i needle = _mm256_set1_epi8(value);
+
+        while (end - p >= 32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i*)p);
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+            if (mask != 0) {
+                return p + CountTrailingZeros(mask);
+            }
+            p += 32;
+        }
+        return FindByteSse2(p, end, value);
+    }
+
+    bool CpuSupportsAvx2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+
+        // OSXSAVE and AVX, then make sure the OS saves YMM state
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }
+#endif
+
+    struct ScanDispatch {
+        FindDelimiterFn findDelimiter;
+        FindByteFn findByte;
+        FindSubstringFn findSubstring;
+        const char* level;
+
+        ScanDispatch() {
+            findDelimiter = FindDelimiterScalar;
+            findByte = FindByteScalar;
+            findSubstring = FindSubstringScalar;
+            level = "scalar";
+#ifdef SCANNER_HAS_SSE2
+            findDelimiter = FindDelimiterSse2;
+            findByte = FindByteSse2;
+            findSubstring = FindSubstringSse2;
+            level = "sse2";
+#endif
+#ifdef SCANNER_HAS_AVX2
+            if (CpuSupportsAvx2()) {
+                findDelimiter = FindDelimiterAvx2;
+                findByte = FindByteAvx2;
+                findSubstring = FindSubstringAvx2;
+                level = "avx2";
+            }
+#endif
+        }
+    };
+
+    const ScanDispatch& GetDispatch() {
+        static const ScanDispatch dispatch;
+        return dispatch;
+    }
+
+    inline char LowerAscii(char c) {
+        return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+    }
+
+    inline bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    inline bool IsKeyChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || IsDigit(c) || c == '_';
+    }
+
+    bool KeyEquals(std::string_view key, const char* lowerName, size_t nameLength) {
+        if (key.size() != nameLength) {
+            return false;
+        }
+        for (size_t i = 0; i < nameLength; i++) {
+            if (LowerAscii(key[i]) != lowerName[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Parses an integer or decimal and floors it to whole milliseconds,
+    // matching the server-side analyzer.
+    bool ParseNumber(const char* p, const char* end, long long& value, const char*& next) {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = (*p == '-');
+            p++;
+        }
+        if (p >= end || !IsDigit(*p)) {
+            return false;
+        }
+
+        long long result = 0;
+        while (p < end && IsDigit(*p)) {
+            result = result * 10 + (*p - '0');
+            p++;
+        }
+
+        bool hasFraction = false;
+        if (p < end && *p == '.') {
+            p++;
+            while (p < end && IsDigit(*p)) {
+                if (*p != '0') {
+                    hasFraction = true;
+                }
+                p++;
+            }
+        }
+
+        if (negative) {
+            result = -result;
+            if (hasFraction) {
+                result--;
+            }
+        }
+
+        value = result;
+        next = p;
+        return true;
+    }
+
+    long long DaysFromCivil(long long year, unsigned int month, unsigned int day) {
+        year -= (month <= 2) ? 1 : 0;
+        long long era = (year >= 0 ? year : year - 399) / 400;
+        unsigned int yearOfEra = (unsigned int)(year - era * 400);
+        unsigned int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        unsigned int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + (long long)dayOfEra - 719468;
+    }
+
+    void CivilFromDays(long long days, long long& year, unsigned int& month, unsigned int& day) {
+        days += 719468;
+        long long era = (days >= 0 ? days : days - 146096) / 146097;
+        unsigned int dayOfEra = (unsigned int)(days - era * 146097);
+        unsigned int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        unsigned int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        unsigned int monthIndex = (5 * dayOfYear + 2) / 153;
+        day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+        month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+        year = (long long)yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+    }
+}
+
+LogRecordScanner::LogRecordScanner(const char* data, size_t size, bool acceptUnterminated) {
+    data_ = data;
+    cursor_ = data;
+    end_ = data + size;
+    acceptUnterminated_ = acceptUnterminated;
+}
+
+bool LogRecordScanner::Next(LogRecord& record) {
+    if (cursor_ >= end_) {
+        return false;
+    }
+
+    const ScanDispatch& dispatch = GetDispatch();
+    const char* lineStart = cursor_;
+    const char* fieldStart = cursor_;
+    const char* p = cursor_;
+    size_t fieldCount = 0;
+    const size_t lastField = (size_t)AgentConstants::LOG_FIELD_COUNT - 1;
+
+    // Split on tabs until the payload field, which runs to the end of line
+    while (true) {
+        const char* hit = (fieldCount < lastField)
+            ? dispatch.findDelimiter(p, end_)
+            : dispatch.findByte(p, end_, '\n');
+
+        if (hit == end_) {
+            if (!acceptUnterminated_) {
+                return false;
+            }
+            record.fields[fieldCount++] = std::string_view(fieldStart, hit - fieldStart);
+            p = hit;
+            break;
+        }
+
+        if (*hit == '\t') {
+            record.fields[fieldCount++] = std::string_view(fieldStart, hit - fieldStart);
+            fieldStart = hit + 1;
+            p = hit + 1;
+            continue;
+        }
+
+        record.fields[fieldCount++] = std::string_view(fieldStart, hit - fieldStart);
+        p = hit;
+        break;
+    }
+
+    const char* lineEnd = p;
+    cursor_ = (p < end_) ? p + 1 : p;
+
+    // Tolerate CRLF line endings
+    if (lineEnd > lineStart && *(lineEnd - 1) == '\r') {
+        lineEnd--;
+        std::string_view& last = record.fields[fieldCount - 1];
+        if (!last.empty() && last.back() == '\r') {
+            last.remove_suffix(1);
+        }
+    }
+
+    record.line = std::string_view(lineStart, lineEnd - lineStart);
+    record.fieldCount = fieldCount;
+    record.offset = lineStart - data_;
+    record.length = cursor_ - lineStart;
+    return true;
+}
+
+size_t LogRecordScanner::Position() const {
+    return cursor_ - data_;
+}
+
+bool LogRecordScanner::ParsePayload(std::string_view text, LogPayload& payload) {
+    payload = LogPayload();
+
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    // Keys may be double-quoted, single-quoted or bare and differ in case
+    // ("startTs" / "StartTs"); stray braces from malformed payloads are skipped.
+    while (p < end) {
+        if (!IsKeyChar(*p) || IsDigit(*p)) {
+            p++;
+            continue;
+        }
+
+        const char* keyStart = p;
+        while (p < end && IsKeyChar(*p)) {
+            p++;
+        }
+        std::string_view key(keyStart, p - keyStart);
+
+        while (p < end && (*p == '"' || *p == '\'' || *p == ' ')) {
+            p++;
+        }
+        if (p >= end || *p != ':') {
+            continue;
+        }
+        p++;
+        while (p < end && (*p == '"' || *p == '\'' || *p == ' ')) {
+            p++;
+        }
+
+        long long value = 0;
+        const char* next = p;
+        if (!ParseNumber(p, end, value, next)) {
+            continue;
+        }
+        p = next;
+
+        if (KeyEquals(key, "barrelid", 8)) {
+            payload.barrelId = value;
+            payload.hasBarrelId = true;
+        }
+        else if (KeyEquals(key, "startts", 7)) {
+            payload.startTs = value;
+            payload.hasStartTs = true;
+        }
+        else if (KeyEquals(key, "endts", 5)) {
+            payload.endTs = value;
+            payload.hasEndTs = true;
+        }
+        else if (KeyEquals(key, "idealms", 7) || KeyEquals(key, "idealts", 7)) {
+            payload.idealMs = value;
+            payload.hasIdealMs = true;
+        }
+    }
+
+    return payload.hasBarrelId;
+}
+
+LogEvent LogRecordScanner::ParseEvent(std::string_view field) {
+    while (!field.empty() && field.front() == ' ') {
+        field.remove_prefix(1);
+    }
+    while (!field.empty() && field.back() == ' ') {
+        field.remove_suffix(1);
+    }
+
+    if (KeyEquals(field, "start", 5)) {
+        return LOG_EVENT_START;
+    }
+    if (KeyEquals(field, "end", 3)) {
+        return LOG_EVENT_END;
+    }
+    return LOG_EVENT_NONE;
+}
+
+bool LogRecordScanner::ParseDateTime(std::string_view text, long long& epochMs) {
+    // Accepts "YYYY-MM-DD HH:MM:SS.fff" and the usual separator variants;
+    // the value is a naive (zone-less) millisecond count so it only needs to
+    // be comparable with other values parsed the same way.
+    long long parts[7] = { 0, 1, 1, 0, 0, 0, 0 };
+    int count = 0;
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    while (p < end && count < 7) {
+        if (!IsDigit(*p)) {
+            p++;
+            continue;
+        }
+
+        long long value = 0;
+        int digits = 0;
+        while (p < end && IsDigit(*p)) {
+            if (count < 6 || digits < 3) {
+                value = value * 10 + (*p - '0');
+                digits++;
+            }
+            p++;
+        }
+
+        if (count == 6) {
+            while (digits < 3) {
+                value *= 10;
+                digits++;
+            }
+        }
+        parts[count++] = value;
+    }
+
+    if (count < 3 || parts[0] < 1970 || parts[1] < 1 || parts[1] > 12 || parts[2] < 1 || parts[2] > 31) {
+        return false;
+    }
+
+    long long days = DaysFromCivil(parts[0], (unsigned int)parts[1], (unsigned int)parts[2]);
+    epochMs = ((days * 24 + parts[3]) * 60 + parts[4]) * 60000 + parts[5] * 1000 + parts[6];
+    return true;
+}
+
+std::string LogRecordScanner::FormatDateTime(long long epochMs) {
+    long long days = epochMs >= 0 ? epochMs / 86400000 : (epochMs - 86399999) / 86400000;
+    long long msOfDay = epochMs - days * 86400000;
+
+    long long year = 0;
+    unsigned int month = 0;
+    unsigned int day = 0;
+    CivilFromDays(days, year, month, day);
+
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u %02lld:%02lld:%02lld.%03lld",
+        year, month, day, msOfDay / 3600000, (msOfDay / 60000) % 60, (msOfDay / 1000) % 60, msOfDay % 1000);
+    return buffer;
+}
+
+const char* LogRecordScanner::FindDelimiter(const char* begin, const char* end) {
+    return GetDispatch().findDelimiter(begin, end);
+}
+
+const char* LogRecordScanner::FindByte(const char* begin, const char* end, char value) {
+    return GetDispatch().findByte(begin, end, value);
+}
+
+const char* LogRecordScanner::FindSubstring(const char* begin, const char* end, std::string_view needle) {
+    if (needle.empty()) {
+        return begin;
+    }
+    if (needle.size() == 1) {
+        return GetDispatch().findByte(begin, end, needle[0]);
+    }
+    return GetDispatch().findSubstring(begin, end, needle.data(), needle.size());
+}
+
+const char* LogRecordScanner::GetSimdLevel() {
+    return GetDispatch().level;
+}
\ No newline at end of file
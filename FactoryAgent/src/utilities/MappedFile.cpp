@@ -0,0 +1,78 @@
+#include "../include/utilities/MappedFile.h"
+
+MappedFile::MappedFile() {
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = NULL;
+    data_ = NULL;
+    size_ = 0;
+    isOpen_ = false;
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string& filePath) {
+    Close();
+
+    file_ = CreateFileA(filePath.c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file_, &fileSize)) {
+        Close();
+        return false;
+    }
+
+    // Empty files cannot be mapped; they are simply open with no data
+    if (fileSize.QuadPart > 0) {
+        mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping_ == NULL) {
+            Close();
+            return false;
+        }
+
+        data_ = (const char*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        if (data_ == NULL) {
+            Close();
+            return false;
+        }
+        size_ = (size_t)fileSize.QuadPart;
+    }
+
+    isOpen_ = true;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_ != NULL) {
+        UnmapViewOfFile(data_);
+        data_ = NULL;
+    }
+    if (mapping_ != NULL) {
+        CloseHandle(mapping_);
+        mapping_ = NULL;
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+    size_ = 0;
+    isOpen_ = false;
+}
+
+bool MappedFile::IsOpen() const {
+    return isOpen_;
+}
+
+const char* MappedFile::GetData() const {
+    return data_;
+}
+
+size_t MappedFile::GetSize() const {
+    return size_;
+}
\ No newline at end of file
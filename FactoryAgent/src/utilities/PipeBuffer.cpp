@@ -0,0 +1,103 @@
+#include "../include/utilities/PipeBuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static unsigned long long ElapsedMs(const std::chrono::steady_clock::time_point& since) {
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - since).count();
+}
+
+PipeBuffer::PipeBuffer(size_t capacity) {
+    buffer_.resize((std::max)(capacity, (size_t)1));
+    head_ = 0;
+    size_ = 0;
+    closed_ = false;
+    aborted_ = false;
+    writerWaitMs_ = 0;
+    readerWaitMs_ = 0;
+}
+
+PipeBuffer::~PipeBuffer() {
+}
+
+bool PipeBuffer::Write(const void* data, size_t size) {
+    const unsigned char* input = (const unsigned char*)data;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (size > 0) {
+        if (size_ == buffer_.size() && !aborted_) {
+            std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+            notFull_.wait(lock, [this]() { return aborted_ || size_ < buffer_.size(); });
+            writerWaitMs_ += ElapsedMs(started);
+        }
+        if (aborted_ || closed_) {
+            return false;
+        }
+
+        // Copy into the free space, which may wrap around the end
+        size_t tail = (head_ + size_) % buffer_.size();
+        size_t count = (std::min)(size, buffer_.size() - size_);
+        size_t first = (std::min)(count, buffer_.size() - tail);
+        memcpy(&buffer_[tail], input, first);
+        memcpy(&buffer_[0], input + first, count - first);
+        size_ += count;
+        input += count;
+        size -= count;
+        notEmpty_.notify_one();
+    }
+    return true;
+}
+
+size_t PipeBuffer::Read(void* buffer, size_t capacity) {
+    unsigned char* output = (unsigned char*)buffer;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (size_ == 0 && !closed_ && !aborted_) {
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        notEmpty_.wait(lock, [this]() { return aborted_ || closed_ || size_ > 0; });
+        readerWaitMs_ += ElapsedMs(started);
+    }
+    if (aborted_) {
+        return 0;
+    }
+
+    size_t count = (std::min)(capacity, size_);
+    size_t first = (std::min)(count, buffer_.size() - head_);
+    memcpy(output, &buffer_[head_], first);
+    memcpy(output + first, &buffer_[0], count - first);
+    head_ = (head_ + count) % buffer_.size();
+    size_ -= count;
+    notFull_.notify_one();
+    return count;
+}
+
+void PipeBuffer::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    notEmpty_.notify_all();
+}
+
+void PipeBuffer::Abort() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = true;
+    }
+    notFull_.notify_all();
+    notEmpty_.notify_all();
+}
+
+bool PipeBuffer::IsAborted() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return aborted_;
+}
+
+unsigned long long PipeBuffer::GetWriterWaitMs() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writerWaitMs_;
+}
+
+unsigned long long PipeBuffer::GetReaderWaitMs() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return readerWaitMs_;
+}
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "../include/utilities/SharedEventRing.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    const char RING_MAGIC[4] = { 'F', 'R', 'N', 'G' };
+
+    size_t HeaderSize() {
+        return (sizeof(SharedRingHeader) + 63) & ~(size_t)63;
+    }
+}
+
+static_assert(sizeof(SharedBarrelEvent) == 64, "SharedBarrelEvent is part of the IPC contract");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Ring indexes must be lock-free in shared memory");
+
+SharedEventRing::SharedEventRing() {
+    header_ = NULL;
+    records_ = NULL;
+    mappingSize_ = 0;
+    mask_ = 0;
+    cachedOtherIndex_ = 0;
+    isOwner_ = false;
+#ifdef _WIN32
+    mapping_ = NULL;
+#else
+    fd_ = -1;
+#endif
+}
+
+SharedEventRing::~SharedEventRing() {
+    Close();
+}
+
+size_t SharedEventRing::GetMappingSize(uint32_t capacity) {
+    return HeaderSize() + (size_t)capacity * sizeof(SharedBarrelEvent);
+}
+
+bool SharedEventRing::Create(const std::string& name, uint32_t capacity) {
+    Close();
+
+    uint32_t rounded = 64;
+    while (rounded < capacity && rounded < (1u << 30)) {
+        rounded <<= 1;
+    }
+
+    if (!Map(name, GetMappingSize(rounded), true)) {
+        return false;
+    }
+
+    SharedRingHeader* header = header_;
+    header->version = AgentConstants::SHARED_EVENT_RING_VERSION;
+    header->recordSize = sizeof(SharedBarrelEvent);
+    header->capacity = rounded;
+    header->writeIndex.store(0, std::memory_order_relaxed);
+    header->readIndex.store(0, std::memory_order_relaxed);
+    header->dropped.store(0, std::memory_order_relaxed);
+    header->producerAttached.store(0, std::memory_order_relaxed);
+
+    // Magic last: a producer that sees it sees an initialised header
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, RING_MAGIC, sizeof(RING_MAGIC));
+
+    mask_ = rounded - 1;
+    isOwner_ = true;
+    return true;
+}
+
+bool SharedEventRing::Open(const std::string& name) {
+    Close();
+
+    if (!Map(name, 0, false)) {
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const SharedRingHeader* header = header_;
+    if (memcmp(header->magic, RING_MAGIC, sizeof(RING_MAGIC)) != 0 ||
+        header->version != AgentConstants::SHARED_EVENT_RING_VERSION ||
+        header->recordSize != sizeof(SharedBarrelEvent) ||
+        header->capacity == 0 || (header->capacity & (header->capacity - 1)) != 0 ||
+        GetMappingSize(header->capacity) > mappingSize_) {
+        Close();
+        return false;
+    }
+
+    mask_ = header->capacity - 1;
+    cachedOtherIndex_ = header_->readIndex.load(std::memory_order_acquire);
+    header_->producerAttached.store(1, std::memory_order_release);
+    return true;
+}
+
+void SharedEventRing::Close() {
+    if (header_ != NULL && !isOwner_) {
+        header_->producerAttached.store(0, std::memory_order_release);
+    }
+
+#ifdef _WIN32
+    if (header_ != NULL) {
+        UnmapViewOfFile(header_);
+    }
+    if (mapping_ != NULL) {
+        CloseHandle(mapping_);
+        mapping_ = NULL;
+    }
+#else
+    if (header_ != NULL) {
+        munmap(header_, mappingSize_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    if (isOwner_) {
+        shm_unlink(name_.c_str());
+    }
+#endif
+
+    header_ = NULL;
+    records_ = NULL;
+    mappingSize_ = 0;
+    mask_ = 0;
+    cachedOtherIndex_ = 0;
+    isOwner_ = false;
+    name_.clear();
+}
+
+bool SharedEventRing::IsOpen() const {
+    return header_ != NULL;
+}
+
+bool SharedEventRing::Map(const std::string& name, size_t size, bool create) {
+#ifdef _WIN32
+    if (create) {
+        mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+            (DWORD)((unsigned long long)size >> 32), (DWORD)(size & 0xFFFFFFFF), name.c_str());
+    }
+    else {
+        mapping_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    }
+    if (mapping_ == NULL) {
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, create ? size : 0);
+    if (view == NULL) {
+        CloseHandle(mapping_);
+        mapping_ = NULL;
+        return false;
+    }
+
+    // An existing section is at least as large as the view we can query
+    MEMORY_BASIC_INFORMATION info;
+    if (!create && VirtualQuery(view, &info, sizeof(info)) != 0) {
+        size = info.RegionSize;
+    }
+#else
+    if (create) {
+        // A ring left behind by a crashed agent is replaced, not reused
+        shm_unlink(name.c_str());
+        fd_ = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd_ >= 0 && ftruncate(fd_, (off_t)size) != 0) {
+            close(fd_);
+            fd_ = -1;
+            shm_unlink(name.c_str());
+        }
+    }
+    else {
+        fd_ = shm_open(name.c_str(), O_RDWR, 0);
+        struct stat info;
+        if (fd_ >= 0 && fstat(fd_, &info) == 0) {
+            size = (size_t)info.st_size;
+        }
+    }
+    if (fd_ < 0 || size < sizeof(SharedRingHeader)) {
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+        return false;
+    }
+
+    void* view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (view == MAP_FAILED) {
+        close(fd_);
+        fd_ = -1;
+        if (create) {
+            shm_unlink(name.c_str());
+        }
+        return false;
+    }
+#endif
+
+    header_ = (SharedRingHeader*)view;
+    records_ = (SharedBarrelEvent*)((char*)view + HeaderSize());
+    mappingSize_ = size;
+    name_ = name;
+    return true;
+}
+
+bool SharedEventRing::TryPush(const SharedBarrelEvent& event) {
+    uint64_t write = header_->writeIndex.load(std::memory_order_relaxed);
+
+    // Only re-read the consumer's index when the cached one says full
+    if (write - cachedOtherIndex_ >= header_->capacity) {
+        cachedOtherIndex_ = header_->readIndex.load(std::memory_order_acquire);
+        if (write - cachedOtherIndex_ >= header_->capacity) {
+            header_->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    records_[write & mask_] = event;
+    header_->writeIndex.store(write + 1, std::memory_order_release);
+    return true;
+}
+
+size_t SharedEventRing::Peek(const SharedBarrelEvent*& records, size_t maxCount) {
+    uint64_t read = header_->readIndex.load(std::memory_order_relaxed);
+    if (cachedOtherIndex_ <= read) {
+        cachedOtherIndex_ = header_->writeIndex.load(std::memory_order_acquire);
+    }
+
+    uint64_t available = cachedOtherIndex_ - read;
+    if (available == 0) {
+        return 0;
+    }
+
+    // Stop at the physical end of the ring; the rest comes on the next call
+    uint64_t slot = read & mask_;
+    uint64_t contiguous = (std::min)(available, (uint64_t)header_->capacity - slot);
+    records = &records_[slot];
+    return (size_t)(std::min)(contiguous, (uint64_t)maxCount);
+}
+
+void SharedEventRing::Release(size_t count) {
+    uint64_t read = header_->readIndex.load(std::memory_order_relaxed);
+    header_->readIndex.store(read + count, std::memory_order_release);
+}
+
+uint64_t SharedEventRing::GetDropped() const {
+    return header_ ? header_->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+bool SharedEventRing::IsProducerAttached() const {
+    return header_ != NULL && header_->producerAttached.load(std::memory_order_acquire) != 0;
+}
\ No newline at end of file
@@ -71,4 +71,36 @@ std::string StringUtils::Replace(const std::string& str, const std::string& from
     }
 
     return result;
+}
+
+bool StringUtils::WildcardMatch(const std::string& str, const std::string& pattern) {
+    // Case-insensitive '*' / '?' match with single-star backtracking
+    size_t s = 0;
+    size_t p = 0;
+    size_t starPos = std::string::npos;
+    size_t matchPos = 0;
+
+    while (s < str.length()) {
+        if (p < pattern.length() && (pattern[p] == '?' ||
+            std::tolower(static_cast<unsigned char>(pattern[p])) == std::tolower(static_cast<unsigned char>(str[s])))) {
+            s++;
+            p++;
+        }
+        else if (p < pattern.length() && pattern[p] == '*') {
+            starPos = p++;
+            matchPos = s;
+        }
+        else if (starPos != std::string::npos) {
+            p = starPos + 1;
+            s = ++matchPos;
+        }
+        else {
+            return false;
+        }
+    }
+
+    while (p < pattern.length() && pattern[p] == '*') {
+        p++;
+    }
+    return p == pattern.length();
 }
\ No newline at end of file
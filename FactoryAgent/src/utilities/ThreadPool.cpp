@@ -0,0 +1,95 @@
+#include "../include/utilities/ThreadPool.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+ThreadPool::ThreadPool(size_t threadCount, bool lowPriority) {
+    activeCount_ = 0;
+    stopping_ = false;
+    lowPriority_ = lowPriority;
+
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    for (size_t i = 0; i < threadCount; i++) {
+        workers_.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    taskAvailable_.notify_all();
+
+    for (size_t i = 0; i < workers_.size(); i++) {
+        if (workers_[i].joinable()) {
+            workers_[i].join();
+        }
+    }
+}
+
+void ThreadPool::Submit(const std::function<void()>& task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push(task);
+    }
+    taskAvailable_.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return tasks_.empty() && activeCount_ == 0; });
+}
+
+size_t ThreadPool::GetThreadCount() const {
+    return workers_.size();
+}
+
+size_t ThreadPool::GetBackgroundThreadCount(size_t maxThreads) {
+    size_t cores = std::thread::hardware_concurrency();
+    size_t count = (cores > 1) ? cores / 2 : 1;
+    if (maxThreads > 0 && count > maxThreads) {
+        count = maxThreads;
+    }
+    return count;
+}
+
+void ThreadPool::WorkerLoop() {
+#ifdef _WIN32
+    if (lowPriority_) {
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+    }
+#endif
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            taskAvailable_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = tasks_.front();
+            tasks_.pop();
+            activeCount_++;
+        }
+
+        // A failing task must not take the worker down with it
+        try {
+            task();
+        }
+        catch (...) {
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            activeCount_--;
+            if (tasks_.empty() && activeCount_ == 0) {
+                idle_.notify_all();
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,1885 @@
+#include "../include/utilities/ZipArchive.h"
+#include "../include/utilities/HashUtils.h"
+#include "../include/utilities/ThreadPool.h"
+#include "../include/common/Constants.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <map>
+#include <set>
+
+namespace fs = std::filesystem;
+
+static const uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+static const uint32_t DATA_DESCRIPTOR_SIGNATURE = 0x08074b50;
+static const uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+static const uint32_t END_SIGNATURE = 0x06054b50;
+static const uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+static const uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+
+static const size_t LOCAL_HEADER_SIZE = 30;
+static const size_t CENTRAL_HEADER_SIZE = 46;
+static const size_t END_SIZE = 22;
+static const size_t ZIP64_END_SIZE = 56;
+static const size_t ZIP64_LOCATOR_SIZE = 20;
+static const size_t MAX_COMMENT_SIZE = 0xFFFF;
+
+static const uint16_t ZIP64_EXTRA_ID = 0x0001;
+static const uint16_t FLAG_ENCRYPTED = 0x0001;
+static const uint16_t FLAG_DATA_DESCRIPTOR = 0x0008;
+static const uint16_t METHOD_STORED = 0;
+static const uint16_t METHOD_DEFLATED = 8;
+static const uint16_t VERSION_DEFAULT = 20;
+static const uint16_t VERSION_ZIP64 = 45;
+static const uint32_t ATTRIBUTE_DIRECTORY = 0x10;
+
+// Sizes above this get ZIP64 local headers, leaving room for deflate overhead
+static const uint64_t ZIP64_SIZE_THRESHOLD = 0xFF000000ULL;
+static const uint64_t ZIP32_LIMIT = 0xFFFFFFFFULL;
+
+static void Put16(std::string& out, uint16_t value) {
+    out.push_back((char)(value & 0xFF));
+    out.push_back((char)(value >> 8));
+}
+
+static void Put32(std::string& out, uint32_t value) {
+    Put16(out, (uint16_t)(value & 0xFFFF));
+    Put16(out, (uint16_t)(value >> 16));
+}
+
+static void Put64(std::string& out, uint64_t value) {
+    Put32(out, (uint32_t)(value & 0xFFFFFFFF));
+    Put32(out, (uint32_t)(value >> 32));
+}
+
+static uint16_t Get16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t Get32(const unsigned char* p) {
+    return (uint32_t)Get16(p) | ((uint32_t)Get16(p + 2) << 16);
+}
+
+static uint64_t Get64(const unsigned char* p) {
+    return (uint64_t)Get32(p) | ((uint64_t)Get32(p + 4) << 32);
+}
+
+// C++17 has no clock_cast, so file times go through the offset between the clocks
+static uint32_t ToDosDateTime(const fs::file_time_type& fileTime) {
+    std::chrono::system_clock::time_point systemTime =
+        std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+            fileTime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+    time_t seconds = std::chrono::system_clock::to_time_t(systemTime);
+
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+
+    if (local.tm_year < 80) {
+        return (1 << 21) | (1 << 16);    // 1980-01-01, the earliest DOS date
+    }
+    uint32_t date = ((local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday;
+    uint32_t time = (local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2);
+    return (date << 16) | time;
+}
+
+static fs::file_time_type FromDosDateTime(uint32_t dosDateTime) {
+    struct tm local;
+    memset(&local, 0, sizeof(local));
+    local.tm_year = (int)((dosDateTime >> 25) & 0x7F) + 80;
+    local.tm_mon = (int)((dosDateTime >> 21) & 0x0F) - 1;
+    local.tm_mday = (int)((dosDateTime >> 16) & 0x1F);
+    local.tm_hour = (int)((dosDateTime >> 11) & 0x1F);
+    local.tm_min = (int)((dosDateTime >> 5) & 0x3F);
+    local.tm_sec = (int)(dosDateTime & 0x1F) * 2;
+    local.tm_isdst = -1;
+
+    std::chrono::system_clock::time_point systemTime = std::chrono::system_clock::from_time_t(mktime(&local));
+    return std::chrono::time_point_cast<fs::file_time_type::duration>(
+        systemTime - std::chrono::system_clock::now() + fs::file_time_type::clock::now());
+}
+
+static std::string NormalizeEntryName(const std::string& name) {
+    std::string normalized = name;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    return normalized;
+}
+
+static bool AppendToVector(const unsigned char* data, size_t size, void* userData) {
+    std::vector<unsigned char>* out = (std::vector<unsigned char>*)userData;
+    out->insert(out->end(), data, data + size);
+    return true;
+}
+
+ZipWriter::ZipWriter() {
+    isOpen_ = false;
+    sink_ = NULL;
+    sinkData_ = NULL;
+    offset_ = 0;
+    pool_ = NULL;
+    maxPending_ = 0;
+    progress_ = NULL;
+    progressData_ = NULL;
+    bytesDone_ = 0;
+    bytesTotal_ = 0;
+}
+
+ZipWriter::~ZipWriter() {
+    if (isOpen_) {
+        Abort();
+    }
+
+    // Joins the workers, which still reference this writer
+    delete pool_;
+}
+
+bool ZipWriter::Open(const std::string& zipPath) {
+    if (isOpen_) {
+        Abort();
+    }
+    Reset();
+    path_ = zipPath;
+
+    file_.open(zipPath, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        return Fail("Cannot create " + zipPath);
+    }
+    isOpen_ = true;
+    return true;
+}
+
+bool ZipWriter::Open(DeflateSink sink, void* userData) {
+    if (isOpen_) {
+        Abort();
+    }
+    Reset();
+    sink_ = sink;
+    sinkData_ = userData;
+    isOpen_ = true;
+    return true;
+}
+
+void ZipWriter::Reset() {
+    path_.clear();
+    sink_ = NULL;
+    sinkData_ = NULL;
+    entries_.clear();
+    offset_ = 0;
+    error_.clear();
+    bytesDone_ = 0;
+    buffer_.resize(AgentConstants::ZIP_IO_BUFFER_SIZE);
+}
+
+unsigned long long ZipWriter::GetBytesWritten() const {
+    return offset_;
+}
+
+void ZipWriter::SetProgress(ZipProgressCallback callback, void* userData, unsigned long long bytesTotal) {
+    progress_ = callback;
+    progressData_ = userData;
+    bytesTotal_ = bytesTotal;
+}
+
+void ZipWriter::SetThreads(size_t threads) {
+    DrainPending(0);
+    delete pool_;
+    pool_ = NULL;
+    maxPending_ = 0;
+
+    threads = (std::min)(threads, (size_t)AgentConstants::ZIP_MAX_THREADS);
+    if (threads > 1) {
+        pool_ = new ThreadPool(threads, true);
+        maxPending_ = threads * AgentConstants::ZIP_PENDING_CHUNKS_PER_THREAD;
+    }
+}
+
+bool ZipWriter::AddFile(const std::string& filePath, const std::string& entryName, int level) {
+    if (!isOpen_) {
+        return Fail("Archive is not open");
+    }
+
+    std::ifstream input(filePath, std::ios::binary);
+    if (!input.is_open()) {
+        return Fail("Cannot open " + filePath);
+    }
+
+    std::error_code ec;
+    uint64_t expectedSize = fs::file_size(filePath, ec);
+    fs::file_time_type modified = fs::last_write_time(filePath, ec);
+
+    std::shared_ptr<PendingFile> file(new PendingFile());
+    ZipEntry& entry = file->entry;
+    entry.name = NormalizeEntryName(entryName);
+    entry.flags = FLAG_DATA_DESCRIPTOR;
+    entry.dosDateTime = ec ? ToDosDateTime(fs::file_time_type::clock::now()) : ToDosDateTime(modified);
+    file->zip64 = expectedSize >= ZIP64_SIZE_THRESHOLD;
+    file->dataStart = 0;
+
+    if (pool_ != NULL) {
+        return AddFileParallel(input, file, level);
+    }
+
+    // The first block decides how the file is compressed
+    input.read((char*)buffer_.data(), buffer_.size());
+    size_t got = (size_t)input.gcount();
+    level = ChooseLevel(entry.name, buffer_.data(), (std::min)(got, (size_t)AgentConstants::ZIP_ADAPTIVE_SAMPLE_SIZE), level);
+    entry.method = level > 0 ? METHOD_DEFLATED : METHOD_STORED;
+    entry.localHeaderOffset = offset_;
+
+    if (!WriteLocalHeader(entry, file->zip64)) {
+        return false;
+    }
+    file->dataStart = offset_;
+
+    if (entry.method == METHOD_DEFLATED) {
+        deflater_.Reset(level, DeflateToOutput, this);
+    }
+
+    uint32_t crc = 0;
+    uint64_t totalRead = 0;
+    while (got > 0) {
+        crc = HashUtils::Crc32(crc, buffer_.data(), got);
+        totalRead += got;
+        bool written = entry.method == METHOD_DEFLATED ? deflater_.Write(buffer_.data(), got) : Emit(buffer_.data(), got);
+        if (!written) {
+            return Fail("Failed writing " + entry.name);
+        }
+
+        bytesDone_ += got;
+        if (progress_ != NULL && !progress_(entry.name, bytesDone_, bytesTotal_, progressData_)) {
+            return Fail("Cancelled");
+        }
+
+        if (!input) {
+            break;
+        }
+        input.read((char*)buffer_.data(), buffer_.size());
+        got = (size_t)input.gcount();
+    }
+    if (input.bad()) {
+        return Fail("Failed reading " + filePath);
+    }
+    if (entry.method == METHOD_DEFLATED && !deflater_.Finish()) {
+        return Fail("Failed writing " + entry.name);
+    }
+
+    entry.crc32 = crc;
+    entry.uncompressedSize = totalRead;
+    entry.compressedSize = offset_ - file->dataStart;
+    if (!file->zip64 && (entry.uncompressedSize >= ZIP32_LIMIT || entry.compressedSize >= ZIP32_LIMIT)) {
+        return Fail(entry.name + " grew while it was being archived");
+    }
+    if (!WriteDataDescriptor(entry, file->zip64)) {
+        return false;
+    }
+
+    entries_.push_back(entry);
+    return true;
+}
+
+bool ZipWriter::AddFileParallel(std::ifstream& input, const std::shared_ptr<PendingFile>& file, int level) {
+    ZipEntry& entry = file->entry;
+    std::vector<unsigned char> previous;
+    uint32_t crc = 0;
+    uint64_t totalRead = 0;
+    bool first = true;
+
+    while (true) {
+        std::shared_ptr<PendingChunk> chunk(new PendingChunk());
+        chunk->input.resize(AgentConstants::ZIP_PARALLEL_CHUNK_SIZE);
+        input.read((char*)chunk->input.data(), chunk->input.size());
+        size_t got = (size_t)input.gcount();
+        if (input.bad()) {
+            return Fail("Failed reading " + entry.name);
+        }
+        chunk->input.resize(got);
+
+        bool last = got < AgentConstants::ZIP_PARALLEL_CHUNK_SIZE || input.peek() == std::ifstream::traits_type::eof();
+        if (first) {
+            level = ChooseLevel(entry.name, chunk->input.data(),
+                (std::min)(got, (size_t)AgentConstants::ZIP_ADAPTIVE_SAMPLE_SIZE), level);
+            entry.method = level > 0 ? METHOD_DEFLATED : METHOD_STORED;
+        }
+
+        crc = HashUtils::Crc32(crc, chunk->input.data(), got);
+        totalRead += got;
+        if (last) {
+            entry.crc32 = crc;
+            entry.uncompressedSize = totalRead;
+        }
+
+        chunk->file = file;
+        chunk->first = first;
+        chunk->last = last;
+        chunk->level = level;
+        chunk->done = false;
+        chunk->failed = false;
+
+        // Each chunk sees the window the sequential deflater would have had
+        if (level > 0) {
+            chunk->dictionary.swap(previous);
+            size_t tail = (std::min)(got, (size_t)32768);
+            previous.assign(chunk->input.end() - tail, chunk->input.end());
+        }
+
+        if (!QueueChunk(chunk)) {
+            return false;
+        }
+
+        bytesDone_ += got;
+        if (progress_ != NULL && !progress_(entry.name, bytesDone_, bytesTotal_, progressData_)) {
+            return Fail("Cancelled");
+        }
+
+        if (last) {
+            return true;
+        }
+        first = false;
+    }
+}
+
+bool ZipWriter::AddDirectory(const std::string& entryName) {
+    if (!isOpen_) {
+        return Fail("Archive is not open");
+    }
+    if (!DrainPending(0)) {
+        return false;
+    }
+
+    ZipEntry entry;
+    entry.name = NormalizeEntryName(entryName);
+    if (entry.name.empty() || entry.name.back() != '/') {
+        entry.name += '/';
+    }
+    entry.method = METHOD_STORED;
+    entry.dosDateTime = ToDosDateTime(fs::file_time_type::clock::now());
+    entry.localHeaderOffset = offset_;
+    entry.isDirectory = true;
+
+    if (!WriteLocalHeader(entry, false)) {
+        return false;
+    }
+    entries_.push_back(entry);
+    return true;
+}
+
+bool ZipWriter::Close() {
+    if (!isOpen_) {
+        return Fail("Archive is not open");
+    }
+
+    if (!DrainPending(0) || !WriteCentralDirectory()) {
+        Abort();
+        return false;
+    }
+
+    isOpen_ = false;
+    if (sink_ != NULL) {
+        return true;
+    }
+
+    file_.close();
+    if (file_.fail()) {
+        Fail("Failed to close " + path_);
+        std::error_code ec;
+        fs::remove(path_, ec);
+        return false;
+    }
+    return true;
+}
+
+void ZipWriter::Abort() {
+    DiscardPending();
+    isOpen_ = false;
+    if (file_.is_open()) {
+        file_.close();
+    }
+    file_.clear();
+
+    if (!path_.empty()) {
+        std::error_code ec;
+        fs::remove(path_, ec);
+    }
+    entries_.clear();
+}
+
+int ZipWriter::ChooseLevel(const std::string& entryName, const unsigned char* sample, size_t sampleSize, int level) {
+    if (level == 0) {
+        return 0;
+    }
+
+    std::string extension;
+    size_t dot = entryName.find_last_of("./");
+    if (dot != std::string::npos && entryName[dot] == '.') {
+        extension = entryName.substr(dot);
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    }
+    for (size_t i = 0; i < sizeof(AgentConstants::ZIP_STORED_EXTENSIONS) / sizeof(AgentConstants::ZIP_STORED_EXTENSIONS[0]); i++) {
+        if (extension == AgentConstants::ZIP_STORED_EXTENSIONS[i]) {
+            return 0;
+        }
+    }
+
+    if (level != AgentConstants::ZIP_LEVEL_ADAPTIVE) {
+        return (std::max)(1, (std::min)(9, level));
+    }
+    if (sampleSize < AgentConstants::ZIP_ADAPTIVE_MIN_FILE_SIZE) {
+        return AgentConstants::ZIP_COMPRESSION_LEVEL;
+    }
+
+    // A fast pass over the sample shows how much the data can shrink
+    std::vector<unsigned char> compressed;
+    compressed.reserve(sampleSize + 64);
+    Deflater probe;
+    probe.Reset(1, AppendToVector, &compressed);
+    probe.Write(sample, sampleSize);
+    probe.Finish();
+
+    double ratio = (double)compressed.size() / (double)sampleSize;
+    if (ratio >= AgentConstants::ZIP_ADAPTIVE_STORE_RATIO) {
+        return 0;
+    }
+    if (ratio >= AgentConstants::ZIP_ADAPTIVE_FAST_RATIO) {
+        return 1;
+    }
+    return AgentConstants::ZIP_COMPRESSION_LEVEL;
+}
+
+const std::string& ZipWriter::GetError() const {
+    return error_;
+}
+
+bool ZipWriter::Emit(const void* data, size_t size) {
+    if (sink_ != NULL) {
+        if (!sink_((const unsigned char*)data, size, sinkData_)) {
+            return Fail("Archive output was closed");
+        }
+    }
+    else {
+        file_.write((const char*)data, size);
+        if (!file_) {
+            return Fail("Failed writing " + path_);
+        }
+    }
+    offset_ += size;
+    return true;
+}
+
+bool ZipWriter::WriteLocalHeader(const ZipEntry& entry, bool zip64) {
+    // Sizes and CRC follow the data in a descriptor, so they are zero here
+    std::string header;
+    Put32(header, LOCAL_HEADER_SIGNATURE);
+    Put16(header, zip64 ? VERSION_ZIP64 : VERSION_DEFAULT);
+    Put16(header, entry.flags);
+    Put16(header, entry.method);
+    Put16(header, (uint16_t)(entry.dosDateTime & 0xFFFF));
+    Put16(header, (uint16_t)(entry.dosDateTime >> 16));
+    Put32(header, 0);
+    Put32(header, zip64 ? 0xFFFFFFFF : 0);
+    Put32(header, zip64 ? 0xFFFFFFFF : 0);
+    Put16(header, (uint16_t)entry.name.size());
+    Put16(header, zip64 ? 20 : 0);
+    header += entry.name;
+    if (zip64) {
+        Put16(header, ZIP64_EXTRA_ID);
+        Put16(header, 16);
+        Put64(header, 0);
+        Put64(header, 0);
+    }
+    return Emit(header.data(), header.size());
+}
+
+bool ZipWriter::WriteDataDescriptor(const ZipEntry& entry, bool zip64) {
+    std::string descriptor;
+    Put32(descriptor, DATA_DESCRIPTOR_SIGNATURE);
+    Put32(descriptor, entry.crc32);
+    if (zip64) {
+        Put64(descriptor, entry.compressedSize);
+        Put64(descriptor, entry.uncompressedSize);
+    }
+    else {
+        Put32(descriptor, (uint32_t)entry.compressedSize);
+        Put32(descriptor, (uint32_t)entry.uncompressedSize);
+    }
+    return Emit(descriptor.data(), descriptor.size());
+}
+
+bool ZipWriter::WriteCentralDirectory() {
+    uint64_t directoryOffset = offset_;
+
+    std::string directory;
+    for (size_t i = 0; i < entries_.size(); i++) {
+        const ZipEntry& entry = entries_[i];
+
+        std::string extra;
+        if (entry.uncompressedSize >= ZIP32_LIMIT) {
+            Put64(extra, entry.uncompressedSize);
+        }
+        if (entry.compressedSize >= ZIP32_LIMIT) {
+            Put64(extra, entry.compressedSize);
+        }
+        if (entry.localHeaderOffset >= ZIP32_LIMIT) {
+            Put64(extra, entry.localHeaderOffset);
+        }
+        bool zip64 = !extra.empty() || entry.uncompressedSize >= ZIP64_SIZE_THRESHOLD;
+
+        Put32(directory, CENTRAL_HEADER_SIGNATURE);
+        Put16(directory, VERSION_ZIP64);
+        Put16(directory, zip64 ? VERSION_ZIP64 : VERSION_DEFAULT);
+        Put16(directory, entry.flags);
+        Put16(directory, entry.method);
+        Put16(directory, (uint16_t)(entry.dosDateTime & 0xFFFF));
+        Put16(directory, (uint16_t)(entry.dosDateTime >> 16));
+        Put32(directory, entry.crc32);
+        Put32(directory, (uint32_t)(std::min)(entry.compressedSize, ZIP32_LIMIT));
+        Put32(directory, (uint32_t)(std::min)(entry.uncompressedSize, ZIP32_LIMIT));
+        Put16(directory, (uint16_t)entry.name.size());
+        Put16(directory, (uint16_t)(extra.empty() ? 0 : extra.size() + 4));
+        Put16(directory, 0);
+        Put16(directory, 0);
+        Put16(directory, 0);
+        Put32(directory, entry.isDirectory ? ATTRIBUTE_DIRECTORY : 0);
+        Put32(directory, (uint32_t)(std::min)(entry.localHeaderOffset, ZIP32_LIMIT));
+        directory += entry.name;
+        if (!extra.empty()) {
+            Put16(directory, ZIP64_EXTRA_ID);
+            Put16(directory, (uint16_t)extra.size());
+            directory += extra;
+        }
+
+        if (directory.size() >= AgentConstants::ZIP_IO_BUFFER_SIZE) {
+            if (!Emit(directory.data(), directory.size())) {
+                return false;
+            }
+            directory.clear();
+        }
+    }
+    if (!Emit(directory.data(), directory.size())) {
+        return false;
+    }
+
+    uint64_t directorySize = offset_ - directoryOffset;
+    uint64_t entryCount = entries_.size();
+
+    std::string end;
+    if (entryCount >= 0xFFFF || directorySize >= ZIP32_LIMIT || directoryOffset >= ZIP32_LIMIT) {
+        uint64_t zip64EndOffset = offset_;
+        Put32(end, ZIP64_END_SIGNATURE);
+        Put64(end, ZIP64_END_SIZE - 12);
+        Put16(end, VERSION_ZIP64);
+        Put16(end, VERSION_ZIP64);
+        Put32(end, 0);
+        Put32(end, 0);
+        Put64(end, entryCount);
+        Put64(end, entryCount);
+        Put64(end, directorySize);
+        Put64(end, directoryOffset);
+
+        Put32(end, ZIP64_LOCATOR_SIGNATURE);
+        Put32(end, 0);
+        Put64(end, zip64EndOffset);
+        Put32(end, 1);
+    }
+
+    Put32(end, END_SIGNATURE);
+    Put16(end, 0);
+    Put16(end, 0);
+    Put16(end, (uint16_t)(std::min)(entryCount, (uint64_t)0xFFFF));
+    Put16(end, (uint16_t)(std::min)(entryCount, (uint64_t)0xFFFF));
+    Put32(end, (uint32_t)(std::min)(directorySize, ZIP32_LIMIT));
+    Put32(end, (uint32_t)(std::min)(directoryOffset, ZIP32_LIMIT));
+    Put16(end, 0);
+    if (!Emit(end.data(), end.size())) {
+        return false;
+    }
+
+    if (sink_ != NULL) {
+        return true;
+    }
+    file_.flush();
+    return file_.good() || Fail("Failed writing " + path_);
+}
+
+bool ZipWriter::Fail(const std::string& message) {
+    if (error_.empty()) {
+        error_ = message;
+    }
+    return false;
+}
+
+bool ZipWriter::QueueChunk(const std::shared_ptr<PendingChunk>& chunk) {
+    // Bounded: wait for the oldest chunk before taking on another
+    if (!DrainPending(maxPending_ - 1)) {
+        return false;
+    }
+
+    if (chunk->level == 0) {
+        chunk->output.swap(chunk->input);
+        chunk->done = true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending_.push_back(chunk);
+    }
+
+    if (chunk->level > 0) {
+        pool_->Submit([this, chunk]() {
+            CompressChunk(*chunk);
+            std::lock_guard<std::mutex> lock(pendingMutex_);
+            chunk->done = true;
+            chunkDone_.notify_all();
+        });
+    }
+    return true;
+}
+
+bool ZipWriter::DrainPending(size_t keep) {
+    std::unique_lock<std::mutex> lock(pendingMutex_);
+    while (!pending_.empty()) {
+        if (!pending_.front()->done) {
+            if (pending_.size() <= keep) {
+                break;
+            }
+            chunkDone_.wait(lock, [this]() { return pending_.front()->done; });
+        }
+
+        std::shared_ptr<PendingChunk> chunk = pending_.front();
+        pending_.pop_front();
+        lock.unlock();
+        bool written = WriteChunk(*chunk);
+        lock.lock();
+
+        if (!written) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ZipWriter::WriteChunk(PendingChunk& chunk) {
+    PendingFile& file = *chunk.file;
+    if (chunk.failed) {
+        return Fail("Failed compressing " + file.entry.name);
+    }
+
+    if (chunk.first) {
+        file.entry.localHeaderOffset = offset_;
+        if (!WriteLocalHeader(file.entry, file.zip64)) {
+            return false;
+        }
+        file.dataStart = offset_;
+    }
+
+    if (!Emit(chunk.output.data(), chunk.output.size())) {
+        return false;
+    }
+
+    if (chunk.last) {
+        file.entry.compressedSize = offset_ - file.dataStart;
+        if (!file.zip64 && (file.entry.uncompressedSize >= ZIP32_LIMIT || file.entry.compressedSize >= ZIP32_LIMIT)) {
+            return Fail(file.entry.name + " grew while it was being archived");
+        }
+        if (!WriteDataDescriptor(file.entry, file.zip64)) {
+            return false;
+        }
+        entries_.push_back(file.entry);
+    }
+    return true;
+}
+
+void ZipWriter::DiscardPending() {
+    // Workers hold their own references, so queued chunks can simply be dropped
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    pending_.clear();
+}
+
+void ZipWriter::CompressChunk(PendingChunk& chunk) {
+    try {
+        Deflater deflater;
+        chunk.output.reserve(chunk.input.size() / 2);
+        deflater.Reset(chunk.level, AppendToVector, &chunk.output);
+        if (!chunk.dictionary.empty()) {
+            deflater.SetDictionary(chunk.dictionary.data(), chunk.dictionary.size());
+        }
+
+        bool ok = deflater.Write(chunk.input.data(), chunk.input.size()) &&
+            (chunk.last ? deflater.Finish() : deflater.Flush());
+        chunk.failed = !ok;
+    }
+    catch (...) {
+        chunk.failed = true;
+    }
+
+    std::vector<unsigned char>().swap(chunk.input);
+    std::vector<unsigned char>().swap(chunk.dictionary);
+}
+
+bool ZipWriter::DeflateToOutput(const unsigned char* data, size_t size, void* userData) {
+    return ((ZipWriter*)userData)->Emit(data, size);
+}
+
+ZipReader::ZipReader() {
+    fileSize_ = 0;
+    threads_ = 1;
+    progress_ = NULL;
+    progressData_ = NULL;
+    bytesDone_ = 0;
+    bytesTotal_ = 0;
+    cancelled_ = false;
+
+    stream_.reader = this;
+    stream_.file = &file_;
+    stream_.entry = NULL;
+    stream_.remaining = 0;
+    stream_.produced = 0;
+    stream_.crc = 0;
+    stream_.sink = NULL;
+    stream_.sinkData = NULL;
+}
+
+ZipReader::~ZipReader() {
+    Close();
+}
+
+bool ZipReader::Open(const std::string& zipPath) {
+    Close();
+    error_.clear();
+
+    std::error_code ec;
+    fileSize_ = fs::file_size(zipPath, ec);
+    if (ec) {
+        return Fail("Cannot open " + zipPath);
+    }
+
+    file_.open(zipPath, std::ios::binary);
+    if (!file_.is_open()) {
+        return Fail("Cannot open " + zipPath);
+    }
+    path_ = zipPath;
+
+    stream_.buffer.resize(AgentConstants::ZIP_IO_BUFFER_SIZE);
+    if (!ReadCentralDirectory()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void ZipReader::Close() {
+    if (file_.is_open()) {
+        file_.close();
+    }
+    file_.clear();
+    entries_.clear();
+    path_.clear();
+    fileSize_ = 0;
+}
+
+void ZipReader::SetProgress(ZipProgressCallback callback, void* userData) {
+    progress_ = callback;
+    progressData_ = userData;
+}
+
+void ZipReader::SetThreads(size_t threads) {
+    threads_ = (std::max)((size_t)1, (std::min)(threads, (size_t)AgentConstants::ZIP_MAX_THREADS));
+}
+
+size_t ZipReader::GetEntryCount() const {
+    return entries_.size();
+}
+
+const ZipEntry& ZipReader::GetEntry(size_t index) const {
+    return entries_[index];
+}
+
+unsigned long long ZipReader::GetTotalUncompressed() const {
+    unsigned long long total = 0;
+    for (size_t i = 0; i < entries_.size(); i++) {
+        total += entries_[i].uncompressedSize;
+    }
+    return total;
+}
+
+bool ZipReader::ReadEntry(size_t index, DeflateSink sink, void* userData) {
+    error_.clear();
+    cancelled_ = false;
+    stream_.sink = sink;
+    stream_.sinkData = userData;
+    if (!ReadStream(stream_, index)) {
+        return Fail(stream_.error);
+    }
+    return true;
+}
+
+bool ZipReader::ReadStream(EntryStream& stream, size_t index) {
+    stream.error.clear();
+    if (index >= entries_.size()) {
+        return FailStream(stream, "No such entry");
+    }
+    const ZipEntry& entry = entries_[index];
+
+    if (entry.flags & FLAG_ENCRYPTED) {
+        return FailStream(stream, entry.name + " is encrypted");
+    }
+    if (entry.method != METHOD_STORED && entry.method != METHOD_DEFLATED) {
+        return FailStream(stream, entry.name + " uses an unsupported compression method");
+    }
+
+    std::ifstream& file = *stream.file;
+    unsigned char header[LOCAL_HEADER_SIZE];
+    file.clear();
+    file.seekg((std::streamoff)entry.localHeaderOffset);
+    file.read((char*)header, sizeof(header));
+    if (file.gcount() != (std::streamsize)sizeof(header) || Get32(header) != LOCAL_HEADER_SIGNATURE) {
+        return FailStream(stream, entry.name + " has no valid local header");
+    }
+
+    uint64_t dataStart = entry.localHeaderOffset + LOCAL_HEADER_SIZE + Get16(header + 26) + Get16(header + 28);
+    if (dataStart > fileSize_ || entry.compressedSize > fileSize_ - dataStart) {
+        return FailStream(stream, entry.name + " extends past the end of the archive");
+    }
+    file.seekg((std::streamoff)dataStart);
+
+    stream.entry = &entry;
+    stream.remaining = entry.compressedSize;
+    stream.produced = 0;
+    stream.crc = 0;
+
+    if (entry.method == METHOD_STORED) {
+        while (stream.remaining > 0) {
+            size_t got = ReadCompressed(stream.buffer.data(), stream.buffer.size(), &stream);
+            if (got == 0) {
+                return FailStream(stream, entry.name + " is truncated");
+            }
+            if (!Verify(stream.buffer.data(), got, &stream)) {
+                return false;
+            }
+        }
+    }
+    else {
+        stream.inflater.Reset(ReadCompressed, &stream, Verify, &stream);
+        if (!stream.inflater.Run()) {
+            return FailStream(stream, entry.name + ": " + stream.inflater.GetError());
+        }
+    }
+
+    if (stream.produced != entry.uncompressedSize) {
+        return FailStream(stream, entry.name + " is shorter than its recorded size");
+    }
+    if (stream.crc != entry.crc32) {
+        return FailStream(stream, entry.name + " failed the CRC check");
+    }
+    return true;
+}
+
+static bool WriteToStream(const unsigned char* data, size_t size, void* userData) {
+    std::ofstream* out = (std::ofstream*)userData;
+    out->write((const char*)data, size);
+    return out->good();
+}
+
+bool ZipReader::ExtractEntry(size_t index, const std::string& destinationFolder) {
+    if (index >= entries_.size()) {
+        return Fail("No such entry");
+    }
+    const ZipEntry& entry = entries_[index];
+
+    std::string relativePath;
+    if (!GetSafeRelativePath(entry.name, relativePath)) {
+        return Fail("Unsafe entry name: " + entry.name);
+    }
+
+    std::error_code ec;
+    fs::path target = fs::path(destinationFolder) / fs::path(relativePath).make_preferred();
+    if (entry.isDirectory) {
+        fs::create_directories(target, ec);
+        return !ec || Fail("Cannot create " + target.string());
+    }
+    if (relativePath.empty()) {
+        return Fail("Unsafe entry name: " + entry.name);
+    }
+
+    fs::create_directories(target.parent_path(), ec);
+    cancelled_ = false;
+    if (!ExtractToFile(stream_, index, target.string())) {
+        return Fail(stream_.error);
+    }
+    return true;
+}
+
+bool ZipReader::ExtractToFile(EntryStream& stream, size_t index, const std::string& target) {
+    const ZipEntry& entry = entries_[index];
+    std::error_code ec;
+
+    // Large files get their final size before the first write so the file
+    // system can allocate them in one piece; failing that they simply grow
+    std::ofstream out;
+    if (entry.uncompressedSize >= AgentConstants::ZIP_PREALLOCATE_MIN_SIZE) {
+        std::ofstream create(target, std::ios::binary | std::ios::trunc);
+        create.close();
+        fs::resize_file(target, entry.uncompressedSize, ec);
+        out.open(target, std::ios::binary | std::ios::in | std::ios::out);
+    }
+    else {
+        out.open(target, std::ios::binary | std::ios::trunc);
+    }
+    if (!out.is_open()) {
+        return FailStream(stream, "Cannot create " + target);
+    }
+
+    stream.sink = WriteToStream;
+    stream.sinkData = &out;
+    bool ok = ReadStream(stream, index);
+    out.close();
+    if (!ok || out.fail()) {
+        FailStream(stream, "Failed writing " + target);
+        fs::remove(target, ec);
+        return false;
+    }
+
+    fs::last_write_time(target, FromDosDateTime(entry.dosDateTime), ec);
+    return true;
+}
+
+bool ZipReader::ExtractAll(const std::string& destinationFolder) {
+    // Refuse the whole archive before writing anything if one name is unsafe
+    std::vector<std::string> relativePaths(entries_.size());
+    for (size_t i = 0; i < entries_.size(); i++) {
+        if (!GetSafeRelativePath(entries_[i].name, relativePaths[i]) ||
+            (relativePaths[i].empty() && !entries_[i].isDirectory)) {
+            return Fail("Unsafe entry name: " + entries_[i].name);
+        }
+    }
+
+    // Plan every target first: all directories are created in one pass and a
+    // name that appears twice is written once, from its last entry, exactly
+    // as extracting in order would leave it
+    fs::path root(destinationFolder);
+    std::set<std::string> folders;
+    folders.insert(root.string());
+    std::map<std::string, size_t> lastWriter;
+    std::vector<std::string> targets(entries_.size());
+    for (size_t i = 0; i < entries_.size(); i++) {
+        fs::path target = root / fs::path(relativePaths[i]).make_preferred();
+        targets[i] = target.string();
+        if (entries_[i].isDirectory) {
+            folders.insert(targets[i]);
+        }
+        else {
+            folders.insert(target.parent_path().string());
+            lastWriter[targets[i]] = i;
+        }
+    }
+
+    std::error_code ec;
+    for (std::set<std::string>::const_iterator it = folders.begin(); it != folders.end(); ++it) {
+        fs::create_directories(*it, ec);
+        if (ec) {
+            return Fail("Cannot create " + *it);
+        }
+    }
+
+    std::vector<size_t> files;
+    files.reserve(lastWriter.size());
+    for (std::map<std::string, size_t>::const_iterator it = lastWriter.begin(); it != lastWriter.end(); ++it) {
+        files.push_back(it->second);
+    }
+
+    bytesDone_ = 0;
+    bytesTotal_ = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        bytesTotal_ += entries_[files[i]].uncompressedSize;
+    }
+    cancelled_ = false;
+
+    if (threads_ > 1 && files.size() > 1) {
+        return ExtractParallel(files, targets);
+    }
+
+    std::sort(files.begin(), files.end());
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!ExtractToFile(stream_, files[i], targets[files[i]])) {
+            return Fail(stream_.error);
+        }
+    }
+    return true;
+}
+
+bool ZipReader::ExtractParallel(const std::vector<size_t>& files, const std::vector<std::string>& targets) {
+    // Largest first, so one big file does not start last and run alone
+    std::vector<size_t> order(files);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return entries_[a].uncompressedSize > entries_[b].uncompressedSize;
+    });
+
+    size_t threads = (std::min)(threads_, order.size());
+    std::atomic<size_t> next(0);
+    {
+        ThreadPool pool(threads, true);
+        for (size_t t = 0; t < threads; t++) {
+            pool.Submit([this, &order, &targets, &next]() {
+                std::ifstream file(path_, std::ios::binary);
+                if (!file.is_open()) {
+                    Cancel("Cannot open " + path_);
+                    return;
+                }
+
+                EntryStream stream;
+                stream.reader = this;
+                stream.file = &file;
+                stream.entry = NULL;
+                stream.remaining = 0;
+                stream.produced = 0;
+                stream.crc = 0;
+                stream.sink = NULL;
+                stream.sinkData = NULL;
+
+                try {
+                    stream.buffer.resize(AgentConstants::ZIP_IO_BUFFER_SIZE);
+                    while (!IsCancelled()) {
+                        size_t i = next++;
+                        if (i >= order.size()) {
+                            break;
+                        }
+                        if (!ExtractToFile(stream, order[i], targets[order[i]])) {
+                            Cancel(stream.error);
+                            break;
+                        }
+                    }
+                }
+                catch (const std::exception& e) {
+                    Cancel(std::string("Extraction failed: ") + e.what());
+                }
+            });
+        }
+        pool.Wait();
+    }
+
+    return !cancelled_;
+}
+
+const std::string& ZipReader::GetError() const {
+    return error_;
+}
+
+bool ZipReader::GetSafeRelativePath(const std::string& entryName, std::string& relativePath) {
+    relativePath.clear();
+    if (entryName.empty() || entryName[0] == '/' || entryName[0] == '\\') {
+        return false;
+    }
+
+    // Drive letters and alternate data streams
+    if (entryName.find(':') != std::string::npos || entryName.find('\0') != std::string::npos) {
+        return false;
+    }
+
+    size_t start = 0;
+    while (start <= entryName.size()) {
+        size_t end = entryName.find_first_of("/\\", start);
+        if (end == std::string::npos) {
+            end = entryName.size();
+        }
+        std::string component = entryName.substr(start, end - start);
+        start = end + 1;
+
+        if (component.empty() || component == ".") {
+            continue;
+        }
+
+        // Windows drops trailing dots and spaces, so ".. " would still mean ".."
+        if (component.find_first_not_of(". ") == std::string::npos) {
+            return false;
+        }
+
+        if (!relativePath.empty()) {
+            relativePath += '/';
+        }
+        relativePath += component;
+    }
+    return true;
+}
+
+bool ZipReader::ReadCentralDirectory() {
+    size_t tailSize = (size_t)(std::min)(fileSize_, (uint64_t)(END_SIZE + MAX_COMMENT_SIZE));
+    if (tailSize < END_SIZE) {
+        return Fail("Not a zip archive");
+    }
+
+    std::vector<unsigned char> tail(tailSize);
+    uint64_t tailStart = fileSize_ - tailSize;
+    file_.seekg((std::streamoff)tailStart);
+    file_.read((char*)tail.data(), tailSize);
+    if (file_.gcount() != (std::streamsize)tailSize) {
+        return Fail("Cannot read the archive");
+    }
+
+    // The end record is the last signature whose comment reaches the end of the file
+    size_t endPos = tailSize - END_SIZE + 1;
+    bool found = false;
+    while (endPos-- > 0) {
+        if (Get32(&tail[endPos]) == END_SIGNATURE &&
+            endPos + END_SIZE + Get16(&tail[endPos + 20]) <= tailSize) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        return Fail("Not a zip archive");
+    }
+
+    const unsigned char* end = &tail[endPos];
+    uint64_t endOffset = tailStart + endPos;
+    uint16_t disk = Get16(end + 4);
+    uint64_t entryCount = Get16(end + 10);
+    uint64_t directorySize = Get32(end + 12);
+    uint64_t directoryOffset = Get32(end + 16);
+    if ((disk != 0 && disk != 0xFFFF) || Get16(end + 8) != Get16(end + 10)) {
+        return Fail("Multi-part archives are not supported");
+    }
+
+    if (entryCount == 0xFFFF || directorySize == ZIP32_LIMIT || directoryOffset == ZIP32_LIMIT) {
+        if (endOffset < ZIP64_LOCATOR_SIZE) {
+            return Fail("ZIP64 locator is missing");
+        }
+
+        unsigned char locator[ZIP64_LOCATOR_SIZE];
+        file_.seekg((std::streamoff)(endOffset - ZIP64_LOCATOR_SIZE));
+        file_.read((char*)locator, sizeof(locator));
+        if (file_.gcount() != (std::streamsize)sizeof(locator) || Get32(locator) != ZIP64_LOCATOR_SIGNATURE) {
+            return Fail("ZIP64 locator is missing");
+        }
+
+        uint64_t zip64EndOffset = Get64(locator + 8);
+        unsigned char zip64End[ZIP64_END_SIZE];
+        if (zip64EndOffset > endOffset - ZIP64_LOCATOR_SIZE) {
+            return Fail("ZIP64 end record is invalid");
+        }
+        file_.seekg((std::streamoff)zip64EndOffset);
+        file_.read((char*)zip64End, sizeof(zip64End));
+        if (file_.gcount() != (std::streamsize)sizeof(zip64End) || Get32(zip64End) != ZIP64_END_SIGNATURE) {
+            return Fail("ZIP64 end record is invalid");
+        }
+
+        entryCount = Get64(zip64End + 32);
+        directorySize = Get64(zip64End + 40);
+        directoryOffset = Get64(zip64End + 48);
+        endOffset = zip64EndOffset;
+    }
+
+    if (directoryOffset > endOffset || directorySize > endOffset - directoryOffset) {
+        return Fail("Central directory is outside the archive");
+    }
+    if (entryCount > directorySize / CENTRAL_HEADER_SIZE) {
+        return Fail("Central directory is truncated");
+    }
+
+    std::vector<unsigned char> directory((size_t)directorySize);
+    file_.seekg((std::streamoff)directoryOffset);
+    file_.read((char*)directory.data(), directory.size());
+    if (file_.gcount() != (std::streamsize)directory.size()) {
+        return Fail("Cannot read the central directory");
+    }
+
+    entries_.reserve((size_t)entryCount);
+    size_t pos = 0;
+    for (uint64_t i = 0; i < entryCount; i++) {
+        if (directory.size() - pos < CENTRAL_HEADER_SIZE || Get32(&directory[pos]) != CENTRAL_HEADER_SIGNATURE) {
+            return Fail("Central directory is corrupt");
+        }
+        const unsigned char* record = &directory[pos];
+        size_t nameLength = Get16(record + 28);
+        size_t extraLength = Get16(record + 30);
+        size_t commentLength = Get16(record + 32);
+        size_t recordSize = CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+        if (directory.size() - pos < recordSize) {
+            return Fail("Central directory is corrupt");
+        }
+
+        ZipEntry entry;
+        entry.flags = Get16(record + 8);
+        entry.method = Get16(record + 10);
+        entry.dosDateTime = ((uint32_t)Get16(record + 14) << 16) | Get16(record + 12);
+        entry.crc32 = Get32(record + 16);
+        entry.compressedSize = Get32(record + 20);
+        entry.uncompressedSize = Get32(record + 24);
+        entry.localHeaderOffset = Get32(record + 42);
+        entry.name.assign((const char*)record + CENTRAL_HEADER_SIZE, nameLength);
+        entry.isDirectory = !entry.name.empty() && (entry.name.back() == '/' || entry.name.back() == '\\');
+
+        // ZIP64 values appear only for the fields that overflowed, in this order
+        const unsigned char* extra = record + CENTRAL_HEADER_SIZE + nameLength;
+        size_t extraPos = 0;
+        while (extraPos + 4 <= extraLength) {
+            uint16_t id = Get16(extra + extraPos);
+            size_t size = Get16(extra + extraPos + 2);
+            if (extraPos + 4 + size > extraLength) {
+                break;
+            }
+            if (id == ZIP64_EXTRA_ID) {
+                const unsigned char* field = extra + extraPos + 4;
+                const unsigned char* fieldEnd = field + size;
+                if (entry.uncompressedSize == ZIP32_LIMIT && field + 8 <= fieldEnd) {
+                    entry.uncompressedSize = Get64(field);
+                    field += 8;
+                }
+                if (entry.compressedSize == ZIP32_LIMIT && field + 8 <= fieldEnd) {
+                    entry.compressedSize = Get64(field);
+                    field += 8;
+                }
+                if (entry.localHeaderOffset == ZIP32_LIMIT && field + 8 <= fieldEnd) {
+                    entry.localHeaderOffset = Get64(field);
+                }
+            }
+            extraPos += 4 + size;
+        }
+
+        if (entry.localHeaderOffset >= directoryOffset) {
+            return Fail(entry.name + " points outside the archive");
+        }
+
+        entries_.push_back(entry);
+        pos += recordSize;
+    }
+    return true;
+}
+
+bool ZipReader::Fail(const std::string& message) {
+    if (error_.empty()) {
+        error_ = message;
+    }
+    return false;
+}
+
+bool ZipReader::FailStream(EntryStream& stream, const std::string& message) {
+    if (stream.error.empty()) {
+        stream.error = message;
+    }
+    return false;
+}
+
+void ZipReader::Cancel(const std::string& message) {
+    std::lock_guard<std::mutex> lock(progressMutex_);
+    cancelled_ = true;
+    Fail(message);
+}
+
+bool ZipReader::IsCancelled() {
+    std::lock_guard<std::mutex> lock(progressMutex_);
+    return cancelled_;
+}
+
+bool ZipReader::ReportProgress(const ZipEntry& entry, size_t size) {
+    std::lock_guard<std::mutex> lock(progressMutex_);
+    if (cancelled_) {
+        return false;
+    }
+    bytesDone_ += size;
+    return progress_ == NULL || progress_(entry.name, bytesDone_, bytesTotal_, progressData_);
+}
+
+size_t ZipReader::ReadCompressed(unsigned char* buffer, size_t capacity, void* userData) {
+    EntryStream* stream = (EntryStream*)userData;
+    size_t wanted = (size_t)(std::min)((uint64_t)capacity, stream->remaining);
+    if (wanted == 0) {
+        return 0;
+    }
+
+    stream->file->read((char*)buffer, wanted);
+    size_t got = (size_t)stream->file->gcount();
+    stream->remaining -= got;
+    return got;
+}
+
+bool ZipReader::Verify(const unsigned char* data, size_t size, void* userData) {
+    EntryStream* stream = (EntryStream*)userData;
+    const ZipEntry& entry = *stream->entry;
+
+    // Never write more than the directory promised, whatever the stream says
+    if (size > entry.uncompressedSize - stream->produced) {
+        return FailStream(*stream, entry.name + " is larger than its recorded size");
+    }
+    stream->produced += size;
+    stream->crc = HashUtils::Crc32(stream->crc, data, size);
+
+    if (!stream->sink(data, size, stream->sinkData)) {
+        return FailStream(*stream, "Failed writing " + entry.name);
+    }
+
+    if (!stream->reader->ReportProgress(entry, size)) {
+        return FailStream(*stream, "Cancelled");
+    }
+    return true;
+}
+
+ZipStreamReader::ZipStreamReader() {
+    source_ = NULL;
+    sourceData_ = NULL;
+    pos_ = 0;
+    end_ = 0;
+    offset_ = 0;
+    progress_ = NULL;
+    progressData_ = NULL;
+    bytesDone_ = 0;
+    sizeKnown_ = false;
+    remaining_ = 0;
+    produced_ = 0;
+    crc_ = 0;
+    out_ = NULL;
+}
+
+ZipStreamReader::~ZipStreamReader() {
+}
+
+void ZipStreamReader::SetProgress(ZipProgressCallback callback, void* userData) {
+    progress_ = callback;
+    progressData_ = userData;
+}
+
+bool ZipStreamReader::ExtractAll(DeflateSource source, void* sourceData, const std::string& destinationFolder) {
+    source_ = source;
+    sourceData_ = sourceData;
+    buffer_.resize(AgentConstants::ZIP_IO_BUFFER_SIZE);
+    pos_ = 0;
+    end_ = 0;
+    offset_ = 0;
+    entries_.clear();
+    error_.clear();
+    bytesDone_ = 0;
+
+    std::error_code ec;
+    fs::create_directories(destinationFolder, ec);
+
+    std::string lastFolder;
+    while (true) {
+        if (!Ensure(4)) {
+            return Fail(entries_.empty() ? "Not a zip archive" : "Archive is truncated");
+        }
+        uint32_t signature = Get32(&buffer_[pos_]);
+        if (signature == LOCAL_HEADER_SIGNATURE) {
+            if (!ReadLocalEntry(destinationFolder, lastFolder)) {
+                return false;
+            }
+        }
+        else if (signature == CENTRAL_HEADER_SIGNATURE || signature == ZIP64_END_SIGNATURE || signature == END_SIGNATURE) {
+            break;
+        }
+        else {
+            return Fail(entries_.empty() ? "Not a zip archive" : "Unexpected data after " + entries_.back().name);
+        }
+    }
+
+    if (!VerifyCentralDirectory(offset_)) {
+        return false;
+    }
+
+    // Read to the end so whoever feeds the stream is never left blocked
+    pos_ = end_;
+    while (source_(buffer_.data(), buffer_.size(), sourceData_) > 0) {
+    }
+    return true;
+}
+
+size_t ZipStreamReader::GetEntryCount() const {
+    return entries_.size();
+}
+
+const ZipEntry& ZipStreamReader::GetEntry(size_t index) const {
+    return entries_[index];
+}
+
+unsigned long long ZipStreamReader::GetTotalUncompressed() const {
+    unsigned long long total = 0;
+    for (size_t i = 0; i < entries_.size(); i++) {
+        total += entries_[i].uncompressedSize;
+    }
+    return total;
+}
+
+unsigned long long ZipStreamReader::GetBytesRead() const {
+    return offset_;
+}
+
+const std::string& ZipStreamReader::GetError() const {
+    return error_;
+}
+
+bool ZipStreamReader::Ensure(size_t size) {
+    if (end_ - pos_ >= size) {
+        return true;
+    }
+
+    memmove(buffer_.data(), buffer_.data() + pos_, end_ - pos_);
+    end_ -= pos_;
+    pos_ = 0;
+    if (size > buffer_.size()) {
+        buffer_.resize(size);
+    }
+
+    while (end_ < size) {
+        size_t got = source_(&buffer_[end_], buffer_.size() - end_, sourceData_);
+        if (got == 0) {
+            return false;
+        }
+        end_ += got;
+    }
+    return true;
+}
+
+bool ZipStreamReader::Read(void* data, size_t size) {
+    if (!Ensure(size)) {
+        return false;
+    }
+    if (size > 0) {
+        memcpy(data, &buffer_[pos_], size);
+    }
+    Consume(size);
+    return true;
+}
+
+void ZipStreamReader::Consume(size_t size) {
+    pos_ += size;
+    offset_ += size;
+}
+
+bool ZipStreamReader::Skip(uint64_t size) {
+    while (size > 0) {
+        if (!Ensure(1)) {
+            return false;
+        }
+        size_t chunk = (size_t)(std::min)((uint64_t)(end_ - pos_), size);
+        Consume(chunk);
+        size -= chunk;
+    }
+    return true;
+}
+
+void ZipStreamReader::Unread(const unsigned char* data, size_t size) {
+    if (size > pos_) {
+        size_t pending = end_ - pos_;
+        if (pending + size > buffer_.size()) {
+            buffer_.resize(pending + size);
+        }
+        memmove(&buffer_[size], &buffer_[pos_], pending);
+        pos_ = size;
+        end_ = size + pending;
+    }
+    pos_ -= size;
+    if (size > 0) {
+        memcpy(&buffer_[pos_], data, size);
+    }
+    offset_ -= size;
+}
+
+bool ZipStreamReader::ReadLocalEntry(const std::string& destinationFolder, std::string& lastFolder) {
+    uint64_t headerOffset = offset_;
+    unsigned char header[LOCAL_HEADER_SIZE];
+    if (!Read(header, sizeof(header))) {
+        return Fail("Archive is truncated");
+    }
+
+    ZipEntry entry;
+    entry.flags = Get16(header + 6);
+    entry.method = Get16(header + 8);
+    entry.dosDateTime = ((uint32_t)Get16(header + 12) << 16) | Get16(header + 10);
+    entry.crc32 = Get32(header + 14);
+    entry.compressedSize = Get32(header + 18);
+    entry.uncompressedSize = Get32(header + 22);
+    entry.localHeaderOffset = headerOffset;
+
+    size_t nameLength = Get16(header + 26);
+    size_t extraLength = Get16(header + 28);
+    std::vector<unsigned char> variable(nameLength + extraLength);
+    if (!Read(variable.data(), variable.size())) {
+        return Fail("Archive is truncated");
+    }
+    entry.name.assign((const char*)variable.data(), nameLength);
+    entry.isDirectory = !entry.name.empty() && (entry.name.back() == '/' || entry.name.back() == '\\');
+
+    // A ZIP64 field in the local header also means 8-byte sizes in the descriptor
+    bool zip64 = false;
+    const unsigned char* extra = variable.data() + nameLength;
+    size_t extraPos = 0;
+    while (extraPos + 4 <= extraLength) {
+        uint16_t id = Get16(extra + extraPos);
+        size_t size = Get16(extra + extraPos + 2);
+        if (extraPos + 4 + size > extraLength) {
+            break;
+        }
+        if (id == ZIP64_EXTRA_ID) {
+            const unsigned char* field = extra + extraPos + 4;
+            const unsigned char* fieldEnd = field + size;
+            zip64 = true;
+            if (entry.uncompressedSize == ZIP32_LIMIT && field + 8 <= fieldEnd) {
+                entry.uncompressedSize = Get64(field);
+                field += 8;
+            }
+            if (entry.compressedSize == ZIP32_LIMIT && field + 8 <= fieldEnd) {
+                entry.compressedSize = Get64(field);
+            }
+        }
+        extraPos += 4 + size;
+    }
+
+    if (entry.flags & FLAG_ENCRYPTED) {
+        return Fail(entry.name + " is encrypted");
+    }
+    if (entry.method != METHOD_STORED && entry.method != METHOD_DEFLATED) {
+        return Fail(entry.name + " uses an unsupported compression method");
+    }
+
+    std::string relativePath;
+    if (!ZipReader::GetSafeRelativePath(entry.name, relativePath) || (relativePath.empty() && !entry.isDirectory)) {
+        return Fail("Unsafe entry name: " + entry.name);
+    }
+
+    current_ = entry;
+    sizeKnown_ = (entry.flags & FLAG_DATA_DESCRIPTOR) == 0;
+    out_ = NULL;
+
+    std::error_code ec;
+    fs::path target = fs::path(destinationFolder) / fs::path(relativePath).make_preferred();
+    if (entry.isDirectory) {
+        fs::create_directories(target, ec);
+        if (ec) {
+            return Fail("Cannot create " + target.string());
+        }
+        if (!ReadEntryData(zip64)) {
+            return false;
+        }
+        entries_.push_back(current_);
+        return true;
+    }
+
+    std::string folder = target.parent_path().string();
+    if (folder != lastFolder) {
+        fs::create_directories(folder, ec);
+        lastFolder = folder;
+    }
+
+    std::ofstream out(target.string(), std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return Fail("Cannot create " + target.string());
+    }
+
+    out_ = &out;
+    bool ok = ReadEntryData(zip64);
+    out_ = NULL;
+    out.close();
+    if (!ok || out.fail()) {
+        Fail("Failed writing " + target.string());
+        fs::remove(target, ec);
+        return false;
+    }
+
+    fs::last_write_time(target, FromDosDateTime(entry.dosDateTime), ec);
+    entries_.push_back(current_);
+    return true;
+}
+
+bool ZipStreamReader::ReadEntryData(bool zip64) {
+    remaining_ = current_.compressedSize;
+    produced_ = 0;
+    crc_ = 0;
+
+    if (current_.method == METHOD_STORED) {
+        if (!sizeKnown_) {
+            return CopyUntilDescriptor(zip64);
+        }
+        while (remaining_ > 0) {
+            if (!Ensure(1)) {
+                return Fail(current_.name + " is truncated");
+            }
+            size_t chunk = (size_t)(std::min)((uint64_t)(end_ - pos_), remaining_);
+            if (!Verify(&buffer_[pos_], chunk, this)) {
+                return false;
+            }
+            Consume(chunk);
+            remaining_ -= chunk;
+        }
+    }
+    else {
+        inflater_.Reset(ReadInput, this, Verify, this);
+        if (!inflater_.Run()) {
+            return Fail(current_.name + ": " + inflater_.GetError());
+        }
+
+        if (!sizeKnown_) {
+            // The deflate stream ends itself; hand back what was read past it
+            const unsigned char* unused = NULL;
+            size_t unusedSize = 0;
+            inflater_.GetUnconsumed(unused, unusedSize);
+            Unread(unused, unusedSize);
+            return ReadDataDescriptor(zip64, inflater_.GetTotalIn());
+        }
+        if (!Skip(remaining_)) {
+            return Fail(current_.name + " is truncated");
+        }
+    }
+
+    if (produced_ != current_.uncompressedSize) {
+        return Fail(current_.name + " is shorter than its recorded size");
+    }
+    if (crc_ != current_.crc32) {
+        return Fail(current_.name + " failed the CRC check");
+    }
+    return true;
+}
+
+bool ZipStreamReader::CopyUntilDescriptor(bool zip64) {
+    // Stored data has no end marker of its own, so the entry ends at the first
+    // descriptor signature whose CRC and sizes describe the bytes before it
+    size_t descriptorSize = zip64 ? 24 : 16;
+    while (true) {
+        if (!Ensure(descriptorSize)) {
+            return Fail(current_.name + " is truncated");
+        }
+
+        const unsigned char* data = &buffer_[pos_];
+        size_t candidates = end_ - pos_ - descriptorSize + 1;
+        size_t found = candidates;
+        for (size_t i = 0; i < candidates; i++) {
+            const unsigned char* p = (const unsigned char*)memchr(data + i, 'P', candidates - i);
+            if (p == NULL) {
+                break;
+            }
+            i = (size_t)(p - data);
+            if (Get32(p) == DATA_DESCRIPTOR_SIGNATURE) {
+                found = i;
+                break;
+            }
+        }
+
+        if (found > 0) {
+            if (!Verify(data, found, this)) {
+                return false;
+            }
+            Consume(found);
+        }
+        if (found == candidates) {
+            continue;
+        }
+
+        const unsigned char* descriptor = &buffer_[pos_];
+        uint64_t compressedSize = zip64 ? Get64(descriptor + 8) : Get32(descriptor + 8);
+        uint64_t uncompressedSize = zip64 ? Get64(descriptor + 16) : Get32(descriptor + 12);
+        if (Get32(descriptor + 4) == crc_ && compressedSize == produced_ && uncompressedSize == produced_) {
+            Consume(descriptorSize);
+            current_.crc32 = crc_;
+            current_.compressedSize = produced_;
+            current_.uncompressedSize = produced_;
+            return true;
+        }
+
+        // The signature bytes were part of the data
+        if (!Verify(descriptor, 1, this)) {
+            return false;
+        }
+        Consume(1);
+    }
+}
+
+bool ZipStreamReader::ReadDataDescriptor(bool zip64, uint64_t compressedSize) {
+    // The signature is optional; a central header always follows, so the
+    // longer form can be buffered either way
+    size_t fieldsSize = zip64 ? 20 : 12;
+    if (!Ensure(4 + fieldsSize)) {
+        return Fail(current_.name + " is truncated");
+    }
+
+    const unsigned char* descriptor = &buffer_[pos_];
+    size_t skip = (Get32(descriptor) == DATA_DESCRIPTOR_SIGNATURE && Get32(descriptor + 4) == crc_) ? 4 : 0;
+    descriptor += skip;
+
+    uint32_t crc = Get32(descriptor);
+    uint64_t recordedCompressed = zip64 ? Get64(descriptor + 4) : Get32(descriptor + 4);
+    uint64_t recordedUncompressed = zip64 ? Get64(descriptor + 12) : Get32(descriptor + 8);
+    Consume(skip + fieldsSize);
+
+    if (crc != crc_) {
+        return Fail(current_.name + " failed the CRC check");
+    }
+    if (recordedCompressed != compressedSize || recordedUncompressed != produced_) {
+        return Fail(current_.name + " does not match its data descriptor");
+    }
+
+    current_.crc32 = crc_;
+    current_.compressedSize = compressedSize;
+    current_.uncompressedSize = produced_;
+    return true;
+}
+
+bool ZipStreamReader::VerifyCentralDirectory(uint64_t directoryOffset) {
+    std::map<uint64_t, size_t> byOffset;
+    for (size_t i = 0; i < entries_.size(); i++) {
+        byOffset[entries_[i].localHeaderOffset] = i;
+    }
+
+    // Every record must describe exactly what was extracted, so a directory
+    // that disagrees with the local headers cannot hide or alter an entry
+    uint64_t recordCount = 0;
+    std::vector<bool> matched(entries_.size(), false);
+    while (true) {
+        if (!Ensure(4)) {
+            return Fail("Central directory is truncated");
+        }
+        if (Get32(&buffer_[pos_]) != CENTRAL_HEADER_SIGNATURE) {
+            break;
+        }
+
+        unsigned char record[CENTRAL_HEADER_SIZE];
+        if (!Read(record, sizeof(record))) {
+            return Fail("Central directory is truncated");
+        }
+        size_t nameLength = Get16(record + 28);
+        size_t extraLength = Get16(record + 30);
+        size_t commentLength = Get16(record + 32);
+        std::vector<unsigned char> variable(nameLength + extraLength);
+        if (!Read(variable.data(), variable.size()) || !Skip(commentLength)) {
+            return Fail("Central directory is truncated");
+        }
+
+        ZipEntry entry;
+        entry.crc32 = Get32(record + 16);
+        entry.compressedSize = Get32(record + 20);
+        entry.uncompressedSize = Get32(record + 24);
+        entry.localHeaderOffset = Get32(record + 42);
+        entry.name.assign((const char*)variable.data(), nameLength);
+
+        const unsigned char* extra = variable.data() + nameLength;
+        size_t extraPos = 0;
+        while (extraPos + 4 <= extraLength) {
+            uint16_t id = Get16(extra + extraPos);
+            size_t size = Get16(extra + extraPos + 2);
+            if (extraPos + 4 + size > extraLength) {
+                break;
+            }
+            if (id == ZIP64_EXTRA_ID) {
+                const unsigned char* field = extra + extraPos + 4;
+                const unsigned char* fieldEnd = field + size;
+                if (entry.uncompressedSize == ZIP32_LIMIT && field + 8 <= fieldEnd) {
+                    entry.uncompressedSize = Get64(field);
+                    field += 8;
+                }
+                if (entry.compressedSize == ZIP32_LIMIT && field + 8 <= fieldEnd) {
+                    entry.compressedSize = Get64(field);
+                    field += 8;
+                }
+                if (entry.localHeaderOffset == ZIP32_LIMIT && field + 8 <= fieldEnd) {
+                    entry.localHeaderOffset = Get64(field);
+                }
+            }
+            extraPos += 4 + size;
+        }
+
+        std::map<uint64_t, size_t>::const_iterator it = byOffset.find(entry.localHeaderOffset);
+        if (it == byOffset.end() || matched[it->second]) {
+            return Fail(entry.name + " is listed in the central directory but was not in the stream");
+        }
+        const ZipEntry& local = entries_[it->second];
+        if (entry.name != local.name || entry.crc32 != local.crc32 ||
+            entry.compressedSize != local.compressedSize || entry.uncompressedSize != local.uncompressedSize) {
+            return Fail(local.name + " does not match the central directory");
+        }
+        matched[it->second] = true;
+        recordCount++;
+    }
+    if (recordCount != entries_.size()) {
+        return Fail("Central directory is missing entries");
+    }
+
+    uint64_t recordedCount = recordCount;
+    uint64_t recordedOffset = directoryOffset;
+    if (Get32(&buffer_[pos_]) == ZIP64_END_SIGNATURE) {
+        unsigned char zip64End[ZIP64_END_SIZE];
+        if (!Read(zip64End, sizeof(zip64End)) || Get64(zip64End + 4) < ZIP64_END_SIZE - 12 ||
+            !Skip(Get64(zip64End + 4) + 12 - ZIP64_END_SIZE)) {
+            return Fail("ZIP64 end record is invalid");
+        }
+        recordedCount = Get64(zip64End + 32);
+        recordedOffset = Get64(zip64End + 48);
+
+        if (!Ensure(4) || Get32(&buffer_[pos_]) != ZIP64_LOCATOR_SIGNATURE || !Skip(ZIP64_LOCATOR_SIZE)) {
+            return Fail("ZIP64 locator is missing");
+        }
+    }
+
+    unsigned char end[END_SIZE];
+    if (!Ensure(4) || Get32(&buffer_[pos_]) != END_SIGNATURE || !Read(end, sizeof(end)) || !Skip(Get16(end + 20))) {
+        return Fail("End of central directory is missing");
+    }
+    if (Get16(end + 10) != 0xFFFF) {
+        recordedCount = Get16(end + 10);
+    }
+    if (Get32(end + 16) != ZIP32_LIMIT) {
+        recordedOffset = Get32(end + 16);
+    }
+    if (recordedCount != recordCount || recordedOffset != directoryOffset) {
+        return Fail("End of central directory does not match the archive");
+    }
+    return true;
+}
+
+bool ZipStreamReader::Fail(const std::string& message) {
+    if (error_.empty()) {
+        error_ = message;
+    }
+    return false;
+}
+
+size_t ZipStreamReader::ReadInput(unsigned char* buffer, size_t capacity, void* userData) {
+    ZipStreamReader* reader = (ZipStreamReader*)userData;
+    if (reader->sizeKnown_) {
+        capacity = (size_t)(std::min)((uint64_t)capacity, reader->remaining_);
+        if (capacity == 0) {
+            return 0;
+        }
+    }
+
+    // Buffered bytes first, then straight from the source
+    size_t got = 0;
+    if (reader->pos_ < reader->end_) {
+        got = (std::min)(capacity, reader->end_ - reader->pos_);
+        memcpy(buffer, &reader->buffer_[reader->pos_], got);
+        reader->pos_ += got;
+    }
+    else {
+        got = reader->source_(buffer, capacity, reader->sourceData_);
+    }
+
+    reader->offset_ += got;
+    if (reader->sizeKnown_) {
+        reader->remaining_ -= got;
+    }
+    return got;
+}
+
+bool ZipStreamReader::Verify(const unsigned char* data, size_t size, void* userData) {
+    ZipStreamReader* reader = (ZipStreamReader*)userData;
+    const ZipEntry& entry = reader->current_;
+
+    if (reader->sizeKnown_ && size > entry.uncompressedSize - reader->produced_) {
+        return reader->Fail(entry.name + " is larger than its recorded size");
+    }
+    reader->produced_ += size;
+    reader->crc_ = HashUtils::Crc32(reader->crc_, data, size);
+
+    if (reader->out_ != NULL) {
+        reader->out_->write((const char*)data, size);
+        if (!reader->out_->good()) {
+            return reader->Fail("Failed writing " + entry.name);
+        }
+    }
+
+    reader->bytesDone_ += size;
+    if (reader->progress_ != NULL && !reader->progress_(entry.name, reader->bytesDone_, 0, reader->progressData_)) {
+        return reader->Fail("Cancelled");
+    }
+    return true;
+}
\ No newline at end of file
@@ -1,45 +1,179 @@
 #include "../include/utilities/ZipUtils.h"
-#include "../include/utilities/FileUtils.h"
+#include "../include/utilities/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
 
 bool ZipUtils::ExtractZip(const std::string& zipPath, const std::string& destinationPath) {
-    if (!FileUtils::FileExists(zipPath)) {
+    ZipOptions options;
+    ZipStats stats;
+    std::string error;
+    return ExtractZip(zipPath, destinationPath, options, stats, error);
+}
+
+bool ZipUtils::ExtractZip(const std::string& zipPath, const std::string& destinationPath,
+    const ZipOptions& options, ZipStats& stats, std::string& error) {
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    ZipReader reader;
+    if (!reader.Open(zipPath)) {
+        error = reader.GetError();
         return false;
     }
 
-    if (!FileUtils::FolderExists(destinationPath)) {
-        FileUtils::CreateFolder(destinationPath);
+    // Same cap as compression: the background share of the cores
+    size_t threads = ThreadPool::GetBackgroundThreadCount(options.maxThreads);
+    reader.SetProgress(options.progress, options.userData);
+    reader.SetThreads(threads);
+    if (!reader.ExtractAll(destinationPath)) {
+        error = reader.GetError();
+        return false;
     }
 
-    std::string cmd = "powershell.exe -NoProfile -Command \"Expand-Archive -Path '" +
-        zipPath + "' -DestinationPath '" + destinationPath + "' -Force\"";
+    std::error_code ec;
+    stats.files = 0;
+    for (size_t i = 0; i < reader.GetEntryCount(); i++) {
+        if (!reader.GetEntry(i).isDirectory) {
+            stats.files++;
+        }
+    }
+    stats.bytesIn = fs::file_size(zipPath, ec);
+    stats.bytesOut = reader.GetTotalUncompressed();
+    stats.threads = threads;
+    stats.elapsedMs = (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    return true;
+}
 
-    int result = system(cmd.c_str());
-    return (result == 0);
+bool ZipUtils::ExtractZip(DeflateSource source, void* userData, const std::string& destinationPath,
+    const ZipOptions& options, ZipStats& stats, std::string& error) {
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    ZipStreamReader reader;
+    reader.SetProgress(options.progress, options.userData);
+    if (!reader.ExtractAll(source, userData, destinationPath)) {
+        error = reader.GetError();
+        return false;
+    }
+
+    stats.files = 0;
+    for (size_t i = 0; i < reader.GetEntryCount(); i++) {
+        if (!reader.GetEntry(i).isDirectory) {
+            stats.files++;
+        }
+    }
+    stats.bytesIn = reader.GetBytesRead();
+    stats.bytesOut = reader.GetTotalUncompressed();
+    stats.threads = 1;
+    stats.elapsedMs = (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    return true;
 }
 
 bool ZipUtils::CreateZip(const std::string& folderPath, const std::string& zipPath) {
-    if (!FileUtils::FolderExists(folderPath)) {
+    ZipOptions options;
+    ZipStats stats;
+    std::string error;
+    return CreateZip(folderPath, zipPath, options, stats, error);
+}
+
+bool ZipUtils::CreateZip(const std::string& folderPath, const std::string& zipPath,
+    const ZipOptions& options, ZipStats& stats, std::string& error) {
+    std::error_code ec;
+    if (!fs::is_directory(folderPath, ec)) {
+        error = "Folder not found: " + folderPath;
         return false;
     }
 
-    if (FileUtils::FileExists(zipPath)) {
-        FileUtils::DeleteFile(zipPath);
+    ZipWriter writer;
+    if (!writer.Open(zipPath)) {
+        error = writer.GetError();
+        return false;
     }
+    return WriteFolder(writer, folderPath, options, stats, error);
+}
 
-    // Append "\*" to folder path to zip the CONTENTS, not the folder itself.
-    // Example: "C:\Models\ModelA\*" -> Zips files inside ModelA
-    std::string sourcePath = folderPath;
-    if (sourcePath.back() == '\\') {
-        sourcePath.pop_back();
+bool ZipUtils::CreateZip(const std::string& folderPath, DeflateSink sink, void* userData,
+    const ZipOptions& options, ZipStats& stats, std::string& error) {
+    std::error_code ec;
+    if (!fs::is_directory(folderPath, ec)) {
+        error = "Folder not found: " + folderPath;
+        return false;
     }
-    sourcePath += "\\*";
 
-    // Standard Compress-Archive command
-    std::string cmd = "powershell.exe -NoProfile -Command \"Compress-Archive -Path '" +
-        sourcePath + "' -DestinationPath '" + zipPath + "' -Force\"";
+    ZipWriter writer;
+    writer.Open(sink, userData);
+    return WriteFolder(writer, folderPath, options, stats, error);
+}
+
+bool ZipUtils::WriteFolder(ZipWriter& writer, const std::string& folderPath,
+    const ZipOptions& options, ZipStats& stats, std::string& error) {
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    std::error_code ec;
+
+    struct Item {
+        std::string path;
+        std::string name;
+        bool isDirectory;
+    };
+
+    // Collect first so the total is known for progress. Directories go first
+    // so the compression pipeline is not drained between files
+    std::vector<Item> items;
+    unsigned long long totalBytes = 0;
+    fs::path root(folderPath);
+    for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        Item item;
+        item.path = it->path().string();
+        item.name = it->path().lexically_relative(root).generic_string();
+        item.isDirectory = it->is_directory(ec);
+        if (!item.isDirectory) {
+            totalBytes += it->file_size(ec);
+        }
+        items.push_back(item);
+    }
+    if (ec) {
+        error = "Cannot list " + folderPath + ": " + ec.message();
+        writer.Abort();
+        return false;
+    }
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return a.isDirectory != b.isDirectory ? a.isDirectory : a.name < b.name;
+    });
 
-    int result = system(cmd.c_str());
+    // Never more than the background share of the cores, at low priority
+    size_t threads = ThreadPool::GetBackgroundThreadCount(options.maxThreads);
 
-    // Check if file was created
-    return (result == 0 && FileUtils::FileExists(zipPath));
+    writer.SetProgress(options.progress, options.userData, totalBytes);
+    writer.SetThreads(threads);
+
+    for (size_t i = 0; i < items.size(); i++) {
+        bool added = items[i].isDirectory ?
+            writer.AddDirectory(items[i].name) :
+            writer.AddFile(items[i].path, items[i].name, options.level);
+        if (!added) {
+            error = writer.GetError();
+            writer.Abort();
+            return false;
+        }
+    }
+
+    if (!writer.Close()) {
+        error = writer.GetError();
+        return false;
+    }
+
+    stats.files = 0;
+    for (size_t i = 0; i < items.size(); i++) {
+        if (!items[i].isDirectory) {
+            stats.files++;
+        }
+    }
+    stats.bytesIn = totalBytes;
+    stats.bytesOut = writer.GetBytesWritten();
+    stats.threads = threads;
+    stats.elapsedMs = (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    return true;
 }
\ No newline at end of file
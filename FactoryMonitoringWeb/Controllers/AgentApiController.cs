@@ -1,6 +1,7 @@
 using FactoryMonitoringWeb.Data;
 using FactoryMonitoringWeb.Models;
 using FactoryMonitoringWeb.Models.DTOs;
+using FactoryMonitoringWeb.Services;
 using Microsoft.AspNetCore.Mvc;
 using Microsoft.EntityFrameworkCore;
 using Newtonsoft.Json;
@@ -160,6 +161,7 @@ namespace FactoryMonitoringWeb.Controllers
                     {
                         PCId = request.PCId,
                         ConfigContent = request.ConfigContent,
+                        ContentHash = request.Hash,
                         LastModified = DateTime.Now
                     };
                     _context.ConfigFiles.Add(newConfig);
@@ -167,6 +169,7 @@ namespace FactoryMonitoringWeb.Controllers
                 else
                 {
                     existingConfig.ConfigContent = request.ConfigContent;
+                    existingConfig.ContentHash = request.Hash;
                     existingConfig.LastModified = DateTime.Now;
 
                     if (existingConfig.PendingUpdate)
@@ -195,6 +198,113 @@ namespace FactoryMonitoringWeb.Controllers
             }
         }
 
+        [HttpPost("configchanges")]
+        public async Task<ActionResult<ConfigChangesResponse>> ConfigChanges([FromBody] ConfigChangesRequest request)
+        {
+            try
+            {
+                var existingConfig = await _context.ConfigFiles
+                    .FirstOrDefaultAsync(c => c.PCId == request.PCId);
+
+                // Changes only apply to the version the agent diffed against
+                string? content = null;
+                if (existingConfig != null && !string.IsNullOrEmpty(existingConfig.ContentHash)
+                    && string.Equals(existingConfig.ContentHash, request.BaseHash, StringComparison.OrdinalIgnoreCase))
+                {
+                    content = ConfigChangeApplier.Apply(existingConfig.ConfigContent, request.Changes);
+                }
+
+                if (existingConfig == null || content == null)
+                {
+                    return Ok(new ConfigChangesResponse
+                    {
+                        Success = true,
+                        Resync = true,
+                        Message = "Full config required"
+                    });
+                }
+
+                existingConfig.ConfigContent = content;
+                existingConfig.ContentHash = request.Hash;
+                existingConfig.LastModified = DateTime.Now;
+
+                if (existingConfig.PendingUpdate)
+                {
+                    existingConfig.UpdateApplied = true;
+                    existingConfig.PendingUpdate = false;
+                }
+
+                await _context.SaveChangesAsync();
+
+                return Ok(new ConfigChangesResponse
+                {
+                    Success = true,
+                    Message = $"Applied {request.Changes.Count} config changes"
+                });
+            }
+            catch (Exception ex)
+            {
+                _logger.LogError(ex, "Error applying config changes");
+                return StatusCode(500, new ConfigChangesResponse
+                {
+                    Success = false,
+                    Message = $"Config changes failed: {ex.Message}"
+                });
+            }
+        }
+
+        [HttpPost("anomalies")]
+        public async Task<ActionResult<ApiResponse>> Anomalies([FromBody] AnomalyEventsRequest request)
+        {
+            try
+            {
+                foreach (var anomaly in request.Events)
+                {
+                    string action = string.IsNullOrEmpty(anomaly.Operation)
+                        ? $"Cycle anomaly: {anomaly.Type}"
+                        : $"Cycle anomaly: {anomaly.Type} in {anomaly.Operation}";
+
+                    _context.SystemLogs.Add(new SystemLog
+                    {
+                        PCId = request.PCId,
+                        Action = action.Length > 255 ? action.Substring(0, 255) : action,
+                        ActionType = "Warning",
+                        Details = JsonConvert.SerializeObject(anomaly),
+                        Timestamp = DateTime.Now
+                    });
+                }
+
+                if (request.Dropped > 0)
+                {
+                    _context.SystemLogs.Add(new SystemLog
+                    {
+                        PCId = request.PCId,
+                        Action = "Cycle anomalies dropped",
+                        ActionType = "Warning",
+                        Details = $"{request.Dropped} anomalies were dropped while the server was unreachable",
+                        Timestamp = DateTime.Now
+                    });
+                }
+
+                await _context.SaveChangesAsync();
+
+                return Ok(new ApiResponse
+                {
+                    Success = true,
+                    Message = $"Recorded {request.Events.Count} anomalies"
+                });
+            }
+            catch (Exception ex)
+            {
+                _logger.LogError(ex, "Error recording anomalies");
+                return StatusCode(500, new ApiResponse
+                {
+                    Success = false,
+                    Message = $"Anomaly recording failed: {ex.Message}"
+                });
+            }
+        }
+
         [HttpPost("updatelog")]
         public async Task<ActionResult<ApiResponse>> UpdateLog([FromBody] LogUpdateRequest request)
         {
@@ -16,6 +16,10 @@ namespace FactoryMonitoringWeb.Models
 
         public DateTime LastModified { get; set; } = DateTime.Now;
 
+        // Agent-side hash of ConfigContent, the base for key-level changes
+        [StringLength(16)]
+        public string? ContentHash { get; set; }
+
         public bool PendingUpdate { get; set; } = false;
 
         public string? UpdatedContent { get; set; }
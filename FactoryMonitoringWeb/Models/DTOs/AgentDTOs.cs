@@ -49,6 +49,42 @@ namespace FactoryMonitoringWeb.Models.DTOs
     {
         public int PCId { get; set; }
         public string ConfigContent { get; set; } = string.Empty;
+        public string? Hash { get; set; }
+    }
+
+    // Config Changes Request - key-level changes against the version with BaseHash
+    public class ConfigChangesRequest
+    {
+        public int PCId { get; set; }
+        public string BaseHash { get; set; } = string.Empty;
+        public string Hash { get; set; } = string.Empty;
+        public List<List<string?>> Changes { get; set; } = new List<List<string?>>();
+    }
+
+    // Config Changes Response - Resync asks the agent for the whole file
+    public class ConfigChangesResponse : ApiResponse
+    {
+        public bool Resync { get; set; }
+    }
+
+    // Anomaly Events Request - cycle-time anomalies seen by the live log tailer
+    public class AnomalyEventsRequest
+    {
+        public int PCId { get; set; }
+        public List<AnomalyEventDto> Events { get; set; } = new List<AnomalyEventDto>();
+        public long Dropped { get; set; }
+    }
+
+    public class AnomalyEventDto
+    {
+        public string Type { get; set; } = string.Empty;
+        public string? Operation { get; set; }
+        public long BarrelId { get; set; }
+        public string Time { get; set; } = string.Empty;
+        public long DurationMs { get; set; }
+        public double ExpectedMs { get; set; }
+        public long? IdealMs { get; set; }
+        public double ZScore { get; set; }
     }
 
     // Log Update Request
@@ -0,0 +1,181 @@
+namespace FactoryMonitoringWeb.Services
+{
+    /// <summary>
+    /// Applies the agent's key-level config changes to the stored INI text.
+    /// Each change is [section, key, oldValue, newValue]; oldValue is null for an
+    /// added key and newValue is null for a removed one. Sections are lower case,
+    /// keys match case-insensitively, as in the agent's parser
+    /// </summary>
+    public static class ConfigChangeApplier
+    {
+        private static readonly char[] Blanks = { ' ', '\t', '\r', '\uFEFF' };
+
+        /// <summary>
+        /// Returns the updated text, or null when a change does not fit the stored
+        /// content and the agent has to send the whole file
+        /// </summary>
+        public static string? Apply(string content, List<List<string?>> changes)
+        {
+            string newline = content.Contains("\r\n") ? "\r\n" : "\n";
+            var lines = content.Replace("\r\n", "\n").Split('\n').ToList();
+
+            foreach (var change in changes)
+            {
+                if (change == null || change.Count != 4 || change[0] == null || change[1] == null)
+                {
+                    return null;
+                }
+
+                string section = change[0]!.ToLowerInvariant();
+                string key = change[1]!;
+                string? oldValue = change[2];
+                string? newValue = change[3];
+
+                var keyLines = FindKeyLines(lines, section, key);
+
+                if (oldValue == null)
+                {
+                    if (newValue == null || keyLines.Count > 0)
+                    {
+                        return null;
+                    }
+                    InsertKey(lines, section, key, newValue);
+                    continue;
+                }
+
+                if (keyLines.Count == 0 || ValueOf(lines[keyLines[0]]) != oldValue)
+                {
+                    return null;
+                }
+
+                if (newValue == null)
+                {
+                    for (int i = keyLines.Count - 1; i >= 0; i--)
+                    {
+                        lines.RemoveAt(keyLines[i]);
+                    }
+                }
+                else
+                {
+                    lines[keyLines[0]] = ReplaceValue(lines[keyLines[0]], newValue);
+                }
+            }
+
+            return string.Join(newline, lines);
+        }
+
+        // Section name for a header line, null for anything else
+        private static string? SectionOf(string line)
+        {
+            string trimmed = line.Trim(Blanks);
+            if (!trimmed.StartsWith("["))
+            {
+                return null;
+            }
+
+            int end = trimmed.IndexOf(']');
+            string name = end < 0 ? trimmed.Substring(1) : trimmed.Substring(1, end - 1);
+            return name.Trim(Blanks).ToLowerInvariant();
+        }
+
+        // Key for a key=value line, null for blanks, comments and headers
+        private static string? KeyOf(string line)
+        {
+            string trimmed = line.Trim(Blanks);
+            if (trimmed.Length == 0 || trimmed[0] == ';' || trimmed[0] == '#' || trimmed[0] == '[')
+            {
+                return null;
+            }
+
+            int equals = trimmed.IndexOf('=');
+            return equals < 0 ? null : trimmed.Substring(0, equals).Trim(Blanks);
+        }
+
+        private static string ValueOf(string line)
+        {
+            return line.Substring(line.IndexOf('=') + 1).Trim(Blanks);
+        }
+
+        private static string ReplaceValue(string line, string value)
+        {
+            int begin = line.IndexOf('=') + 1;
+            while (begin < line.Length && (line[begin] == ' ' || line[begin] == '\t'))
+            {
+                begin++;
+            }
+
+            int end = line.Length;
+            while (end > begin && Array.IndexOf(Blanks, line[end - 1]) >= 0)
+            {
+                end--;
+            }
+
+            return line.Substring(0, begin) + value + line.Substring(end);
+        }
+
+        private static List<int> FindKeyLines(List<string> lines, string section, string key)
+        {
+            var found = new List<int>();
+            string current = string.Empty;
+
+            for (int i = 0; i < lines.Count; i++)
+            {
+                string? header = SectionOf(lines[i]);
+                if (header != null)
+                {
+                    current = header;
+                    continue;
+                }
+
+                if (current == section && string.Equals(KeyOf(lines[i]), key, StringComparison.OrdinalIgnoreCase))
+                {
+                    found.Add(i);
+                }
+            }
+
+            return found;
+        }
+
+        private static void InsertKey(List<string> lines, string section, string key, string value)
+        {
+            string entry = key + "=" + value;
+            string current = string.Empty;
+            int insertAfter = -1;
+            bool sectionFound = section.Length == 0;
+
+            for (int i = 0; i < lines.Count; i++)
+            {
+                string? header = SectionOf(lines[i]);
+                if (header != null)
+                {
+                    current = header;
+                    if (current == section)
+                    {
+                        sectionFound = true;
+                        insertAfter = i;
+                    }
+                    continue;
+                }
+
+                if (current == section && KeyOf(lines[i]) != null)
+                {
+                    insertAfter = i;
+                }
+            }
+
+            if (sectionFound)
+            {
+                lines.Insert(insertAfter + 1, entry);
+                return;
+            }
+
+            // New section goes at the end, ahead of the trailing newline
+            int insertAt = lines.Count;
+            if (insertAt > 0 && lines[insertAt - 1].Length == 0)
+            {
+                insertAt--;
+            }
+            lines.InsertRange(insertAt, new[] { "[" + section + "]", entry });
+        }
+    }
+}
@@ -0,0 +1,22 @@
+USE FactoryMonitoringDB;
+GO
+
+-- ============================================
+-- Add ContentHash to ConfigFiles
+-- ============================================
+-- Agent-side hash of the stored config; key-level changes are only
+-- applied when the agent's base version matches it
+IF NOT EXISTS (SELECT * FROM sys.columns WHERE object_id = OBJECT_ID('ConfigFiles') AND name = 'ContentHash')
+BEGIN
+    PRINT 'Adding ContentHash column...';
+
+    ALTER TABLE ConfigFiles
+    ADD ContentHash NVARCHAR(16) NULL;
+
+    PRINT 'ContentHash column added successfully!';
+END
+ELSE
+BEGIN
+    PRINT 'ContentHash column already exists. Skipping.';
+END
+GO